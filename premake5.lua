@@ -37,6 +37,31 @@ project "jchess-core"
 
     files {"src/core/**.cpp", "src/core/**.h"}
     
+project "jchess-formats"
+    kind "StaticLib"
+
+    location(locdir)
+    targetdir "%{prj.location}"
+    objdir "%{prj.location}/obj"
+
+    links {"jchess-core", "zstd", "bz2"}
+
+    files {
+        "src/formats/**.h",
+        "src/formats/algebraic.cpp",
+        "src/formats/binaryFile.cpp",
+        "src/formats/checksum.cpp",
+        "src/formats/compressedInput.cpp",
+        "src/formats/fenParser.cpp",
+        "src/formats/gameArchive.cpp",
+        "src/formats/gameMetadata.cpp",
+        "src/formats/mappedFile.cpp",
+        "src/formats/openingExplorer.cpp",
+        "src/formats/parallelPGNReader.cpp",
+        "src/formats/pgnFile.cpp",
+        "src/formats/pgnReader.cpp",
+    }
+    
 -- project "jchess-engine"
 --     kind "StaticLib"
 
@@ -48,19 +73,19 @@ project "jchess-core"
 
 --     files {"src/engine/**.cpp", "src/engine/**.h"}
     
--- project "jchess-database"
---     kind "StaticLib"
+project "jchess-database"
+    kind "StaticLib"
 
---     location(locdir)
---     targetdir "%{prj.location}"
---     objdir "%{prj.location}/obj"
+    location(locdir)
+    targetdir "%{prj.location}"
+    objdir "%{prj.location}/obj"
 
---     pqxxdir = os.findheader("pqxx/pqxx")
---     includedirs({"src", pqxxdir})
+    pqdir = os.findheader("libpq-fe.h", {"/usr/include/postgresql"})
+    includedirs({"src", pqdir})
 
---     links {"jchess-core", "pq", "pqxx"}
+    links {"jchess-formats", "jchess-core", "pq", "pthread"}
 
---     files {"src/database/**.cpp", "src/database/**.h"}
+    files {"src/database/**.cpp", "src/database/**.h"}
 
 -- project "jchess-lib"
 --     kind "StaticLib"
@@ -73,6 +98,74 @@ project "jchess-core"
 
 --     files {"src/interface/**.cpp", "src/interface/**.h"}
 
+project "jchess-perft"
+    kind "ConsoleApp"
+
+    location(locdir)
+    targetdir "%{prj.location}"
+    objdir "%{prj.location}/obj"
+
+    files "scripts/perft.cpp"
+
+    links {"jchess-core", "pthread"}
+
+project "jchess-binary-bench"
+    kind "ConsoleApp"
+
+    location(locdir)
+    targetdir "%{prj.location}"
+    objdir "%{prj.location}/obj"
+
+    files "scripts/binaryBench.cpp"
+
+    links {"jchess-formats", "jchess-core", "pthread", "zstd", "bz2"}
+
+project "jchess-fen-bench"
+    kind "ConsoleApp"
+
+    location(locdir)
+    targetdir "%{prj.location}"
+    objdir "%{prj.location}/obj"
+
+    files "scripts/fenBench.cpp"
+
+    links {"jchess-formats", "jchess-core", "pthread", "zstd", "bz2"}
+
+project "jchess-loader"
+    kind "ConsoleApp"
+
+    location(locdir)
+    targetdir "%{prj.location}"
+    objdir "%{prj.location}/obj"
+
+    includedirs(pqdir)
+    files "scripts/loader.cpp"
+
+    links {"jchess-database", "jchess-formats", "jchess-core", "pq", "pthread", "zstd", "bz2"}
+
+project "jchess-db"
+    kind "ConsoleApp"
+
+    location(locdir)
+    targetdir "%{prj.location}"
+    objdir "%{prj.location}/obj"
+
+    includedirs(pqdir)
+    files "scripts/db.cpp"
+
+    links {"jchess-database", "jchess-formats", "jchess-core", "pq", "pthread", "zstd", "bz2"}
+
+project "jchess-explorer"
+    kind "ConsoleApp"
+
+    location(locdir)
+    targetdir "%{prj.location}"
+    objdir "%{prj.location}/obj"
+
+    files "scripts/explorer.cpp"
+
+    links {"jchess-formats", "jchess-core", "pthread", "zstd", "bz2"}
+
 project "gtest_main"
     kind "StaticLib"
     location "build/dep/gtest_main"
@@ -90,7 +183,7 @@ project "jchess-test"
     targetdir "%{prj.location}"
     objdir "%{prj.location}/obj"
 
-    files "test/core/**.cpp"
-    includedirs {"src", "dep/googletest/googletest/include"}
+    files {"test/core/**.cpp", "test/formats/**.cpp", "test/database/**.cpp"}
+    includedirs {"src", "dep/googletest/googletest/include", pqdir}
     
-    links {"jchess-core", "gtest_main"}
\ No newline at end of file
+    links {"jchess-database", "jchess-formats", "jchess-core", "gtest_main", "pq", "pthread", "zstd", "bz2"}
\ No newline at end of file
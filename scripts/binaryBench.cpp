@@ -0,0 +1,97 @@
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "formats/binaryFile.h"
+#include "formats/compressedInput.h"
+#include "formats/pgnFile.h"
+#include "formats/pgnReader.h"
+
+/* Usage: jchess-binary-bench <games.pgn[.zst|.bz2]> [maxGames]
+ *
+ * Reads the games, then encodes them in each binary version and decodes them back, printing
+ * the size per game and the encode and decode throughput. Decoding replays every game, so it
+ * is bound by move generation rather than by the format.
+ */
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <games.pgn[.zst|.bz2]> [maxGames]\n";
+        return 1;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    auto seconds = [](Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    };
+
+    try
+    {
+        size_t maxGames = (argc > 2) ? std::stoul(argv[2]) : SIZE_MAX;
+
+        std::vector<JChess::Game> games;
+        size_t plies = 0;
+        {
+            JChess::InputFile input{argv[1]};
+            JChess::PGNReader reader{input};
+            while (games.size() < maxGames)
+            {
+                const auto *game = reader.next();
+                if (!game)
+                    break;
+                try
+                {
+                    games.push_back(JChess::readPGN(*game));
+                    plies += games.back().moves.size();
+                }
+                catch (const std::exception &)
+                {
+                    // Games with illegal moves or bad tags are not what is being measured
+                }
+            }
+        }
+        std::cout << games.size() << " games, " << plies << " plies\n";
+        if (games.empty())
+            return 0;
+
+        for (auto version : {JChess::BinaryVersion::V1, JChess::BinaryVersion::V2})
+        {
+            std::string out;
+            auto start = Clock::now();
+            for (const auto &game : games)
+                JChess::writeBinary(out, game, version);
+            double encodeTime = seconds(start);
+
+            std::string_view input{out};
+            JChess::Game game;
+            size_t mismatches = 0;
+            start = Clock::now();
+            for (size_t i = 0; i < games.size(); ++i)
+            {
+                JChess::readBinary(input, game);
+                mismatches += !(game.moves == games[i].moves);
+            }
+            double decodeTime = seconds(start);
+
+            std::cout << "v" << static_cast<int>(version) << ": "
+                      << static_cast<double>(out.size()) / static_cast<double>(games.size()) << " bytes/game, "
+                      << static_cast<double>(out.size()) / static_cast<double>(plies) << " bytes/ply, "
+                      << "encode " << static_cast<double>(games.size()) / encodeTime << " games/s, "
+                      << "decode " << static_cast<double>(games.size()) / decodeTime << " games/s ("
+                      << static_cast<double>(plies) / decodeTime << " plies/s)";
+            if (mismatches)
+                std::cout << ", " << mismatches << " mismatched games";
+            std::cout << '\n';
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+}
@@ -1,30 +1,75 @@
-#include <fstream>
+#include <exception>
 #include <iostream>
 #include <string>
+#include <utility>
 
-#include "chessfiles/binaryFile.h"
-#include "chessfiles/pgnFile.h"
-#include "JChess/game.h"
+#include "core/game.h"
+#include "formats/compressedInput.h"
+#include "formats/gameArchive.h"
+#include "formats/gameMetadata.h"
+#include "formats/mappedFile.h"
+#include "formats/parallelPGNReader.h"
+#include "formats/pgnFile.h"
+#include "formats/pgnReader.h"
 
+/* Usage: converter <games.pgn[.zst|.bz2]> <archive> [threads]
+ *
+ * Writes the games to a game archive, and their headers to a columnar sidecar next to it,
+ * "<archive>.meta", for filtering. An uncompressed file is mapped, and its games are parsed
+ * and read on `threads` threads (one per hardware thread by default), in file order; a
+ * compressed one is decompressed ahead of a single parsing thread.
+ */
 int main(int argc, char *argv[])
 {
-    if (argc != 3)
+    if (argc != 3 && argc != 4)
         return 1;
 
     std::string input_filename{argv[1]};
     std::string output_filename{argv[2]};
+    unsigned threads = argc > 3 ? static_cast<unsigned>(std::stoul(argv[3])) : 0;
 
-    std::ifstream input{input_filename};
-    auto game = JChess::readPGN(input);
-    input.close();
+    JChess::GameArchiveWriter archive{output_filename};
+    JChess::GameMetadataWriter metadata{output_filename + ".meta"};
+    auto add = [&](const JChess::Game &game)
+    {
+        archive.add(game);
+        metadata.add(game);
+    };
 
-    std::ofstream output{output_filename};
-    JChess::writeBinary(output, game);
-    output.close();
+    JChess::MappedFile file{input_filename};
+    size_t skipped = 0;
+    if (JChess::detectCompression(file.text().substr(0, 4)) == JChess::Compression::None)
+    {
+        JChess::ParallelPGNReader reader{std::move(file), {.threads = threads, .readGames = true}};
+        while (const auto *game = reader.nextGame())
+            add(*game);
+        skipped = reader.gamesSkipped();
+    }
+    else
+    {
+        // .pgn.zst or .pgn.bz2
+        JChess::InputFile pgnInput{input_filename};
+        JChess::PGNReader reader{pgnInput};
+        JChess::Game game;
+        while (const auto *pgnGame = reader.next())
+        {
+            try
+            {
+                JChess::readPGN(*pgnGame, game);
+            }
+            catch (const std::exception &)
+            {
+                ++skipped;
+                continue;
+            }
+            add(game);
+        }
+    }
+    archive.finish();
+    metadata.finish();
 
-    input.open(output_filename);
-    auto game2 = JChess::readBinary(input);
-    input.close();
+    JChess::GameArchive{output_filename}.verify();
+    std::cout << archive.gamesWritten() << " games, " << skipped << " skipped\n";
 
     return 0;
-}
\ No newline at end of file
+}
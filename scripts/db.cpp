@@ -1,20 +1,121 @@
+#include <atomic>
+#include <chrono>
+#include <exception>
 #include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
-#include <pqxx/pqxx>
-
+#include "core/packedPosition.h"
+#include "core/state.h"
+#include "database/connectionPool.h"
 #include "database/games.h"
+#include "formats/compressedInput.h"
+#include "formats/pgnFile.h"
+#include "formats/pgnReader.h"
 
-int main()
+namespace
 {
-    try
+    // Inserts the games one at a time with `insertGame`, from `threads` threads sharing a pool
+    int insert(const char *conninfo, const char *path, unsigned threads)
+    {
+        JChess::Database::ConnectionPool pool{conninfo, threads};
+        JChess::InputFile input{path};
+        JChess::PGNReader reader{input};
+        std::mutex readerMutex;
+        std::atomic<size_t> inserted{0}, skipped{0};
+        std::exception_ptr error;
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::jthread> workers;
+        for (unsigned i = 0; i < threads; ++i)
+            workers.emplace_back([&]
+                                 {
+                                     try
+                                     {
+                                         while (true)
+                                         {
+                                             JChess::Game game;
+                                             {
+                                                 std::lock_guard lock{readerMutex};
+                                                 if (error)
+                                                     return;
+                                                 const auto *pgnGame = reader.next();
+                                                 if (!pgnGame)
+                                                     return;
+                                                 try
+                                                 {
+                                                     JChess::readPGN(*pgnGame, game);
+                                                 }
+                                                 catch (const std::exception &)
+                                                 {
+                                                     ++skipped;
+                                                     continue;
+                                                 }
+                                             }
+                                             auto conn = pool.acquire();
+                                             JChess::Database::insertGame(*conn, game);
+                                             ++inserted;
+                                         }
+                                     }
+                                     catch (...)
+                                     {
+                                         std::lock_guard lock{readerMutex};
+                                         if (!error)
+                                             error = std::current_exception();
+                                     }
+                                 });
+        workers.clear();
+        if (error)
+            std::rethrow_exception(error);
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << inserted << " games inserted, " << skipped << " skipped, "
+                  << static_cast<double>(inserted) / seconds << " games/s on " << pool.open() << " connections\n";
+        return 0;
+    }
+
+    int find(const char *conninfo, const char *fen)
     {
-        pqxx::connection conn;
-        pqxx::work work(conn);
+        JChess::Database::Connection conn{conninfo};
+        auto id = JChess::Database::findPosition(conn, JChess::PackedPosition{JChess::State{fen}});
+        if (!id)
+        {
+            std::cout << "Not in the database\n";
+            return 1;
+        }
+        std::cout << "positionID " << id << '\n';
+        return 0;
+    }
+} // namespace
 
-        work.commit();
+/* Usage: jchess-db <conninfo> insert <games.pgn[.zst|.bz2]> [threads]
+ *        jchess-db <conninfo> find <FEN>
+ *
+ * Inserts games one at a time, over a pool of `threads` connections (4 by default), or
+ * looks up the ID of a position. `jchess-loader` loads many games much faster.
+ */
+int main(int argc, char *argv[])
+{
+    std::string_view command = argc > 2 ? argv[2] : "";
+    if (argc < 4 || (command != "insert" && command != "find"))
+    {
+        std::cerr << "Usage: jchess-db <conninfo> insert <games.pgn[.zst|.bz2]> [threads]\n"
+                     "       jchess-db <conninfo> find <FEN>\n";
+        return 1;
+    }
+
+    try
+    {
+        if (command == "find")
+            return find(argv[1], argv[3]);
+        return insert(argv[1], argv[3], argc > 4 ? static_cast<unsigned>(std::stoul(argv[4])) : 4);
     }
     catch (const std::exception &e)
     {
         std::cerr << e.what() << '\n';
+        return 1;
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,139 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "core/packedPosition.h"
+#include "core/state.h"
+#include "formats/algebraic.h"
+#include "formats/compressedInput.h"
+#include "formats/openingExplorer.h"
+#include "formats/pgnFile.h"
+#include "formats/pgnReader.h"
+
+namespace
+{
+    int build(const char *pgnPath, const char *indexPath, const JChess::ExplorerBuildOptions &options)
+    {
+        JChess::InputFile input{pgnPath};
+        JChess::PGNReader reader{input};
+        JChess::OpeningExplorerBuilder builder{options};
+        JChess::Game game;
+        size_t skipped = 0;
+        while (const auto *pgnGame = reader.next())
+        {
+            try
+            {
+                JChess::readPGN(*pgnGame, game);
+            }
+            catch (const std::exception &)
+            {
+                ++skipped;
+                continue;
+            }
+            builder.add(game);
+        }
+        size_t games = builder.games(), runs = builder.runs();
+        builder.write(indexPath);
+        std::cout << games << " games counted, " << skipped << " skipped, " << runs << " runs spilled, "
+                  << JChess::OpeningExplorer{indexPath}.size() << " positions\n";
+        return 0;
+    }
+
+    JChess::Speed parseSpeed(std::string_view name)
+    {
+        constexpr std::string_view names[]{"ultrabullet", "bullet", "blitz", "rapid", "classical"};
+        for (size_t i = 0; i < std::size(names); ++i)
+            if (name == names[i])
+                return static_cast<JChess::Speed>(i);
+        throw std::runtime_error("Unknown speed: " + std::string{name});
+    }
+
+    int query(const char *indexPath, const char *fen, int argc, char *argv[])
+    {
+        JChess::ExplorerFilter filter;
+        for (int i = 0; i + 1 < argc; i += 2)
+        {
+            std::string_view option{argv[i]};
+            std::string value{argv[i + 1]};
+            if (option == "--elo")
+            {
+                auto dash = value.find('-');
+                auto min = static_cast<uint16_t>(std::stoul(value.substr(0, dash)));
+                auto max = dash == std::string::npos ? uint16_t{UINT16_MAX} : static_cast<uint16_t>(std::stoul(value.substr(dash + 1)));
+                filter.ELO = JChess::Range<uint16_t>{min, max};
+            }
+            else if (option == "--speed")
+                filter.acceptSpeed(parseSpeed(value));
+            else
+                throw std::runtime_error("Unknown option: " + std::string{option});
+        }
+
+        JChess::OpeningExplorer explorer{indexPath};
+        JChess::State state{fen};
+        JChess::PackedPosition position{state};
+
+        // The first lookup faults the pages in; time the ones after it
+        auto moves = explorer.moves(position, filter);
+        constexpr int repeats = 1000;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repeats; ++i)
+            moves = explorer.moves(position, filter);
+        auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        for (const auto &move : moves)
+        {
+            std::chrono::year_month_day last{std::chrono::floor<std::chrono::days>(move.lastPlayed)};
+            std::printf("%-8s %8u games  %5.1f%% / %5.1f%% / %5.1f%%  ELO %4u  last %d-%02u-%02u\n",
+                        JChess::Algebraic::toSAN(state, move.move).c_str(), move.games(),
+                        100.0 * move.whiteWins / move.games(), 100.0 * move.draws / move.games(),
+                        100.0 * move.blackWins / move.games(), static_cast<unsigned>(move.averageELO), static_cast<int>(last.year()),
+                        static_cast<unsigned>(last.month()), static_cast<unsigned>(last.day()));
+        }
+        std::printf("%zu moves, %.2f us per lookup\n", moves.size(), elapsed / repeats);
+        return 0;
+    }
+} // namespace
+
+/* Usage: jchess-explorer build <games.pgn[.zst|.bz2]> <index> [maxPlies] [memoryMB]
+ *        jchess-explorer query <index> <FEN> [--elo <min>[-<max>]] [--speed <speed>]...
+ *
+ * Builds an opening explorer index of the first `maxPlies` moves (40 by default) of each
+ * game, counting in `memoryMB` (1024 by default) and spilling to the temporary directory
+ * beyond it, or prints the moves played from a position with their scores, white / draw / black.
+ * Speeds are ultrabullet, bullet, blitz, rapid and classical. `jchess-loader --explorer`
+ * builds the same index while loading the games into the database.
+ */
+int main(int argc, char *argv[])
+{
+    std::string_view command = argc > 1 ? argv[1] : "";
+    if (argc < 4 || (command != "build" && command != "query"))
+    {
+        std::cerr << "Usage: jchess-explorer build <games.pgn[.zst|.bz2]> <index> [maxPlies] [memoryMB]\n"
+                     "       jchess-explorer query <index> <FEN> [--elo <min>[-<max>]] [--speed <speed>]...\n";
+        return 1;
+    }
+
+    try
+    {
+        if (command == "build")
+        {
+            JChess::ExplorerBuildOptions options;
+            if (argc > 4)
+                options.maxPlies = std::stoul(argv[4]);
+            if (argc > 5)
+                options.memoryBytes = std::stoul(argv[5]) << 20;
+            return build(argv[2], argv[3], options);
+        }
+        return query(argv[2], argv[3], argc - 4, argv + 4);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+}
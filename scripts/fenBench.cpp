@@ -0,0 +1,106 @@
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "core/state.h"
+#include "formats/fenParser.h"
+#include "formats/mappedFile.h"
+
+/* Usage: jchess-fen-bench <positions.epd> [repeats]
+ *
+ * Parses the file with the batch EPD reader and writes every position back out as FEN. Then
+ * compares reading those through `State`'s own FEN constructor with converting the parsed
+ * positions by `toState`, and packs and unpacks them as `PackedPosition`s, printing the
+ * throughput of each step.
+ */
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <positions.epd> [repeats]\n";
+        return 1;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    auto seconds = [](Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    };
+
+    try
+    {
+        size_t repeats = (argc > 2) ? std::stoul(argv[2]) : 5;
+        JChess::MappedFile file{argv[1]};
+
+        JChess::FEN::EPDBatch batch;
+        auto start = Clock::now();
+        for (size_t i = 0; i < repeats; ++i)
+            batch = JChess::FEN::readEPD(file);
+        double parseTime = seconds(start) / static_cast<double>(repeats);
+        auto count = static_cast<double>(batch.positions.size());
+        std::cout << batch.positions.size() << " positions, " << batch.failures.size() << " failures\n"
+                  << "batch parse: " << count / parseTime << " positions/s, "
+                  << static_cast<double>(file.size()) / parseTime / 1e6 << " MB/s\n";
+        if (batch.positions.empty())
+            return 0;
+
+        std::string fens;
+        std::vector<size_t> ends;
+        char buffer[JChess::FEN::maxLength];
+        start = Clock::now();
+        for (const auto &position : batch.positions)
+        {
+            fens.append(buffer, JChess::FEN::write(position, buffer));
+            ends.push_back(fens.size());
+        }
+        double writeTime = seconds(start);
+        std::cout << "write: " << count / writeTime << " positions/s\n";
+
+        uint64_t hashes = 0;
+        size_t begin = 0;
+        start = Clock::now();
+        for (size_t end : ends)
+        {
+            // `State` reads its FEN through a stream over a null-terminated string
+            std::string fen = fens.substr(begin, end - begin);
+            begin = end;
+            hashes ^= JChess::State{fen}.hash();
+        }
+        double stateTime = seconds(start);
+        std::cout << "State(fen): " << count / stateTime << " positions/s\n";
+
+        start = Clock::now();
+        for (const auto &position : batch.positions)
+            hashes ^= JChess::FEN::toState(position).hash();
+        double toStateTime = seconds(start);
+        std::cout << "toState: " << count / toStateTime << " positions/s\n";
+        if (hashes)
+            std::cout << "the two parsers disagree\n";
+
+        std::vector<JChess::PackedPosition> packed;
+        packed.reserve(batch.positions.size());
+        start = Clock::now();
+        for (const auto &position : batch.positions)
+            packed.push_back(JChess::FEN::pack(position));
+        double packTime = seconds(start);
+
+        size_t mismatches = 0;
+        start = Clock::now();
+        for (size_t i = 0; i < packed.size(); ++i)
+            mismatches += JChess::FEN::unpack(packed[i]).pieces != batch.positions[i].pieces;
+        double unpackTime = seconds(start);
+        std::cout << "pack: " << count / packTime << " positions/s, unpack: " << count / unpackTime << " positions/s";
+        if (mismatches)
+            std::cout << " (" << mismatches << " mismatched)";
+        std::cout << '\n';
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,120 @@
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <iostream>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "database/connection.h"
+#include "database/ingestPipeline.h"
+#include "database/positionDictionary.h"
+#include "database/schema.h"
+#include "formats/compressedInput.h"
+#include "formats/openingExplorer.h"
+
+namespace
+{
+    void report(const JChess::Database::IngestStats &stats)
+    {
+        using JChess::Database::IngestStage;
+        std::printf("%zu games, %zu moves, %zu new positions, %zu skipped, %.0f games/s |",
+                    stats.loaded.games, stats.loaded.moves, stats.loaded.newPositions, stats.skipped,
+                    static_cast<double>(stats.loaded.games) / stats.seconds);
+        // How busy each stage's threads are, and how full the queue it takes from is
+        for (size_t i = 0; i < stats.stages.size(); ++i)
+        {
+            const auto &stage = stats.stages[i];
+            std::printf(" %s %.0f%%", JChess::Database::ingestStageNames[i].data(),
+                        100 * stage.busySeconds / (stage.threads * stats.seconds));
+            if (stage.queueCapacity)
+                std::printf(" [%zu/%zu]", stage.queued, stage.queueCapacity);
+        }
+        std::printf("\n");
+        std::fflush(stdout);
+    }
+} // namespace
+
+/* Usage: jchess-loader [--create] [--explorer <index>] <conninfo> <games.pgn[.zst|.bz2]> [writers]
+ *
+ * Loads the games into a database with the schema of src/database/schema.h, creating it
+ * first with --create, through an `IngestPipeline` with `writers` connections (2 by
+ * default). The positions already in the table are read into memory first. Prints the
+ * progress and how busy each stage is every second. Games that cannot be read are skipped.
+ *
+ * With --explorer, also writes an opening explorer index of the games loaded in this run.
+ */
+int main(int argc, char *argv[])
+{
+    bool create = false;
+    const char *explorerPath = nullptr;
+    while (argc > 1 && std::string_view{argv[1]}.starts_with("--"))
+    {
+        std::string_view option{argv[1]};
+        if (option == "--create")
+            create = true;
+        else if (option == "--explorer" && argc > 2)
+        {
+            explorerPath = argv[2];
+            --argc;
+            ++argv;
+        }
+        else
+            break;
+        --argc;
+        ++argv;
+    }
+    if (argc < 3)
+    {
+        std::cerr << "Usage: jchess-loader [--create] [--explorer <index>] <conninfo> <games.pgn[.zst|.bz2]> [writers]\n";
+        return 1;
+    }
+
+    try
+    {
+        JChess::Database::IngestOptions options;
+        if (argc > 3)
+            options.writers = static_cast<unsigned>(std::stoul(argv[3]));
+        JChess::OpeningExplorerBuilder explorer;
+        if (explorerPath)
+            options.explorer = &explorer;
+
+        JChess::Database::PositionDictionary dictionary;
+        {
+            JChess::Database::Connection conn{argv[1]};
+            if (create)
+                conn.exec(JChess::Database::schema);
+            // Positions already in the table are then never sent again
+            auto known = dictionary.warm(conn);
+            std::cout << known << " known positions, " << dictionary.memoryUsage() / (1 << 20) << " MiB" << std::endl;
+        }
+
+        JChess::InputFile input{argv[2]};
+        JChess::Database::IngestPipeline pipeline{argv[1], input, dictionary, options};
+        std::jthread reporter{[&](std::stop_token stop)
+                              {
+                                  while (!stop.stop_requested())
+                                  {
+                                      for (int i = 0; i < 10 && !stop.stop_requested(); ++i)
+                                          std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                                      report(pipeline.stats());
+                                  }
+                              }};
+        pipeline.wait();
+        reporter.request_stop();
+        reporter.join();
+
+        if (explorerPath)
+        {
+            size_t games = explorer.games();
+            explorer.write(explorerPath);
+            std::cout << games << " games in the opening explorer index" << std::endl;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+}
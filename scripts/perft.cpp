@@ -0,0 +1,83 @@
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "core/perft.h"
+#include "core/state.h"
+
+/* Usage: jchess-perft [-t threads] [-H hashMB] [FEN] <depth>
+ *
+ * Prints the node count below each root move ("divide"), the total, and the throughput.
+ * The FEN may be given as one quoted argument or as its six space-separated fields, and
+ * defaults to the starting position. The tree is split across `threads` workers (default:
+ * one per hardware thread), optionally sharing a transposition table of `hashMB` megabytes.
+ */
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " [-t threads] [-H hashMB] [FEN] <depth>\n";
+        return 1;
+    }
+
+    JChess::PerftOptions options;
+    int first = 1;
+    try
+    {
+        for (; first + 1 < argc - 1; first += 2)
+        {
+            std::string flag{argv[first]};
+            if (flag == "-t")
+                options.threads = static_cast<unsigned>(std::stoul(argv[first + 1]));
+            else if (flag == "-H")
+                options.hashBytes = std::stoul(argv[first + 1]) << 20;
+            else
+                break;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Invalid option value: " << e.what() << '\n';
+        return 1;
+    }
+
+    std::string fen;
+    for (int i = first; i < argc - 1; ++i)
+    {
+        if (!fen.empty())
+            fen += ' ';
+        fen += argv[i];
+    }
+    if (fen.empty())
+        fen = JChess::FEN::startstate;
+
+    try
+    {
+        unsigned depth = static_cast<unsigned>(std::stoul(argv[argc - 1]));
+        JChess::State state{fen};
+
+        auto start = std::chrono::steady_clock::now();
+        auto counts = JChess::parallelPerftDivide(state, depth, options);
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+        uint64_t nodes = 0;
+        for (const auto &[move, count] : counts)
+        {
+            std::cout << move.toUCI() << ": " << count << '\n';
+            nodes += count;
+        }
+
+        std::cout << "\nNodes searched: " << nodes << '\n'
+                  << "Time (s): " << elapsed.count() << '\n'
+                  << "Nodes/sec: " << static_cast<uint64_t>(nodes / elapsed.count()) << '\n';
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}
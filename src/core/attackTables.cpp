@@ -0,0 +1,216 @@
+#include "core/attackTables.h"
+
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define JCHESS_RUNTIME_PEXT 1
+#endif
+
+namespace JChess::AttackTables
+{
+    namespace detail
+    {
+        std::array<Magic, 64> bishopMagics{};
+        std::array<Magic, 64> rookMagics{};
+        bool usePext = false;
+
+        std::array<std::array<Bitboard, 64>, 64> betweenTable{};
+        std::array<std::array<Bitboard, 64>, 64> lineTable{};
+
+#if defined(JCHESS_RUNTIME_PEXT)
+        __attribute__((target("bmi2"))) size_t pextIndex(Bitboard occupied, Bitboard mask)
+        {
+            return static_cast<size_t>(_pext_u64(occupied, mask));
+        }
+#else
+        size_t pextIndex(Bitboard, Bitboard)
+        {
+            std::unreachable();
+        }
+#endif
+    } // namespace detail
+
+    namespace
+    {
+        // Sizes for the largest masks: 2^12 per rook square, 2^9 per bishop square,
+        // less where the mask is shorter
+        constexpr size_t rookTableSize = 0x19000;
+        constexpr size_t bishopTableSize = 0x1480;
+
+        std::array<Bitboard, rookTableSize> rookTable{};
+        std::array<Bitboard, bishopTableSize> bishopTable{};
+
+        bool detectPext()
+        {
+#if defined(__BMI2__)
+            return true;
+#elif defined(JCHESS_RUNTIME_PEXT)
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("bmi2");
+#else
+            return false;
+#endif
+        }
+
+        // xorshift64*, seeded deterministically so startup cost is reproducible
+        class Prng
+        {
+        public:
+            explicit Prng(uint64_t seed) : m_state(seed) {}
+
+            uint64_t next()
+            {
+                m_state ^= m_state >> 12;
+                m_state ^= m_state << 25;
+                m_state ^= m_state >> 27;
+                return m_state * 2685821657736338717ull;
+            }
+
+            // Magic candidates work best with few set bits
+            uint64_t sparse()
+            {
+                return next() & next() & next();
+            }
+
+        private:
+            uint64_t m_state;
+        };
+
+        template <size_t N>
+        Bitboard slidingAttacks(const std::array<Offset, N> &directions, size_t idx, Bitboard occupied)
+        {
+            Bitboard attacked = Bitboards::empty;
+            for (const auto &dir : directions)
+            {
+                for (Square sq = Bitboards::square(idx) + dir; detail::onBoard(sq); sq += dir)
+                {
+                    attacked |= Bitboards::bit(sq);
+                    if (occupied & Bitboards::bit(sq))
+                        break;
+                }
+            }
+            return attacked;
+        }
+
+        // The squares whose occupancy can change the attack set: every square of each
+        // ray except the last, since a piece on the edge cannot block anything further
+        template <size_t N>
+        Bitboard relevantMask(const std::array<Offset, N> &directions, size_t idx)
+        {
+            Bitboard mask = Bitboards::empty;
+            for (const auto &dir : directions)
+                for (Square sq = Bitboards::square(idx) + dir; detail::onBoard(sq + dir); sq += dir)
+                    mask |= Bitboards::bit(sq);
+            return mask;
+        }
+
+        template <size_t N>
+        void initSlider(const std::array<Offset, N> &directions,
+                        std::array<detail::Magic, 64> &magics,
+                        Bitboard *table)
+        {
+            // Per-rank seeds that find working magics in few attempts for this square layout
+            constexpr std::array<uint64_t, 8> seeds{255, 334, 199, 79, 341, 110, 310, 83};
+            std::vector<Bitboard> occupancies, reference;
+            std::vector<unsigned> epoch;
+            unsigned attempt = 0;
+
+            for (size_t idx = 0; idx < 64; ++idx)
+            {
+                auto &m = magics[idx];
+                Prng prng{seeds[static_cast<size_t>(Bitboards::square(idx).rank)]};
+                m.mask = relevantMask(directions, idx);
+                m.shift = static_cast<unsigned>(64 - Bitboards::count(m.mask));
+                m.attacks = table;
+
+                // Enumerate every subset of the mask (Carry-Rippler)
+                occupancies.clear();
+                reference.clear();
+                Bitboard occ = Bitboards::empty;
+                do
+                {
+                    occupancies.push_back(occ);
+                    reference.push_back(slidingAttacks(directions, idx, occ));
+                    occ = (occ - m.mask) & m.mask;
+                } while (occ);
+
+                size_t size = occupancies.size();
+                table += size;
+
+                if (detail::usePext)
+                {
+                    for (size_t i = 0; i < size; ++i)
+                        m.attacks[m.index(occupancies[i])] = reference[i];
+                    continue;
+                }
+
+                // Search for a magic that maps every subset to a slot without destructive
+                // collisions. `epoch` marks which slots were written during this attempt.
+                epoch.assign(size, 0);
+                for (size_t i = 0; i < size;)
+                {
+                    do
+                        m.magic = prng.sparse();
+                    while (Bitboards::count((m.mask * m.magic) >> 56) < 6);
+
+                    ++attempt;
+                    for (i = 0; i < size; ++i)
+                    {
+                        auto slot = m.index(occupancies[i]);
+                        auto &entry = m.attacks[slot];
+                        if (epoch[slot] < attempt)
+                        {
+                            epoch[slot] = attempt;
+                            entry = reference[i];
+                        }
+                        else if (entry != reference[i])
+                            break;
+                    }
+                }
+            }
+        }
+
+        void initLines()
+        {
+            for (size_t a = 0; a < 64; ++a)
+            {
+                for (size_t b = 0; b < 64; ++b)
+                {
+                    if (a == b)
+                        continue;
+
+                    Bitboard ends = Bitboards::bit(a) | Bitboards::bit(b);
+                    if (rookAttacks(a, Bitboards::empty) & Bitboards::bit(b))
+                    {
+                        detail::lineTable[a][b] = (rookAttacks(a, Bitboards::empty) & rookAttacks(b, Bitboards::empty)) | ends;
+                        detail::betweenTable[a][b] = rookAttacks(a, Bitboards::bit(b)) & rookAttacks(b, Bitboards::bit(a));
+                    }
+                    else if (bishopAttacks(a, Bitboards::empty) & Bitboards::bit(b))
+                    {
+                        detail::lineTable[a][b] = (bishopAttacks(a, Bitboards::empty) & bishopAttacks(b, Bitboards::empty)) | ends;
+                        detail::betweenTable[a][b] = bishopAttacks(a, Bitboards::bit(b)) & bishopAttacks(b, Bitboards::bit(a));
+                    }
+                }
+            }
+        }
+
+        struct Initializer
+        {
+            Initializer()
+            {
+                detail::usePext = detectPext();
+                initSlider(Offsets::bishop, detail::bishopMagics, bishopTable.data());
+                initSlider(Offsets::rook, detail::rookMagics, rookTable.data());
+                initLines();
+            }
+        };
+
+        const Initializer initializer{};
+    } // namespace
+
+    bool usingPext()
+    {
+        return detail::usePext;
+    }
+} // namespace JChess::AttackTables
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <utility>
+
+#include "core/bitboard.h"
+#include "core/color.h"
+#include "core/offset.h"
+#include "core/piece.h"
+#include "core/square.h"
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+/* Precomputed attack sets, indexed by `Board::squareToIdx`.
+ *
+ * Leaper (pawn, knight, king) tables are built at compile time. Slider tables use
+ * magic bitboards and are filled once at startup; on CPUs with BMI2 the occupancy is
+ * indexed with PEXT instead of a magic multiply (chosen at compile time if the build
+ * targets BMI2, otherwise detected at runtime). The between/line tables used for pins
+ * and check evasions are derived from the slider tables at the same time.
+ */
+namespace JChess::AttackTables
+{
+    namespace detail
+    {
+        constexpr inline bool onBoard(Square square)
+        {
+            return 0 <= square.file && square.file <= 7 &&
+                   0 <= square.rank && square.rank <= 7;
+        }
+
+        template <size_t N>
+        constexpr std::array<Bitboard, 64> leaperTable(const std::array<Offset, N> &offsets, int rankSign = 1)
+        {
+            std::array<Bitboard, 64> table{};
+            for (size_t idx = 0; idx < 64; ++idx)
+            {
+                for (auto offset : offsets)
+                {
+                    offset.rank *= rankSign;
+                    Square to = Bitboards::square(idx) + offset;
+                    if (onBoard(to))
+                        table[idx] |= Bitboards::bit(to);
+                }
+            }
+            return table;
+        }
+
+        struct Magic
+        {
+            Bitboard mask = 0;
+            Bitboard magic = 0;
+            Bitboard *attacks = nullptr;
+            unsigned shift = 0;
+
+            size_t index(Bitboard occupied) const;
+        };
+
+        extern std::array<Magic, 64> bishopMagics;
+        extern std::array<Magic, 64> rookMagics;
+        extern bool usePext;
+
+        extern std::array<std::array<Bitboard, 64>, 64> betweenTable;
+        extern std::array<std::array<Bitboard, 64>, 64> lineTable;
+
+        size_t pextIndex(Bitboard occupied, Bitboard mask);
+
+        inline size_t Magic::index(Bitboard occupied) const
+        {
+#if defined(__BMI2__)
+            return static_cast<size_t>(_pext_u64(occupied, mask));
+#else
+            if (usePext)
+                return pextIndex(occupied, mask);
+            return static_cast<size_t>(((occupied & mask) * magic) >> shift);
+#endif
+        }
+
+        constexpr inline std::array<Bitboard, 64> knight = leaperTable(Offsets::knight);
+        constexpr inline std::array<Bitboard, 64> king = leaperTable(Offsets::queenKing);
+        constexpr inline std::array<std::array<Bitboard, 64>, 2> pawn{
+            leaperTable(Offsets::pawnAttack, 1),
+            leaperTable(Offsets::pawnAttack, -1),
+        };
+    } // namespace detail
+
+    // Whether slider lookups index their tables with PEXT rather than magic multiplication
+    bool usingPext();
+
+    constexpr inline Bitboard pawnAttacks(Color color, size_t idx)
+    {
+        return detail::pawn[static_cast<size_t>(color)][idx];
+    }
+
+    constexpr inline Bitboard knightAttacks(size_t idx)
+    {
+        return detail::knight[idx];
+    }
+
+    constexpr inline Bitboard kingAttacks(size_t idx)
+    {
+        return detail::king[idx];
+    }
+
+    inline Bitboard bishopAttacks(size_t idx, Bitboard occupied)
+    {
+        const auto &m = detail::bishopMagics[idx];
+        return m.attacks[m.index(occupied)];
+    }
+
+    inline Bitboard rookAttacks(size_t idx, Bitboard occupied)
+    {
+        const auto &m = detail::rookMagics[idx];
+        return m.attacks[m.index(occupied)];
+    }
+
+    inline Bitboard queenAttacks(size_t idx, Bitboard occupied)
+    {
+        return bishopAttacks(idx, occupied) | rookAttacks(idx, occupied);
+    }
+
+    // The squares strictly between two squares sharing a rank, file, or diagonal (else empty)
+    inline Bitboard between(size_t idx1, size_t idx2)
+    {
+        return detail::betweenTable[idx1][idx2];
+    }
+
+    // The full rank, file, or diagonal through two squares, including both (else empty)
+    inline Bitboard line(size_t idx1, size_t idx2)
+    {
+        return detail::lineTable[idx1][idx2];
+    }
+
+    // The squares attacked by `piece` standing on square `idx` given the occupied squares
+    inline Bitboard attacks(Piece piece, size_t idx, Bitboard occupied)
+    {
+        switch (piece.type)
+        {
+        case PieceType::Pawn:
+            return pawnAttacks(piece.color, idx);
+        case PieceType::Knight:
+            return knightAttacks(idx);
+        case PieceType::Bishop:
+            return bishopAttacks(idx, occupied);
+        case PieceType::Rook:
+            return rookAttacks(idx, occupied);
+        case PieceType::Queen:
+            return queenAttacks(idx, occupied);
+        case PieceType::King:
+            return kingAttacks(idx);
+
+        default:
+            std::unreachable();
+        }
+    }
+} // namespace JChess::AttackTables
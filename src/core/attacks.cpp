@@ -1,323 +1,131 @@
 #include "core/attacks.h"
 
-#include <ranges>
-#include <utility>
-
-#include "core/offset.h"
+#include "core/attackTables.h"
 
 namespace JChess
 {
-    Attacks::Attacks(std::shared_ptr<Board> board)
-        : m_board_ptr(board)
+    Attacks::Attacks(const Board &board)
     {
-        recompute();
+        recompute(board);
     }
 
-    void Attacks::recompute()
+    void Attacks::recompute(const Board &board)
     {
-        for (auto &bs : m_attackedByWhite)
-            bs.reset();
-        for (auto &bs : m_attackedByBlack)
-            bs.reset();
-        for (auto &bs : m_attackedFrom)
-            bs.reset();
-
-        auto board = getBoard();
+        m_attackedByWhite.fill(Bitboards::empty);
+        m_attackedByBlack.fill(Bitboards::empty);
+        m_attackedFrom.fill(Bitboards::empty);
 
-        for (const auto &[square, occupant] : std::views::zip(board->eachSquare(), board->eachOccupant()))
-            if (occupant)
-                addAttacker(square, occupant.value());
+        Bitboard occupied = board.occupied();
+        while (occupied)
+        {
+            auto idx = Bitboards::popLsb(occupied);
+            addAttacker(board, idx, board.get(Board::idxToSquare(idx)).value());
+        }
     }
 
     std::vector<Square> Attacks::squaresAttackedBy(Square square) const
     {
-        auto board = getBoard();
-        return bitsetToVector(m_attackedFrom[board->squareToIdx(square)]);
+        return bitboardToVector(attackedBy(square));
     }
 
     std::vector<Square> Attacks::squaresAttacking(Square square, Color color) const
     {
-        auto board = getBoard();
-        auto idx = board->squareToIdx(square);
-        const auto &attackedBy = (color == Color::White) ? m_attackedByWhite[idx]
-                                                         : m_attackedByBlack[idx];
-        return bitsetToVector(attackedBy);
+        return bitboardToVector(attackers(square, color));
     }
 
-    bool Attacks::isAttacked(Square square, Color color) const
+    Bitboard Attacks::attackedBy(Square square) const
     {
-        auto board = getBoard();
-        auto idx = board->squareToIdx(square);
-        auto &attackedBy = (color == Color::White) ? m_attackedByWhite[idx]
-                                                   : m_attackedByBlack[idx];
-        return attackedBy.any();
+        return m_attackedFrom[Board::squareToIdx(square)];
     }
 
-    size_t Attacks::numAttackers(Square square, Color color) const
+    Bitboard Attacks::attackers(Square square, Color color) const
     {
-        auto board = getBoard();
-        auto idx = board->squareToIdx(square);
-        auto &attackedBy = (color == Color::White) ? m_attackedByWhite[idx]
-                                                   : m_attackedByBlack[idx];
-        return attackedBy.count();
+        auto idx = Board::squareToIdx(square);
+        return (color == Color::White) ? m_attackedByWhite[idx]
+                                       : m_attackedByBlack[idx];
     }
 
-    void Attacks::applyMove(const Move &move)
+    bool Attacks::isAttacked(Square square, Color color) const
     {
-        Color activeColor = move.piece.color;
-        Color otherColor = oppositeColor(activeColor);
-
-        removePiece(move.from);
-        if (!move.capture || move.enPassant)
-            addPiece(move.to);
-        removeAttacker(move.from, move.piece);
-
-        if (move.enPassant)
-        {
-            Square capturedPawnSq = move.to + Offsets::backward(activeColor);
-            removePiece(capturedPawnSq);
-            removeAttacker(capturedPawnSq, Piece{otherColor, PieceType::Pawn});
-        }
-        else if (move.castle)
-        {
-            bool qs = move.castle.value() == Castling::Side::QUEEN;
-            Square rookTo = Square{qs ? 3 : 5, move.from.rank},
-                   rookFrom = Square{qs ? 0 : 7, move.from.rank};
-            removePiece(rookFrom);
-            addPiece(rookTo);
-            Piece rook{activeColor, PieceType::Rook};
-            removeAttacker(rookFrom, rook);
-            addAttacker(rookTo, rook);
-        }
-        else if (move.capture)
-        {
-            removeAttacker(move.to, move.capture.value());
-        }
-
-        Piece addedAttacker = move.promotion.value_or(move.piece);
-        addAttacker(move.to, addedAttacker);
+        return attackers(square, color) != Bitboards::empty;
     }
 
-    void Attacks::addAttacker(Square square, Piece piece)
+    size_t Attacks::numAttackers(Square square, Color color) const
     {
-        Square newSq{};
-        auto board = getBoard();
+        return Bitboards::count(attackers(square, color));
+    }
 
-        std::vector<Square> attackedSquares;
-        attackedSquares.reserve(16);
+    Bitboard Attacks::attackersTo(const Board &board, size_t idx, Bitboard occupied)
+    {
+        using namespace AttackTables;
+        Bitboard diagonal = board.pieces(PieceType::Bishop) | board.pieces(PieceType::Queen);
+        Bitboard lateral = board.pieces(PieceType::Rook) | board.pieces(PieceType::Queen);
+
+        return (pawnAttacks(Color::Black, idx) & board.pieces(Color::White, PieceType::Pawn)) |
+               (pawnAttacks(Color::White, idx) & board.pieces(Color::Black, PieceType::Pawn)) |
+               (knightAttacks(idx) & board.pieces(PieceType::Knight)) |
+               (kingAttacks(idx) & board.pieces(PieceType::King)) |
+               (bishopAttacks(idx, occupied) & diagonal) |
+               (rookAttacks(idx, occupied) & lateral);
+    }
 
-        switch (piece.type)
+    void Attacks::applyMove(const Board &board, PackedMove move)
+    {
+        Bitboard changed = Bitboards::bit(move.fromIdx()) | Bitboards::bit(move.toIdx());
+        if (move.isEnPassant())
+            changed |= Bitboards::bit(move.enPassantCaptureSquare());
+        else if (move.isCastle())
         {
-        case PieceType::Pawn:
-            for (auto offset : Offsets::pawnAttack)
-            {
-                if (piece.color == Color::Black)
-                    offset.rank *= -1;
-                newSq = square + offset;
-                if (board->valid(newSq))
-                    attackedSquares.push_back(newSq);
-            }
-            break;
-
-        case PieceType::Knight:
-            for (const auto &offset : Offsets::knight)
-            {
-                newSq = square + offset;
-                if (board->valid(newSq))
-                    attackedSquares.push_back(newSq);
-            }
-            break;
-
-        case PieceType::Bishop:
-            for (const auto &offset : Offsets::bishop)
-                for (const auto &newSq : board->getPath(square, offset, true))
-                    attackedSquares.push_back(newSq);
-            break;
-
-        case PieceType::Rook:
-            for (const auto &offset : Offsets::rook)
-                for (const auto &newSq : board->getPath(square, offset, true))
-                    attackedSquares.push_back(newSq);
-            break;
-
-        case PieceType::Queen:
-            for (const auto &offset : Offsets::queenKing)
-                for (const auto &newSq : board->getPath(square, offset, true))
-                    attackedSquares.push_back(newSq);
-            break;
-
-        case PieceType::King:
-            for (const auto &offset : Offsets::queenKing)
-            {
-                newSq = square + offset;
-                if (board->valid(newSq))
-                    attackedSquares.push_back(newSq);
-            }
-            break;
-
-        default:
-            std::unreachable();
-            break;
+            // Castling is always along the mover's home rank
+            Color activeColor = (move.from().rank == Board::homeRank(Color::White)) ? Color::White : Color::Black;
+            changed |= Bitboards::bit(Board::rookFromSquare(activeColor, move.castle().value())) |
+                       Bitboards::bit(Board::rookToSquare(activeColor, move.castle().value()));
         }
 
-        auto idx = board->squareToIdx(square);
-        for (const auto &attacked : attackedSquares)
-            m_attackedFrom[idx][board->squareToIdx(attacked)] = 1;
-
-        if (piece.color == Color::White)
-            for (const auto &attacked : attackedSquares)
-                m_attackedByWhite[board->squareToIdx(attacked)][idx] = 1;
-        else
-            for (const auto &attacked : attackedSquares)
-                m_attackedByBlack[board->squareToIdx(attacked)][idx] = 1;
+        update(board, changed);
     }
 
-    void Attacks::removeAttacker(Square square, Piece piece)
+    void Attacks::update(const Board &board, Bitboard changed)
     {
-        Square newSq{};
-        auto board = getBoard();
-
-        std::vector<Square> attackedSquares;
-        attackedSquares.reserve(16);
-
-        switch (piece.type)
+        Bitboard dirty = changed;
+        while (changed)
         {
-        case PieceType::Pawn:
-            for (auto offset : Offsets::pawnAttack)
-            {
-                if (piece.color == Color::White)
-                    offset.rank *= -1;
-                newSq = square + offset;
-                if (board->valid(newSq))
-                    attackedSquares.push_back(newSq);
-            }
-            break;
-
-        case PieceType::Knight:
-            for (const auto &offset : Offsets::knight)
-            {
-                newSq = square + offset;
-                if (board->valid(newSq))
-                    attackedSquares.push_back(newSq);
-            }
-            break;
-
-        case PieceType::Bishop:
-            for (const auto &offset : Offsets::bishop)
-                for (const auto &newSq : board->getPath(square, offset, true))
-                    attackedSquares.push_back(newSq);
-            break;
-
-        case PieceType::Rook:
-            for (const auto &offset : Offsets::rook)
-                for (const auto &newSq : board->getPath(square, offset, true))
-                    attackedSquares.push_back(newSq);
-            break;
-
-        case PieceType::Queen:
-            for (const auto &offset : Offsets::queenKing)
-                for (const auto &newSq : board->getPath(square, offset, true))
-                    attackedSquares.push_back(newSq);
-            break;
-
-        case PieceType::King:
-            for (const auto &offset : Offsets::queenKing)
-            {
-                newSq = square + offset;
-                if (board->valid(newSq))
-                    attackedSquares.push_back(newSq);
-            }
-            break;
-
-        default:
-            std::unreachable();
+            auto idx = Bitboards::popLsb(changed);
+            dirty |= m_attackedByWhite[idx] | m_attackedByBlack[idx];
         }
 
-        auto idx = board->squareToIdx(square);
-        for (const auto &attacked : attackedSquares)
-            m_attackedFrom[idx][board->squareToIdx(attacked)] = 0;
+        Bitboard toRemove = dirty;
+        while (toRemove)
+            removeAttacker(Bitboards::popLsb(toRemove));
 
-        if (piece.color == Color::White)
-            for (const auto &attacked : attackedSquares)
-                m_attackedByWhite[board->squareToIdx(attacked)][idx] = 0;
-        else
-            for (const auto &attacked : attackedSquares)
-                m_attackedByBlack[board->squareToIdx(attacked)][idx] = 0;
+        dirty &= board.occupied();
+        while (dirty)
+        {
+            auto idx = Bitboards::popLsb(dirty);
+            addAttacker(board, idx, board.get(Board::idxToSquare(idx)).value());
+        }
     }
 
-    void Attacks::addPiece(Square square)
+    void Attacks::addAttacker(const Board &board, size_t idx, Piece piece)
     {
-        auto board = getBoard();
-
-        for (size_t i = 0; i < 64; ++i)
-        {
-            if (!m_attackedFrom[i][board->squareToIdx(square)])
-                continue;
-            Square attacker = board->idxToSquare(i);
+        Bitboard attacked = AttackTables::attacks(piece, idx, board.occupied());
+        m_attackedFrom[idx] = attacked;
 
-            [[unlikely]] if (!board->get(attacker))
-                throw std::runtime_error("Invalid attacker");
-            auto piece = board->get(attacker).value();
-
-            auto &attackedBy = (piece.color == Color::White) ? m_attackedByWhite : m_attackedByBlack;
-
-            if (piece.type == PieceType::Pawn ||
-                piece.type == PieceType::Knight ||
-                piece.type == PieceType::King)
-                continue;
-
-            Offset offset{square.file - attacker.file,
-                          square.rank - attacker.rank};
-            offset.norm();
-
-            for (const auto &newSq : board->getPath(square, offset, true))
-            {
-                auto idx = board->squareToIdx(newSq);
-                attackedBy[idx][i] = 0;
-                m_attackedFrom[i][idx] = 0;
-            }
-        }
+        auto &attackedBy = (piece.color == Color::White) ? m_attackedByWhite : m_attackedByBlack;
+        while (attacked)
+            attackedBy[Bitboards::popLsb(attacked)] |= Bitboards::bit(idx);
     }
 
-    void Attacks::removePiece(Square square)
+    void Attacks::removeAttacker(size_t idx)
     {
-        auto board = getBoard();
+        Bitboard attacked = m_attackedFrom[idx];
+        m_attackedFrom[idx] = Bitboards::empty;
 
-        for (size_t i = 0; i < 64; ++i)
+        while (attacked)
         {
-            if (!m_attackedFrom[i][board->squareToIdx(square)])
-                continue;
-            Square attacker = board->idxToSquare(i);
-
-            [[unlikely]] if (!board->get(attacker))
-                throw std::runtime_error("Invalid attacker");
-            auto piece = board->get(attacker).value();
-
-            auto &attackedBy = (piece.color == Color::White) ? m_attackedByWhite : m_attackedByBlack;
-
-            if (piece.type == PieceType::Pawn ||
-                piece.type == PieceType::Knight ||
-                piece.type == PieceType::King)
-                continue;
-
-            Offset offset{square.file - attacker.file,
-                          square.rank - attacker.rank};
-            offset.norm();
-
-            for (const auto &newSq : board->getPath(square, offset, true))
-            {
-                auto idx = board->squareToIdx(newSq);
-                attackedBy[idx][i] = 1;
-                m_attackedFrom[i][idx] = 1;
-            }
+            auto target = Bitboards::popLsb(attacked);
+            m_attackedByWhite[target] &= ~Bitboards::bit(idx);
+            m_attackedByBlack[target] &= ~Bitboards::bit(idx);
         }
     }
-
-    std::shared_ptr<Board> Attacks::getBoard() const
-    {
-        std::shared_ptr<Board> sp_pos = m_board_ptr.lock();
-        if (!sp_pos)
-            throw std::runtime_error("AttackingPieces could not access Postion");
-        return sp_pos;
-    }
-} // namespace JChess
\ No newline at end of file
+} // namespace JChess
@@ -1,25 +1,28 @@
 #pragma once
 
 #include <array>
-#include <bitset>
-#include <memory>
 #include <vector>
 
+#include "core/bitboard.h"
 #include "core/board.h"
 #include "core/color.h"
-#include "core/move.h"
+#include "core/packedMove.h"
 #include "core/piece.h"
 #include "core/square.h"
 
 namespace JChess
 {
-    using AttackerArray = std::array<std::bitset<64>, 64>;
+    using AttackerArray = std::array<Bitboard, 64>;
 
+    /* Attack sets of every piece on a board, kept in step with that board by the owner
+     * (`State`), which passes the board in whenever it changes. Holds no reference to the
+     * board itself, so it is a plain value: copies are independent and trivially copyable.
+     */
     class Attacks
     {
     public:
         Attacks() = delete;
-        explicit Attacks(std::shared_ptr<Board> board);
+        explicit Attacks(const Board &board);
 
         /* The squares that the piece on the given square attacks.
          */
@@ -30,6 +33,11 @@ namespace JChess
          */
         std::vector<Square> squaresAttacking(Square square, Color color) const;
 
+        /* Bitboard versions of the two above, for use in move generation.
+         */
+        Bitboard attackedBy(Square square) const;
+        Bitboard attackers(Square square, Color color) const;
+
         /* Ascertain whether the given square is attacked by pieces of the given color.
          */
         bool isAttacked(Square square, Color color) const;
@@ -38,41 +46,42 @@ namespace JChess
          */
         size_t numAttackers(Square square, Color color) const;
 
-        /* To be called within Position::applyMove (at the end). Assumes that the
-        referenced board is the new state.
-         * Note: I would like to restrict access to this method exclusively to
-         * `Position::applyMove` if possible, e.g., via friend specification, but I can't
-         * figure it out. But it's also useful for testing.
+        /* All pieces (of either color) attacking square `idx` of `board`, computed from the
+         * attack tables with the given occupancy rather than from the cached state. Useful
+         * for testing hypothetical occupancies, e.g., with the king or a pawn removed.
+         */
+        static Bitboard attackersTo(const Board &board, size_t idx, Bitboard occupied);
+
+        /* To be called within State::makeMove (at the end), with the board after the move
+        has been applied, or within State::unmakeMove with the board after it has been undone.
          */
-        void applyMove(const Move &move);
+        void applyMove(const Board &board, PackedMove move);
 
     private:
         // Compute the attacking pieces from scratch
-        // Should only need to be called at construction, may make private in the future
-        void recompute();
+        void recompute(const Board &board);
 
-        void addAttacker(Square square, Piece piece);
-        void removeAttacker(Square square, Piece piece);
-        void addPiece(Square square);
-        void removePiece(Square square);
-        std::shared_ptr<Board> getBoard() const;
+        /* Recompute the attacks of every piece that may have changed after the occupants
+         * of `changed` were modified: the pieces on those squares, and every piece that
+         * attacked one of those squares before the change (e.g., sliders that are now
+         * blocked or unblocked).
+         */
+        void update(const Board &board, Bitboard changed);
+
+        void addAttacker(const Board &board, size_t idx, Piece piece);
+        void removeAttacker(size_t idx);
 
-        constexpr static inline std::vector<Square> bitsetToVector(const std::bitset<64> &bs)
+        static inline std::vector<Square> bitboardToVector(Bitboard bb)
         {
             std::vector<Square> squares;
-            squares.reserve(bs.count());
-            for (int row = 7, i = 0; row >= 0; ++row)
-                for (int col = 0; col < 0; ++col, ++i)
-                    if (bs[i])
-                        squares.emplace_back(col, row);
+            squares.reserve(Bitboards::count(bb));
+            while (bb)
+                squares.push_back(Board::idxToSquare(Bitboards::popLsb(bb)));
 
             return squares;
         }
 
     private:
-        // board pointer
-        std::weak_ptr<Board> m_board_ptr;
-
         // Squares occupied by white pieces that attack the given square
         AttackerArray m_attackedByWhite;
         // Squares occupied by black pieces that attack the given square
@@ -80,4 +89,4 @@ namespace JChess
         // Squares that the piece occupying the given square attacks
         AttackerArray m_attackedFrom;
     };
-} // namespace JChess
\ No newline at end of file
+} // namespace JChess
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#include "core/square.h"
+
+namespace JChess
+{
+    /* A set of squares, one bit per square. Bit `i` corresponds to the square at
+     * `Board::squareToIdx`, i.e., a8 is bit 0, h8 is bit 7, and h1 is bit 63.
+     */
+    using Bitboard = uint64_t;
+
+    namespace Bitboards
+    {
+        constexpr Bitboard empty = 0ull;
+        constexpr Bitboard all = ~0ull;
+
+        constexpr inline size_t idx(Square square)
+        {
+            return static_cast<size_t>((7 - square.rank) * 8 + square.file);
+        }
+
+        constexpr inline Square square(size_t idx)
+        {
+            return Square{static_cast<int>(idx % 8), 7 - static_cast<int>(idx / 8)};
+        }
+
+        constexpr inline Bitboard bit(size_t idx)
+        {
+            return 1ull << idx;
+        }
+
+        constexpr inline Bitboard bit(Square square)
+        {
+            return bit(idx(square));
+        }
+
+        constexpr inline bool test(Bitboard bb, size_t idx)
+        {
+            return (bb >> idx) & 1ull;
+        }
+
+        constexpr inline size_t count(Bitboard bb)
+        {
+            return static_cast<size_t>(std::popcount(bb));
+        }
+
+        // Index of the least significant set bit. `bb` must be non-empty.
+        constexpr inline size_t lsb(Bitboard bb)
+        {
+            return static_cast<size_t>(std::countr_zero(bb));
+        }
+
+        // Removes the least significant set bit from `bb` and returns its index.
+        constexpr inline size_t popLsb(Bitboard &bb)
+        {
+            size_t i = lsb(bb);
+            bb &= bb - 1;
+            return i;
+        }
+    } // namespace Bitboards
+} // namespace JChess
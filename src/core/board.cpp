@@ -1,6 +1,5 @@
 #include "core/board.h"
 
-#include <algorithm>
 #include <ranges>
 #include <sstream>
 #include <stdexcept>
@@ -24,7 +23,7 @@ namespace JChess
             {
             case 0:
                 piece = std::get<Piece>(p);
-                m_arr[i++] = piece;
+                place(i++, piece);
                 ++col;
 
                 if (piece.type == PieceType::King)
@@ -85,33 +84,53 @@ namespace JChess
         }
     }
 
-    Occupant Board::get(Square square) const
+    Board::Board(const std::array<Occupant, 64> &occupants)
     {
-        return m_arr[squareToIdx(square)];
+        for (size_t i = 0; i < 64; ++i)
+            if (occupants[i])
+                place(i, occupants[i].value());
     }
 
     Occupant Board::put(Square square, Piece piece)
     {
-        auto oldPiece = m_arr[squareToIdx(square)];
-        m_arr[squareToIdx(square)] = piece;
+        auto idx = squareToIdx(square);
+        auto oldPiece = m_arr[idx];
+        if (oldPiece)
+            clear(idx, oldPiece.value());
+        place(idx, piece);
         return oldPiece;
     }
 
     Occupant Board::remove(Square square)
     {
-        auto p = get(square);
-        m_arr[squareToIdx(square)] = std::nullopt;
+        auto idx = squareToIdx(square);
+        auto p = m_arr[idx];
+        if (p)
+            clear(idx, p.value());
         return p;
     }
 
+    void Board::place(size_t idx, Piece piece)
+    {
+        m_arr[idx] = piece;
+        m_pieces[pieceIdx(piece)] |= Bitboards::bit(idx);
+        m_colors[static_cast<size_t>(piece.color)] |= Bitboards::bit(idx);
+    }
+
+    void Board::clear(size_t idx, Piece piece)
+    {
+        m_arr[idx] = std::nullopt;
+        m_pieces[pieceIdx(piece)] &= ~Bitboards::bit(idx);
+        m_colors[static_cast<size_t>(piece.color)] &= ~Bitboards::bit(idx);
+    }
+
     Square Board::kingSquare(Color color) const
     {
-        auto it = std::find(m_arr.begin(), m_arr.end(), Piece{color, PieceType::King});
-        if (it == m_arr.end())
+        auto kings = pieces(color, PieceType::King);
+        if (!kings)
             throw std::runtime_error("Could not locate king");
 
-        size_t idx = static_cast<size_t>(it - m_arr.begin());
-        return idxToSquare(idx);
+        return idxToSquare(Bitboards::lsb(kings));
     }
 
     bool Board::canMoveTo(Color movingColor, Square to) const
@@ -126,7 +145,7 @@ namespace JChess
         return (occ && occ.value().color != movingColor);
     }
 
-    bool betweenSquares(Square test, Square start, Square end)
+    bool Board::betweenSquares(Square test, Square start, Square end)
     {
         Offset dir1 = end - start;
         if (!dir1.isDiagonal() && !dir1.isLateral())
@@ -176,6 +195,7 @@ namespace JChess
                 {
                     if (num_empty)
                         fenstr += static_cast<char>('0' + num_empty);
+                    num_empty = 0;
                     fenstr += FEN::pieceToChar(m_arr[i].value());
                 }
                 else
@@ -210,17 +230,6 @@ namespace JChess
         return m_arr;
     }
 
-    size_t Board::squareToIdx(Square square)
-    {
-        return static_cast<size_t>((7 - square.rank) * 8 + square.file);
-    }
-
-    Square Board::idxToSquare(size_t idx)
-    {
-        int q = idx / 8, r = idx % 8;
-        return Square{r, 7 - q};
-    }
-
     bool Board::valid(Square square)
     {
         return 0 <= square.file &&
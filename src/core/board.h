@@ -7,6 +7,7 @@
 #include <string_view>
 #include <vector>
 
+#include "core/bitboard.h"
 #include "core/castling.h"
 #include "core/color.h"
 #include "core/offset.h"
@@ -19,15 +20,26 @@ namespace JChess
 {
     using Occupant = std::optional<Piece>;
 
+    /* Piece placement, stored both as a mailbox (for O(1) `get`) and as one bitboard
+     * per colored piece type plus one occupancy bitboard per color (for set operations).
+     * Every mutation goes through `put`/`remove`, which keep the two in sync.
+     */
     class Board
     {
     public:
         explicit Board(std::string_view fenString = FEN::startpos);
+        // From a mailbox indexed by `squareToIdx`, trusted to hold a valid position
+        explicit Board(const std::array<Occupant, 64> &occupants);
         Occupant get(Square square) const;
         Occupant put(Square square, Piece piece);
         Occupant remove(Square square);
         Square kingSquare(Color color) const;
 
+        Bitboard pieces(Color color, PieceType type) const;
+        Bitboard pieces(PieceType type) const;
+        Bitboard pieces(Color color) const;
+        Bitboard occupied() const;
+
         bool canMoveTo(Color movingColor, Square to) const;
         bool pawnCanCapture(Color movingColor, Square to) const;
 
@@ -43,8 +55,8 @@ namespace JChess
         static std::array<Square, 64> eachSquare();
 
         static bool valid(Square square);
-        static size_t squareToIdx(Square square);
-        static Square idxToSquare(size_t idx);
+        static constexpr size_t squareToIdx(Square square) { return Bitboards::idx(square); }
+        static constexpr Square idxToSquare(size_t idx) { return Bitboards::square(idx); }
         static int homeRank(Color color);
         static bool betweenSquares(Square test, Square start, Square end);
 
@@ -55,7 +67,45 @@ namespace JChess
         static Square rookToSquare(Color color, Castling::Side side);
         static Square kingToSquare(Color color, Castling::Side side);
 
+    private:
+        static constexpr size_t pieceIdx(Piece piece)
+        {
+            return static_cast<size_t>(piece.color) * 6 + static_cast<size_t>(piece.type);
+        }
+
+        void place(size_t idx, Piece piece);
+        void clear(size_t idx, Piece piece);
+
     private:
         std::array<Occupant, 64> m_arr;
+        // Indexed by `pieceIdx`, i.e., color-major, then `PieceType`
+        std::array<Bitboard, 12> m_pieces{};
+        // Indexed by `Color`
+        std::array<Bitboard, 2> m_colors{};
     };
+
+    inline Occupant Board::get(Square square) const
+    {
+        return m_arr[squareToIdx(square)];
+    }
+
+    inline Bitboard Board::pieces(Color color, PieceType type) const
+    {
+        return m_pieces[pieceIdx(Piece{color, type})];
+    }
+
+    inline Bitboard Board::pieces(PieceType type) const
+    {
+        return pieces(Color::White, type) | pieces(Color::Black, type);
+    }
+
+    inline Bitboard Board::pieces(Color color) const
+    {
+        return m_colors[static_cast<size_t>(color)];
+    }
+
+    inline Bitboard Board::occupied() const
+    {
+        return m_colors[0] | m_colors[1];
+    }
 } // namespace JChess
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace JChess
+{
+    /* A queue between threads, any number on either side, that holds at most `capacity`
+     * items: `push` waits while it is full, so a slow consumer holds back its producers
+     * rather than letting memory pile up, and `pop` waits while it is empty.
+     *
+     * `close` ends the queue: pushes fail from then on, and pops return what is left and then
+     * nothing. The items are expected to be large batches, so a lock per item costs nothing.
+     */
+    template <class T>
+    class BoundedQueue
+    {
+    public:
+        explicit BoundedQueue(size_t capacity) : m_capacity(capacity ? capacity : 1) {}
+
+        BoundedQueue(const BoundedQueue &) = delete;
+        BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+        // Waits for room; false, dropping `item`, if the queue is closed
+        bool push(T item)
+        {
+            {
+                std::unique_lock lock{m_mutex};
+                m_notFull.wait(lock, [this] { return m_closed || m_items.size() < m_capacity; });
+                if (m_closed)
+                    return false;
+                m_items.push_back(std::move(item));
+            }
+            m_notEmpty.notify_one();
+            return true;
+        }
+
+        // Waits for an item; nothing once the queue is closed and empty
+        std::optional<T> pop()
+        {
+            std::optional<T> item;
+            {
+                std::unique_lock lock{m_mutex};
+                m_notEmpty.wait(lock, [this] { return m_closed || !m_items.empty(); });
+                if (m_items.empty())
+                    return item;
+                item.emplace(std::move(m_items.front()));
+                m_items.pop_front();
+            }
+            m_notFull.notify_one();
+            return item;
+        }
+
+        void close()
+        {
+            {
+                std::lock_guard lock{m_mutex};
+                m_closed = true;
+            }
+            m_notFull.notify_all();
+            m_notEmpty.notify_all();
+        }
+
+        // Items waiting, which may have changed by the time it returns
+        size_t size() const
+        {
+            std::lock_guard lock{m_mutex};
+            return m_items.size();
+        }
+        size_t capacity() const { return m_capacity; }
+
+    private:
+        const size_t m_capacity;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_notFull;
+        std::condition_variable m_notEmpty;
+        std::deque<T> m_items;
+        bool m_closed = false;
+    };
+} // namespace JChess
@@ -28,6 +28,11 @@ namespace JChess::Castling
             for (const auto &c : fenStringRights)
                 m_rights[FEN::charToCastleIdx(c)] = true;
         }
+        // In the order K, Q, k, q
+        explicit constexpr Rights(const std::array<bool, 4> &rights)
+            : m_rights(rights)
+        {
+        }
         constexpr void reset(bool val = true)
         {
             m_rights.fill(val);
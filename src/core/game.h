@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "annotation/annotation.h"
+#include "annotation/evaluation.h"
+#include "annotation/time.h"
+#include "core/move.h"
+
+namespace JChess
+{
+    struct GameResult
+    {
+        // In the order used by the database's `winner` column
+        enum class Type : uint8_t
+        {
+            WhiteWins,
+            BlackWins,
+            Draw,
+            None,
+        };
+
+        // In the order used by the database's `condition` column
+        enum class Reason : uint8_t
+        {
+            None,
+            Checkmate,
+            Timeout,
+            Resignation,
+            RulesInfraction,
+            Stalemate,
+            Agreement,
+            InsufficientMaterial,
+        };
+
+        Type type = Type::None;
+        Reason reason = Reason::None;
+    };
+
+    /* A game with its metadata, as read from PGN or the binary formats. The annotations, when
+     * present, have one entry per move.
+     */
+    struct Game
+    {
+        std::string whiteUsername;
+        std::string blackUsername;
+        GameResult result;
+        std::chrono::sys_seconds datetime{}; // UTC
+        uint16_t whiteELO = 0;
+        uint16_t blackELO = 0;
+        std::string ECOCode;
+        TimeControl timeControl{};
+        // Empty for the standard starting position
+        std::string startFEN;
+
+        std::vector<Move> moves;
+        std::optional<std::vector<Evaluation>> evaluations;
+        std::optional<std::vector<msDuration>> clocks;
+        std::optional<std::vector<Annotation>> annotations;
+    };
+} // namespace JChess
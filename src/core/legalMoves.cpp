@@ -1,351 +1,360 @@
 #include "core/legalMoves.h"
 
-#include <algorithm>
-#include <ranges>
+#include <array>
 #include <utility>
 
+#include "core/attackTables.h"
 #include "core/attacks.h"
+#include "core/bitboard.h"
 #include "core/offset.h"
 
 namespace JChess
 {
+    constexpr std::array<PieceType, 4> promotionTypes{
+        PieceType::Knight,
+        PieceType::Bishop,
+        PieceType::Rook,
+        PieceType::Queen,
+    };
+
     bool castleIsLegal(const State &state, Castling::Side side)
     {
         if (!state.castleRights.get(state.turn, side))
             return false;
 
-        Square midSquare = Board::rookToSquare(state.turn, side);
-
-        if (state.attacks.numAttackers(midSquare, oppositeColor(state.turn)) > 0)
+        const auto &board = state.board;
+        Square kingFrom{4, Board::homeRank(state.turn)};
+        Square rookFrom = Board::rookFromSquare(state.turn, side);
+        if (board.get(kingFrom) != Piece{state.turn, PieceType::King} ||
+            board.get(rookFrom) != Piece{state.turn, PieceType::Rook})
             return false;
 
+        auto kingIdx = Board::squareToIdx(kingFrom);
+
         // check that each square between king and rook is empty
-        int file1 = (side == Castling::Side::QUEEN) ? 1 : 5,
-            file2 = (side == Castling::Side::QUEEN) ? 3 : 6;
-        for (auto file = file1; file <= file2; ++file)
-            if (state.board.get(Square{file, midSquare.rank}))
+        if (AttackTables::between(kingIdx, Board::squareToIdx(rookFrom)) & board.occupied())
+            return false;
+
+        // check that the king does not pass through or land on an attacked square
+        Square kingTo = Board::kingToSquare(state.turn, side);
+        Bitboard kingPath = AttackTables::between(kingIdx, Board::squareToIdx(kingTo)) | Bitboards::bit(kingTo);
+        Color oppColor = oppositeColor(state.turn);
+        while (kingPath)
+            if (state.attacks.isAttacked(Board::idxToSquare(Bitboards::popLsb(kingPath)), oppColor))
                 return false;
 
         return true;
     }
 
-    bool epCatureResultsInCheck(Square from, const State &state, Square kingSq)
+    /* Capturing en passant removes two pawns from the same rank at once, so it can expose
+     * the king to a rook or queen along that rank (or a bishop along a diagonal through the
+     * captured pawn) even when neither pawn is pinned on its own. Replay the occupancy and
+     * look for any remaining attacker of the king.
+     */
+    bool epCaptureIsLegal(const State &state, size_t from, size_t kingIdx)
     {
-        if (from.rank != kingSq.rank)
-            return false;
-
-        Square epPawn{state.enPassant.value().file, from.rank};
-        int dir = (kingSq.file < epPawn.file) ? 1 : -1;
-
-        auto file = kingSq.file;
-        file += dir;
-        while (file != epPawn.file && file != from.file)
-        {
-            if (state.board.get(Square{file, from.rank}))
-                return false;
-            file += dir;
-        }
+        const auto &board = state.board;
+        Square epSquare = state.enPassant.value();
+        Square capturedSq = epSquare + Offsets::backward(state.turn);
 
-        file += dir;
+        Bitboard occupied = (board.occupied() ^ Bitboards::bit(from) ^ Bitboards::bit(capturedSq)) |
+                            Bitboards::bit(epSquare);
+        Bitboard remainingEnemies = board.pieces(oppositeColor(state.turn)) & ~Bitboards::bit(capturedSq);
 
-        Occupant occ;
-        while (0 < file && file < 7)
-        {
-            file += dir;
-            occ = state.board.get(Square{file, from.rank});
-            if (occ)
-                break;
-        }
-        if (!occ)
-            return false;
-        Piece piece = occ.value();
-        return (piece.color != state.turn &&
-                (piece.type == PieceType::Queen ||
-                 piece.type == PieceType::Rook));
+        return !(Attacks::attackersTo(board, kingIdx, occupied) & remainingEnemies);
     }
 
     std::optional<Square> getHardPin(const State &state, Square testSquare, Square kingSq)
     {
-        auto pinDirection = kingSq - testSquare;
-        if (!pinDirection.norm())
-            return {};
-
-        auto pathToPin = state.board.getPath(testSquare, -pinDirection, true);
-        if (pathToPin.empty())
-            return {};
-
-        auto pinSquare = pathToPin.back();
+        auto kingIdx = Board::squareToIdx(kingSq);
+        auto testIdx = Board::squareToIdx(testSquare);
+        const auto &board = state.board;
 
-        auto occupant = state.board.get(pinSquare);
-        if (!occupant || occupant.value().color == state.turn)
+        if (!AttackTables::line(kingIdx, testIdx) ||
+            (AttackTables::between(kingIdx, testIdx) & board.occupied()))
             return {};
 
-        Piece piece = occupant.value();
+        Color oppColor = oppositeColor(state.turn);
+        Bitboard occupied = board.occupied() ^ Bitboards::bit(testIdx);
+        Bitboard snipers;
+        if (AttackTables::rookAttacks(kingIdx, Bitboards::empty) & Bitboards::bit(testIdx))
+            snipers = AttackTables::rookAttacks(kingIdx, occupied) &
+                      (board.pieces(oppColor, PieceType::Rook) | board.pieces(oppColor, PieceType::Queen));
+        else
+            snipers = AttackTables::bishopAttacks(kingIdx, occupied) &
+                      (board.pieces(oppColor, PieceType::Bishop) | board.pieces(oppColor, PieceType::Queen));
 
-        if (piece.type == PieceType::Queen ||
-            (piece.type == PieceType::Bishop && pinDirection.isDiagonal()) ||
-            (piece.type == PieceType::Rook && pinDirection.isLateral()))
-            return pinSquare;
+        while (snipers)
+        {
+            auto sniper = Bitboards::popLsb(snipers);
+            if (AttackTables::between(kingIdx, sniper) & Bitboards::bit(testIdx))
+                return Board::idxToSquare(sniper);
+        }
 
         return {};
     }
 
-    /* This is a complex function, but I'm hoping to do branching at compile time as much as possible.
-     * In general, a pawn can move one square forward if the space is empty, or capture one square to
-     * either foward diagonal. If it is on its starting rank, it can additionally move two squares forward
-     * if both are empty. If it is able to promote, each promotion piece is a separate move, and it can
-     * capture to promote as well. If it is able to capture en passant, that square must be capturable despite
-     * being empty.
-     */
-    template <Color color>
-    std::vector<Move> candidatePawnMoves(const State &state, Square from, Square kingSq)
+    // Pieces of the side to move that cannot leave the line between their king and an
+    // enemy slider
+    Bitboard pinnedPieces(const State &state, size_t kingIdx)
     {
-        std::vector<Move> moves{};
-        constexpr Color oppColor = oppositeColor(color);
-        constexpr Piece pawn{color, PieceType::Pawn};
-        constexpr int pawnStartRank = static_cast<int>(color) * 5 + 1;
-        constexpr int pawnToPromoteRank = static_cast<int>(color) * -5 + 6;
-        constexpr int pawnToEPRank = static_cast<int>(color) * -1 + 4;
-
-        Square oneForward = from + Offsets::forward(color);
-        Square attackLeft = oneForward + Offset{-1, 0};
-        Square attackRight = oneForward + Offset{1, 0};
-
-        bool canCaptureEnPassant = (state.enPassant) &&
-                                   (from.rank == pawnToEPRank) &&
-                                   (abs(from.file - state.enPassant.value().file) == 1);
-
-        if (from.rank == pawnToPromoteRank)
+        const auto &board = state.board;
+        Color oppColor = oppositeColor(state.turn);
+        Bitboard snipers =
+            (AttackTables::rookAttacks(kingIdx, Bitboards::empty) &
+             (board.pieces(oppColor, PieceType::Rook) | board.pieces(oppColor, PieceType::Queen))) |
+            (AttackTables::bishopAttacks(kingIdx, Bitboards::empty) &
+             (board.pieces(oppColor, PieceType::Bishop) | board.pieces(oppColor, PieceType::Queen)));
+
+        Bitboard pinned = Bitboards::empty;
+        while (snipers)
         {
-            moves.reserve(12);
-
-            constexpr Piece knight{color, PieceType::Knight};
-            constexpr Piece bishop{color, PieceType::Bishop};
-            constexpr Piece rook{color, PieceType::Rook};
-            constexpr Piece queen{color, PieceType::Queen};
+            Bitboard blockers = AttackTables::between(kingIdx, Bitboards::popLsb(snipers)) & board.occupied();
+            if (Bitboards::count(blockers) == 1)
+                pinned |= blockers & board.pieces(state.turn);
+        }
+        return pinned;
+    }
 
-            if (!state.board.get(oneForward))
+    namespace
+    {
+        enum class Stage
+        {
+            All,
+            Captures, // captures, en passant and every promotion
+            Quiets,   // everything else, including castling
+        };
+
+        /* Generate the legal moves of one stage, passing each to `emit`, which returns false
+         * to stop early. Returns false if it was stopped. The checkers, pins and check mask
+         * are computed once and shared by every piece.
+         */
+        template <Stage stage, class Emit>
+        bool generate(const State &state, Emit &&emit)
+        {
+            constexpr bool captures = stage != Stage::Quiets;
+            constexpr bool quiets = stage != Stage::Captures;
+
+            const auto &board = state.board;
+            Color turnColor = state.turn;
+            Color oppColor = oppositeColor(turnColor);
+            Bitboard own = board.pieces(turnColor);
+            Bitboard enemies = board.pieces(oppColor);
+
+            Square kingSq = board.kingSquare(turnColor);
+            auto kingIdx = Board::squareToIdx(kingSq);
+
+            // The squares a non-pawn move of this stage may land on
+            Bitboard stageMask = ~own;
+            if constexpr (stage == Stage::Captures)
+                stageMask = enemies;
+            else if constexpr (stage == Stage::Quiets)
+                stageMask = ~board.occupied();
+
+            auto emitAll = [&](size_t from, Bitboard toSquares)
             {
-                moves.push_back({.piece = pawn, .from = from, .to = oneForward, .promotion = knight});
-                moves.push_back({.piece = pawn, .from = from, .to = oneForward, .promotion = bishop});
-                moves.push_back({.piece = pawn, .from = from, .to = oneForward, .promotion = rook});
-                moves.push_back({.piece = pawn, .from = from, .to = oneForward, .promotion = queen});
-            }
-            if (from.file != 0 && state.board.pawnCanCapture(color, attackLeft))
+                while (toSquares)
+                {
+                    auto to = Bitboards::popLsb(toSquares);
+                    if (!emit(PackedMove{from, to, Bitboards::test(enemies, to) ? PackedMove::Capture : PackedMove::Quiet}))
+                        return false;
+                }
+                return true;
+            };
+
+            auto emitPromotions = [&](size_t from, Bitboard toSquares)
             {
-                moves.push_back({
-                    .piece = pawn,
-                    .from = from,
-                    .to = attackLeft,
-                    .promotion = knight,
-                    .capture = state.board.get(attackLeft),
-                });
-                moves.push_back({
-                    .piece = pawn,
-                    .from = from,
-                    .to = attackLeft,
-                    .promotion = bishop,
-                    .capture = state.board.get(attackLeft),
-                });
-                moves.push_back({
-                    .piece = pawn,
-                    .from = from,
-                    .to = attackLeft,
-                    .promotion = rook,
-                    .capture = state.board.get(attackLeft),
-                });
-                moves.push_back({
-                    .piece = pawn,
-                    .from = from,
-                    .to = attackLeft,
-                    .promotion = queen,
-                    .capture = state.board.get(attackLeft),
-                });
-            }
-            if (from.file != 7 && state.board.pawnCanCapture(color, attackRight))
+                while (toSquares)
+                {
+                    auto to = Bitboards::popLsb(toSquares);
+                    uint16_t flags = Bitboards::test(enemies, to) ? PackedMove::PromotionCapture : PackedMove::Promotion;
+                    for (auto type : promotionTypes)
+                        if (!emit(PackedMove{from, to, static_cast<uint16_t>(flags | (static_cast<int>(type) - static_cast<int>(PieceType::Knight)))}))
+                            return false;
+                }
+                return true;
+            };
+
+            Bitboard checkers = state.attacks.attackers(kingSq, oppColor);
+
+            // The king may not step along the line of a slider checking it, so test each target
+            // with the king lifted off the board
+            Bitboard occupiedWithoutKing = board.occupied() ^ Bitboards::bit(kingIdx);
+            Bitboard toSquares = AttackTables::kingAttacks(kingIdx) & stageMask;
+            while (toSquares)
             {
-                moves.push_back({
-                    .piece = pawn,
-                    .from = from,
-                    .to = attackRight,
-                    .promotion = knight,
-                    .capture = state.board.get(attackRight),
-                });
-                moves.push_back({
-                    .piece = pawn,
-                    .from = from,
-                    .to = attackRight,
-                    .promotion = bishop,
-                    .capture = state.board.get(attackRight),
-                });
-                moves.push_back({
-                    .piece = pawn,
-                    .from = from,
-                    .to = attackRight,
-                    .promotion = rook,
-                    .capture = state.board.get(attackRight),
-                });
-                moves.push_back({
-                    .piece = pawn,
-                    .from = from,
-                    .to = attackRight,
-                    .promotion = queen,
-                    .capture = state.board.get(attackRight),
-                });
+                auto to = Bitboards::popLsb(toSquares);
+                if (!(Attacks::attackersTo(board, to, occupiedWithoutKing) & enemies) &&
+                    !emitAll(kingIdx, Bitboards::bit(to)))
+                    return false;
             }
-        }
-        else if (from.rank == pawnStartRank)
-        {
-            moves.reserve(4);
-            Square twoForward = oneForward + Offsets::forward(color);
 
-            if (!state.board.get(oneForward))
+            if constexpr (quiets)
             {
-                moves.emplace_back(pawn, from, oneForward);
-                if (!state.board.get(twoForward))
-                    moves.emplace_back(pawn, from, twoForward);
+                if (!checkers) // castling moves
+                {
+                    if (castleIsLegal(state, Castling::Side::QUEEN) &&
+                        !emit(PackedMove{kingSq, Board::kingToSquare(turnColor, Castling::Side::QUEEN), PackedMove::QueenCastle}))
+                        return false;
+                    if (castleIsLegal(state, Castling::Side::KING) &&
+                        !emit(PackedMove{kingSq, Board::kingToSquare(turnColor, Castling::Side::KING), PackedMove::KingCastle}))
+                        return false;
+                }
             }
-            if (from.file != 0 && state.board.pawnCanCapture(color, attackLeft))
-                moves.push_back({
-                    .piece = pawn,
-                    .from = from,
-                    .to = attackLeft,
-                    .capture = state.board.get(attackLeft),
-                });
-            if (from.file != 7 && state.board.pawnCanCapture(color, attackRight))
-                moves.push_back({
-                    .piece = pawn,
-                    .from = from,
-                    .to = attackRight,
-                    .capture = state.board.get(attackRight),
-                });
-        }
-        else if (canCaptureEnPassant)
-        {
-            moves.reserve(3);
-            Square epAttack = state.enPassant.value();
-            Square otherAttack = Square{2 * from.file - epAttack.file, epAttack.rank};
-
-            if (!state.board.get(oneForward))
-                moves.emplace_back(pawn, from, oneForward);
-            if (!epCatureResultsInCheck(from, state, kingSq))
-                moves.push_back({
-                    .piece = pawn,
-                    .from = from,
-                    .to = epAttack,
-                    .enPassant = true,
-                    .capture = Piece{oppColor, PieceType::Pawn},
-                });
-            if (0 <= otherAttack.file && otherAttack.file <= 7 && state.board.pawnCanCapture(color, otherAttack))
-                moves.push_back({
-                    .piece = pawn,
-                    .from = from,
-                    .to = otherAttack,
-                    .capture = state.board.get(otherAttack),
-                });
-        }
-        else
-        {
-            moves.reserve(3);
-
-            if (!state.board.get(oneForward))
-                moves.emplace_back(pawn, from, oneForward);
-            if (from.file != 0 && state.board.pawnCanCapture(color, attackLeft))
-                moves.push_back({
-                    .piece = pawn,
-                    .from = from,
-                    .to = attackLeft,
-                    .capture = state.board.get(attackLeft),
-                });
-            if (from.file != 7 && state.board.pawnCanCapture(color, attackRight))
-                moves.push_back({
-                    .piece = pawn,
-                    .from = from,
-                    .to = attackRight,
-                    .capture = state.board.get(attackRight),
-                });
-        }
 
-        return moves;
-    }
+            if (Bitboards::count(checkers) > 1)
+                return true;
 
-    template <>
-    std::vector<Move> candidatePawnMoves<Color::White>(const State &, Square, Square);
-    template <>
-    std::vector<Move> candidatePawnMoves<Color::Black>(const State &, Square, Square);
+            // With one checker, other pieces must capture it or block the line to the king
+            Bitboard targetMask = ~own;
+            if (checkers)
+                targetMask &= checkers | AttackTables::between(kingIdx, Bitboards::lsb(checkers));
 
-    std::vector<Move> legalMoves(const State &state)
-    {
-        std::vector<Move> moves{};
-        const auto &board = state.board;
-        Color turnColor = state.turn;
-        Color oppColor = oppositeColor(turnColor);
+            Bitboard pinned = pinnedPieces(state, kingIdx);
 
-        Piece king{turnColor, PieceType::King};
-        Square kingSq = board.kingSquare(turnColor);
+            for (auto type : {PieceType::Knight, PieceType::Bishop, PieceType::Rook, PieceType::Queen})
+            {
+                Bitboard movers = board.pieces(turnColor, type);
+                while (movers)
+                {
+                    auto from = Bitboards::popLsb(movers);
+                    toSquares = state.attacks.attackedBy(Board::idxToSquare(from)) & targetMask & stageMask;
+                    if (pinned & Bitboards::bit(from))
+                        toSquares &= AttackTables::line(kingIdx, from);
+
+                    if (!emitAll(from, toSquares))
+                        return false;
+                }
+            }
 
-        auto numCheckers = state.attacks.numAttackers(kingSq, oppColor);
-        bool inCheck = numCheckers >= 1;
+            /* In general, a pawn can move one square forward if the space is empty, or capture one square to
+             * either foward diagonal. If it is on its starting rank, it can additionally move two squares forward
+             * if both are empty. If it is able to promote, each promotion piece is a separate move, and it can
+             * capture to promote as well. If it is able to capture en passant, that square must be capturable despite
+             * being empty.
+             */
+            int pawnStartRank = static_cast<int>(turnColor) * 5 + 1;
+            int promotionRank = static_cast<int>(turnColor) * -7 + 7;
+            Bitboard movers = board.pieces(turnColor, PieceType::Pawn);
+            while (movers)
+            {
+                auto from = Bitboards::popLsb(movers);
+                Square fromSq = Board::idxToSquare(from);
+
+                Bitboard allowed = targetMask;
+                if (pinned & Bitboards::bit(from))
+                    allowed &= AttackTables::line(kingIdx, from);
+
+                Bitboard pawnCaptures = AttackTables::pawnAttacks(turnColor, from) & enemies & allowed;
+                Square oneForward = fromSq + Offsets::forward(turnColor);
+                Bitboard push = Bitboards::empty, doublePush = Bitboards::empty;
+                if (!board.get(oneForward))
+                {
+                    push = Bitboards::bit(oneForward);
+                    Square twoForward = oneForward + Offsets::forward(turnColor);
+                    if (fromSq.rank == pawnStartRank && !board.get(twoForward))
+                        doublePush = Bitboards::bit(twoForward);
+                }
+                push &= allowed;
+                doublePush &= allowed;
+
+                if (oneForward.rank == promotionRank)
+                {
+                    if constexpr (captures)
+                        if (!emitPromotions(from, pawnCaptures | push))
+                            return false;
+                }
+                else
+                {
+                    if constexpr (captures)
+                        if (!emitAll(from, pawnCaptures))
+                            return false;
+                    if constexpr (quiets)
+                    {
+                        if (!emitAll(from, push))
+                            return false;
+                        if (doublePush && !emit(PackedMove{from, Bitboards::lsb(doublePush), PackedMove::DoublePush}))
+                            return false;
+                    }
+                }
+
+                if constexpr (captures)
+                {
+                    if (state.enPassant &&
+                        (AttackTables::pawnAttacks(turnColor, from) & Bitboards::bit(state.enPassant.value())) &&
+                        epCaptureIsLegal(state, from, kingIdx) &&
+                        !emit(PackedMove{fromSq, state.enPassant.value(), PackedMove::EnPassant}))
+                        return false;
+                }
+            }
 
-        std::vector<Square> toSquares = state.attacks.squaresAttackedBy(kingSq);
-        for (const auto &to : toSquares)
-            if (state.attacks.numAttackers(to, oppColor) == 0 &&
-                board.canMoveTo(turnColor, to))
-                moves.push_back({.piece = king, .from = kingSq, .to = to, .capture = board.get(to)});
+            return true;
+        }
 
-        if (!inCheck) // castling moves
+        template <Stage stage>
+        void generateInto(const State &state, MoveList &moves)
         {
-            if (castleIsLegal(state, Castling::Side::QUEEN))
-                moves.push_back({.piece = king,
-                                 .from = kingSq,
-                                 .to = board.kingToSquare(turnColor, Castling::Side::QUEEN),
-                                 .castle = Castling::Side::QUEEN});
-            if (castleIsLegal(state, Castling::Side::KING))
-                moves.push_back({.piece = king,
-                                 .from = kingSq,
-                                 .to = board.kingToSquare(turnColor, Castling::Side::KING),
-                                 .castle = Castling::Side::KING});
+            moves.clear();
+            auto append = [&moves](PackedMove move)
+            {
+                moves.push_back(move);
+                return true;
+            };
+            generate<stage>(state, append);
         }
+    } // namespace
 
-        if (numCheckers > 1)
-            return moves;
+    void legalMoves(const State &state, MoveList &moves)
+    {
+        generateInto<Stage::All>(state, moves);
+    }
 
-        std::optional<Square> checker{
-            (numCheckers == 0) ? std::nullopt
-                               : std::make_optional(state.attacks.squaresAttacking(kingSq, oppColor)[0])};
+    void legalCaptures(const State &state, MoveList &moves)
+    {
+        generateInto<Stage::Captures>(state, moves);
+    }
 
-        for (const auto &[square, occupant] : std::views::zip(board.eachSquare(), board.eachOccupant()))
-        {
-            if (!occupant || occupant.value().color != turnColor || occupant.value().type == PieceType::King)
-                continue;
+    void legalQuiets(const State &state, MoveList &moves)
+    {
+        generateInto<Stage::Quiets>(state, moves);
+    }
 
-            Piece piece = occupant.value();
+    void legalEvasions(const State &state, MoveList &moves)
+    {
+        moves.clear();
+        if (inCheck(state))
+            generateInto<Stage::All>(state, moves);
+    }
 
-            auto hardPin = getHardPin(state, square, kingSq);
+    bool inCheck(const State &state)
+    {
+        return state.attacks.isAttacked(state.board.kingSquare(state.turn), oppositeColor(state.turn));
+    }
 
-            std::vector<Move> candidateMoves;
-            if (piece.type == PieceType::Pawn)
-            {
-                if (turnColor == Color::White)
-                    candidatePawnMoves<Color::White>(state, square, kingSq).swap(candidateMoves);
-                else
-                    candidatePawnMoves<Color::Black>(state, square, kingSq).swap(candidateMoves);
-            }
-            else
-            {
-                toSquares = state.attacks.squaresAttackedBy(square);
-                candidateMoves.reserve(toSquares.size());
-                for (const auto &to : toSquares)
-                    if (board.canMoveTo(turnColor, to))
-                        candidateMoves.push_back({.piece = piece, .from = square, .to = to, .capture = board.get(to)});
-            }
+    bool hasAnyLegalMove(const State &state)
+    {
+        auto stopAtFirst = [](PackedMove)
+        {
+            return false;
+        };
+        return !generate<Stage::All>(state, stopAtFirst);
+    }
 
-            for (const auto &move : candidateMoves)
-                if ((!checker || Board::betweenSquares(move.to, checker.value(), kingSq)) &&
-                    (!hardPin || Board::betweenSquares(move.to, hardPin.value(), kingSq)))
-                    moves.push_back(move);
-        }
+    std::vector<PackedMove> legalPackedMoves(const State &state)
+    {
+        MoveList list;
+        legalMoves(state, list);
+        return {list.begin(), list.end()};
+    }
 
+    std::vector<Move> legalMoves(const State &state)
+    {
+        MoveList list;
+        legalMoves(state, list);
+        std::vector<Move> moves;
+        moves.reserve(list.size());
+        for (auto move : list)
+            moves.push_back(move.unpack(state.board));
         return moves;
     }
 } // namespace JChess
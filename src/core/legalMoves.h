@@ -4,11 +4,43 @@
 #include <vector>
 
 #include "core/move.h"
+#include "core/moveList.h"
+#include "core/packedMove.h"
 #include "core/square.h"
 #include "core/state.h"
 
 namespace JChess
 {
     std::optional<Square> getHardPin(const State &state, Square testSquare, Square kingSq);
+
+    /* Write the legal moves in the given state into `moves`, replacing its contents.
+     * Allocates nothing; this is the generator that the overloads below wrap.
+     */
+    void legalMoves(const State &state, MoveList &moves);
+
+    /* Staged generation: the same moves as `legalMoves`, split into captures (including en
+     * passant) together with every promotion, and the remaining quiet moves (including
+     * castling). Together they produce exactly the legal moves.
+     */
+    void legalCaptures(const State &state, MoveList &moves);
+    void legalQuiets(const State &state, MoveList &moves);
+
+    /* The legal moves when the side to move is in check, and none otherwise.
+     */
+    void legalEvasions(const State &state, MoveList &moves);
+
+    bool inCheck(const State &state);
+
+    /* Whether the side to move has any legal move, stopping at the first one found. With
+     * `inCheck`, distinguishes checkmate and stalemate without generating every move.
+     */
+    bool hasAnyLegalMove(const State &state);
+
+    /* The legal moves in the given state, in the encoding used for generation and storage.
+     */
+    std::vector<PackedMove> legalPackedMoves(const State &state);
+
+    /* The same moves, unpacked into full `Move`s (moving piece, captured piece and so on).
+     */
     std::vector<Move> legalMoves(const State &state);
 } // namespace JChess
\ No newline at end of file
@@ -0,0 +1,12 @@
+#include "core/move.h"
+
+#include "core/packedMove.h"
+
+namespace JChess
+{
+    // The notation is defined once, on the packed encoding
+    std::string Move::toUCI() const
+    {
+        return PackedMove{*this}.toUCI();
+    }
+} // namespace JChess
@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <functional>
 #include <optional>
+#include <string>
 
 #include "core/castling.h"
 #include "core/piece.h"
@@ -27,5 +28,8 @@ namespace JChess
                    from == other.from &&
                    to == other.to;
         }
+
+        // Long algebraic notation as used by UCI, e.g., "e2e4" or "e7e8q"
+        std::string toUCI() const;
     };
 } // namespace JChess
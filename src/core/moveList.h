@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "core/packedMove.h"
+
+namespace JChess
+{
+    /* A fixed-capacity list of moves for move generation, meant to live on the stack so that
+     * generating moves never touches the heap. No legal chess position has more than 218
+     * moves, so 256 entries always suffice.
+     */
+    class MoveList
+    {
+    public:
+        static constexpr size_t capacity = 256;
+
+        constexpr void push_back(PackedMove move) { m_moves[m_size++] = move; }
+        template <class... Args>
+        constexpr void emplace_back(Args &&...args) { m_moves[m_size++] = PackedMove(args...); }
+        constexpr void clear() { m_size = 0; }
+
+        constexpr size_t size() const { return m_size; }
+        constexpr bool empty() const { return m_size == 0; }
+        constexpr PackedMove operator[](size_t i) const { return m_moves[i]; }
+
+        constexpr const PackedMove *begin() const { return m_moves.data(); }
+        constexpr const PackedMove *end() const { return m_moves.data() + m_size; }
+
+        constexpr bool contains(PackedMove move) const
+        {
+            for (auto m : *this)
+                if (m == move)
+                    return true;
+            return false;
+        }
+
+    private:
+        std::array<PackedMove, capacity> m_moves;
+        uint16_t m_size = 0;
+    };
+} // namespace JChess
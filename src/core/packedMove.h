@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "core/bitboard.h"
+#include "core/board.h"
+#include "core/castling.h"
+#include "core/color.h"
+#include "core/move.h"
+#include "core/piece.h"
+#include "core/square.h"
+
+#include "formats/fen.h"
+
+namespace JChess
+{
+    /* A move in 16 bits, the one encoding shared by move generation, the binary formats and
+     * the database blobs:
+     *
+     *   bits  0-5   from square (`Board::squareToIdx`, a8 = 0, h1 = 63)
+     *   bits  6-11  to square (the king's destination when castling)
+     *   bits 12-15  flags: 0 quiet, 1 double pawn push, 2 castle kingside, 3 castle queenside,
+     *               4 capture, 5 en passant capture, 8-11 promotion to N/B/R/Q,
+     *               12-15 capturing promotion to N/B/R/Q
+     *
+     * The moving and captured pieces are not stored: they are on the board the move is played
+     * on, and `unpack` recovers the full `Move` from it when needed. The all-zero value is
+     * never a legal move and serves as a null move.
+     */
+    class PackedMove
+    {
+    public:
+        enum Flags : uint16_t
+        {
+            Quiet = 0,
+            DoublePush = 1,
+            KingCastle = 2,
+            QueenCastle = 3,
+            Capture = 4,
+            EnPassant = 5,
+            Promotion = 8,
+            PromotionCapture = 12,
+        };
+
+        constexpr PackedMove() = default;
+        constexpr PackedMove(size_t from, size_t to, uint16_t flags)
+            : m_data(static_cast<uint16_t>(from | (to << 6) | (flags << 12)))
+        {
+        }
+        constexpr PackedMove(Square from, Square to, uint16_t flags)
+            : PackedMove(Board::squareToIdx(from), Board::squareToIdx(to), flags)
+        {
+        }
+
+        // Pack a full move. Moves from `legalMoves` carry everything needed; the moving
+        // piece's color and the captured piece are dropped.
+        explicit constexpr PackedMove(const Move &move)
+            : PackedMove(move.from, move.to, flagsOf(move))
+        {
+        }
+
+        static constexpr PackedMove fromRaw(uint16_t data)
+        {
+            PackedMove move;
+            move.m_data = data;
+            return move;
+        }
+
+        constexpr uint16_t raw() const { return m_data; }
+
+        constexpr size_t fromIdx() const { return m_data & 0x3F; }
+        constexpr size_t toIdx() const { return (m_data >> 6) & 0x3F; }
+        constexpr Square from() const { return Board::idxToSquare(fromIdx()); }
+        constexpr Square to() const { return Board::idxToSquare(toIdx()); }
+        constexpr uint16_t flags() const { return m_data >> 12; }
+
+        constexpr bool isNull() const { return m_data == 0; }
+        constexpr bool isCapture() const { return flags() & Capture; }
+        constexpr bool isEnPassant() const { return flags() == EnPassant; }
+        constexpr bool isDoublePush() const { return flags() == DoublePush; }
+        constexpr bool isPromotion() const { return flags() & Promotion; }
+        constexpr PieceType promotionType() const
+        {
+            return static_cast<PieceType>(static_cast<int>(PieceType::Knight) + (flags() & 3));
+        }
+        constexpr bool isCastle() const { return flags() == KingCastle || flags() == QueenCastle; }
+        constexpr std::optional<Castling::Side> castle() const
+        {
+            if (!isCastle())
+                return std::nullopt;
+            return (flags() == KingCastle) ? Castling::Side::KING : Castling::Side::QUEEN;
+        }
+
+        // The square of the pawn taken by an en passant capture: behind the destination,
+        // on the rank the capturing pawn started from
+        constexpr Square enPassantCaptureSquare() const
+        {
+            return Square{to().file, from().rank};
+        }
+
+        constexpr bool operator==(const PackedMove &other) const = default;
+
+        /* The full move, given the board it is played on (before it is played).
+         */
+        Move unpack(const Board &board) const
+        {
+            Piece piece = board.get(from()).value();
+            Move move{.piece = piece, .from = from(), .to = to()};
+            if (isEnPassant())
+            {
+                move.enPassant = true;
+                move.capture = Piece{oppositeColor(piece.color), PieceType::Pawn};
+            }
+            else if (isCapture())
+                move.capture = board.get(to());
+            move.castle = castle();
+            if (isPromotion())
+                move.promotion = Piece{piece.color, promotionType()};
+            return move;
+        }
+
+        // Long algebraic notation as used by UCI, e.g., "e2e4" or "e7e8q"
+        std::string toUCI() const
+        {
+            std::string str{
+                static_cast<char>('a' + from().file),
+                static_cast<char>('1' + from().rank),
+                static_cast<char>('a' + to().file),
+                static_cast<char>('1' + to().rank),
+            };
+            if (isPromotion())
+                str += FEN::pieceToChar(Piece{Color::Black, promotionType()});
+            return str;
+        }
+
+    private:
+        static constexpr uint16_t flagsOf(const Move &move)
+        {
+            if (move.castle)
+                return (move.castle.value() == Castling::Side::KING) ? KingCastle : QueenCastle;
+            if (move.enPassant)
+                return EnPassant;
+
+            uint16_t flags = move.capture ? Capture : Quiet;
+            if (move.promotion)
+                flags |= Promotion | (static_cast<int>(move.promotion.value().type) - static_cast<int>(PieceType::Knight));
+            else if (move.piece.type == PieceType::Pawn && (move.to.rank - move.from.rank == 2 || move.from.rank - move.to.rank == 2))
+                flags = DoublePush;
+            return flags;
+        }
+
+    private:
+        uint16_t m_data = 0;
+    };
+
+    static_assert(sizeof(PackedMove) == 2);
+} // namespace JChess
@@ -0,0 +1,268 @@
+#include "core/packedPosition.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include "core/attackTables.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define JCHESS_RUNTIME_BMI2 1
+#endif
+
+namespace JChess
+{
+    namespace
+    {
+        using Pieces = std::array<uint64_t, 2>;
+        // Bit `b` of a piece code is set on plane `b` of the occupied squares
+        using Planes = std::array<Bitboard, 4>;
+
+        constexpr uint64_t nibbleOnes = 0x1111111111111111ull;
+        constexpr size_t maxPieces = 32;
+
+        // `count` ones, one in the lowest bit of each of the lowest `count` nibbles
+        constexpr uint64_t lowNibbles(size_t count)
+        {
+            return count ? nibbleOnes >> (64 - 4 * count) : 0;
+        }
+
+        // Stores nibbles at nibble `n` of the stream; the stream has room for them
+        void append(Pieces &pieces, size_t n, uint64_t nibbles)
+        {
+            auto shift = n % 16 * 4;
+            pieces[n / 16] |= nibbles << shift;
+            if (shift && n < 16)
+                pieces[1] |= nibbles >> (64 - shift);
+        }
+
+        // The 16 nibbles of the stream from nibble `n`, zero past its end
+        uint64_t extract(const Pieces &pieces, size_t n)
+        {
+            auto shift = n % 16 * 4;
+            if (n >= 16)
+                return pieces[1] >> shift;
+            return shift ? (pieces[0] >> shift) | (pieces[1] << (64 - shift)) : pieces[0];
+        }
+
+        uint64_t loadWord(const PackedPosition::Squares &squares, size_t w)
+        {
+            uint64_t word;
+            std::memcpy(&word, squares.data() + 8 * w, sizeof(word));
+            return word;
+        }
+
+        void storeWord(PackedPosition::Squares &squares, size_t w, uint64_t word)
+        {
+            std::memcpy(squares.data() + 8 * w, &word, sizeof(word));
+        }
+
+        void packPlanesScalar(const Planes &planes, Bitboard occupancy, Pieces &pieces)
+        {
+            for (size_t n = 0; occupancy; ++n)
+            {
+                auto idx = Bitboards::popLsb(occupancy);
+                uint64_t code = 0;
+                for (size_t b = 0; b < planes.size(); ++b)
+                    code |= static_cast<uint64_t>(Bitboards::test(planes[b], idx)) << b;
+                pieces[n / 16] |= code << (n % 16 * 4);
+            }
+        }
+
+        void compressScalar(const PackedPosition::Squares &squares, PackedPosition &position)
+        {
+            size_t n = 0;
+            for (size_t idx = 0; idx < 64; ++idx)
+            {
+                auto code = (squares[idx / 2] >> (idx % 2 * 4)) & 0xF;
+                if (!code)
+                    continue;
+                if (n == maxPieces)
+                    throw std::runtime_error("More than 32 pieces to pack.");
+                position.occupancy |= Bitboards::bit(idx);
+                position.pieces[n / 16] |= static_cast<uint64_t>(code - 1) << (n % 16 * 4);
+                ++n;
+            }
+        }
+
+        void expandScalar(const PackedPosition &position, PackedPosition::Squares &squares)
+        {
+            auto occupancy = position.occupancy;
+            for (size_t n = 0; occupancy; ++n)
+            {
+                auto idx = Bitboards::popLsb(occupancy);
+                squares[idx / 2] |= static_cast<uint8_t>((position.code(n) + 1) << (idx % 2 * 4));
+            }
+        }
+
+#if defined(JCHESS_RUNTIME_BMI2)
+        /* With BMI2, a mailbox word of 16 nibbles compresses to the nibbles of its occupied
+         * squares with one PEXT under the mask of its non-zero nibbles, and expands back with
+         * one PDEP; piece codes go from bit planes to nibbles by depositing each plane into
+         * every fourth bit.
+         */
+        __attribute__((target("bmi2"))) void packPlanesBMI2(const Planes &planes, Bitboard occupancy, Pieces &pieces)
+        {
+            std::array<uint64_t, 4> compressed;
+            for (size_t b = 0; b < planes.size(); ++b)
+                compressed[b] = _pext_u64(planes[b], occupancy);
+            for (size_t half = 0; half < pieces.size(); ++half)
+            {
+                uint64_t nibbles = 0;
+                for (size_t b = 0; b < planes.size(); ++b)
+                    nibbles |= _pdep_u64(compressed[b] >> (16 * half), nibbleOnes << b);
+                pieces[half] = nibbles;
+            }
+        }
+
+        __attribute__((target("bmi2"))) void compressBMI2(const PackedPosition::Squares &squares, PackedPosition &position)
+        {
+            size_t n = 0;
+            for (size_t w = 0; w < 4; ++w)
+            {
+                auto word = loadWord(squares, w);
+                auto occupied = (word | word >> 1 | word >> 2 | word >> 3) & nibbleOnes;
+                auto count = Bitboards::count(occupied);
+                if (n + count > maxPieces)
+                    throw std::runtime_error("More than 32 pieces to pack.");
+                position.occupancy |= _pext_u64(occupied, nibbleOnes) << (16 * w);
+                if (count)
+                    append(position.pieces, n, _pext_u64(word, occupied * 0xF) - lowNibbles(count));
+                n += count;
+            }
+        }
+
+        __attribute__((target("bmi2"))) void expandBMI2(const PackedPosition &position, PackedPosition::Squares &squares)
+        {
+            size_t n = 0;
+            for (size_t w = 0; w < 4; ++w)
+            {
+                auto occupied = _pdep_u64(position.occupancy >> (16 * w), nibbleOnes);
+                auto count = Bitboards::count(occupied);
+                auto nibbles = extract(position.pieces, n) & (lowNibbles(count) * 0xF);
+                storeWord(squares, w, _pdep_u64(nibbles + lowNibbles(count), occupied * 0xF));
+                n += count;
+            }
+        }
+#endif
+
+        bool detectBMI2()
+        {
+#if defined(__BMI2__)
+            return true;
+#elif defined(JCHESS_RUNTIME_BMI2)
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("bmi2");
+#else
+            return false;
+#endif
+        }
+
+        const bool useBMI2 = detectBMI2();
+    } // namespace
+
+    PackedPosition::PackedPosition(const State &state)
+        : occupancy(state.board.occupied())
+    {
+        if (Bitboards::count(occupancy) > maxPieces)
+            throw std::runtime_error("More than 32 pieces to pack.");
+
+        Planes planes{};
+        for (size_t code = 0; code < 12; ++code)
+        {
+            auto bitboard = state.board.pieces(static_cast<Color>(code / 6), static_cast<PieceType>(code % 6));
+            for (size_t b = 0; b < planes.size(); ++b)
+                if (code & (1 << b))
+                    planes[b] |= bitboard;
+        }
+#if defined(JCHESS_RUNTIME_BMI2)
+        if (useBMI2)
+            packPlanesBMI2(planes, occupancy, pieces);
+        else
+#endif
+            packPlanesScalar(planes, occupancy, pieces);
+
+        flags = static_cast<uint8_t>(state.turn);
+        const auto &rights = state.castleRights.get();
+        for (size_t i = 0; i < rights.size(); ++i)
+            flags |= static_cast<uint8_t>(rights[i] << (i + 1));
+
+        if (state.enPassant)
+        {
+            auto idx = Board::squareToIdx(state.enPassant.value());
+            if (AttackTables::pawnAttacks(oppositeColor(state.turn), idx) & state.board.pieces(state.turn, PieceType::Pawn))
+                enPassant = static_cast<uint8_t>(idx);
+        }
+
+        constexpr uint32_t counterMax = std::numeric_limits<uint16_t>::max();
+        halfmoveClock = static_cast<uint16_t>(std::min(state.halfTurnCounter, counterMax));
+        fullmoveNumber = static_cast<uint16_t>(std::min(state.fullTurnCounter, counterMax));
+    }
+
+    PackedPosition PackedPosition::fromSquares(const Squares &squares)
+    {
+        PackedPosition position;
+#if defined(JCHESS_RUNTIME_BMI2)
+        if (useBMI2)
+            compressBMI2(squares, position);
+        else
+#endif
+            compressScalar(squares, position);
+        return position;
+    }
+
+    PackedPosition::Squares PackedPosition::squares() const
+    {
+        Squares squares{};
+#if defined(JCHESS_RUNTIME_BMI2)
+        if (useBMI2)
+            expandBMI2(*this, squares);
+        else
+#endif
+            expandScalar(*this, squares);
+        return squares;
+    }
+
+    PackedPosition PackedPosition::fromKey(std::string_view key)
+    {
+        if (key.size() != keySize)
+            throw std::runtime_error("Invalid packed position key size.");
+        PackedPosition position;
+        std::memcpy(static_cast<void *>(&position), key.data(), keySize);
+        return position;
+    }
+
+    Board PackedPosition::board() const
+    {
+        std::array<Occupant, 64> occupants;
+        auto remaining = occupancy;
+        for (size_t n = 0; remaining; ++n)
+        {
+            auto c = code(n);
+            occupants[Bitboards::popLsb(remaining)] = Piece{static_cast<Color>(c / 6), static_cast<PieceType>(c % 6)};
+        }
+        return Board{occupants};
+    }
+
+    Castling::Rights PackedPosition::castleRights() const
+    {
+        std::array<bool, 4> rights;
+        for (size_t i = 0; i < rights.size(); ++i)
+            rights[i] = flags & (1 << (i + 1));
+        return Castling::Rights{rights};
+    }
+
+    std::optional<Square> PackedPosition::enPassantSquare() const
+    {
+        if (enPassant == noSquare)
+            return std::nullopt;
+        return Board::idxToSquare(enPassant);
+    }
+
+    State PackedPosition::unpack() const
+    {
+        return State{board(), turn(), castleRights(), enPassantSquare(), halfmoveClock, fullmoveNumber};
+    }
+} // namespace JChess
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+
+#include "core/bitboard.h"
+#include "core/board.h"
+#include "core/castling.h"
+#include "core/color.h"
+#include "core/square.h"
+#include "core/state.h"
+
+namespace JChess
+{
+    /* A position in 32 bytes, the one encoding shared by hash tables, mapped files and the
+     * database keys:
+     *
+     *   occupancy       the occupied squares, as a `Bitboard`
+     *   pieces          a nibble per occupied square, in bit order of `occupancy` from the
+     *                   lowest nibble of `pieces[0]`: color * 6 + piece type
+     *   flags           bit 0 set for black to move, bits 1-4 the castling rights K, Q, k, q
+     *   enPassant       the en passant target (`Board::squareToIdx`), or `noSquare`. Kept only
+     *                   when a pawn of the side to move attacks it, so that a double push that
+     *                   allows no capture does not make the position differ.
+     *   halfmoveClock, fullmoveNumber
+     *
+     * The first `keySize` bytes are the position itself, and are what `==` and `hash`
+     * compare: the counters only say how it was reached. Unused nibbles and bytes are zero,
+     * so the bytes can be compared and stored as they are.
+     */
+    struct PackedPosition
+    {
+        static constexpr uint8_t noSquare = 64;
+        static constexpr size_t keySize = 26;
+        // A mailbox of nibbles as in `FEN::Position`: square `i` in byte `i / 2`, low nibble
+        // first; 0 for empty, else 1 + color * 6 + piece type
+        using Squares = std::array<uint8_t, 32>;
+
+        Bitboard occupancy = 0;
+        std::array<uint64_t, 2> pieces{};
+        uint8_t flags = 0;
+        uint8_t enPassant = noSquare;
+        uint16_t halfmoveClock = 0;
+        uint16_t fullmoveNumber = 1;
+        uint16_t unused = 0;
+
+        constexpr PackedPosition() = default;
+        explicit PackedPosition(const State &state);
+
+        // Throws `std::runtime_error` for more than 32 pieces
+        static PackedPosition fromSquares(const Squares &squares);
+        Squares squares() const;
+
+        State unpack() const;
+        Board board() const;
+
+        Color turn() const { return static_cast<Color>(flags & 1); }
+        Castling::Rights castleRights() const;
+        std::optional<Square> enPassantSquare() const;
+
+        // The bytes of the key, e.g., for a database column
+        std::string_view key() const { return {reinterpret_cast<const char *>(this), keySize}; }
+        // From the bytes of a key, with no counters. Throws `std::runtime_error` unless there
+        // are `keySize` of them.
+        static PackedPosition fromKey(std::string_view key);
+
+        // The code of the piece on the `n`th occupied square
+        uint8_t code(size_t n) const { return static_cast<uint8_t>((pieces[n / 16] >> (n % 16 * 4)) & 0xF); }
+
+        bool operator==(const PackedPosition &other) const
+        {
+            return occupancy == other.occupancy && pieces == other.pieces && flags == other.flags &&
+                   enPassant == other.enPassant;
+        }
+
+        uint64_t hash() const
+        {
+            // Murmur3's finalizer over the key, one word at a time
+            auto mix = [](uint64_t h)
+            {
+                h = (h ^ (h >> 33)) * 0xFF51AFD7ED558CCDull;
+                h = (h ^ (h >> 33)) * 0xC4CEB9FE1A85EC53ull;
+                return h ^ (h >> 33);
+            };
+            uint64_t h = mix(occupancy);
+            h = mix(h ^ pieces[0]);
+            h = mix(h ^ pieces[1]);
+            return mix(h ^ flags ^ static_cast<uint64_t>(enPassant) << 8);
+        }
+    };
+
+    static_assert(sizeof(PackedPosition) == 32);
+    static_assert(std::is_trivially_copyable_v<PackedPosition>);
+    static_assert(offsetof(PackedPosition, halfmoveClock) == PackedPosition::keySize);
+} // namespace JChess
+
+template <>
+struct std::hash<JChess::PackedPosition>
+{
+    size_t operator()(const JChess::PackedPosition &position) const noexcept
+    {
+        return position.hash();
+    }
+};
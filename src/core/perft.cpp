@@ -0,0 +1,364 @@
+#include "core/perft.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "core/legalMoves.h"
+
+namespace JChess
+{
+    namespace
+    {
+        // Walks the tree with make/unmake on a single State rather than copying it per node
+        uint64_t perftInPlace(State &state, unsigned depth)
+        {
+            MoveList moves;
+            legalMoves(state, moves);
+            if (depth == 1) // bulk counting: no need to play the last ply
+                return moves.size();
+
+            uint64_t nodes = 0;
+            for (auto move : moves)
+            {
+                auto undo = state.makeMove(move);
+                nodes += perftInPlace(state, depth - 1);
+                state.unmakeMove(move, undo);
+            }
+            return nodes;
+        }
+    } // namespace
+
+    uint64_t perft(const State &state, unsigned depth)
+    {
+        if (depth == 0)
+            return 1;
+
+        State scratch = state;
+        return perftInPlace(scratch, depth);
+    }
+
+    std::vector<std::pair<Move, uint64_t>> perftDivide(const State &state, unsigned depth)
+    {
+        std::vector<std::pair<Move, uint64_t>> counts;
+        if (depth == 0)
+            return counts;
+
+        State scratch = state;
+        auto moves = legalMoves(scratch);
+        counts.reserve(moves.size());
+        for (const auto &move : moves)
+        {
+            auto undo = scratch.makeMove(move);
+            counts.emplace_back(move, depth > 1 ? perftInPlace(scratch, depth - 1) : 1);
+            scratch.unmakeMove(move, undo);
+        }
+        return counts;
+    }
+
+    namespace
+    {
+        // Subtrees at most this deep are walked by a single worker rather than split further
+        constexpr unsigned maxLeafDepth = 4;
+
+        /* Lockless shared table of subtree node counts. Each entry stores the key XORed
+         * with the data next to the data itself, so an entry torn by concurrent writers
+         * fails the key check instead of returning a wrong count.
+         */
+        class PerftTable
+        {
+        public:
+            explicit PerftTable(size_t bytes)
+                : m_size(std::bit_floor(std::max<size_t>(bytes / sizeof(Entry), 1))),
+                  m_entries(std::make_unique<Entry[]>(m_size))
+            {
+            }
+
+            bool probe(uint64_t key, unsigned depth, uint64_t &nodes) const
+            {
+                const auto &entry = m_entries[key & (m_size - 1)];
+                uint64_t data = entry.data.load(std::memory_order_relaxed);
+                uint64_t check = entry.check.load(std::memory_order_relaxed);
+                if ((check ^ data) != key || (data & 0xFF) != depth)
+                    return false;
+                nodes = data >> 8;
+                return true;
+            }
+
+            void store(uint64_t key, unsigned depth, uint64_t nodes)
+            {
+                auto &entry = m_entries[key & (m_size - 1)];
+                uint64_t data = (nodes << 8) | depth;
+                entry.check.store(key ^ data, std::memory_order_relaxed);
+                entry.data.store(data, std::memory_order_relaxed);
+            }
+
+        private:
+            struct Entry
+            {
+                std::atomic<uint64_t> check{0};
+                std::atomic<uint64_t> data{0};
+            };
+
+            size_t m_size;
+            std::unique_ptr<Entry[]> m_entries;
+        };
+
+        uint64_t hashedPerft(State &state, unsigned depth, PerftTable &table)
+        {
+            if (depth <= 1)
+                return depth ? perftInPlace(state, depth) : 1;
+
+            uint64_t key = state.hash();
+            uint64_t nodes = 0;
+            if (table.probe(key, depth, nodes))
+                return nodes;
+
+            MoveList moves;
+            legalMoves(state, moves);
+            for (auto move : moves)
+            {
+                auto undo = state.makeMove(move);
+                nodes += hashedPerft(state, depth - 1, table);
+                state.unmakeMove(move, undo);
+            }
+            table.store(key, depth, nodes);
+            return nodes;
+        }
+
+        uint64_t walk(State &state, unsigned depth, const PositionVisitor &visit, unsigned worker)
+        {
+            if (depth == 0)
+            {
+                visit(state, worker);
+                return 1;
+            }
+
+            uint64_t count = 0;
+            MoveList moves;
+            legalMoves(state, moves);
+            for (auto move : moves)
+            {
+                auto undo = state.makeMove(move);
+                count += walk(state, depth - 1, visit, worker);
+                state.unmakeMove(move, undo);
+            }
+            return count;
+        }
+
+        struct Task
+        {
+            State state;
+            unsigned depth;
+            size_t root; // index of the root move this subtree belongs to
+        };
+
+        struct alignas(64) TaskQueue
+        {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        /* Counts the subtrees below each root move on a pool of workers. Each worker pops
+         * tasks from the back of its own queue (depth-first, which keeps the queues short)
+         * and, when that runs dry, steals from the front of the others, where the largest
+         * remaining subtrees are. Tasks deeper than the leaf depth are split into one task
+         * per move; the rest are handed to `leaf(state, depth, worker)`.
+         */
+        class WorkStealingPool
+        {
+        public:
+            using LeafFunction = std::function<uint64_t(State &, unsigned depth, unsigned worker)>;
+
+            WorkStealingPool(unsigned threads, unsigned rootDepth, LeafFunction leaf)
+                : m_queues(std::max(threads, 1u)),
+                  m_leafDepth(std::min(rootDepth - 1, maxLeafDepth)),
+                  m_leaf(std::move(leaf))
+            {
+            }
+
+            std::vector<std::pair<Move, uint64_t>> run(const State &state, unsigned depth)
+            {
+                auto moves = legalMoves(state);
+                m_counts = std::make_unique<std::atomic<uint64_t>[]>(moves.size());
+                m_pending = moves.size();
+                for (size_t i = 0; i < moves.size(); ++i)
+                {
+                    Task task{state, depth - 1, i};
+                    task.state.applyMove(moves[i]);
+                    m_queues[i % m_queues.size()].tasks.push_back(std::move(task));
+                }
+
+                std::vector<std::thread> threads;
+                threads.reserve(m_queues.size() - 1);
+                for (unsigned worker = 1; worker < m_queues.size(); ++worker)
+                    threads.emplace_back(&WorkStealingPool::work, this, worker);
+                work(0);
+                for (auto &thread : threads)
+                    thread.join();
+
+                if (m_error)
+                    std::rethrow_exception(m_error);
+
+                std::vector<std::pair<Move, uint64_t>> counts;
+                counts.reserve(moves.size());
+                for (size_t i = 0; i < moves.size(); ++i)
+                    counts.emplace_back(moves[i], m_counts[i].load());
+                return counts;
+            }
+
+        private:
+            void work(unsigned worker)
+            {
+                while (m_pending.load(std::memory_order_acquire) > 0 && !m_stop.load(std::memory_order_relaxed))
+                {
+                    auto task = next(worker);
+                    if (!task)
+                    {
+                        std::this_thread::yield();
+                        continue;
+                    }
+
+                    try
+                    {
+                        process(worker, std::move(task.value()));
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard lock{m_errorMutex};
+                        if (!m_error)
+                            m_error = std::current_exception();
+                        m_stop = true;
+                    }
+                    m_pending.fetch_sub(1, std::memory_order_acq_rel);
+                }
+            }
+
+            std::optional<Task> next(unsigned worker)
+            {
+                {
+                    auto &own = m_queues[worker];
+                    std::lock_guard lock{own.mutex};
+                    if (!own.tasks.empty())
+                    {
+                        Task task = std::move(own.tasks.back());
+                        own.tasks.pop_back();
+                        return task;
+                    }
+                }
+
+                for (size_t i = 1; i < m_queues.size(); ++i)
+                {
+                    auto &victim = m_queues[(worker + i) % m_queues.size()];
+                    std::lock_guard lock{victim.mutex};
+                    if (!victim.tasks.empty())
+                    {
+                        Task task = std::move(victim.tasks.front());
+                        victim.tasks.pop_front();
+                        return task;
+                    }
+                }
+                return std::nullopt;
+            }
+
+            void process(unsigned worker, Task task)
+            {
+                if (task.depth <= m_leafDepth)
+                {
+                    m_counts[task.root].fetch_add(m_leaf(task.state, task.depth, worker), std::memory_order_relaxed);
+                    return;
+                }
+
+                MoveList moves;
+                legalMoves(task.state, moves);
+                m_pending.fetch_add(moves.size(), std::memory_order_acq_rel);
+                auto &own = m_queues[worker];
+                for (const auto &move : moves)
+                {
+                    Task child{task.state, task.depth - 1, task.root};
+                    child.state.applyMove(move);
+                    std::lock_guard lock{own.mutex};
+                    own.tasks.push_back(std::move(child));
+                }
+            }
+
+        private:
+            std::vector<TaskQueue> m_queues;
+            unsigned m_leafDepth;
+            LeafFunction m_leaf;
+
+            std::unique_ptr<std::atomic<uint64_t>[]> m_counts;
+            // Tasks queued or in progress; the workers stop when it reaches zero
+            std::atomic<size_t> m_pending{0};
+
+            std::atomic<bool> m_stop{false};
+            std::mutex m_errorMutex;
+            std::exception_ptr m_error;
+        };
+
+        unsigned threadCount(unsigned requested)
+        {
+            if (requested)
+                return requested;
+            return std::max(std::thread::hardware_concurrency(), 1u);
+        }
+    } // namespace
+
+    uint64_t parallelPerft(const State &state, unsigned depth, const PerftOptions &options)
+    {
+        if (depth == 0)
+            return 1;
+
+        uint64_t nodes = 0;
+        for (const auto &[move, count] : parallelPerftDivide(state, depth, options))
+            nodes += count;
+        return nodes;
+    }
+
+    std::vector<std::pair<Move, uint64_t>> parallelPerftDivide(const State &state, unsigned depth,
+                                                               const PerftOptions &options)
+    {
+        if (depth == 0)
+            return {};
+
+        std::unique_ptr<PerftTable> table;
+        if (options.hashBytes)
+            table = std::make_unique<PerftTable>(options.hashBytes);
+
+        WorkStealingPool pool{threadCount(options.threads), depth,
+                              [&table](State &leaf, unsigned leafDepth, unsigned)
+                              {
+                                  if (table)
+                                      return hashedPerft(leaf, leafDepth, *table);
+                                  return leafDepth ? perftInPlace(leaf, leafDepth) : 1;
+                              }};
+        return pool.run(state, depth);
+    }
+
+    uint64_t enumeratePositions(const State &state, unsigned depth, const PositionVisitor &visit,
+                                unsigned threads)
+    {
+        if (depth == 0)
+        {
+            visit(state, 0);
+            return 1;
+        }
+
+        WorkStealingPool pool{threadCount(threads), depth,
+                              [&visit](State &leaf, unsigned leafDepth, unsigned worker)
+                              {
+                                  return walk(leaf, leafDepth, visit, worker);
+                              }};
+
+        uint64_t count = 0;
+        for (const auto &[move, subtree] : pool.run(state, depth))
+            count += subtree;
+        return count;
+    }
+} // namespace JChess
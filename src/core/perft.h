@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "core/move.h"
+#include "core/state.h"
+
+namespace JChess
+{
+    /* Count the leaf nodes of the legal move tree of the given depth below `state`.
+     * Used to validate `legalMoves` and `State::applyMove` against published node counts
+     * and to benchmark them.
+     */
+    uint64_t perft(const State &state, unsigned depth);
+
+    /* The same count split by root move ("divide"), in the order that `legalMoves`
+     * generates them. Useful for bisecting a discrepancy against another engine.
+     */
+    std::vector<std::pair<Move, uint64_t>> perftDivide(const State &state, unsigned depth);
+
+    struct PerftOptions
+    {
+        // Number of worker threads, or 0 for one per hardware thread
+        unsigned threads = 0;
+        // Size in bytes of the transposition table shared by the workers, or 0 to disable it.
+        // Rounded down to a power of two entries of 16 bytes each.
+        size_t hashBytes = 0;
+    };
+
+    /* Parallel versions of the two above. The subtrees below the root moves are split into
+     * tasks on a work-stealing thread pool; each task carries its own copy of the `State`, so
+     * workers share nothing but the task queues, the per-root-move counters and, optionally,
+     * a Zobrist-keyed transposition table of subtree counts.
+     */
+    uint64_t parallelPerft(const State &state, unsigned depth, const PerftOptions &options = {});
+    std::vector<std::pair<Move, uint64_t>> parallelPerftDivide(const State &state, unsigned depth,
+                                                               const PerftOptions &options = {});
+
+    /* Called with each position reached and the index of the worker thread that reached it,
+     * which is less than the number of threads. Called concurrently from different workers.
+     */
+    using PositionVisitor = std::function<void(const State &, unsigned worker)>;
+
+    /* Visit every position exactly `depth` plies below `state` (once per path, so transposed
+     * positions are visited more than once) on the same thread pool as `parallelPerft`.
+     * Returns the number of positions visited, which equals `perft(state, depth)`. An exception
+     * thrown by `visit` stops the enumeration and is rethrown on the calling thread.
+     */
+    uint64_t enumeratePositions(const State &state, unsigned depth, const PositionVisitor &visit,
+                                unsigned threads = 0);
+} // namespace JChess
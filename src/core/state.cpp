@@ -1,21 +1,14 @@
 #include "core/state.h"
 
-#include <memory>
 #include <sstream>
 #include <stdexcept>
 
-#include "core/offset.h"
+#include "core/zobrist.h"
 
 namespace JChess
 {
-    State::State()
-        : board(FEN::startpos), fullTurnCounter(1), halfTurnCounter(0),
-          attacks(std::make_shared<Board>(board))
-    {
-    }
-
     State::State(std::string_view fenstr)
-        : board(fenstr), attacks(std::make_shared<Board>(board))
+        : board(fenstr), attacks(board)
     {
         std::istringstream readFEN{fenstr.data()};
 
@@ -54,55 +47,138 @@ namespace JChess
         halfTurnCounter = std::stoul(word);
         readFEN >> word;
         fullTurnCounter = std::stoul(word);
+
+        rehash();
+    }
+
+    State::State(const Board &board, Color turn, Castling::Rights castleRights, std::optional<Square> enPassant,
+                 uint32_t halfTurnCounter, uint32_t fullTurnCounter)
+        : board(board), fullTurnCounter(fullTurnCounter), halfTurnCounter(halfTurnCounter), turn(turn),
+          castleRights(castleRights), enPassant(enPassant), attacks(board)
+    {
+        rehash();
+    }
+
+    void State::rehash()
+    {
+        m_hash = Zobrist::hash(board, turn, castleRights, enPassant);
     }
 
     void State::applyMove(const JChess::Move &move)
     {
-        board.remove(move.from);
-        board.put(move.to, move.promotion.value_or(move.piece));
+        makeMove(PackedMove{move});
+    }
 
-        if (move.piece.type == PieceType::Pawn || move.capture)
-            halfTurnCounter = 0;
-        else
-            ++halfTurnCounter;
+    void State::applyMove(PackedMove move)
+    {
+        makeMove(move);
+    }
+
+    Undo State::makeMove(const Move &move)
+    {
+        return makeMove(PackedMove{move});
+    }
+
+    void State::unmakeMove(const Move &move, const Undo &undo)
+    {
+        unmakeMove(PackedMove{move}, undo);
+    }
 
-        if (move.castle)
+    Undo State::makeMove(PackedMove move)
+    {
+        Undo undo{
+            .castleRights = castleRights,
+            .enPassant = enPassant,
+            .halfTurnCounter = halfTurnCounter,
+            .hash = m_hash,
+        };
+
+        // Castling rights and the en passant square are hashed back in once updated
+        m_hash ^= Zobrist::castling(castleRights) ^ Zobrist::enPassant(enPassant) ^ Zobrist::turn(Color::Black);
+
+        Square from = move.from(), to = move.to();
+        Piece piece = board.remove(from).value();
+        Piece placed = move.isPromotion() ? Piece{turn, move.promotionType()} : piece;
+        undo.captured = board.put(to, placed);
+        m_hash ^= Zobrist::piece(piece, from) ^ Zobrist::piece(placed, to);
+        if (undo.captured)
+            m_hash ^= Zobrist::piece(undo.captured.value(), to);
+
+        if (move.isCastle())
         {
-            bool qs = move.castle.value() == Castling::Side::QUEEN;
-            Square rookFrom{qs ? 0 : 7, move.from.rank},
-                rookTo{qs ? 3 : 5, move.from.rank};
+            auto side = move.castle().value();
+            Square rookFrom = Board::rookFromSquare(turn, side), rookTo = Board::rookToSquare(turn, side);
             auto rook = board.remove(rookFrom);
             board.put(rookTo, rook.value());
+            m_hash ^= Zobrist::piece(rook.value(), rookFrom) ^ Zobrist::piece(rook.value(), rookTo);
 
             castleRights.remove(turn);
         }
-        else if (move.enPassant)
+        else if (move.isEnPassant())
         {
-            Square capturedPawnSq = move.to + Offsets::backward(turn);
-            board.remove(capturedPawnSq);
-            enPassant = std::nullopt;
+            Square capturedPawnSq = move.enPassantCaptureSquare();
+            undo.captured = board.remove(capturedPawnSq);
+            m_hash ^= Zobrist::piece(undo.captured.value(), capturedPawnSq);
         }
 
-        if (move.piece.type == PieceType::Pawn &&
-            2 == abs(move.to.rank - move.from.rank) &&
-            move.to.file == move.from.file)
-            enPassant = Square{move.from.file, (move.from.rank + move.to.rank) / 2};
+        if (piece.type == PieceType::Pawn || undo.captured)
+            halfTurnCounter = 0;
+        else
+            ++halfTurnCounter;
+
+        if (move.isDoublePush())
+            enPassant = Square{from.file, (from.rank + to.rank) / 2};
         else
             enPassant = std::nullopt;
 
-        auto r = board.homeRank(turn);
-        if (move.piece.type == PieceType::Rook && move.from.rank == r)
+        // Moving the king or a rook off its home square, or having a rook captured on its
+        // home square, forfeits the corresponding castling rights
+        if (piece.type == PieceType::King)
+            castleRights.remove(turn);
+        for (auto side : {Castling::Side::QUEEN, Castling::Side::KING})
         {
-            if (move.from.file == 0)
-                castleRights.remove(turn, Castling::Side::QUEEN);
-            if (move.from.file == 7)
-                castleRights.remove(turn, Castling::Side::KING);
+            if (from == board.rookFromSquare(turn, side))
+                castleRights.remove(turn, side);
+            if (to == board.rookFromSquare(oppositeColor(turn), side))
+                castleRights.remove(oppositeColor(turn), side);
         }
+
+        m_hash ^= Zobrist::castling(castleRights) ^ Zobrist::enPassant(enPassant);
+
         if (turn == Color::Black)
             fullTurnCounter++;
         turn = oppositeColor(turn);
 
-        attacks.applyMove(move);
+        attacks.applyMove(board, move);
+        return undo;
+    }
+
+    void State::unmakeMove(PackedMove move, const Undo &undo)
+    {
+        turn = oppositeColor(turn);
+        if (turn == Color::Black)
+            fullTurnCounter--;
+
+        Piece piece = board.remove(move.to()).value();
+        board.put(move.from(), move.isPromotion() ? Piece{turn, PieceType::Pawn} : piece);
+
+        if (move.isCastle())
+        {
+            auto rook = board.remove(Board::rookToSquare(turn, move.castle().value()));
+            board.put(Board::rookFromSquare(turn, move.castle().value()), rook.value());
+        }
+        else if (move.isEnPassant())
+            board.put(move.enPassantCaptureSquare(), undo.captured.value());
+        else if (undo.captured)
+            board.put(move.to(), undo.captured.value());
+
+        castleRights = undo.castleRights;
+        enPassant = undo.enPassant;
+        halfTurnCounter = undo.halfTurnCounter;
+        m_hash = undo.hash;
+
+        // The same squares change back, so the incremental update applies in reverse too
+        attacks.applyMove(board, move);
     }
 
     std::string State::toFEN() const
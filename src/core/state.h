@@ -4,18 +4,30 @@
 #include <optional>
 #include <string>
 #include <string_view>
+#include <type_traits>
 
 #include "core/attacks.h"
 #include "core/board.h"
 #include "core/castling.h"
 #include "core/color.h"
 #include "core/move.h"
+#include "core/packedMove.h"
 #include "core/square.h"
 
 #include "formats/fen.h"
 
 namespace JChess
 {
+    /// @brief What `State::makeMove` overwrites and `State::unmakeMove` needs to restore
+    struct Undo
+    {
+        std::optional<Piece> captured;
+        Castling::Rights castleRights;
+        std::optional<Square> enPassant;
+        uint32_t halfTurnCounter;
+        uint64_t hash;
+    };
+
     /// @brief The game state of a game of chess
     class State
     {
@@ -29,12 +41,39 @@ namespace JChess
         Attacks attacks;
 
     public:
-        State();
         State(std::string_view fenstr = FEN::startstate);
+        /// @brief A state from its parts, e.g., as parsed elsewhere; the board is trusted
+        State(const Board &board, Color turn, Castling::Rights castleRights, std::optional<Square> enPassant,
+              uint32_t halfTurnCounter, uint32_t fullTurnCounter);
         /// @brief Applies a move to the board state
         /// @param move
         void applyMove(const Move &move);
+        void applyMove(PackedMove move);
+
+        /// @brief Applies a move in place, returning what is needed to take it back
+        /// @param move a legal move in this state
+        Undo makeMove(PackedMove move);
+        Undo makeMove(const Move &move);
+        /// @brief Takes back the last move made with `makeMove`
+        /// @param move the same move passed to `makeMove`
+        /// @param undo the record it returned
+        void unmakeMove(PackedMove move, const Undo &undo);
+        void unmakeMove(const Move &move, const Undo &undo);
+
+        /// @brief The Zobrist key of the position: pieces, side to move, castling rights and
+        /// en passant file. Maintained incrementally by `applyMove`; modifying the members
+        /// directly leaves it stale until `rehash` is called.
+        uint64_t hash() const { return m_hash; }
+        /// @brief Recomputes the Zobrist key from scratch
+        void rehash();
 
         std::string toFEN() const;
+
+    private:
+        uint64_t m_hash;
     };
+
+    // States are copied per task and handed between threads in bulk, so copying one must
+    // stay a memcpy: no owning or reference-counted members
+    static_assert(std::is_trivially_copyable_v<State>);
 } // namespace JChess
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "core/board.h"
+#include "core/castling.h"
+#include "core/color.h"
+#include "core/piece.h"
+#include "core/square.h"
+
+/* Zobrist hashing: a position's key is the XOR of one random 64-bit key per (piece, square),
+ * plus keys for the side to move, each castling right, and the en passant file. The keys are
+ * generated at compile time from a fixed seed, so hashes are stable across runs and builds.
+ */
+namespace JChess::Zobrist
+{
+    namespace detail
+    {
+        // splitmix64
+        constexpr uint64_t mix(uint64_t &state)
+        {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        struct Keys
+        {
+            // Indexed by color * 6 + piece type, then `Board::squareToIdx`
+            std::array<std::array<uint64_t, 64>, 12> pieces{};
+            // Indexed as in `Castling::Rights::get()`
+            std::array<uint64_t, 4> castling{};
+            std::array<uint64_t, 8> enPassantFile{};
+            uint64_t blackToMove = 0;
+        };
+
+        constexpr Keys generate()
+        {
+            Keys keys;
+            uint64_t state = 0x4A43686573735A6Bull;
+            for (auto &squares : keys.pieces)
+                for (auto &key : squares)
+                    key = mix(state);
+            for (auto &key : keys.castling)
+                key = mix(state);
+            for (auto &key : keys.enPassantFile)
+                key = mix(state);
+            keys.blackToMove = mix(state);
+            return keys;
+        }
+
+        constexpr inline Keys keys = generate();
+    } // namespace detail
+
+    constexpr inline uint64_t piece(Piece piece, size_t idx)
+    {
+        return detail::keys.pieces[static_cast<size_t>(piece.color) * 6 + static_cast<size_t>(piece.type)][idx];
+    }
+
+    constexpr inline uint64_t piece(Piece p, Square square)
+    {
+        return piece(p, Board::squareToIdx(square));
+    }
+
+    constexpr inline uint64_t castling(const Castling::Rights &rights)
+    {
+        uint64_t key = 0;
+        const auto &flags = rights.get();
+        for (size_t i = 0; i < flags.size(); ++i)
+            if (flags[i])
+                key ^= detail::keys.castling[i];
+        return key;
+    }
+
+    constexpr inline uint64_t enPassant(const std::optional<Square> &square)
+    {
+        return square ? detail::keys.enPassantFile[static_cast<size_t>(square.value().file)] : 0;
+    }
+
+    constexpr inline uint64_t turn(Color color)
+    {
+        return (color == Color::Black) ? detail::keys.blackToMove : 0;
+    }
+
+    // The full key of the given position, computed from scratch
+    inline uint64_t hash(const Board &board, Color turnColor, const Castling::Rights &rights,
+                         const std::optional<Square> &enPassantSquare)
+    {
+        uint64_t key = turn(turnColor) ^ castling(rights) ^ enPassant(enPassantSquare);
+
+        Bitboard occupied = board.occupied();
+        while (occupied)
+        {
+            auto idx = Bitboards::popLsb(occupied);
+            key ^= piece(board.get(Board::idxToSquare(idx)).value(), idx);
+        }
+        return key;
+    }
+} // namespace JChess::Zobrist
@@ -1,21 +1,18 @@
 #pragma once
 
-#include <cstddef>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
-#include <pqxx/pqxx>
+#include "core/move.h"
+#include "core/packedMove.h"
 
-#include "internal/game/move.h"
-#include "internal/game/position.h"
-
-namespace JChess
+namespace JChess::Database
 {
-    using blob = std::basic_string<std::byte>;
-
-    blob movesToBlob(const std::vector<Move> &moves);
-    std::vector<Move> blobToMoves(const blob &movesBlob);
+    // `games.movesBlob`: two bytes per move, `PackedMove::raw()`, little-endian
+    void appendMovesBlob(std::string &blob, std::span<const Move> moves);
+    std::vector<PackedMove> blobToMoves(std::string_view blob);
 
-    blob positionToBlob(const Board &board);
-    Board blobToPosition(const blob &posBlob);
-} // namespace JChess
\ No newline at end of file
+    // Positions are stored as `PackedPosition::key()` and read with `PackedPosition::fromKey`
+} // namespace JChess::Database
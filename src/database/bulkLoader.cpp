@@ -0,0 +1,272 @@
+#include "database/bulkLoader.h"
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "core/packedMove.h"
+#include "core/state.h"
+#include "database/blobs.h"
+#include "database/schema.h"
+
+namespace JChess::Database
+{
+    namespace
+    {
+        constexpr Statement allocateIDs{
+            "jchess_allocate_ids",
+            "SELECT nextval(pg_get_serial_sequence($1, $2)) FROM generate_series(1, $3)"};
+        // In key order, so concurrent loaders inserting the same new positions wait on each
+        // other instead of deadlocking
+        constexpr Statement insertLoadedPositions{
+            "jchess_insert_loaded_positions",
+            "INSERT INTO positions (positionID, position) SELECT positionID, position FROM loadPositions "
+            "ORDER BY position ON CONFLICT (position) DO NOTHING"};
+        // The loaded positions that were already in the table
+        constexpr Statement selectTakenPositions{
+            "jchess_select_taken_positions",
+            "SELECT positions.positionID, positions.position FROM positions JOIN loadPositions USING (position) "
+            "WHERE positions.positionID <> loadPositions.positionID"};
+
+        std::vector<int64_t> allocatedIDs(const Result &result, size_t count)
+        {
+            if (result.rows() != count)
+                throw std::runtime_error("Could not allocate IDs.");
+            std::vector<int64_t> ids(count);
+            for (size_t i = 0; i < count; ++i)
+                ids[i] = result.integer(i, 0);
+            return ids;
+        }
+
+        void optionalELO(CopyWriter &copy, uint16_t elo)
+        {
+            if (elo)
+                copy.int32(elo);
+            else
+                copy.null();
+        }
+    } // namespace
+
+    void BatchPositions::collect(std::span<const Game> games, PositionDictionary &scratch)
+    {
+        positions.clear();
+        plyPositions.clear();
+        scratch.clear();
+        for (const auto &game : games)
+        {
+            State state = game.startFEN.empty() ? State{} : State{game.startFEN};
+            for (const auto &move : game.moves)
+            {
+                PackedPosition position{state};
+                int64_t index = scratch.find(position);
+                if (!index)
+                {
+                    positions.push_back(position);
+                    index = static_cast<int64_t>(positions.size());
+                    scratch.insert(position, index);
+                }
+                plyPositions.push_back(static_cast<uint32_t>(index - 1));
+                state.applyMove(move);
+            }
+        }
+        ids.assign(positions.size(), 0);
+        unknown.clear();
+    }
+
+    void BatchPositions::lookup(const PositionDictionary &dictionary)
+    {
+        unknown.clear();
+        for (size_t i = 0; i < positions.size(); ++i)
+        {
+            ids[i] = dictionary.find(positions[i]);
+            if (!ids[i])
+                unknown.push_back(i);
+        }
+    }
+
+    void BatchPositions::learn(PositionDictionary &dictionary) const
+    {
+        for (size_t i : unknown)
+            dictionary.insert(positions[i], ids[i]);
+    }
+
+    BulkLoader::BulkLoader(Connection &conn, PositionDictionary &dictionary)
+        : m_conn(conn), m_dictionary(dictionary)
+    {
+    }
+
+    LoadStats BulkLoader::load(std::span<const Game> games)
+    {
+        // Replay the games first, so nothing is sent for a batch that cannot be loaded
+        m_positions.collect(games, m_scratch);
+        m_positions.lookup(m_dictionary);
+        auto stats = write(games, m_positions);
+        m_positions.learn(m_dictionary);
+        return stats;
+    }
+
+    LoadStats BulkLoader::write(std::span<const Game> games, BatchPositions &positions)
+    {
+        LoadStats stats;
+        stats.games = games.size();
+        stats.moves = positions.plyPositions.size();
+        if (games.empty())
+            return stats;
+
+        if (!m_tempTable)
+        {
+            m_conn.exec("CREATE TEMPORARY TABLE IF NOT EXISTS loadPositions "
+                        "(positionID BIGINT NOT NULL, position BYTEA NOT NULL) ON COMMIT DELETE ROWS");
+            m_tempTable = true;
+        }
+
+        // Sequences are not transactional, so the IDs are taken before the transaction
+        auto allocate = [](const char *table, const char *column, size_t count)
+        { return Query{&allocateIDs, Params{}.text(table).text(column).int64(static_cast<int64_t>(count))}; };
+        auto results = m_conn.pipeline({allocate("games", "gameid", games.size()),
+                                        allocate("moves", "moveid", stats.moves),
+                                        allocate("positions", "positionid", positions.unknown.size())});
+        auto gameIDs = allocatedIDs(results[0], games.size());
+        auto moveIDs = allocatedIDs(results[1], stats.moves);
+        auto positionIDs = allocatedIDs(results[2], positions.unknown.size());
+
+        Transaction txn{m_conn};
+        resolvePositions(positions, positionIDs, stats);
+        copyGames(games, gameIDs);
+        copyMoves(games, gameIDs, moveIDs, positions);
+        txn.commit();
+        return stats;
+    }
+
+    void BulkLoader::resolvePositions(BatchPositions &positions, const std::vector<int64_t> &newIDs, LoadStats &stats)
+    {
+        if (positions.unknown.empty())
+            return;
+
+        m_copy.clear();
+        for (size_t k = 0; k < positions.unknown.size(); ++k)
+        {
+            size_t i = positions.unknown[k];
+            positions.ids[i] = newIDs[k];
+            m_copy.row(2);
+            m_copy.int64(newIDs[k]);
+            m_copy.bytes(positions.positions[i].key());
+        }
+        m_conn.copyIn("COPY loadPositions FROM STDIN (FORMAT binary)", m_copy.finish());
+
+        auto inserted = m_conn.exec(insertLoadedPositions);
+        stats.newPositions = inserted.affectedRows();
+        if (stats.newPositions == positions.unknown.size())
+            return;
+
+        // The rest were added by someone else since the dictionary saw the table
+        auto result = m_conn.exec(selectTakenPositions);
+        if (result.rows() != positions.unknown.size() - stats.newPositions)
+            throw std::runtime_error("Could not resolve the ID of a position.");
+        m_scratch.clear();
+        for (size_t k = 0; k < positions.unknown.size(); ++k)
+            m_scratch.insert(positions.positions[positions.unknown[k]], static_cast<int64_t>(positions.unknown[k] + 1));
+        for (size_t row = 0; row < result.rows(); ++row)
+        {
+            if (int64_t index = m_scratch.find(PackedPosition::fromKey(result.value(row, 1))))
+                positions.ids[static_cast<size_t>(index - 1)] = result.integer(row, 0);
+        }
+    }
+
+    void BulkLoader::copyGames(std::span<const Game> games, const std::vector<int64_t> &gameIDs)
+    {
+        m_copy.clear();
+        std::string movesBlob;
+        for (size_t g = 0; g < games.size(); ++g)
+        {
+            const auto &game = games[g];
+            m_copy.row(14);
+            m_copy.int64(gameIDs[g]);
+            m_copy.timestamp(game.datetime);
+            m_copy.text(game.whiteUsername);
+            m_copy.text(game.blackUsername);
+            optionalELO(m_copy, game.whiteELO);
+            optionalELO(m_copy, game.blackELO);
+            if (game.timeControl.initial.count())
+                m_copy.interval(game.timeControl.initial);
+            else
+                m_copy.null();
+            m_copy.interval(game.timeControl.increment);
+            m_copy.text(winnerLabels[static_cast<size_t>(game.result.type)]);
+            m_copy.text(conditionLabels[static_cast<size_t>(game.result.reason)]);
+            m_copy.int32(static_cast<int32_t>(game.moves.size()));
+            if (game.ECOCode.size() == 3)
+                m_copy.text(game.ECOCode);
+            else
+                m_copy.null();
+            m_copy.text(game.startFEN);
+
+            movesBlob.clear();
+            appendMovesBlob(movesBlob, game.moves);
+            m_copy.bytes(movesBlob);
+        }
+        m_conn.copyIn("COPY games (gameID, datetimeUTC, whiteUsername, blackUsername, whiteELO, blackELO, "
+                      "timeLimit, timeIncrement, winner, condition, halfMoves, ecoCode, startFEN, movesBlob) "
+                      "FROM STDIN (FORMAT binary)",
+                      m_copy.finish());
+    }
+
+    void BulkLoader::copyMoves(std::span<const Game> games, const std::vector<int64_t> &gameIDs,
+                               const std::vector<int64_t> &moveIDs, const BatchPositions &positions)
+    {
+        m_copy.clear();
+        size_t ply = 0;
+        for (size_t g = 0; g < games.size(); ++g)
+        {
+            const auto &game = games[g];
+            for (size_t i = 0; i < game.moves.size(); ++i, ++ply)
+            {
+                m_copy.row(11);
+                m_copy.int64(moveIDs[ply]);
+                m_copy.int64(gameIDs[g]);
+                if (i > 0)
+                    m_copy.int64(moveIDs[ply - 1]);
+                else
+                    m_copy.null();
+                if (i + 1 < game.moves.size())
+                    m_copy.int64(moveIDs[ply + 1]);
+                else
+                    m_copy.null();
+                m_copy.int64(positions.ids[positions.plyPositions[ply]]);
+                m_copy.int32(static_cast<int32_t>(i + 1));
+                m_copy.int16(static_cast<int16_t>(PackedMove{game.moves[i]}.raw()));
+
+                if (game.clocks && i < game.clocks->size())
+                    m_copy.interval((*game.clocks)[i]);
+                else
+                    m_copy.null();
+                if (game.evaluations && i < game.evaluations->size())
+                {
+                    const auto &evaluation = (*game.evaluations)[i];
+                    if (evaluation.centipawns)
+                    {
+                        m_copy.int32(evaluation.value);
+                        m_copy.null();
+                    }
+                    else
+                    {
+                        m_copy.null();
+                        m_copy.int32(evaluation.value);
+                    }
+                }
+                else
+                {
+                    m_copy.null();
+                    m_copy.null();
+                }
+                if (game.annotations && i < game.annotations->size() && (*game.annotations)[i] != Annotation::None)
+                    m_copy.text(annotationLabels[static_cast<size_t>((*game.annotations)[i])]);
+                else
+                    m_copy.null();
+            }
+        }
+        m_conn.copyIn("COPY moves (moveID, gameID, prevMoveID, nextMoveID, positionID, moveNumber, move, "
+                      "timeLeft, evaluationCP, evaluationM, annotation) FROM STDIN (FORMAT binary)",
+                      m_copy.finish());
+    }
+} // namespace JChess::Database
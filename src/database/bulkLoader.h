@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "core/game.h"
+#include "core/packedPosition.h"
+#include "database/connection.h"
+#include "database/copyWriter.h"
+#include "database/positionDictionary.h"
+
+namespace JChess::Database
+{
+    struct LoadStats
+    {
+        size_t games = 0;
+        size_t moves = 0;
+        // Positions not already in the table
+        size_t newPositions = 0;
+    };
+
+    /* The positions of a batch of games, worked out before anything is sent. Filled on any
+     * thread: `collect` replays the games and `lookup` reads the dictionary, so the loader's
+     * connection only waits on the network.
+     */
+    struct BatchPositions
+    {
+        // The distinct positions, their IDs (0 until known), and per ply of each game in
+        // turn, an index into them
+        std::vector<PackedPosition> positions;
+        std::vector<int64_t> ids;
+        std::vector<uint32_t> plyPositions;
+        // Indices of the positions that were not in the dictionary
+        std::vector<size_t> unknown;
+
+        // Replays the games. `scratch` holds the batch's positions while they are deduplicated
+        void collect(std::span<const Game> games, PositionDictionary &scratch);
+        // Takes the IDs of the positions the dictionary knows
+        void lookup(const PositionDictionary &dictionary);
+        // Adds the IDs found for the unknown positions by `BulkLoader::write`
+        void learn(PositionDictionary &dictionary) const;
+    };
+
+    /* Loads batches of games into the tables of src/database/schema.h, a batch per
+     * transaction, in a handful of round-trips however many games it has:
+     *
+     *   1. game, move and new position IDs, taken from the tables' sequences in one
+     *      pipelined round-trip, so moves can be linked to each other before they are sent;
+     *   2. the batch's positions that are not in the dictionary, copied into a temporary
+     *      table and inserted where new;
+     *   3. the games and moves, each streamed with a binary COPY.
+     *
+     * Positions in the dictionary, which once warmed is most of them, are never sent. Ones
+     * that another writer added since are found by the insert and their IDs read back, so a
+     * stale or empty dictionary costs time but not correctness. The dictionary learns the new
+     * IDs when the transaction commits.
+     *
+     * A batch of a few thousand games keeps the round-trips rare and the buffers small.
+     */
+    class BulkLoader
+    {
+    public:
+        BulkLoader(Connection &conn, PositionDictionary &dictionary);
+
+        // Writes all of the games or, if anything fails, none of them
+        LoadStats load(std::span<const Game> games);
+
+        /* The network half of `load`, for games whose positions were collected and looked
+         * up elsewhere: fills in the IDs of the unknown positions, and leaves the dictionary
+         * to the caller.
+         */
+        LoadStats write(std::span<const Game> games, BatchPositions &positions);
+
+    private:
+        void resolvePositions(BatchPositions &positions, const std::vector<int64_t> &newIDs, LoadStats &stats);
+        void copyGames(std::span<const Game> games, const std::vector<int64_t> &gameIDs);
+        void copyMoves(std::span<const Game> games, const std::vector<int64_t> &gameIDs,
+                       const std::vector<int64_t> &moveIDs, const BatchPositions &positions);
+
+    private:
+        Connection &m_conn;
+        PositionDictionary &m_dictionary;
+        CopyWriter m_copy;
+        BatchPositions m_positions;
+        PositionDictionary m_scratch;
+        bool m_tempTable = false;
+    };
+} // namespace JChess::Database
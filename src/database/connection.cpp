@@ -0,0 +1,237 @@
+#include "database/connection.h"
+
+#include <charconv>
+#include <stdexcept>
+#include <utility>
+
+namespace JChess::Database
+{
+    namespace
+    {
+        std::runtime_error error(PGconn *conn, std::string_view context)
+        {
+            std::string message{context};
+            message += ": ";
+            message += conn ? PQerrorMessage(conn) : "out of memory";
+            while (!message.empty() && message.back() == '\n')
+                message.pop_back();
+            return std::runtime_error(message);
+        }
+    } // namespace
+
+    int64_t Result::integer(size_t row, size_t column) const
+    {
+        auto bytes = value(row, column);
+        uint64_t value = 0;
+        for (char c : bytes)
+            value = value << 8 | static_cast<uint8_t>(c);
+        // Sign-extend 4-byte integers
+        if (bytes.size() == 4)
+            return static_cast<int32_t>(value);
+        return static_cast<int64_t>(value);
+    }
+
+    size_t Result::affectedRows() const
+    {
+        std::string_view count{PQcmdTuples(m_result)};
+        size_t rows = 0;
+        std::from_chars(count.data(), count.data() + count.size(), rows);
+        return rows;
+    }
+
+    Connection::Connection(const std::string &conninfo)
+        : m_conn(PQconnectdb(conninfo.c_str()))
+    {
+        if (!m_conn || PQstatus(m_conn) != CONNECTION_OK)
+        {
+            auto e = error(m_conn, "Could not connect to the database");
+            PQfinish(m_conn);
+            throw e;
+        }
+    }
+
+    Connection::~Connection()
+    {
+        PQfinish(m_conn);
+    }
+
+    Connection::Connection(Connection &&other) noexcept
+        : m_conn(std::exchange(other.m_conn, nullptr)), m_prepared(std::move(other.m_prepared))
+    {
+    }
+
+    Connection &Connection::operator=(Connection &&other) noexcept
+    {
+        std::swap(m_conn, other.m_conn);
+        std::swap(m_prepared, other.m_prepared);
+        return *this;
+    }
+
+    Result Connection::check(PGresult *result)
+    {
+        Result owned{result};
+        auto status = PQresultStatus(result);
+        if (status != PGRES_COMMAND_OK && status != PGRES_TUPLES_OK)
+            throw error(m_conn, "Query failed");
+        return owned;
+    }
+
+    Result Connection::exec(const char *sql)
+    {
+        return check(PQexec(m_conn, sql));
+    }
+
+    Result Connection::exec(const char *sql, const Params &params, bool binaryResults)
+    {
+        return check(PQexecParams(m_conn, sql, static_cast<int>(params.size()), params.types(), params.values(),
+                                  params.lengths(), params.formats(), binaryResults));
+    }
+
+    void Connection::prepare(const Statement &statement, const Params &params)
+    {
+        if (m_prepared.contains(statement.name))
+            return;
+        check(PQprepare(m_conn, statement.name, statement.sql, static_cast<int>(params.size()), params.types()));
+        m_prepared.insert(statement.name);
+    }
+
+    Result Connection::exec(const Statement &statement, const Params &params, bool binaryResults)
+    {
+        prepare(statement, params);
+        return check(PQexecPrepared(m_conn, statement.name, static_cast<int>(params.size()), params.values(),
+                                    params.lengths(), params.formats(), binaryResults));
+    }
+
+    std::vector<Result> Connection::pipeline(const std::vector<Query> &queries, bool binaryResults)
+    {
+        // Preparing is a round-trip of its own, but only the first time
+        for (const auto &query : queries)
+            prepare(*query.statement, query.params);
+
+        if (PQenterPipelineMode(m_conn) != 1)
+            throw error(m_conn, "Could not enter pipeline mode");
+
+        bool sent = true;
+        for (const auto &query : queries)
+        {
+            const auto &params = query.params;
+            sent = sent && PQsendQueryPrepared(m_conn, query.statement->name, static_cast<int>(params.size()),
+                                               params.values(), params.lengths(), params.formats(), binaryResults) == 1;
+        }
+        sent = sent && PQpipelineSync(m_conn) == 1;
+        // Only a broken connection fails to send, so there is nothing to recover
+        if (!sent)
+            throw error(m_conn, "Could not send a pipeline");
+
+        // Each statement's result is followed by a null one, and the sync by its own result
+        std::vector<Result> results;
+        results.reserve(queries.size());
+        std::string failure;
+        for (size_t i = 0; i < queries.size(); ++i)
+        {
+            Result result{PQgetResult(m_conn)};
+            auto status = PQresultStatus(result.raw());
+            if (failure.empty() && status != PGRES_COMMAND_OK && status != PGRES_TUPLES_OK)
+                failure = result.raw() ? PQresultErrorMessage(result.raw()) : PQerrorMessage(m_conn);
+            if (result.raw())
+                PQclear(PQgetResult(m_conn));
+            results.push_back(std::move(result));
+        }
+        Result sync{PQgetResult(m_conn)};
+        if (PQresultStatus(sync.raw()) != PGRES_PIPELINE_SYNC && failure.empty())
+            failure = PQerrorMessage(m_conn);
+        PQexitPipelineMode(m_conn);
+
+        if (!failure.empty())
+        {
+            while (!failure.empty() && failure.back() == '\n')
+                failure.pop_back();
+            throw std::runtime_error("Query failed: " + failure);
+        }
+        return results;
+    }
+
+    bool Connection::idle() const
+    {
+        return PQstatus(m_conn) == CONNECTION_OK && PQtransactionStatus(m_conn) == PQTRANS_IDLE;
+    }
+
+    void Connection::copyIn(const char *sql, std::string_view data)
+    {
+        Result start{PQexec(m_conn, sql)};
+        if (PQresultStatus(start.raw()) != PGRES_COPY_IN)
+            throw error(m_conn, "Could not start COPY");
+
+        // libpq buffers what it is given; chunks keep that buffer small
+        constexpr size_t chunkSize = 1 << 20;
+        bool sent = true;
+        for (size_t offset = 0; sent && offset < data.size(); offset += chunkSize)
+        {
+            auto chunk = data.substr(offset, chunkSize);
+            sent = PQputCopyData(m_conn, chunk.data(), static_cast<int>(chunk.size())) == 1;
+        }
+        if (PQputCopyEnd(m_conn, sent ? nullptr : "could not send data") != 1)
+            throw error(m_conn, "Could not end COPY");
+
+        // One result for the COPY, then none
+        Result result{PQgetResult(m_conn)};
+        while (PGresult *extra = PQgetResult(m_conn))
+            PQclear(extra);
+        if (!sent || PQresultStatus(result.raw()) != PGRES_COMMAND_OK)
+            throw error(m_conn, "COPY failed");
+    }
+
+    void Connection::copyOut(const char *sql, const std::function<void(std::string_view)> &onData)
+    {
+        Result start{PQexec(m_conn, sql)};
+        if (PQresultStatus(start.raw()) != PGRES_COPY_OUT)
+            throw error(m_conn, "Could not start COPY");
+
+        char *buffer = nullptr;
+        int length;
+        while ((length = PQgetCopyData(m_conn, &buffer, 0)) > 0)
+        {
+            try
+            {
+                onData({buffer, static_cast<size_t>(length)});
+            }
+            catch (...)
+            {
+                // Drain the COPY, so the connection stays usable
+                PQfreemem(buffer);
+                while (PQgetCopyData(m_conn, &buffer, 0) > 0)
+                    PQfreemem(buffer);
+                while (PGresult *extra = PQgetResult(m_conn))
+                    PQclear(extra);
+                throw;
+            }
+            PQfreemem(buffer);
+        }
+
+        Result result{PQgetResult(m_conn)};
+        while (PGresult *extra = PQgetResult(m_conn))
+            PQclear(extra);
+        if (length == -2 || PQresultStatus(result.raw()) != PGRES_COMMAND_OK)
+            throw error(m_conn, "COPY failed");
+    }
+
+    Transaction::Transaction(Connection &conn)
+        : m_conn(conn)
+    {
+        m_conn.exec("BEGIN");
+    }
+
+    Transaction::~Transaction()
+    {
+        if (m_done)
+            return;
+        // Nothing to do if even that fails: the server rolls back when the connection closes
+        PQclear(PQexec(m_conn.raw(), "ROLLBACK"));
+    }
+
+    void Transaction::commit()
+    {
+        m_conn.exec("COMMIT");
+        m_done = true;
+    }
+} // namespace JChess::Database
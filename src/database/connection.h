@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <libpq-fe.h>
+
+#include "database/params.h"
+
+namespace JChess::Database
+{
+    /* A query result, owning its `PGresult`. Values are text, or the binary send format of
+     * their type if the query asked for binary results.
+     */
+    class Result
+    {
+    public:
+        explicit Result(PGresult *result = nullptr) : m_result(result) {}
+        ~Result() { PQclear(m_result); }
+
+        Result(Result &&other) noexcept : m_result(std::exchange(other.m_result, nullptr)) {}
+        Result &operator=(Result &&other) noexcept
+        {
+            std::swap(m_result, other.m_result);
+            return *this;
+        }
+        Result(const Result &) = delete;
+        Result &operator=(const Result &) = delete;
+
+        size_t rows() const { return static_cast<size_t>(PQntuples(m_result)); }
+        bool isNull(size_t row, size_t column) const { return PQgetisnull(m_result, static_cast<int>(row), static_cast<int>(column)); }
+        std::string_view value(size_t row, size_t column) const
+        {
+            return {PQgetvalue(m_result, static_cast<int>(row), static_cast<int>(column)),
+                    static_cast<size_t>(PQgetlength(m_result, static_cast<int>(row), static_cast<int>(column)))};
+        }
+        // A binary `bigint` or `integer` value
+        int64_t integer(size_t row, size_t column) const;
+        // The rows an INSERT, UPDATE or DELETE touched
+        size_t affectedRows() const;
+
+        PGresult *raw() const { return m_result; }
+
+    private:
+        PGresult *m_result;
+    };
+
+    /* A statement that each connection prepares the first time it runs it, with the types
+     * of the parameters it is given then, and from then on runs by name: the server parses
+     * and plans it once per connection. Define them as constants; `name` must be unique.
+     */
+    struct Statement
+    {
+        const char *name;
+        const char *sql;
+    };
+
+    // A statement and its parameters, for `Connection::pipeline`
+    struct Query
+    {
+        const Statement *statement;
+        Params params;
+    };
+
+    /* A libpq connection. Every failure throws `std::runtime_error` with the server's
+     * message.
+     */
+    class Connection
+    {
+    public:
+        // `conninfo` as for `PQconnectdb`, e.g., "dbname=chess" or a postgresql:// URI
+        explicit Connection(const std::string &conninfo);
+        ~Connection();
+
+        Connection(Connection &&other) noexcept;
+        Connection &operator=(Connection &&other) noexcept;
+        Connection(const Connection &) = delete;
+        Connection &operator=(const Connection &) = delete;
+
+        // Runs one or more statements, without parameters
+        Result exec(const char *sql);
+        // Runs a statement once, asking for binary or text results
+        Result exec(const char *sql, const Params &params, bool binaryResults = true);
+        // Runs a prepared statement, preparing it first if this connection has not
+        Result exec(const Statement &statement, const Params &params = {}, bool binaryResults = true);
+
+        /* Runs prepared statements in pipeline mode: all are sent before any result is read,
+         * so they take one round-trip together. If one fails, the ones after it are skipped
+         * and its error is thrown once all are done. COPY cannot be pipelined.
+         */
+        std::vector<Result> pipeline(const std::vector<Query> &queries, bool binaryResults = true);
+
+        // Runs a `COPY ... FROM STDIN` statement, sending `data` as its input
+        void copyIn(const char *sql, std::string_view data);
+        // Runs a `COPY ... TO STDOUT` statement, passing each buffer of its output to `onData`
+        void copyOut(const char *sql, const std::function<void(std::string_view)> &onData);
+
+        // Connected, and not in a transaction
+        bool idle() const;
+
+        PGconn *raw() const { return m_conn; }
+
+    private:
+        Result check(PGresult *result);
+        void prepare(const Statement &statement, const Params &params);
+
+    private:
+        PGconn *m_conn = nullptr;
+        std::unordered_set<std::string> m_prepared; // statement names
+    };
+
+    /* A transaction, rolled back by the destructor unless committed.
+     */
+    class Transaction
+    {
+    public:
+        explicit Transaction(Connection &conn);
+        ~Transaction();
+
+        Transaction(const Transaction &) = delete;
+        Transaction &operator=(const Transaction &) = delete;
+
+        void commit();
+
+    private:
+        Connection &m_conn;
+        bool m_done = false;
+    };
+} // namespace JChess::Database
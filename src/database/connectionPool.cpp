@@ -0,0 +1,86 @@
+#include "database/connectionPool.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace JChess::Database
+{
+    ConnectionPool::Lease::Lease(ConnectionPool &pool, std::unique_ptr<Connection> conn)
+        : m_pool(&pool), m_conn(std::move(conn))
+    {
+    }
+
+    ConnectionPool::Lease::Lease(Lease &&other) noexcept
+        : m_pool(other.m_pool), m_conn(std::move(other.m_conn))
+    {
+    }
+
+    ConnectionPool::Lease &ConnectionPool::Lease::operator=(Lease &&other) noexcept
+    {
+        std::swap(m_pool, other.m_pool);
+        std::swap(m_conn, other.m_conn);
+        return *this;
+    }
+
+    ConnectionPool::Lease::~Lease()
+    {
+        if (m_conn)
+            m_pool->release(std::move(m_conn));
+    }
+
+    ConnectionPool::ConnectionPool(std::string conninfo, size_t size)
+        : m_conninfo(std::move(conninfo)), m_size(std::max<size_t>(size, 1))
+    {
+    }
+
+    ConnectionPool::Lease ConnectionPool::acquire()
+    {
+        {
+            std::unique_lock lock{m_mutex};
+            m_released.wait(lock, [this] { return !m_idle.empty() || m_open < m_size; });
+            if (!m_idle.empty())
+            {
+                auto conn = std::move(m_idle.back());
+                m_idle.pop_back();
+                return Lease{*this, std::move(conn)};
+            }
+            ++m_open;
+        }
+
+        // Connecting takes a round-trip or more, so it happens outside the lock
+        try
+        {
+            return Lease{*this, std::make_unique<Connection>(m_conninfo)};
+        }
+        catch (...)
+        {
+            {
+                std::lock_guard lock{m_mutex};
+                --m_open;
+            }
+            m_released.notify_one();
+            throw;
+        }
+    }
+
+    size_t ConnectionPool::open() const
+    {
+        std::lock_guard lock{m_mutex};
+        return m_open;
+    }
+
+    void ConnectionPool::release(std::unique_ptr<Connection> conn)
+    {
+        bool reusable = conn->idle();
+        if (!reusable)
+            conn.reset();
+        {
+            std::lock_guard lock{m_mutex};
+            if (reusable)
+                m_idle.push_back(std::move(conn));
+            else
+                --m_open;
+        }
+        m_released.notify_one();
+    }
+} // namespace JChess::Database
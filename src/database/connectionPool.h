@@ -0,0 +1,71 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "database/connection.h"
+
+namespace JChess::Database
+{
+    /* Up to `size` connections to one database, shared by threads. A connection is opened
+     * the first time one is needed and none is free, and kept open for the next caller, so
+     * its prepared statements are reused as well:
+     *
+     *     ConnectionPool pool{"dbname=chess", 4};
+     *     auto conn = pool.acquire();
+     *     insertGame(*conn, game);
+     *
+     * A connection that comes back broken or inside a transaction is closed rather than
+     * handed out again.
+     */
+    class ConnectionPool
+    {
+    public:
+        // A connection on loan, returned to the pool by the destructor
+        class Lease
+        {
+        public:
+            Lease(Lease &&other) noexcept;
+            Lease &operator=(Lease &&other) noexcept;
+            ~Lease();
+
+            Connection &operator*() const { return *m_conn; }
+            Connection *operator->() const { return m_conn.get(); }
+
+        private:
+            friend class ConnectionPool;
+            Lease(ConnectionPool &pool, std::unique_ptr<Connection> conn);
+
+            ConnectionPool *m_pool;
+            std::unique_ptr<Connection> m_conn;
+        };
+
+        ConnectionPool(std::string conninfo, size_t size);
+
+        ConnectionPool(const ConnectionPool &) = delete;
+        ConnectionPool &operator=(const ConnectionPool &) = delete;
+
+        // Waits for a free connection if `size` are on loan. Throws if one cannot be opened
+        Lease acquire();
+
+        size_t size() const { return m_size; }
+        // Connections open now, on loan or not
+        size_t open() const;
+
+    private:
+        void release(std::unique_ptr<Connection> conn);
+
+    private:
+        const std::string m_conninfo;
+        const size_t m_size;
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_released;
+        std::vector<std::unique_ptr<Connection>> m_idle;
+        size_t m_open = 0; // including those being opened
+    };
+} // namespace JChess::Database
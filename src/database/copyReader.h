@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+
+namespace JChess::Database
+{
+    /* Reads the output of a `COPY ... TO STDOUT (FORMAT binary)`, the format `CopyWriter`
+     * writes. libpq hands that output over a row per buffer, with the header ahead of the
+     * first row and the trailer on its own. The reader takes the buffers one by one with
+     * `feed`.
+     *
+     * Malformed data throws `std::runtime_error`.
+     */
+    class CopyReader
+    {
+    public:
+        // Starts on a buffer, skipping the header if it has one
+        void feed(std::string_view data)
+        {
+            using namespace std::string_view_literals;
+            constexpr auto signature = "PGCOPY\n\377\r\n\0"sv;
+            m_data = data;
+            if (m_data.starts_with(signature))
+            {
+                m_data.remove_prefix(signature.size());
+                get<uint32_t>(); // flags
+                skip(get<uint32_t>()); // header extension
+            }
+        }
+
+        // Starts the buffer's row, returning its field count, or 0 for the trailer or nothing
+        size_t row()
+        {
+            if (m_data.empty())
+                return 0;
+            auto fields = get<int16_t>();
+            return fields < 0 ? 0 : static_cast<size_t>(fields);
+        }
+
+        // The next field's bytes, or nothing if it is NULL
+        std::optional<std::string_view> field()
+        {
+            auto length = get<int32_t>();
+            if (length < 0)
+                return std::nullopt;
+            auto value = m_data.substr(0, static_cast<size_t>(length));
+            skip(static_cast<size_t>(length));
+            return value;
+        }
+
+        // The next field, which must be a `bigint`
+        int64_t int64()
+        {
+            if (get<int32_t>() != 8)
+                throw std::runtime_error("Expected a bigint in the COPY data.");
+            return get<int64_t>();
+        }
+
+    private:
+        void skip(size_t count)
+        {
+            if (count > m_data.size())
+                throw std::runtime_error("Truncated COPY data.");
+            m_data.remove_prefix(count);
+        }
+
+        template <class T>
+        T get()
+        {
+            if (m_data.size() < sizeof(T))
+                throw std::runtime_error("Truncated COPY data.");
+            uint64_t bits = 0;
+            for (size_t i = 0; i < sizeof(T); ++i)
+                bits = bits << 8 | static_cast<uint8_t>(m_data[i]);
+            m_data.remove_prefix(sizeof(T));
+            return static_cast<T>(bits);
+        }
+
+    private:
+        std::string_view m_data;
+    };
+} // namespace JChess::Database
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "database/sendFormat.h"
+
+namespace JChess::Database
+{
+    /* Builds the input of a `COPY ... FROM STDIN (FORMAT binary)`: a signature and header,
+     * then per row a field count and each field as a length and the bytes of the type's
+     * binary send format (-1 for NULL), then a -1 trailer. All integers are big-endian.
+     *
+     * The caller writes exactly the fields of the target columns, in order, with the right
+     * types; the server rejects the COPY otherwise.
+     */
+    class CopyWriter
+    {
+    public:
+        CopyWriter() { clear(); }
+
+        void row(uint16_t fields) { put<uint16_t>(fields); }
+
+        void null() { put<int32_t>(-1); }
+        void boolean(bool value) { field<uint8_t>(value); }
+        void int16(int16_t value) { field(value); }
+        void int32(int32_t value) { field(value); }
+        void int64(int64_t value) { field(value); }
+        // `text`, `varchar` and enum labels
+        void text(std::string_view value) { bytes(value); }
+        void bytes(std::string_view value)
+        {
+            put(static_cast<int32_t>(value.size()));
+            m_data.append(value);
+        }
+        void timestamp(std::chrono::sys_seconds time) { field(SendFormat::timestamp(time)); }
+        void interval(std::chrono::microseconds duration)
+        {
+            put(static_cast<int32_t>(SendFormat::intervalSize));
+            SendFormat::appendInterval(m_data, duration);
+        }
+
+        // The complete input, with its trailer
+        const std::string &finish()
+        {
+            put<int16_t>(-1);
+            return m_data;
+        }
+
+        size_t size() const { return m_data.size(); }
+        // Starts over, keeping the buffer
+        void clear()
+        {
+            using namespace std::string_view_literals;
+            m_data.clear();
+            m_data.append("PGCOPY\n\377\r\n\0"sv);
+            put<int32_t>(0); // flags
+            put<int32_t>(0); // header extension length
+        }
+
+    private:
+        template <class T>
+        void put(T value) { SendFormat::append(m_data, value); }
+
+        template <class T>
+        void field(T value)
+        {
+            put(static_cast<int32_t>(sizeof(T)));
+            put(value);
+        }
+
+    private:
+        std::string m_data;
+    };
+} // namespace JChess::Database
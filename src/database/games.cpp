@@ -1,73 +1,146 @@
 #include "database/games.h"
 
-#include <array>
-#include <cstdint>
-#include <format>
-#include <sstream>
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
-#include <pqxx/pqxx>
+#include "database/blobs.h"
+#include "database/bulkLoader.h"
+#include "database/positionDictionary.h"
+#include "database/schema.h"
 
-namespace JChess
+namespace JChess::Database
 {
-    std::string_view assembleMovesBlob(const std::vector<Move> &moves)
+    namespace
     {
-        std::string moveData;
-        moveData.resize(moves.size() * 4);
-        uint16_t m = 0;
-        uint64_t count = 0;
-        for (const auto &move : moves)
+        constexpr Statement allocateMoveIDs{
+            "jchess_allocate_move_ids",
+            "SELECT nextval(pg_get_serial_sequence('moves', 'moveid')) FROM generate_series(1, $1)"};
+        constexpr Statement insertGameRow{
+            "jchess_insert_game",
+            "INSERT INTO games (datetimeUTC, whiteUsername, blackUsername, whiteELO, blackELO, timeLimit, "
+            "timeIncrement, winner, condition, halfMoves, ecoCode, startFEN, movesBlob) "
+            "VALUES ($1, $2, $3, $4, $5, $6, $7, $8::gameWinner, $9::winCondition, $10, $11, $12, $13) "
+            "RETURNING gameID"};
+        // The position's ID, adding it if it is new. No rows if another transaction added it
+        // meanwhile, which `findPosition` then sees
+        constexpr Statement addPosition{
+            "jchess_add_position",
+            "WITH found AS (SELECT positionID FROM positions WHERE position = $1), "
+            "added AS (INSERT INTO positions (position) SELECT $1 WHERE NOT EXISTS (SELECT FROM found) "
+            "ON CONFLICT (position) DO NOTHING RETURNING positionID) "
+            "SELECT positionID FROM found UNION ALL SELECT positionID FROM added"};
+        constexpr Statement selectPosition{
+            "jchess_select_position",
+            "SELECT positionID FROM positions WHERE position = $1"};
+        constexpr Statement insertMove{
+            "jchess_insert_move",
+            "INSERT INTO moves (moveID, gameID, prevMoveID, nextMoveID, positionID, moveNumber, move, "
+            "timeLeft, evaluationCP, evaluationM, annotation) "
+            "VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11::annotationType)"};
+
+        Params gameParams(const Game &game)
+        {
+            Params params;
+            params.timestamp(game.datetime).text(game.whiteUsername).text(game.blackUsername);
+            for (uint16_t elo : {game.whiteELO, game.blackELO})
+                elo ? params.int32(elo) : params.null();
+            game.timeControl.initial.count() ? params.interval(game.timeControl.initial) : params.null();
+            params.interval(game.timeControl.increment);
+            params.text(winnerLabels[static_cast<size_t>(game.result.type)]);
+            params.text(conditionLabels[static_cast<size_t>(game.result.reason)]);
+            params.int32(static_cast<int32_t>(game.moves.size()));
+            game.ECOCode.size() == 3 ? params.text(game.ECOCode) : params.null();
+            params.text(game.startFEN);
+            std::string movesBlob;
+            appendMovesBlob(movesBlob, game.moves);
+            params.bytes(movesBlob);
+            return params;
+        }
+
+        Params moveParams(const Game &game, size_t i, int64_t gameID, const std::vector<int64_t> &moveIDs, int64_t positionID)
         {
-            uint16_t m = static_cast<uint16_t>(move.piece.color);
-            m <<= 3;
-            m |= static_cast<uint16_t>(move.piece.type);
-            m <<= 3;
-            m |= move.from.file;
-            m <<= 3;
-            m |= move.from.rank;
-            m <<= 3;
-            m |= move.to.file;
-            m <<= 3;
-            m |= move.to.rank;
+            Params params;
+            params.int64(moveIDs[i]).int64(gameID);
+            i > 0 ? params.int64(moveIDs[i - 1]) : params.null();
+            i + 1 < moveIDs.size() ? params.int64(moveIDs[i + 1]) : params.null();
+            params.int64(positionID).int32(static_cast<int32_t>(i + 1));
+            params.int16(static_cast<int16_t>(PackedMove{game.moves[i]}.raw()));
 
-            count += 4;
-            moveData[count - 1] = '0' + (m & 0x000F);
-            m >>= 4;
-            moveData[count - 2] = '0' + (m & 0x000F);
-            m >>= 4;
-            moveData[count - 3] = '0' + (m & 0x000F);
-            m >>= 4;
-            moveData[count - 4] = '0' + (m & 0x000F);
+            game.clocks && i < game.clocks->size() ? params.interval((*game.clocks)[i]) : params.null();
+            if (game.evaluations && i < game.evaluations->size())
+            {
+                const auto &evaluation = (*game.evaluations)[i];
+                if (evaluation.centipawns)
+                    params.int32(evaluation.value).null();
+                else
+                    params.null().int32(evaluation.value);
+            }
+            else
+                params.null().null();
+            if (game.annotations && i < game.annotations->size() && (*game.annotations)[i] != Annotation::None)
+                params.text(annotationLabels[static_cast<size_t>((*game.annotations)[i])]);
+            else
+                params.null();
+            return params;
         }
-        return moveData;
-    }
+    } // namespace
 
-    std::string_view insertGameCommand(const Game &game)
+    int64_t insertGame(Connection &conn, const Game &game)
     {
-        constexpr std::array<std::string_view, 4> results{"white", "black", "draw", "none"};
-        constexpr std::array<std::string_view, 8> conditions{
-            "none", "checkmate", "timeout", "resignation",
-            "infraction", "stalemate", "agreement", "material"};
+        BatchPositions positions;
+        PositionDictionary scratch;
+        positions.collect({&game, 1}, scratch);
+
+        Transaction txn{conn};
 
-        std::ostringstream command{
-            "INSERT INTO games (gameID, datetimeUTC, whiteUsername, blackUsername,"
-            " whiteELO, blackELO, timeLimit, timeIncrement, winner, condition,"
-            " halfMoves, ecoCode, movesBlob) VALUES "};
+        // The positions are added in the order of their keys, as `BulkLoader` does, rather than
+        // as played. Otherwise two games that transpose could each wait on the other's new
+        // position, and the server would abort one of them as deadlocked.
+        std::vector<size_t> order(positions.positions.size());
+        std::iota(order.begin(), order.end(), size_t{0});
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                  { return positions.positions[a].key() < positions.positions[b].key(); });
 
-        auto timestamp = std::format("timestamp (0) '{:04d}{:02d}{:02d} {:02d}:{:02d}:{:02d}'",
-                                     game.datetime.year, game.datetime.month, game.datetime.day,
-                                     game.datetime.hour, game.datetime.minute, game.datetime.second);
-        auto timeLimit = std::format("INTERVAL '{} seconds'", game.timeControl.initialTime);
-        auto timeIncrement = std::format("INTERVAL '{} seconds'", game.timeControl.increment);
-        auto result = results[static_cast<int>(game.result.type)];
-        auto condition = conditions[static_cast<int>(game.result.reason)];
-        auto movesBlob = std::format("bytea '\\x{}');", assembleMovesBlob(game.moves));
+        // The game, its move IDs and its positions' IDs
+        std::vector<Query> queries;
+        queries.reserve(2 + positions.positions.size());
+        queries.push_back({&insertGameRow, gameParams(game)});
+        queries.push_back({&allocateMoveIDs, Params{}.int64(static_cast<int64_t>(game.moves.size()))});
+        for (size_t i : order)
+            queries.push_back({&addPosition, Params{}.bytes(positions.positions[i].key())});
+        auto results = conn.pipeline(queries);
 
-        command << "(DEFAULT, " << timestamp << ", " << game.whiteUsername << ", " << game.blackUsername << ", "
-                << game.whiteELO << ", " << game.blackELO << ", " << timeLimit << ", " << timeIncrement << ", "
-                << result << ", " << condition << ", " << game.moves.size() << ", " << game.ECOCode << ", "
-                << movesBlob << ");";
+        int64_t gameID = results[0].integer(0, 0);
+        std::vector<int64_t> moveIDs(game.moves.size());
+        if (results[1].rows() != moveIDs.size())
+            throw std::runtime_error("Could not allocate IDs for moves.");
+        for (size_t i = 0; i < moveIDs.size(); ++i)
+            moveIDs[i] = results[1].integer(i, 0);
+        for (size_t k = 0; k < order.size(); ++k)
+        {
+            const auto &result = results[2 + k];
+            size_t i = order[k];
+            positions.ids[i] = result.rows() ? result.integer(0, 0) : findPosition(conn, positions.positions[i]);
+            if (!positions.ids[i])
+                throw std::runtime_error("Could not resolve the ID of a position.");
+        }
+
+        // The moves, linked to each other
+        queries.clear();
+        for (size_t i = 0; i < game.moves.size(); ++i)
+            queries.push_back({&insertMove, moveParams(game, i, gameID, moveIDs, positions.ids[positions.plyPositions[i]])});
+        conn.pipeline(queries);
 
-        return command.str();
+        txn.commit();
+        return gameID;
+    }
+
+    int64_t findPosition(Connection &conn, const PackedPosition &position)
+    {
+        auto result = conn.exec(selectPosition, Params{}.bytes(position.key()));
+        return result.rows() ? result.integer(0, 0) : 0;
     }
-} // namespace JChess
+} // namespace JChess::Database
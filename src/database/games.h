@@ -1,15 +1,20 @@
 #pragma once
 
-#include <vector>
+#include <cstdint>
 
-#include <pqxx/pqxx>
+#include "core/game.h"
+#include "core/packedPosition.h"
+#include "database/connection.h"
 
-#include "internal/game/game.h"
-#include "internal/game/move.h"
-
-namespace JChess
+namespace JChess::Database
 {
-    std::string_view assembleMovesBlob(const std::vector<Move> &moves);
-    std::string_view insertGameCommand(const Game &game);
-    bool insertGame(pqxx::connection &conn, const Game &game);
-} // namespace JChess
+    /* Writes one game, its moves and the positions not yet in the table, in a transaction,
+     * and returns the game's ID. All statements are prepared once per connection and sent
+     * in two pipelines, so a game takes four round-trips however long it is. For more than a
+     * few games at a time, `BulkLoader` is much faster.
+     */
+    int64_t insertGame(Connection &conn, const Game &game);
+
+    // The ID of a position, or 0 if it is not in the table
+    int64_t findPosition(Connection &conn, const PackedPosition &position);
+} // namespace JChess::Database
@@ -0,0 +1,322 @@
+#include "database/ingestPipeline.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include "database/connection.h"
+#include "formats/pgnFile.h"
+#include "formats/pgnReader.h"
+
+namespace JChess::Database
+{
+    namespace
+    {
+        using Clock = std::chrono::steady_clock;
+
+        IngestOptions resolved(IngestOptions options)
+        {
+            unsigned hardware = std::max(std::thread::hardware_concurrency(), 1u);
+            if (!options.parsers)
+                options.parsers = hardware;
+            if (!options.replayers)
+                options.replayers = hardware;
+            options.writers = std::max(options.writers, 1u);
+            options.batchBytes = std::max<size_t>(options.batchBytes, 1);
+            return options;
+        }
+
+        size_t queueCapacity(const IngestOptions &options, unsigned consumers)
+        {
+            return options.queueBatches ? options.queueBatches : 2 * size_t{consumers};
+        }
+    } // namespace
+
+    IngestPipeline::IngestPipeline(const std::string &conninfo, std::istream &input, PositionDictionary &dictionary,
+                                   IngestOptions options)
+        : m_dictionary(dictionary),
+          m_options(resolved(options)),
+          m_texts(queueCapacity(m_options, m_options.parsers)),
+          m_parsed(queueCapacity(m_options, m_options.replayers)),
+          m_replayed(queueCapacity(m_options, m_options.writers)),
+          m_start(Clock::now())
+    {
+        counters(IngestStage::Read).running = 1;
+        counters(IngestStage::Parse).running = m_options.parsers;
+        counters(IngestStage::Replay).running = m_options.replayers;
+        counters(IngestStage::Write).running = m_options.writers;
+
+        m_threads.reserve(1 + m_options.parsers + m_options.replayers + m_options.writers);
+        try
+        {
+            m_threads.emplace_back(&IngestPipeline::read, this, std::ref(input));
+            for (unsigned i = 0; i < m_options.parsers; ++i)
+                m_threads.emplace_back(&IngestPipeline::parse, this);
+            for (unsigned i = 0; i < m_options.replayers; ++i)
+                m_threads.emplace_back(&IngestPipeline::replay, this);
+            for (unsigned i = 0; i < m_options.writers; ++i)
+                m_threads.emplace_back(&IngestPipeline::write, this, conninfo);
+        }
+        catch (...)
+        {
+            // Those that did start would wait forever on the stages that did not
+            stop();
+            for (auto &thread : m_threads)
+                thread.join();
+            throw;
+        }
+    }
+
+    IngestPipeline::~IngestPipeline()
+    {
+        stop();
+        for (auto &thread : m_threads)
+            if (thread.joinable())
+                thread.join();
+    }
+
+    LoadStats IngestPipeline::wait()
+    {
+        for (auto &thread : m_threads)
+            if (thread.joinable())
+                thread.join();
+        std::lock_guard lock{m_mutex};
+        if (m_error)
+            std::rethrow_exception(m_error);
+        return m_loaded;
+    }
+
+    IngestStats IngestPipeline::stats() const
+    {
+        IngestStats stats;
+        for (size_t i = 0; i < stats.stages.size(); ++i)
+        {
+            const auto &counters = m_counters[i];
+            auto &stage = stats.stages[i];
+            stage.batches = counters.batches.load(std::memory_order_relaxed);
+            stage.games = counters.games.load(std::memory_order_relaxed);
+            stage.busySeconds = static_cast<double>(counters.busyNanoseconds.load(std::memory_order_relaxed)) * 1e-9;
+        }
+        stats.stages[static_cast<size_t>(IngestStage::Read)].threads = 1;
+        stats.stages[static_cast<size_t>(IngestStage::Parse)].threads = m_options.parsers;
+        stats.stages[static_cast<size_t>(IngestStage::Replay)].threads = m_options.replayers;
+        stats.stages[static_cast<size_t>(IngestStage::Write)].threads = m_options.writers;
+
+        auto queue = [&](IngestStage stage, const auto &input)
+        {
+            stats.stages[static_cast<size_t>(stage)].queued = input.size();
+            stats.stages[static_cast<size_t>(stage)].queueCapacity = input.capacity();
+        };
+        queue(IngestStage::Parse, m_texts);
+        queue(IngestStage::Replay, m_parsed);
+        queue(IngestStage::Write, m_replayed);
+
+        stats.seconds = std::chrono::duration<double>(Clock::now() - m_start).count();
+        stats.skipped = m_skipped.load(std::memory_order_relaxed);
+        std::lock_guard lock{m_mutex};
+        stats.loaded = m_loaded;
+        return stats;
+    }
+
+    void IngestPipeline::record(IngestStage stage, size_t games, Clock::time_point since)
+    {
+        auto &stageCounters = counters(stage);
+        stageCounters.batches.fetch_add(1, std::memory_order_relaxed);
+        stageCounters.games.fetch_add(games, std::memory_order_relaxed);
+        stageCounters.busyNanoseconds.fetch_add(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - since).count(),
+            std::memory_order_relaxed);
+    }
+
+    bool IngestPipeline::leave(IngestStage stage)
+    {
+        return counters(stage).running.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    }
+
+    void IngestPipeline::fail()
+    {
+        {
+            std::lock_guard lock{m_mutex};
+            if (!m_error)
+                m_error = std::current_exception();
+        }
+        stop();
+    }
+
+    void IngestPipeline::stop()
+    {
+        m_stopped = true;
+        m_texts.close();
+        m_parsed.close();
+        m_replayed.close();
+    }
+
+    void IngestPipeline::read(std::istream &input)
+    {
+        try
+        {
+            // The text after the last game boundary of a piece starts the next one
+            std::string pending;
+            size_t target = m_options.batchBytes;
+            bool more = true;
+            while (more && !m_stopped)
+            {
+                auto start = Clock::now();
+                std::string text = std::move(pending);
+                size_t have = text.size();
+                if (have < target)
+                {
+                    text.resize(target);
+                    input.read(text.data() + have, static_cast<std::streamsize>(target - have));
+                    text.resize(have + static_cast<size_t>(input.gcount()));
+                    if (input.bad())
+                        throw std::runtime_error("Could not read the input.");
+                    more = !input.eof();
+                }
+
+                size_t cut = more ? nextGameBoundary(text, text.size() / 2) : text.size();
+                if (more && cut == text.size())
+                {
+                    // A game longer than half a piece: read on until one ends
+                    pending = std::move(text);
+                    target += m_options.batchBytes;
+                    continue;
+                }
+                target = m_options.batchBytes;
+                pending.assign(text, cut);
+                text.resize(cut);
+                record(IngestStage::Read, 0, start);
+                if (!text.empty() && !m_texts.push(std::move(text)))
+                    break;
+            }
+        }
+        catch (...)
+        {
+            fail();
+        }
+        if (leave(IngestStage::Read))
+            m_texts.close();
+    }
+
+    void IngestPipeline::parse()
+    {
+        try
+        {
+            while (auto text = m_texts.pop())
+            {
+                if (m_stopped)
+                    break;
+                auto start = Clock::now();
+                ParsedBatch batch;
+                PGNReader reader{std::string_view{*text}};
+                while (const auto *pgnGame = reader.next())
+                {
+                    try
+                    {
+                        batch.games.push_back(readPGN(*pgnGame));
+                    }
+                    catch (const std::exception &)
+                    {
+                        m_skipped.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+                record(IngestStage::Parse, batch.games.size(), start);
+                if (!m_parsed.push(std::move(batch)))
+                    break;
+            }
+        }
+        catch (...)
+        {
+            fail();
+        }
+        if (leave(IngestStage::Parse))
+            m_parsed.close();
+    }
+
+    void IngestPipeline::replay()
+    {
+        try
+        {
+            PositionDictionary scratch;
+            while (auto parsed = m_parsed.pop())
+            {
+                if (m_stopped)
+                    break;
+                auto start = Clock::now();
+                ReplayedBatch batch{std::move(parsed->games), {}};
+                batch.positions.collect(batch.games, scratch);
+                {
+                    std::shared_lock lock{m_dictionaryMutex};
+                    batch.positions.lookup(m_dictionary);
+                }
+                if (m_options.explorer)
+                    explore(batch);
+                record(IngestStage::Replay, batch.games.size(), start);
+                if (!m_replayed.push(std::move(batch)))
+                    break;
+            }
+        }
+        catch (...)
+        {
+            fail();
+        }
+        if (leave(IngestStage::Replay))
+            m_replayed.close();
+    }
+
+    void IngestPipeline::explore(const ReplayedBatch &batch)
+    {
+        const auto &positions = batch.positions;
+        std::vector<uint64_t> hashes(positions.positions.size());
+        for (size_t i = 0; i < hashes.size(); ++i)
+            hashes[i] = positions.positions[i].hash();
+
+        // The hashes of each game's plies, in the order `collect` replayed them
+        std::vector<std::vector<uint64_t>> plies(batch.games.size());
+        size_t ply = 0;
+        for (size_t i = 0; i < batch.games.size(); ++i)
+        {
+            size_t moves = batch.games[i].moves.size();
+            size_t counted = std::min(moves, m_options.explorer->maxPlies());
+            plies[i].reserve(counted);
+            for (size_t j = 0; j < counted; ++j)
+                plies[i].push_back(hashes[positions.plyPositions[ply + j]]);
+            ply += moves;
+        }
+
+        std::lock_guard lock{m_explorerMutex};
+        for (size_t i = 0; i < batch.games.size(); ++i)
+            m_options.explorer->add(batch.games[i], plies[i]);
+    }
+
+    void IngestPipeline::write(const std::string &conninfo)
+    {
+        try
+        {
+            Connection conn{conninfo};
+            BulkLoader loader{conn, m_dictionary};
+            while (auto batch = m_replayed.pop())
+            {
+                if (m_stopped)
+                    break;
+                auto start = Clock::now();
+                auto loaded = loader.write(batch->games, batch->positions);
+                {
+                    std::unique_lock lock{m_dictionaryMutex};
+                    batch->positions.learn(m_dictionary);
+                }
+                record(IngestStage::Write, loaded.games, start);
+
+                std::lock_guard lock{m_mutex};
+                m_loaded.games += loaded.games;
+                m_loaded.moves += loaded.moves;
+                m_loaded.newPositions += loaded.newPositions;
+            }
+        }
+        catch (...)
+        {
+            fail();
+        }
+        leave(IngestStage::Write);
+    }
+} // namespace JChess::Database
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <istream>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "core/boundedQueue.h"
+#include "core/game.h"
+#include "database/bulkLoader.h"
+#include "database/positionDictionary.h"
+#include "formats/openingExplorer.h"
+
+namespace JChess::Database
+{
+    struct IngestOptions
+    {
+        // Threads parsing PGN and replaying games; 0 for one per hardware thread
+        unsigned parsers = 0;
+        unsigned replayers = 0;
+        // Connections writing batches at once
+        unsigned writers = 2;
+        // Approximate size of the PGN text per batch, which ends at a game boundary; 4 MB is
+        // a few thousand games of a Lichess export
+        size_t batchBytes = 4 << 20;
+        // Batches each queue holds; 0 for twice the threads taking from it
+        size_t queueBatches = 0;
+        // Also counts the games into this explorer index, if set, which must outlive the
+        // pipeline. Games are counted as they are replayed, so after an error it may have
+        // some that were never written.
+        OpeningExplorerBuilder *explorer = nullptr;
+    };
+
+    enum class IngestStage
+    {
+        Read,
+        Parse,
+        Replay,
+        Write,
+    };
+    inline constexpr std::array<std::string_view, 4> ingestStageNames{"read", "parse", "replay", "write"};
+
+    /* A snapshot of the pipeline's counters. A stage whose threads are busy nearly all the
+     * time, with its input queue full and its output queue empty, is the one holding the
+     * others back.
+     */
+    struct IngestStats
+    {
+        struct Stage
+        {
+            unsigned threads = 0;
+            size_t batches = 0;
+            // Games handled, which the reader does not count
+            size_t games = 0;
+            // Time spent working rather than waiting on the queues, summed over the threads
+            double busySeconds = 0;
+            // Batches waiting in the queue the stage takes from; the reader takes from none
+            size_t queued = 0;
+            size_t queueCapacity = 0;
+        };
+
+        std::array<Stage, 4> stages; // indexed by `IngestStage`
+        double seconds = 0;
+        // Games that could not be read, which are skipped
+        size_t skipped = 0;
+        LoadStats loaded;
+
+        const Stage &operator[](IngestStage stage) const { return stages[static_cast<size_t>(stage)]; }
+    };
+
+    /* Loads PGN games into the database on four stages of threads, connected by bounded
+     * queues of batches:
+     *
+     *   read    one thread cutting the input into pieces of `batchBytes` at game boundaries;
+     *   parse   `parsers` threads turning each piece into `Game`s;
+     *   replay  `replayers` threads collecting each batch's positions and looking them up in
+     *           the dictionary (`BatchPositions`), and counting the games into the
+     *           options' `explorer`, if any;
+     *   write   `writers` connections, each writing a batch per transaction with a
+     *           `BulkLoader`, then adding the new positions to the dictionary.
+     *
+     * Each queue holds a few batches, so a stage that falls behind holds back the ones before
+     * it rather than letting memory pile up, and `stats` shows which stage that is. Batches
+     * are written in no particular order.
+     *
+     *     PositionDictionary dictionary;
+     *     dictionary.warm(conn);
+     *     InputFile input{"games.pgn.zst"};
+     *     IngestPipeline pipeline{conninfo, input, dictionary};
+     *     auto loaded = pipeline.wait();
+     *
+     * The first error stops the pipeline and is thrown from `wait`. The batches already
+     * committed stay in the database.
+     */
+    class IngestPipeline
+    {
+    public:
+        // Starts the threads. `input` and `dictionary` must outlive the pipeline
+        IngestPipeline(const std::string &conninfo, std::istream &input, PositionDictionary &dictionary,
+                       IngestOptions options = {});
+        // Stops the pipeline, if it is still running, and waits for the threads
+        ~IngestPipeline();
+
+        IngestPipeline(const IngestPipeline &) = delete;
+        IngestPipeline &operator=(const IngestPipeline &) = delete;
+
+        // Waits until every batch is written, or the first error, which is thrown
+        LoadStats wait();
+
+        // Safe to call from any thread while the pipeline runs
+        IngestStats stats() const;
+
+    private:
+        struct ParsedBatch
+        {
+            std::vector<Game> games;
+        };
+        struct ReplayedBatch
+        {
+            std::vector<Game> games;
+            BatchPositions positions;
+        };
+
+        struct alignas(64) StageCounters
+        {
+            std::atomic<size_t> batches{0};
+            std::atomic<size_t> games{0};
+            std::atomic<int64_t> busyNanoseconds{0};
+            std::atomic<unsigned> running{0};
+        };
+
+        void read(std::istream &input);
+        void parse();
+        void replay();
+        void write(const std::string &conninfo);
+
+        // Called as each thread of a stage ends: true for the last one, which closes the
+        // stage's output
+        bool leave(IngestStage stage);
+        // Records the exception being handled, unless there already is one, and stops
+        void fail();
+        void stop();
+        void record(IngestStage stage, size_t games, std::chrono::steady_clock::time_point since);
+        StageCounters &counters(IngestStage stage) { return m_counters[static_cast<size_t>(stage)]; }
+
+        void explore(const ReplayedBatch &batch);
+
+    private:
+        PositionDictionary &m_dictionary;
+        std::shared_mutex m_dictionaryMutex;
+        std::mutex m_explorerMutex;
+        IngestOptions m_options;
+
+        BoundedQueue<std::string> m_texts;
+        BoundedQueue<ParsedBatch> m_parsed;
+        BoundedQueue<ReplayedBatch> m_replayed;
+
+        std::array<StageCounters, 4> m_counters;
+        std::chrono::steady_clock::time_point m_start;
+        std::atomic<size_t> m_skipped{0};
+        std::atomic<bool> m_stopped{false};
+
+        mutable std::mutex m_mutex; // guards the rest
+        LoadStats m_loaded;
+        std::exception_ptr m_error;
+
+        std::vector<std::thread> m_threads;
+    };
+} // namespace JChess::Database
@@ -1,10 +0,0 @@
-#pragma once
-
-#include <istream>
-
-#include <pqxx/pqxx>
-
-namespace JChess
-{
-    void insertGame(pqxx::connection &conn, const Game &game);
-} // namespace JChess
\ No newline at end of file
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <libpq-fe.h>
+
+#include "database/sendFormat.h"
+
+namespace JChess::Database
+{
+    /* The parameters of a statement, each sent with its type and in its binary send
+     * format, so the server neither guesses types nor parses text:
+     *
+     *     conn.exec(findPosition, Params{}.bytes(position.key()));
+     *
+     * NULL has no type of its own; the server takes it from the statement. Enum labels are
+     * `text`, cast in the SQL, e.g., `$1::gameWinner`.
+     */
+    class Params
+    {
+    public:
+        Params &null()
+        {
+            begin(0, -1);
+            return *this;
+        }
+        Params &boolean(bool value) { return field<uint8_t>(boolOid, value); }
+        Params &int16(int16_t value) { return field(int2Oid, value); }
+        Params &int32(int32_t value) { return field(int4Oid, value); }
+        Params &int64(int64_t value) { return field(int8Oid, value); }
+        Params &text(std::string_view value) { return add(textOid, value); }
+        Params &bytes(std::string_view value) { return add(byteaOid, value); }
+        Params &timestamp(std::chrono::sys_seconds time) { return field(timestampOid, SendFormat::timestamp(time)); }
+        Params &interval(std::chrono::microseconds duration)
+        {
+            begin(intervalOid, SendFormat::intervalSize);
+            SendFormat::appendInterval(m_data, duration);
+            return *this;
+        }
+
+        size_t size() const { return m_types.size(); }
+
+        // The arrays `PQexecParams` and its relatives take
+        const Oid *types() const { return m_types.data(); }
+        const char *const *values() const
+        {
+            // The values move as the buffer grows, so their pointers are only taken now
+            m_values.resize(size());
+            for (size_t i = 0; i < size(); ++i)
+                m_values[i] = m_lengths[i] < 0 ? nullptr : m_data.data() + m_offsets[i];
+            return m_values.data();
+        }
+        const int *lengths() const { return m_lengths.data(); }
+        const int *formats() const { return m_formats.data(); }
+
+    private:
+        // From the server's pg_type catalog
+        static constexpr Oid boolOid = 16;
+        static constexpr Oid byteaOid = 17;
+        static constexpr Oid int8Oid = 20;
+        static constexpr Oid int2Oid = 21;
+        static constexpr Oid int4Oid = 23;
+        static constexpr Oid textOid = 25;
+        static constexpr Oid timestampOid = 1114;
+        static constexpr Oid intervalOid = 1186;
+
+        // Starts a parameter whose `length` bytes are appended next
+        void begin(Oid type, int length)
+        {
+            m_types.push_back(type);
+            m_offsets.push_back(m_data.size());
+            m_lengths.push_back(length);
+            m_formats.push_back(1);
+        }
+
+        template <class T>
+        Params &field(Oid type, T value)
+        {
+            begin(type, sizeof(T));
+            SendFormat::append(m_data, value);
+            return *this;
+        }
+
+        Params &add(Oid type, std::string_view value)
+        {
+            begin(type, static_cast<int>(value.size()));
+            m_data.append(value);
+            return *this;
+        }
+
+    private:
+        std::string m_data;
+        std::vector<Oid> m_types;
+        std::vector<size_t> m_offsets;
+        std::vector<int> m_lengths; // -1 for NULL
+        std::vector<int> m_formats;
+        mutable std::vector<const char *> m_values;
+    };
+} // namespace JChess::Database
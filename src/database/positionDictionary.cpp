@@ -0,0 +1,125 @@
+#include "database/positionDictionary.h"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+#include "database/copyReader.h"
+
+namespace JChess::Database
+{
+    namespace
+    {
+        constexpr size_t minCapacity = 16;
+
+        // The tag comes from the high half of the hash and the home slot from the low half, so
+        // the two are independent at any capacity up to 2^32
+        constexpr uint64_t tagOf(uint64_t hash) { return hash >> 32 << 32; }
+        constexpr uint64_t tagMask = ~uint64_t{0} << 32;
+        constexpr size_t entryOf(uint64_t slot) { return static_cast<size_t>(static_cast<uint32_t>(slot)) - 1; }
+
+        // At most three quarters full
+        constexpr size_t capacityFor(size_t count)
+        {
+            return std::bit_ceil(std::max(minCapacity, count + count / 3 + 1));
+        }
+    } // namespace
+
+    size_t PositionDictionary::probe(const PackedPosition &position, uint64_t hash) const
+    {
+        const size_t mask = m_slots.size() - 1;
+        const uint64_t tag = tagOf(hash);
+        for (size_t i = hash & mask;; i = (i + 1) & mask)
+        {
+            uint64_t slot = m_slots[i];
+            if (!slot || ((slot & tagMask) == tag && m_positions[entryOf(slot)] == position))
+                return i;
+        }
+    }
+
+    int64_t PositionDictionary::find(const PackedPosition &position) const
+    {
+        if (m_slots.empty())
+            return 0;
+        uint64_t slot = m_slots[probe(position, position.hash())];
+        return slot ? m_ids[entryOf(slot)] : 0;
+    }
+
+    bool PositionDictionary::insert(const PackedPosition &position, int64_t id)
+    {
+        if (id <= 0)
+            throw std::runtime_error("Position IDs must be positive.");
+        if (m_slots.size() < capacityFor(m_positions.size() + 1))
+            rehash(capacityFor(m_positions.size() + 1));
+
+        uint64_t hash = position.hash();
+        size_t i = probe(position, hash);
+        if (m_slots[i])
+            return false;
+        if (m_positions.size() >= UINT32_MAX)
+            throw std::runtime_error("Too many positions for the dictionary.");
+        m_positions.push_back(position);
+        m_ids.push_back(id);
+        m_slots[i] = tagOf(hash) | m_positions.size();
+        return true;
+    }
+
+    void PositionDictionary::reserve(size_t count)
+    {
+        m_positions.reserve(count);
+        m_ids.reserve(count);
+        if (m_slots.size() < capacityFor(count))
+            rehash(capacityFor(count));
+    }
+
+    void PositionDictionary::clear()
+    {
+        std::fill(m_slots.begin(), m_slots.end(), 0);
+        m_positions.clear();
+        m_ids.clear();
+    }
+
+    size_t PositionDictionary::memoryUsage() const
+    {
+        return m_slots.capacity() * sizeof(uint64_t) + m_positions.capacity() * sizeof(PackedPosition) +
+               m_ids.capacity() * sizeof(int64_t);
+    }
+
+    void PositionDictionary::rehash(size_t capacity)
+    {
+        // Entries do not move, so only the slots are rebuilt
+        m_slots.assign(capacity, 0);
+        const size_t mask = capacity - 1;
+        for (size_t entry = 0; entry < m_positions.size(); ++entry)
+        {
+            uint64_t hash = m_positions[entry].hash();
+            size_t i = hash & mask;
+            while (m_slots[i])
+                i = (i + 1) & mask;
+            m_slots[i] = tagOf(hash) | (entry + 1);
+        }
+    }
+
+    size_t PositionDictionary::warm(Connection &conn)
+    {
+        size_t rows = 0;
+        CopyReader reader;
+        conn.copyOut("COPY positions (positionID, position) TO STDOUT (FORMAT binary)",
+                     [&](std::string_view data)
+                     {
+                         reader.feed(data);
+                         size_t fields = reader.row();
+                         if (!fields)
+                             return;
+                         if (fields != 2)
+                             throw std::runtime_error("Unexpected COPY data for positions.");
+                         int64_t id = reader.int64();
+                         auto key = reader.field();
+                         if (!key)
+                             throw std::runtime_error("A position is NULL.");
+                         insert(PackedPosition::fromKey(*key), id);
+                         ++rows;
+                     });
+        return rows;
+    }
+} // namespace JChess::Database
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "core/packedPosition.h"
+#include "database/connection.h"
+
+namespace JChess::Database
+{
+    /* The IDs of positions, kept in memory so a loader sends the server only the positions
+     * it has not seen.
+     *
+     * An open-addressing table with linear probing. Each slot is 8 bytes: 32 bits of the
+     * position's hash as a tag, and the index of its entry. The entries, the positions and
+     * their IDs, are stored densely beside the slots. A probe reads slots until the tag
+     * matches and only then compares the full key, so a lookup touches one or two cache
+     * lines of slots and the one entry it returns. A position costs 40 bytes of entry and
+     * 11 to 21 bytes of slots.
+     *
+     * IDs are positive. Not thread-safe for writes.
+     */
+    class PositionDictionary
+    {
+    public:
+        PositionDictionary() = default;
+
+        // The ID of `position`, or 0 if it is not in the dictionary
+        int64_t find(const PackedPosition &position) const;
+        // Adds `position` with `id`, or returns false, changing nothing, if it is already there
+        bool insert(const PackedPosition &position, int64_t id);
+
+        // Makes room for `count` positions in all
+        void reserve(size_t count);
+        // Removes every position, keeping the memory
+        void clear();
+
+        size_t size() const { return m_positions.size(); }
+        // Bytes allocated for the slots and entries
+        size_t memoryUsage() const;
+
+        // Adds every row of the `positions` table, returning how many were read
+        size_t warm(Connection &conn);
+
+    private:
+        // The slot holding `position`, or the empty slot where it would go
+        size_t probe(const PackedPosition &position, uint64_t hash) const;
+        void rehash(size_t capacity);
+
+    private:
+        // `tag << 32 | (entry + 1)`, or 0 if empty. The capacity is a power of two
+        std::vector<uint64_t> m_slots;
+        std::vector<PackedPosition> m_positions;
+        std::vector<int64_t> m_ids;
+    };
+} // namespace JChess::Database
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <string_view>
+
+namespace JChess::Database
+{
+    // The labels of the enum types below, indexed by `GameResult::Type`, `GameResult::Reason`
+    // and `Annotation`, whose `None` is NULL
+    inline constexpr std::array<std::string_view, 4> winnerLabels{"white", "black", "draw", "none"};
+    inline constexpr std::array<std::string_view, 8> conditionLabels{
+        "none", "checkmate", "timeout", "resignation",
+        "infraction", "stalemate", "agreement", "material"};
+    inline constexpr std::array<std::string_view, 7> annotationLabels{
+        "", "good", "mistake", "brilliant", "blunder", "interesting", "dubious"};
+
+    /* The tables `BulkLoader` writes to. IDs are identity columns generated BY DEFAULT, so
+     * the loader can take them from the sequences in blocks and link moves to each other
+     * before sending them. Run it once, e.g., with `Connection::exec`, on an empty schema.
+     */
+    constexpr const char *schema = R"sql(
+CREATE TYPE gameWinner AS ENUM ('white', 'black', 'draw', 'none');
+CREATE TYPE winCondition AS ENUM (
+    'none',
+    'checkmate',
+    'timeout',
+    'resignation',
+    'infraction',
+    'stalemate',
+    'agreement',
+    'material'
+);
+CREATE TYPE annotationType AS ENUM (
+    'good',
+    'mistake',
+    'brilliant',
+    'blunder',
+    'interesting',
+    'dubious'
+);
+CREATE TABLE IF NOT EXISTS games (
+    gameID BIGINT PRIMARY KEY GENERATED BY DEFAULT AS IDENTITY,
+    datetimeUTC TIMESTAMP (0),
+    whiteUsername TEXT,
+    blackUsername TEXT,
+    whiteELO INTEGER CHECK (whiteELO BETWEEN 100 AND 6000),
+    blackELO INTEGER CHECK (blackELO BETWEEN 100 AND 6000),
+    timeLimit INTERVAL CHECK (timeLimit > '0 seconds'),
+    timeIncrement INTERVAL CHECK (timeIncrement >= '0 seconds'),
+    winner gameWinner NOT NULL,
+    condition winCondition,
+    halfMoves INTEGER NOT NULL CHECK (halfMoves >= 0),
+    ecoCode VARCHAR(3) CHECK (char_length(ecoCode) = 3),
+    -- Empty for the standard starting position
+    startFEN TEXT,
+    -- Two bytes per move: `PackedMove::raw()`, little-endian
+    movesBlob BYTEA NOT NULL
+);
+-- The first `PackedPosition::keySize` bytes of a `PackedPosition`
+CREATE TABLE IF NOT EXISTS positions (
+    positionID BIGINT PRIMARY KEY GENERATED BY DEFAULT AS IDENTITY,
+    position BYTEA NOT NULL UNIQUE CHECK (octet_length(position) = 26)
+);
+CREATE TABLE IF NOT EXISTS moves (
+    moveID BIGINT PRIMARY KEY GENERATED BY DEFAULT AS IDENTITY,
+    gameID BIGINT NOT NULL REFERENCES games ON UPDATE CASCADE ON DELETE CASCADE,
+    -- Links within the game, not foreign keys, so loading need not check them row by row
+    prevMoveID BIGINT,
+    nextMoveID BIGINT,
+    -- The position the move is played from
+    positionID BIGINT NOT NULL REFERENCES positions ON UPDATE CASCADE,
+    moveNumber INTEGER NOT NULL CHECK (moveNumber > 0),
+    -- `PackedMove::raw()`, as a signed 16-bit integer; the pieces and squares follow from it
+    -- and the position
+    move SMALLINT NOT NULL,
+    timeLeft INTERVAL,
+    evaluationCP INTEGER,
+    evaluationM INTEGER,
+    annotation annotationType
+);
+CREATE INDEX IF NOT EXISTS moves_gameID ON moves (gameID);
+CREATE INDEX IF NOT EXISTS moves_positionID ON moves (positionID);
+)sql";
+} // namespace JChess::Database
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+/* The binary send formats of the column types the database module writes, shared by
+ * `CopyWriter` and `Params`. All integers are big-endian.
+ */
+namespace JChess::Database::SendFormat
+{
+    template <class T>
+    void append(std::string &data, T value)
+    {
+        auto bits = static_cast<std::make_unsigned_t<T>>(value);
+        for (size_t shift = 8 * sizeof(T); shift > 0; shift -= 8)
+            data.push_back(static_cast<char>(bits >> (shift - 8)));
+    }
+
+    // `timestamp`, in microseconds since 2000-01-01
+    constexpr int64_t timestamp(std::chrono::sys_seconds time)
+    {
+        constexpr int64_t postgresEpoch = 946684800;
+        return (time.time_since_epoch().count() - postgresEpoch) * 1000000;
+    }
+
+    // `interval`: microseconds, then days and months, which are left at zero
+    constexpr size_t intervalSize = 16;
+    inline void appendInterval(std::string &data, std::chrono::microseconds duration)
+    {
+        append<int64_t>(data, duration.count());
+        append<int32_t>(data, 0);
+        append<int32_t>(data, 0);
+    }
+} // namespace JChess::Database::SendFormat
@@ -0,0 +1,267 @@
+#include "formats/algebraic.h"
+
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+#include "core/attacks.h"
+#include "core/bitboard.h"
+#include "core/board.h"
+#include "core/castling.h"
+#include "core/legalMoves.h"
+
+namespace JChess::Algebraic
+{
+    namespace
+    {
+        std::optional<PieceType> pieceFromChar(char c)
+        {
+            switch (c)
+            {
+            case 'N':
+                return PieceType::Knight;
+            case 'B':
+                return PieceType::Bishop;
+            case 'R':
+                return PieceType::Rook;
+            case 'Q':
+                return PieceType::Queen;
+            case 'K':
+                return PieceType::King;
+            default:
+                return std::nullopt;
+            }
+        }
+
+        bool isFile(char c) { return 'a' <= c && c <= 'h'; }
+        bool isRank(char c) { return '1' <= c && c <= '8'; }
+
+        // A SAN token taken apart, without reference to any position
+        struct ParsedSAN
+        {
+            PieceType type = PieceType::Pawn;
+            size_t toIdx = 0;
+            int fromFile = -1;
+            int fromRank = -1;
+            std::optional<PieceType> promotion;
+            std::optional<Castling::Side> castle;
+        };
+
+        constexpr std::string_view pieceChars = "PNBRQK";
+
+        /* The other pieces of the moving type that could legally move to the same square: the
+         * ones attacking it, less any that are pinned (or would leave a check unanswered).
+         * Kings and pawns never need this.
+         */
+        Bitboard rivals(const State &state, PackedMove move, PieceType type)
+        {
+            const auto &board = state.board;
+            size_t to = move.toIdx();
+            Bitboard occupied = board.occupied();
+            Bitboard others = board.pieces(state.turn, type) & Attacks::attackersTo(board, to, occupied) &
+                              ~Bitboards::bit(move.fromIdx());
+            if (!others)
+                return others;
+
+            size_t king = Board::squareToIdx(board.kingSquare(state.turn));
+            Bitboard enemies = board.pieces(oppositeColor(state.turn)) & ~Bitboards::bit(to);
+            Bitboard legal = Bitboards::empty;
+            while (others)
+            {
+                size_t idx = Bitboards::popLsb(others);
+                Bitboard after = (occupied & ~Bitboards::bit(idx)) | Bitboards::bit(to);
+                if (!(Attacks::attackersTo(board, king, after) & enemies))
+                    legal |= Bitboards::bit(idx);
+            }
+            return legal;
+        }
+
+        [[noreturn]] void invalid(std::string_view san, const char *reason)
+        {
+            throw std::runtime_error(std::string(reason) + ": \"" + std::string(san) + "\"");
+        }
+
+        ParsedSAN parse(std::string_view san)
+        {
+            ParsedSAN parsed;
+            std::string_view s = san;
+            while (!s.empty() && (s.back() == '+' || s.back() == '#' || s.back() == '!' || s.back() == '?'))
+                s.remove_suffix(1);
+
+            if (s == "O-O" || s == "0-0")
+            {
+                parsed.type = PieceType::King;
+                parsed.castle = Castling::Side::KING;
+                return parsed;
+            }
+            if (s == "O-O-O" || s == "0-0-0")
+            {
+                parsed.type = PieceType::King;
+                parsed.castle = Castling::Side::QUEEN;
+                return parsed;
+            }
+
+            if (!s.empty())
+                if (auto type = pieceFromChar(s.front()))
+                {
+                    parsed.type = type.value();
+                    s.remove_prefix(1);
+                }
+
+            // "e8=Q", or "e8Q" as some writers have it
+            if (parsed.type == PieceType::Pawn && !s.empty())
+                if (auto promotion = pieceFromChar(s.back()); promotion && promotion != PieceType::King)
+                {
+                    parsed.promotion = promotion;
+                    s.remove_suffix(1);
+                    if (!s.empty() && s.back() == '=')
+                        s.remove_suffix(1);
+                }
+
+            if (s.size() < 2 || !isFile(s[s.size() - 2]) || !isRank(s.back()))
+                invalid(san, "Invalid SAN move");
+            parsed.toIdx = Board::squareToIdx(Square{s[s.size() - 2] - 'a', s.back() - '1'});
+            s.remove_suffix(2);
+
+            // What is left is the disambiguation and the capture mark: [file][rank][x]
+            if (!s.empty() && (s.back() == 'x' || s.back() == ':'))
+                s.remove_suffix(1);
+            if (!s.empty() && isFile(s.front()))
+            {
+                parsed.fromFile = s.front() - 'a';
+                s.remove_prefix(1);
+            }
+            if (!s.empty() && isRank(s.front()))
+            {
+                parsed.fromRank = s.front() - '1';
+                s.remove_prefix(1);
+            }
+            if (!s.empty())
+                invalid(san, "Invalid SAN move");
+
+            return parsed;
+        }
+    } // namespace
+
+    void SANResolver::reset(const State &state)
+    {
+        JChess::legalMoves(state, m_moves);
+
+        m_first.fill(none);
+        const auto &occupants = state.board.eachOccupant();
+        // Linked in reverse, so that each chain lists its moves in generation order
+        for (size_t i = m_moves.size(); i-- > 0;)
+        {
+            auto move = m_moves[i];
+            auto &first = m_first[key(occupants[move.fromIdx()]->type, move.toIdx())];
+            m_next[i] = first;
+            first = static_cast<uint8_t>(i);
+        }
+    }
+
+    PackedMove SANResolver::resolve(std::string_view san) const
+    {
+        auto parsed = parse(san);
+
+        if (parsed.castle)
+        {
+            for (auto move : m_moves)
+                if (move.castle() == parsed.castle)
+                    return move;
+            invalid(san, "Illegal move");
+        }
+
+        PackedMove found;
+        size_t matches = 0;
+        for (auto i = m_first[key(parsed.type, parsed.toIdx)]; i != none; i = m_next[i])
+        {
+            auto move = m_moves[i];
+            if (move.isCastle())
+                continue;
+            if (parsed.fromFile >= 0 && move.from().file != parsed.fromFile)
+                continue;
+            if (parsed.fromRank >= 0 && move.from().rank != parsed.fromRank)
+                continue;
+            if (move.isPromotion() != parsed.promotion.has_value())
+                continue;
+            if (move.isPromotion() && move.promotionType() != parsed.promotion.value())
+                continue;
+
+            found = move;
+            ++matches;
+        }
+
+        if (matches == 0)
+            invalid(san, "Illegal move");
+        if (matches > 1)
+            invalid(san, "Ambiguous move");
+        return found;
+    }
+
+    Move fromSAN(const State &state, std::string_view san)
+    {
+        return SANResolver{state}.resolve(san).unpack(state.board);
+    }
+
+    void writeSAN(std::string &out, State &state, PackedMove move)
+    {
+        auto from = move.from();
+        auto to = move.to();
+
+        if (auto side = move.castle())
+            out += (side == Castling::Side::KING) ? "O-O" : "O-O-O";
+        else
+        {
+            auto type = state.board.eachOccupant()[move.fromIdx()]->type;
+            if (type == PieceType::Pawn)
+            {
+                if (move.isCapture())
+                {
+                    out += static_cast<char>('a' + from.file);
+                    out += 'x';
+                }
+            }
+            else
+            {
+                out += pieceChars[static_cast<size_t>(type)];
+                if (type != PieceType::King)
+                    if (Bitboard others = rivals(state, move, type))
+                    {
+                        bool fileShared = false, rankShared = false;
+                        while (others)
+                        {
+                            auto square = Board::idxToSquare(Bitboards::popLsb(others));
+                            fileShared |= square.file == from.file;
+                            rankShared |= square.rank == from.rank;
+                        }
+                        if (!fileShared || rankShared)
+                            out += static_cast<char>('a' + from.file);
+                        if (fileShared)
+                            out += static_cast<char>('1' + from.rank);
+                    }
+                if (move.isCapture())
+                    out += 'x';
+            }
+
+            out += static_cast<char>('a' + to.file);
+            out += static_cast<char>('1' + to.rank);
+            if (move.isPromotion())
+            {
+                out += '=';
+                out += pieceChars[static_cast<size_t>(move.promotionType())];
+            }
+        }
+
+        state.applyMove(move);
+        if (inCheck(state))
+            out += hasAnyLegalMove(state) ? '+' : '#';
+    }
+
+    std::string toSAN(const State &state, PackedMove move)
+    {
+        std::string san;
+        State after = state;
+        writeSAN(san, after, move);
+        return san;
+    }
+} // namespace JChess::Algebraic
@@ -1,6 +1,75 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "core/move.h"
+#include "core/moveList.h"
+#include "core/packedMove.h"
+#include "core/piece.h"
+#include "core/state.h"
+
 namespace JChess::Algebraic
 {
+    /* Resolves moves in standard algebraic notation (SAN), e.g., "Nbd7", "exd6", "e8=Q+" or
+     * "O-O", against one position. The position's legal moves are generated once and indexed
+     * by moving piece type and destination square, so a token is only compared with the few
+     * legal moves that land on its square. As only legal moves are indexed, pins, en passant
+     * and promotions resolve exactly, and disambiguation is needed only where SAN requires it.
+     *
+     *     SANResolver resolver{state};
+     *     PackedMove move = resolver.resolve("Nf3");
+     *
+     * Nothing is allocated, so one resolver can be reset for every ply of a game.
+     */
+    class SANResolver
+    {
+    public:
+        SANResolver() = default;
+        explicit SANResolver(const State &state) { reset(state); }
+
+        // Index the legal moves of the given position, replacing the previous one
+        void reset(const State &state);
+
+        /* The legal move the token denotes. Check, mate and annotation suffixes are ignored,
+         * as is a missing or superfluous capture mark. Throws `std::runtime_error` if the token
+         * is malformed, or if it matches no legal move or more than one.
+         */
+        PackedMove resolve(std::string_view san) const;
+
+        const MoveList &legalMoves() const { return m_moves; }
+
+    private:
+        static constexpr size_t key(PieceType type, size_t toIdx)
+        {
+            return static_cast<size_t>(type) * 64 + toIdx;
+        }
+
+        static constexpr uint8_t none = 0xFF;
+
+    private:
+        MoveList m_moves;
+        // Chains of indices into `m_moves`, one chain per key, ended by `none`. Filling these
+        // is cheaper than sorting the moves by key, and no chain is longer than a few moves.
+        std::array<uint8_t, 6 * 64> m_first;
+        std::array<uint8_t, MoveList::capacity> m_next;
+    };
+
+    /* The full move (moving and captured pieces and so on) that the token denotes in the
+     * given state. For many moves of one game, reuse a `SANResolver` instead.
+     */
+    Move fromSAN(const State &state, std::string_view san);
+
+    /* Append the SAN of a legal move to `out`, e.g., "Nbd7", "exd6", "e8=Q+" or "O-O#", and
+     * play the move on `state`, which the check or mate suffix needs anyway. The origin is
+     * disambiguated only as far as SAN requires: by file, then rank, then both, counting only
+     * the other pieces that could legally make the same move.
+     */
+    void writeSAN(std::string &out, State &state, PackedMove move);
 
+    // The SAN of a legal move, for one-off use; leaves the state unchanged
+    std::string toSAN(const State &state, PackedMove move);
 } // namespace JChess::Algebraic
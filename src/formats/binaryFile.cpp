@@ -1,287 +1,814 @@
+#include "formats/binaryFile.h"
+
 #include <algorithm>
-#include <bitset>
+#include <array>
+#include <bit>
 #include <cmath>
+#include <cstdio>
 #include <cstring>
-#include <functional>
-#include <variant>
+#include <stdexcept>
 
-#include "fileFormat/binaryFile.h"
+#include "core/legalMoves.h"
+#include "core/moveList.h"
+#include "core/packedMove.h"
+#include "core/state.h"
 
 namespace JChess
 {
-    constexpr std::string_view FORMATCODE = "PGN1";
-
-    template <class T, class U>
-    constexpr void writeToBits(T &bits, U value, uint8_t shift)
+    namespace
     {
-        bits <<= shift;
-        bits |= static_cast<T>(value);
-    }
+        constexpr std::string_view formatCodeV1 = "PGP1";
+        // The first layout of version 1, with 3-byte moves, which no longer describe a move
+        // on their own; they cannot be read, but are told apart from corrupt data
+        constexpr std::string_view formatCodeLegacy = "PGN1";
+        constexpr std::string_view formatCodeV2 = "PGN2";
+
+        // Evaluations are exact up to this many centipawns, and rounded to `evalCoarseStep` beyond
+        constexpr int32_t evalFineLimit = 1000;
+        constexpr int32_t evalCoarseStep = 10;
+        constexpr int32_t evalLimit = 30000;
+        // Codes from here up are mates: `evalMateBase + n` for mate in n, negated for the opponent
+        constexpr int32_t evalMateBase = evalFineLimit + (evalLimit - evalFineLimit) / evalCoarseStep + 1;
+
+        // Clock resolutions, the coarsest that every clock of a game is a multiple of
+        constexpr std::array<uint32_t, 4> clockUnits{1000, 100, 10, 1};
+
+        enum StatusBits : uint8_t
+        {
+            HasEvaluations = 1 << 0,
+            HasClocks = 1 << 1,
+            HasAnnotations = 1 << 2,
+            HasStartFEN = 1 << 3,
+            // bits 4-5: result type; bits 6-7: index into `clockUnits`
+        };
+
+        [[noreturn]] void invalid(const char *reason)
+        {
+            throw std::runtime_error(std::string("Invalid binary game: ") + reason);
+        }
 
-    template <class T, class U>
-    constexpr T readFromBits(T &bits, U mask, uint8_t shift)
-    {
-        T value = bits & static_cast<T>(mask);
-        bits >>= shift;
-        return value;
-    }
+        [[noreturn]] void unknownCode(std::string_view code)
+        {
+            if (code == formatCodeLegacy)
+                invalid("3-byte move layout of version 1, convert the games again from PGN");
+            invalid("unknown format code");
+        }
 
-    void writeBinary(std::ostream &output, const Game &game)
-    {
-        writeBinaryHeader(output, game);
-        for (const auto &m : game.moves)
-            writeBinaryMove(output, m);
+        constexpr uint64_t zigzag(int64_t value)
+        {
+            return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+        }
 
-        if (game.evaluations)
-            for (const auto &e : game.evaluations.value())
-                writeBinaryEvaluation(output, e.value);
+        constexpr int64_t unzigzag(uint64_t value)
+        {
+            return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+        }
 
-        if (game.clocks)
-            for (const auto &c : game.clocks.value())
-                writeBinaryClock(output, c.seconds);
-    }
+        class Writer
+        {
+        public:
+            explicit Writer(std::string &out)
+                : m_out(out) {}
 
-    void writeBinaryHeader(std::ostream &output, const Game &game)
-    {
-        output.write(FORMATCODE.data(), 4);
-        uint16_t whiteUsernameLength = game.whiteUsername.size();
-        uint16_t blackUsernameLength = game.blackUsername.size();
-        output.write(reinterpret_cast<const char *>(&whiteUsernameLength), sizeof(whiteUsernameLength));
-        output.write(reinterpret_cast<const char *>(&blackUsernameLength), sizeof(blackUsernameLength));
-        output.write(game.whiteUsername.c_str(), whiteUsernameLength);
-        output.write(game.blackUsername.c_str(), blackUsernameLength);
-        char formattedUTCDatetime[15];
-        snprintf(formattedUTCDatetime, 15, "%04d%02d%02d%02d%02d%02d",
-                 game.datetime.year, game.datetime.month, game.datetime.day,
-                 game.datetime.hour, game.datetime.minute, game.datetime.second);
-        output.write(formattedUTCDatetime, 14);
-
-        output.write(reinterpret_cast<const char *>(&game.whiteELO), sizeof(game.whiteELO));
-        output.write(reinterpret_cast<const char *>(&game.blackELO), sizeof(game.blackELO));
-        output.write(game.ECOCode.c_str(), 3);
-        output.write(reinterpret_cast<const char *>(&game.timeControl.initialTime), sizeof(game.timeControl.initialTime));
-        output.write(reinterpret_cast<const char *>(&game.timeControl.increment), sizeof(game.timeControl.increment));
-
-        uint8_t status = 0;
-        writeToBits(status, game.evaluations.has_value(), 1);
-        writeToBits(status, game.clocks.has_value(), 1);
-        writeToBits(status, game.result.type, 2);
-        writeToBits(status, game.result.reason, 3);
-        output.write(reinterpret_cast<const char *>(&status), sizeof(status));
-
-        uint16_t numberOfHalfMoves = game.moves.size();
-        output.write(reinterpret_cast<const char *>(&numberOfHalfMoves), sizeof(numberOfHalfMoves));
-    }
+            void byte(uint8_t value) { m_out += static_cast<char>(value); }
+            void bytes(std::string_view data) { m_out += data; }
+            void u16(uint16_t value)
+            {
+                byte(static_cast<uint8_t>(value));
+                byte(static_cast<uint8_t>(value >> 8));
+            }
+            void u32(uint32_t value)
+            {
+                u16(static_cast<uint16_t>(value));
+                u16(static_cast<uint16_t>(value >> 16));
+            }
+            void varint(uint64_t value)
+            {
+                while (value >= 0x80)
+                {
+                    byte(static_cast<uint8_t>(value | 0x80));
+                    value >>= 7;
+                }
+                byte(static_cast<uint8_t>(value));
+            }
+            void string(std::string_view str)
+            {
+                varint(str.size());
+                bytes(str);
+            }
 
-    void writeBinaryMove(std::ostream &output, const Move &move)
-    {
-        uint16_t move_data = 0;
-        writeToBits(move_data, move.piece.color, 1);
-        writeToBits(move_data, move.piece.type, 3);
-        writeToBits(move_data, move.from.file, 3);
-        writeToBits(move_data, move.from.rank, 3);
-        writeToBits(move_data, move.to.file, 3);
-        writeToBits(move_data, move.to.rank, 3);
-        output.write(reinterpret_cast<const char *>(&move_data), sizeof(move_data));
-
-        uint8_t extra_data = 0;
-        writeToBits(extra_data, move.check, 1);
-        writeToBits(extra_data, move.capturedPiece, 3);
-        // writeToBits(extra_data, move.annotation, 3);
-        output.write(reinterpret_cast<const char *>(&extra_data), sizeof(extra_data));
-    }
+        private:
+            std::string &m_out;
+        };
 
-    void writeBinaryEvaluation(std::ostream &output, const eval_t &eval)
-    {
-        if (const auto eval_ptr = std::get_if<float>(&eval))
-            output.write(reinterpret_cast<const char *>(eval_ptr), sizeof(*eval_ptr));
-        else if (const auto mate_evaluation_ptr = std::get_if<int>(&eval))
+        class Reader
         {
-            uint32_t tmp = (*mate_evaluation_ptr) | 0xFFFFFF00;
-            output.write(reinterpret_cast<const char *>(&tmp), sizeof(tmp));
+        public:
+            explicit Reader(std::string_view input)
+                : m_input(input) {}
+
+            std::string_view rest() const { return m_input; }
+
+            std::string_view bytes(size_t count)
+            {
+                if (m_input.size() < count)
+                    invalid("truncated");
+                auto data = m_input.substr(0, count);
+                m_input.remove_prefix(count);
+                return data;
+            }
+            uint8_t byte() { return static_cast<uint8_t>(bytes(1)[0]); }
+            uint16_t u16()
+            {
+                uint16_t low = byte();
+                return static_cast<uint16_t>(low | byte() << 8);
+            }
+            uint32_t u32()
+            {
+                uint32_t low = u16();
+                return low | static_cast<uint32_t>(u16()) << 16;
+            }
+            uint64_t varint()
+            {
+                uint64_t value = 0;
+                for (int shift = 0; shift < 64; shift += 7)
+                {
+                    uint8_t b = byte();
+                    value |= static_cast<uint64_t>(b & 0x7F) << shift;
+                    if (!(b & 0x80))
+                        return value;
+                }
+                invalid("varint too long");
+            }
+            void string(std::string &str)
+            {
+                auto length = varint();
+                str.assign(bytes(length));
+            }
+
+        private:
+            std::string_view m_input;
+        };
+
+        // Bits packed least significant first; `value` may have up to 32 bits
+        class BitWriter
+        {
+        public:
+            void write(uint32_t value, unsigned bits)
+            {
+                m_buffer |= static_cast<uint64_t>(value) << m_bits;
+                m_bits += bits;
+                while (m_bits >= 8)
+                {
+                    m_out += static_cast<char>(m_buffer);
+                    m_buffer >>= 8;
+                    m_bits -= 8;
+                }
+            }
+            std::string &finish()
+            {
+                if (m_bits)
+                    m_out += static_cast<char>(m_buffer);
+                m_buffer = 0;
+                m_bits = 0;
+                return m_out;
+            }
+
+        private:
+            std::string m_out;
+            uint64_t m_buffer = 0;
+            unsigned m_bits = 0;
+        };
+
+        class BitReader
+        {
+        public:
+            explicit BitReader(std::string_view input)
+                : m_input(input) {}
+
+            uint32_t read(unsigned bits)
+            {
+                while (m_bits < bits)
+                {
+                    if (m_input.empty())
+                        invalid("truncated bit stream");
+                    m_buffer |= static_cast<uint64_t>(static_cast<uint8_t>(m_input.front())) << m_bits;
+                    m_input.remove_prefix(1);
+                    m_bits += 8;
+                }
+                auto value = static_cast<uint32_t>(m_buffer & ((uint64_t{1} << bits) - 1));
+                m_buffer >>= bits;
+                m_bits -= bits;
+                return value;
+            }
+
+        private:
+            std::string_view m_input;
+            uint64_t m_buffer = 0;
+            unsigned m_bits = 0;
+        };
+
+        /* A move's index among the `count` legal moves in a truncated binary code: the first
+         * `2^b - count` indices take b - 1 bits and the rest b, where b is the bit width of
+         * `count - 1`. A forced move takes no bits. The b-bit codes are written as their high
+         * b - 1 bits then the lowest, so that the reader can tell them apart from the prefix.
+         */
+        void writeIndex(BitWriter &bits, uint32_t index, size_t count)
+        {
+            if (count <= 1)
+                return;
+            auto width = static_cast<unsigned>(std::bit_width(count - 1));
+            auto shortCodes = static_cast<uint32_t>((size_t{1} << width) - count);
+            if (index < shortCodes)
+                bits.write(index, width - 1);
+            else
+            {
+                uint32_t code = index + shortCodes;
+                bits.write(code >> 1, width - 1);
+                bits.write(code & 1, 1);
+            }
         }
-        else
-            throw std::runtime_error("Invalid evaluation type");
-    }
 
-    void writeBinaryClock(std::ostream &output, const uint16_t secondsRemaining)
-    {
-        output.write(reinterpret_cast<const char *>(&secondsRemaining), sizeof(secondsRemaining));
-    }
+        uint32_t readIndex(BitReader &bits, size_t count)
+        {
+            if (count <= 1)
+                return 0;
+            auto width = static_cast<unsigned>(std::bit_width(count - 1));
+            auto shortCodes = static_cast<uint32_t>((size_t{1} << width) - count);
+            uint32_t prefix = bits.read(width - 1);
+            if (prefix < shortCodes)
+                return prefix;
+            return ((prefix << 1) | bits.read(1)) - shortCodes;
+        }
 
-    void writeBinaryState(std::ostream &output, const State &board)
-    {
-        uint32_t row = 0;
-        size_t idx = 0;
-        for (auto i = 0; i < 8; ++i)
+        /* Adaptive Rice codes for the clock and evaluation deltas: the parameter follows the
+         * running mean of the values coded so far (as in LOCO-I), so a quiet stretch of a game
+         * costs a few bits per value. Quotients past `escape` are followed by the raw value.
+         */
+        class RiceCoder
+        {
+        public:
+            void write(BitWriter &bits, uint64_t value)
+            {
+                unsigned k = parameter();
+                uint64_t quotient = value >> k;
+                if (quotient < escape)
+                {
+                    bits.write((1u << quotient) - 1, static_cast<unsigned>(quotient) + 1);
+                    if (k)
+                        bits.write(static_cast<uint32_t>(value & ((uint64_t{1} << k) - 1)), k);
+                }
+                else
+                {
+                    bits.write((1u << escape) - 1, escape);
+                    bits.write(static_cast<uint32_t>(value), 32);
+                    bits.write(static_cast<uint32_t>(value >> 32), 32);
+                }
+                update(value);
+            }
+
+            uint64_t read(BitReader &bits)
+            {
+                unsigned k = parameter();
+                uint64_t quotient = 0;
+                while (quotient < escape && bits.read(1))
+                    ++quotient;
+                uint64_t value;
+                if (quotient < escape)
+                    value = (quotient << k) | (k ? bits.read(k) : 0);
+                else
+                {
+                    value = bits.read(32);
+                    value |= static_cast<uint64_t>(bits.read(32)) << 32;
+                }
+                update(value);
+                return value;
+            }
+
+        private:
+            static constexpr unsigned escape = 24;
+
+            unsigned parameter() const
+            {
+                unsigned k = 0;
+                while (k < 31 && (m_count << k) < m_total)
+                    ++k;
+                return k;
+            }
+
+            void update(uint64_t value)
+            {
+                m_total += std::min<uint64_t>(value, uint64_t{1} << 32);
+                if (++m_count == 32)
+                {
+                    m_total >>= 1;
+                    m_count >>= 1;
+                }
+            }
+
+        private:
+            uint64_t m_total = 4;
+            uint64_t m_count = 1;
+        };
+
+        int32_t quantizeEval(Evaluation eval)
         {
-            for (auto j = 0; j < 8; ++j)
+            if (!eval.centipawns)
             {
-                auto piece = board.board[idx++];
-                row <<= 1;
-                row |= static_cast<uint8_t>(piece.color);
-                row <<= 3;
-                row |= static_cast<uint8_t>(piece.type);
+                int32_t mate = std::clamp(eval.value, -0xFFFF, 0xFFFF);
+                return (mate < 0) ? -(evalMateBase - mate) : evalMateBase + mate;
             }
-            output.write(reinterpret_cast<const char *>(&row), sizeof(row));
+            int32_t cp = std::clamp(eval.value, -evalLimit, evalLimit);
+            int32_t magnitude = std::abs(cp);
+            if (magnitude > evalFineLimit)
+                magnitude = evalFineLimit + (magnitude - evalFineLimit + evalCoarseStep / 2) / evalCoarseStep;
+            return (cp < 0) ? -magnitude : magnitude;
         }
 
-        std::bitset<8> extra{0u};
-        if (board.enPassant)
-            extra |= static_cast<uint8_t>(board.enPassant.value().file);
-        extra[7] = board.turn == Color::Black;
-        extra[6] = board.castleRights.get(Color::White, CastleRights::Side::KING);
-        extra[5] = board.castleRights.get(Color::White, CastleRights::Side::QUEEN);
-        extra[4] = board.castleRights.get(Color::Black, CastleRights::Side::KING);
-        extra[3] = board.castleRights.get(Color::Black, CastleRights::Side::QUEEN);
-        uint8_t extra_byte = static_cast<uint8_t>(extra.to_ulong());
-        output.write(reinterpret_cast<const char *>(&extra_byte), sizeof(extra_byte));
-
-        auto tmp = board.halfTurnCounter;
-        if (board.enPassant)
-            tmp = std::numeric_limits<uint8_t>::max();
-        output.write(reinterpret_cast<const char *>(&tmp), sizeof(tmp));
-
-        output.write(reinterpret_cast<const char *>(&board.fullTurnCounter), sizeof(board.fullTurnCounter));
-    }
+        Evaluation dequantizeEval(int32_t code)
+        {
+            int32_t magnitude = std::abs(code);
+            if (magnitude >= evalMateBase)
+            {
+                int32_t mate = magnitude - evalMateBase;
+                return Evaluation{.value = (code < 0) ? -mate : mate, .centipawns = false};
+            }
+            if (magnitude > evalFineLimit)
+                magnitude = evalFineLimit + (magnitude - evalFineLimit) * evalCoarseStep;
+            return Evaluation{.value = (code < 0) ? -magnitude : magnitude};
+        }
 
-    Game readBinary(std::istream &input)
-    {
-        Game game;
-        readBinaryHeader(input, game);
-        for (auto &move : game.moves)
-            readBinaryMove(input, move);
+        // ECO codes A00-E99 as 1-500; 0 for anything else, which is then stored as a string
+        uint64_t ecoCode(std::string_view eco)
+        {
+            if (eco.size() != 3 || eco[0] < 'A' || eco[0] > 'E' || eco[1] < '0' || eco[1] > '9' || eco[2] < '0' || eco[2] > '9')
+                return 0;
+            return static_cast<uint64_t>((eco[0] - 'A') * 100 + (eco[1] - '0') * 10 + (eco[2] - '0') + 1);
+        }
 
-        if (game.evaluations)
-            for (auto &eval : game.evaluations.value())
-                readBinaryEvaluation(input, eval);
+        State startState(const Game &game)
+        {
+            return game.startFEN.empty() ? State{} : State{game.startFEN};
+        }
 
-        if (game.clocks)
-            for (auto &clock : game.clocks.value())
-                readBinaryClock(input, clock);
+        void writeV2(std::string &out, const Game &game)
+        {
+            std::string body;
+            Writer writer{body};
 
-        return game;
-    }
+            size_t plies = game.moves.size();
+            auto checkSize = [plies](const auto &annotations)
+            {
+                if (annotations && annotations->size() != plies)
+                    invalid("annotations do not match the moves");
+            };
+            checkSize(game.evaluations);
+            checkSize(game.clocks);
+            checkSize(game.annotations);
+
+            size_t unit = 0;
+            if (game.clocks)
+                while (unit + 1 < clockUnits.size() &&
+                       !std::all_of(game.clocks->begin(), game.clocks->end(), [&](msDuration clock)
+                                    { return clock.count() % clockUnits[unit] == 0; }))
+                    ++unit;
+
+            bool annotated = game.annotations &&
+                             std::any_of(game.annotations->begin(), game.annotations->end(), [](Annotation a)
+                                         { return a != Annotation::None; });
+
+            uint8_t status = static_cast<uint8_t>(static_cast<uint8_t>(game.result.type) << 4 | unit << 6);
+            if (game.evaluations)
+                status |= HasEvaluations;
+            if (game.clocks)
+                status |= HasClocks;
+            if (annotated)
+                status |= HasAnnotations;
+            if (!game.startFEN.empty())
+                status |= HasStartFEN;
+            writer.byte(status);
+            writer.byte(static_cast<uint8_t>(game.result.reason));
+
+            writer.varint(zigzag(game.datetime.time_since_epoch().count()));
+            writer.varint(game.whiteELO);
+            writer.varint(game.blackELO);
+            auto eco = ecoCode(game.ECOCode);
+            writer.varint(eco);
+            if (!eco)
+                writer.string(game.ECOCode);
+            writer.string(game.whiteUsername);
+            writer.string(game.blackUsername);
+            writer.varint(game.timeControl.initial.count());
+            writer.varint(game.timeControl.increment.count());
+            if (!game.startFEN.empty())
+                writer.string(game.startFEN);
+            writer.varint(plies);
+
+            // One bit stream: the moves, as indices into `legalMoves`, whose order is
+            // deterministic, then the clocks and the evaluations
+            BitWriter bits;
+            State state = startState(game);
+            MoveList legal;
+            for (const auto &move : game.moves)
+            {
+                legalMoves(state, legal);
+                PackedMove packed{move};
+                auto found = std::find(legal.begin(), legal.end(), packed);
+                if (found == legal.end())
+                    invalid("illegal move");
+                writeIndex(bits, static_cast<uint32_t>(found - legal.begin()), legal.size());
+                state.applyMove(packed);
+            }
 
-    void readBinaryHeader(std::istream &input, Game &game)
-    {
-        std::string formatID{"0000"};
-        input.read(formatID.data(), 4);
-        if (formatID != FORMATCODE)
-            throw std::runtime_error("Invalid binary format code");
-
-        uint16_t whiteUsernameLength = 0, blackUsernameLength = 0;
-        input.read(reinterpret_cast<char *>(&whiteUsernameLength), sizeof(whiteUsernameLength));
-        input.read(reinterpret_cast<char *>(&blackUsernameLength), sizeof(blackUsernameLength));
-        game.whiteUsername.resize(whiteUsernameLength);
-        game.blackUsername.resize(blackUsernameLength);
-        input.read(game.whiteUsername.data(), whiteUsernameLength);
-        input.read(game.blackUsername.data(), blackUsernameLength);
-
-        std::string datetimeString;
-        datetimeString.resize(14);
-        input.read(datetimeString.data(), 14);
-        game.datetime = Datetime(datetimeString.substr(0, 8), datetimeString.substr(8));
-
-        input.read(reinterpret_cast<char *>(&game.whiteELO), sizeof(game.whiteELO));
-        input.read(reinterpret_cast<char *>(&game.blackELO), sizeof(game.blackELO));
-
-        input.read(game.ECOCode.data(), 3);
-
-        input.read(reinterpret_cast<char *>(&game.timeControl.initialTime), sizeof(game.timeControl.initialTime));
-        input.read(reinterpret_cast<char *>(&game.timeControl.increment), sizeof(game.timeControl.increment));
-
-        uint8_t status = 0;
-        input.read(reinterpret_cast<char *>(&status), sizeof(status));
-        game.result.reason = static_cast<GameResult::Reason>(readFromBits(status, 0x07u, 3));
-        game.result.type = static_cast<GameResult::Type>(readFromBits(status, 0x03u, 2));
-        bool includeClocks = readFromBits(status, 0x01u, 1);
-        bool includeEvals = readFromBits(status, 0x01u, 1);
-        if (includeEvals)
-            game.evaluations.emplace();
-        if (includeClocks)
-            game.clocks.emplace();
-
-        uint16_t numberOfHalfMoves = 0;
-        input.read(reinterpret_cast<char *>(&numberOfHalfMoves), sizeof(numberOfHalfMoves));
-        game.moves.resize(numberOfHalfMoves);
-    }
+            // Clocks, as the time each side used less its increment, in the game's clock unit
+            if (game.clocks)
+            {
+                RiceCoder coder;
+                int64_t increment = game.timeControl.increment.count();
+                std::array<int64_t, 2> previous{game.timeControl.initial.count(), game.timeControl.initial.count()};
+                size_t side = (startState(game).turn == Color::White) ? 0 : 1;
+                for (auto clock : game.clocks.value())
+                {
+                    int64_t now = clock.count();
+                    coder.write(bits, zigzag((previous[side] + increment - now) / static_cast<int64_t>(clockUnits[unit])));
+                    previous[side] = now;
+                    side ^= 1;
+                }
+            }
 
-    void readBinaryMove(std::istream &input, Move &move)
-    {
-        uint16_t move_data = 0;
-        uint8_t extra_data = 0;
+            if (game.evaluations)
+            {
+                RiceCoder coder;
+                int32_t previous = 0;
+                for (auto eval : game.evaluations.value())
+                {
+                    int32_t code = quantizeEval(eval);
+                    coder.write(bits, zigzag(code - previous));
+                    previous = code;
+                }
+            }
+            writer.string(bits.finish());
 
-        input.read(reinterpret_cast<char *>(&move_data), sizeof(move_data));
-        input.read(reinterpret_cast<char *>(&extra_data), sizeof(extra_data));
+            // Annotations are rare, so only the annotated plies are listed
+            if (annotated)
+            {
+                const auto &annotations = game.annotations.value();
+                size_t count = static_cast<size_t>(std::count_if(annotations.begin(), annotations.end(), [](Annotation a)
+                                                                 { return a != Annotation::None; }));
+                writer.varint(count);
+                size_t last = 0;
+                for (size_t i = 0; i < plies; ++i)
+                    if (annotations[i] != Annotation::None)
+                    {
+                        writer.varint(i - last);
+                        writer.byte(static_cast<uint8_t>(annotations[i]));
+                        last = i;
+                    }
+            }
 
-        move.to.file = readFromBits(move_data, 0x07u, 3);
-        move.to.rank = readFromBits(move_data, 0x07u, 3);
+            Writer header{out};
+            header.bytes(formatCodeV2);
+            header.varint(body.size());
+            out += body;
+        }
 
-        move.from.file = readFromBits(move_data, 0x07u, 3);
-        move.from.rank = readFromBits(move_data, 0x07u, 3);
+        void readV2(Reader &reader, Game &game)
+        {
+            auto length = reader.varint();
+            Reader body{reader.bytes(length)};
+
+            uint8_t status = body.byte();
+            game.result.type = static_cast<GameResult::Type>((status >> 4) & 3);
+            size_t unit = status >> 6;
+            uint8_t reason = body.byte();
+            if (reason > static_cast<uint8_t>(GameResult::Reason::InsufficientMaterial))
+                invalid("result reason");
+            game.result.reason = static_cast<GameResult::Reason>(reason);
+
+            game.datetime = std::chrono::sys_seconds{std::chrono::seconds{unzigzag(body.varint())}};
+            game.whiteELO = static_cast<uint16_t>(body.varint());
+            game.blackELO = static_cast<uint16_t>(body.varint());
+            auto eco = body.varint();
+            if (eco)
+            {
+                --eco;
+                game.ECOCode = {static_cast<char>('A' + eco / 100), static_cast<char>('0' + eco / 10 % 10), static_cast<char>('0' + eco % 10)};
+            }
+            else
+                body.string(game.ECOCode);
+            body.string(game.whiteUsername);
+            body.string(game.blackUsername);
+            auto initial = body.varint();
+            auto increment = body.varint();
+            if (initial > UINT32_MAX || increment > UINT32_MAX)
+                invalid("time control");
+            game.timeControl.initial = msDuration{static_cast<uint32_t>(initial)};
+            game.timeControl.increment = msDuration{static_cast<uint32_t>(increment)};
+            game.startFEN.clear();
+            if (status & HasStartFEN)
+                body.string(game.startFEN);
+
+            auto plies = body.varint();
+            if (plies > length * 8 + 1024) // a forced move takes no bits, but games are finite
+                invalid("move count");
+
+            auto bitsLength = body.varint();
+            BitReader bits{body.bytes(bitsLength)};
+            State state = startState(game);
+            MoveList legal;
+            game.moves.clear();
+            game.moves.reserve(plies);
+            for (size_t i = 0; i < plies; ++i)
+            {
+                legalMoves(state, legal);
+                auto index = readIndex(bits, legal.size());
+                if (index >= legal.size())
+                    invalid("move index");
+                auto move = legal[index];
+                game.moves.push_back(move.unpack(state.board));
+                state.applyMove(move);
+            }
 
-        move.piece.type = static_cast<PieceType>(readFromBits(move_data, 0x07u, 3));
-        move.piece.color = static_cast<Color>(move_data);
+            if (status & HasClocks)
+            {
+                auto &clocks = game.clocks ? game.clocks.value() : game.clocks.emplace();
+                clocks.clear();
+                RiceCoder coder;
+                int64_t increment = game.timeControl.increment.count();
+                std::array<int64_t, 2> previous{game.timeControl.initial.count(), game.timeControl.initial.count()};
+                size_t side = (startState(game).turn == Color::White) ? 0 : 1;
+                for (size_t i = 0; i < plies; ++i)
+                {
+                    int64_t now = previous[side] + increment - unzigzag(coder.read(bits)) * clockUnits[unit];
+                    if (now < 0 || now > UINT32_MAX)
+                        invalid("clock");
+                    clocks.push_back(msDuration{static_cast<uint32_t>(now)});
+                    previous[side] = now;
+                    side ^= 1;
+                }
+            }
+            else
+                game.clocks.reset();
 
-        // move.annotation = static_cast<Annotation>(readFromBits(extra_data, 0x07u, 3));
-        move.capturedPiece = Piece{.color = oppositeColor(move.piece.color),
-                                   .type = static_cast<PieceType>(readFromBits(extra_data, 0x07u, 3))};
-        move.check = static_cast<bool>(readFromBits(extra_data, (uint8_t)0x01, 1));
-    }
+            if (status & HasEvaluations)
+            {
+                auto &evaluations = game.evaluations ? game.evaluations.value() : game.evaluations.emplace();
+                evaluations.clear();
+                RiceCoder coder;
+                int32_t code = 0;
+                for (size_t i = 0; i < plies; ++i)
+                {
+                    code += static_cast<int32_t>(unzigzag(coder.read(bits)));
+                    evaluations.push_back(dequantizeEval(code));
+                }
+            }
+            else
+                game.evaluations.reset();
 
-    void readBinaryEvaluation(std::istream &input, Evaluation &eval)
-    {
-        float tmp = 0;
-        input.read(reinterpret_cast<char *>(&tmp), sizeof(tmp));
-        if (!std::isnan(tmp))
+            if (status & HasAnnotations)
+            {
+                auto &annotations = game.annotations ? game.annotations.value() : game.annotations.emplace();
+                annotations.assign(plies, Annotation::None);
+                auto count = body.varint();
+                size_t ply = 0;
+                for (size_t i = 0; i < count; ++i)
+                {
+                    ply += body.varint();
+                    uint8_t annotation = body.byte();
+                    if (ply >= plies || annotation > static_cast<uint8_t>(Annotation::Dubious))
+                        invalid("annotation");
+                    annotations[ply] = static_cast<Annotation>(annotation);
+                }
+            }
+            else
+                game.annotations.reset();
+        }
+
+        // "YYYYmmddHHMMSS"
+        void writeDatetimeV1(Writer &writer, std::chrono::sys_seconds datetime)
+        {
+            using namespace std::chrono;
+            auto days = floor<std::chrono::days>(datetime);
+            year_month_day ymd{days};
+            hh_mm_ss time{datetime - days};
+            char formatted[32];
+            std::snprintf(formatted, sizeof(formatted), "%04d%02u%02u%02d%02d%02d",
+                          static_cast<int>(ymd.year()), static_cast<unsigned>(ymd.month()), static_cast<unsigned>(ymd.day()),
+                          static_cast<int>(time.hours().count()), static_cast<int>(time.minutes().count()),
+                          static_cast<int>(time.seconds().count()));
+            writer.bytes(std::string_view(formatted, 14));
+        }
+
+        std::chrono::sys_seconds readDatetimeV1(std::string_view text)
+        {
+            auto field = [&](size_t pos, size_t length)
+            {
+                int value = 0;
+                for (char c : text.substr(pos, length))
+                {
+                    if (c < '0' || c > '9')
+                        invalid("datetime");
+                    value = value * 10 + (c - '0');
+                }
+                return value;
+            };
+            using namespace std::chrono;
+            year_month_day ymd{year{field(0, 4)}, month{static_cast<unsigned>(field(4, 2))}, day{static_cast<unsigned>(field(6, 2))}};
+            return sys_days{ymd} + hours{field(8, 2)} + minutes{field(10, 2)} + seconds{field(12, 2)};
+        }
+
+        void writeV1(std::string &out, const Game &game)
         {
-            eval.value = tmp;
-            return;
+            Writer writer{out};
+            writer.bytes(formatCodeV1);
+            writer.u16(static_cast<uint16_t>(game.whiteUsername.size()));
+            writer.u16(static_cast<uint16_t>(game.blackUsername.size()));
+            writer.bytes(game.whiteUsername);
+            writer.bytes(game.blackUsername);
+            writeDatetimeV1(writer, game.datetime);
+            writer.u16(game.whiteELO);
+            writer.u16(game.blackELO);
+            writer.bytes((game.ECOCode + "   ").substr(0, 3));
+            writer.u16(static_cast<uint16_t>(game.timeControl.initial.count() / 1000));
+            writer.u16(static_cast<uint16_t>(game.timeControl.increment.count() / 1000));
+
+            uint8_t status = static_cast<uint8_t>(game.evaluations.has_value() << 6 | game.clocks.has_value() << 5 |
+                                                  static_cast<uint8_t>(game.result.type) << 3 |
+                                                  static_cast<uint8_t>(game.result.reason));
+            writer.byte(status);
+            writer.u16(static_cast<uint16_t>(game.moves.size()));
+
+            for (const auto &move : game.moves)
+                writer.u16(PackedMove{move}.raw());
+
+            // Pawns as a float; mates as a NaN with the (signed) moves to mate in the low byte
+            if (game.evaluations)
+                for (auto eval : game.evaluations.value())
+                {
+                    uint32_t bits = 0;
+                    if (eval.centipawns)
+                    {
+                        float pawns = static_cast<float>(eval.value) / 100.0f;
+                        std::memcpy(&bits, &pawns, sizeof(bits));
+                    }
+                    else
+                        bits = 0xFFFFFF00u | static_cast<uint8_t>(static_cast<int8_t>(eval.value));
+                    writer.u32(bits);
+                }
+
+            if (game.clocks)
+                for (auto clock : game.clocks.value())
+                    writer.u16(static_cast<uint16_t>(clock.count() / 1000));
+        }
+
+        void readV1(Reader &reader, Game &game)
+        {
+            auto whiteLength = reader.u16();
+            auto blackLength = reader.u16();
+            game.whiteUsername.assign(reader.bytes(whiteLength));
+            game.blackUsername.assign(reader.bytes(blackLength));
+            game.datetime = readDatetimeV1(reader.bytes(14));
+            game.whiteELO = reader.u16();
+            game.blackELO = reader.u16();
+            auto eco = reader.bytes(3);
+            game.ECOCode.assign(eco.substr(0, eco.find_last_not_of(' ') + 1));
+            game.timeControl.initial = msDuration{reader.u16() * 1000u};
+            game.timeControl.increment = msDuration{reader.u16() * 1000u};
+
+            uint8_t status = reader.byte();
+            game.result.reason = static_cast<GameResult::Reason>(status & 0x07);
+            game.result.type = static_cast<GameResult::Type>((status >> 3) & 0x03);
+            auto plies = reader.u16();
+
+            State state;
+            game.startFEN.clear();
+            game.moves.clear();
+            game.moves.reserve(plies);
+            MoveList legal;
+            for (size_t i = 0; i < plies; ++i)
+            {
+                auto move = PackedMove::fromRaw(reader.u16());
+                legalMoves(state, legal);
+                if (!legal.contains(move))
+                    invalid("illegal move");
+                game.moves.push_back(move.unpack(state.board));
+                state.applyMove(move);
+            }
+
+            if (status & (1 << 6))
+            {
+                auto &evaluations = game.evaluations ? game.evaluations.value() : game.evaluations.emplace();
+                evaluations.clear();
+                for (size_t i = 0; i < plies; ++i)
+                {
+                    uint32_t bits = reader.u32();
+                    float pawns = 0;
+                    std::memcpy(&pawns, &bits, sizeof(pawns));
+                    if (std::isnan(pawns))
+                        evaluations.push_back({.value = static_cast<int8_t>(bits & 0xFF), .centipawns = false});
+                    else
+                        evaluations.push_back({.value = static_cast<int32_t>(std::lround(pawns * 100.0f))});
+                }
+            }
+            else
+                game.evaluations.reset();
+
+            if (status & (1 << 5))
+            {
+                auto &clocks = game.clocks ? game.clocks.value() : game.clocks.emplace();
+                clocks.clear();
+                for (size_t i = 0; i < plies; ++i)
+                    clocks.push_back(msDuration{reader.u16() * 1000u});
+            }
+            else
+                game.clocks.reset();
+
+            game.annotations.reset();
         }
+    } // namespace
+
+    void writeBinary(std::string &out, const Game &game, BinaryVersion version)
+    {
+        if (version == BinaryVersion::V1)
+            writeV1(out, game);
+        else
+            writeV2(out, game);
+    }
 
-        int32_t e = 0;
-        std::memcpy(&e, &tmp, 4);
-        eval.value = static_cast<int>(e);
+    void writeBinary(std::ostream &output, const Game &game, BinaryVersion version)
+    {
+        std::string buffer;
+        writeBinary(buffer, game, version);
+        output.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    }
+
+    void readBinary(std::string_view &input, Game &game)
+    {
+        Reader reader{input};
+        auto code = reader.bytes(4);
+        if (code == formatCodeV2)
+            readV2(reader, game);
+        else if (code == formatCodeV1)
+            readV1(reader, game);
+        else
+            unknownCode(code);
+        input = reader.rest();
     }
 
-    void readBinaryClock(std::istream &input, ClockTime &clock)
+    Game readBinary(std::string_view &input)
     {
-        input.read(reinterpret_cast<char *>(&clock.seconds), sizeof(clock.seconds));
+        Game game;
+        readBinary(input, game);
+        return game;
     }
 
-    void readBinaryState(std::istream &input, State &board)
+    Game readBinary(std::istream &input)
     {
-        uint32_t row = 0;
-        size_t idx = 0;
-        for (auto i = 0; i < 8; ++i)
+        // Only as many bytes as the game takes: its length is in its header, which is read
+        // in pieces for version 1
+        std::string buffer;
+        auto read = [&](size_t count)
+        {
+            auto start = buffer.size();
+            buffer.resize(start + count);
+            input.read(buffer.data() + start, static_cast<std::streamsize>(count));
+            if (static_cast<size_t>(input.gcount()) != count)
+                invalid("truncated");
+            return std::string_view{buffer}.substr(start);
+        };
+        auto u16 = [](std::string_view bytes, size_t at)
         {
-            input.read(reinterpret_cast<char *>(&row), sizeof(row));
-            for (auto j = 0; j < 8; ++j)
+            return static_cast<size_t>(static_cast<uint8_t>(bytes[at]) | static_cast<uint8_t>(bytes[at + 1]) << 8);
+        };
+
+        auto code = read(4);
+        if (code == formatCodeV1)
+        {
+            auto lengths = read(4);
+            // Usernames, datetime, ELOs, ECO, time control, status and number of half-moves
+            auto header = read(u16(lengths, 0) + u16(lengths, 2) + 14 + 4 + 3 + 4 + 1 + 2);
+            uint8_t status = static_cast<uint8_t>(header[header.size() - 3]);
+            size_t plies = u16(header, header.size() - 2);
+            read(plies * (2 + (status & (1 << 6) ? 4 : 0) + (status & (1 << 5) ? 2 : 0)));
+        }
+        else if (code == formatCodeV2)
+        {
+            uint64_t length = 0;
+            for (int shift = 0;; shift += 7)
             {
-                board.board[idx].color = static_cast<Color>((row & 0x80000000) >> 31);
-                board.board[idx++].type = static_cast<PieceType>((row & 0x70000000) >> 28);
-                row <<= 4;
+                if (shift >= 64)
+                    invalid("varint too long");
+                auto b = static_cast<uint8_t>(read(1)[0]);
+                length |= static_cast<uint64_t>(b & 0x7F) << shift;
+                if (!(b & 0x80))
+                    break;
             }
+            read(length);
         }
-
-        uint8_t extra = 0;
-        input.read(reinterpret_cast<char *>(&extra), sizeof(extra));
-        std::bitset<8> extraBits{extra};
-        board.turn = static_cast<Color>(extraBits.test(7));
-        board.castleRights.set(Color::White, CastleRights::Side::KING, extraBits.test(6));
-        board.castleRights.set(Color::White, CastleRights::Side::QUEEN, extraBits.test(5));
-        board.castleRights.set(Color::Black, CastleRights::Side::KING, extraBits.test(4));
-        board.castleRights.set(Color::Black, CastleRights::Side::QUEEN, extraBits.test(3));
-        board.enPassant.emplace("a1");
-        board.enPassant.value().file = extra & 0x07;
-
-        input.read(reinterpret_cast<char *>(&board.halfTurnCounter), sizeof(board.halfTurnCounter));
-        if (board.halfTurnCounter != std::numeric_limits<uint8_t>::max())
-            board.halfTurnCounter = 0u;
         else
-            board.enPassant.reset();
+            unknownCode(code);
 
-        input.read(reinterpret_cast<char *>(&board.fullTurnCounter), sizeof(board.fullTurnCounter));
+        std::string_view view{buffer};
+        return readBinary(view);
     }
-} // namespace JChess
\ No newline at end of file
+} // namespace JChess
@@ -1,26 +1,38 @@
 #pragma once
 
+#include <cstdint>
 #include <istream>
 #include <ostream>
+#include <string>
+#include <string_view>
 
-#include "internal/annotation/clockTime.h"
-#include "internal/annotation/evaluation.h"
-#include "internal/logic/game.h"
-#include "internal/logic/state.h"
+#include "core/game.h"
 
 namespace JChess
 {
-    void writeBinary(std::ostream &output, const Game &game);
-    void writeBinaryHeader(std::ostream &output, const Game &game);
-    void writeBinaryMove(std::ostream &output, const Move &move);
-    void writeBinaryEvaluation(std::ostream &output, const eval_t &eval);
-    void writeBinaryClock(std::ostream &output, const uint16_t secondsRemaining);
-    void writeBinaryState(std::ostream &output, const State &state);
+    enum class BinaryVersion : uint8_t
+    {
+        // "PGP1": 2-byte `PackedMove`s, 4-byte float evaluations and 2-byte clocks in seconds
+        V1 = 1,
+        // "PGN2": each move as its index among the legal moves, in as few bits as the number
+        // of legal moves needs; delta-coded clocks and quantized, delta-coded evaluations in
+        // adaptive Rice codes
+        V2 = 2,
+    };
 
+    /* Append a game in the binary format to `out`. Version 1 cannot hold a starting FEN or
+     * annotations and rounds clocks to seconds. Version 2 keeps every field, except that
+     * evaluations beyond +-10 pawns are rounded to a tenth of a pawn.
+     */
+    void writeBinary(std::string &out, const Game &game, BinaryVersion version = BinaryVersion::V2);
+    void writeBinary(std::ostream &output, const Game &game, BinaryVersion version = BinaryVersion::V2);
+
+    /* Read the game at the front of `input`, in either version, and advance past it. Both
+     * versions replay the moves to recover them. Throws `std::runtime_error` if the data is
+     * truncated or invalid.
+     */
+    void readBinary(std::string_view &input, Game &game);
+    Game readBinary(std::string_view &input);
+    // Reads only the bytes of the game
     Game readBinary(std::istream &input);
-    void readBinaryHeader(std::istream &input, Game &game);
-    void readBinaryMove(std::istream &input, Move &move);
-    void readBinaryEvaluation(std::istream &input, Evaluation &eval);
-    void readBinaryClock(std::istream &input, ClockTime &clock);
-    void readBinaryState(std::istream &input, State &state);
 } // namespace JChess
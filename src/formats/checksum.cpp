@@ -0,0 +1,52 @@
+#include "formats/checksum.h"
+
+#include <array>
+#include <cstring>
+
+namespace JChess
+{
+    namespace
+    {
+        constexpr uint32_t polynomial = 0x82F63B78; // reflected
+
+        // Slicing-by-8: table k advances a byte that is followed by k more
+        constexpr std::array<std::array<uint32_t, 256>, 8> tables = []
+        {
+            std::array<std::array<uint32_t, 256>, 8> t{};
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                uint32_t crc = i;
+                for (int bit = 0; bit < 8; ++bit)
+                    crc = (crc >> 1) ^ ((crc & 1) ? polynomial : 0);
+                t[0][i] = crc;
+            }
+            for (uint32_t i = 0; i < 256; ++i)
+                for (size_t k = 1; k < 8; ++k)
+                    t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+            return t;
+        }();
+    } // namespace
+
+    uint32_t crc32c(std::string_view data, uint32_t crc)
+    {
+        const auto *p = reinterpret_cast<const unsigned char *>(data.data());
+        size_t size = data.size();
+        crc = ~crc;
+
+        for (; size >= 8; p += 8, size -= 8)
+        {
+            uint32_t low, high;
+            std::memcpy(&low, p, 4);
+            std::memcpy(&high, p + 4, 4);
+            low ^= crc;
+            crc = tables[7][low & 0xFF] ^ tables[6][(low >> 8) & 0xFF] ^
+                  tables[5][(low >> 16) & 0xFF] ^ tables[4][low >> 24] ^
+                  tables[3][high & 0xFF] ^ tables[2][(high >> 8) & 0xFF] ^
+                  tables[1][(high >> 16) & 0xFF] ^ tables[0][high >> 24];
+        }
+        for (; size; ++p, --size)
+            crc = (crc >> 8) ^ tables[0][(crc ^ *p) & 0xFF];
+
+        return ~crc;
+    }
+} // namespace JChess
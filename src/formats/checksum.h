@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace JChess
+{
+    /* CRC-32C (Castagnoli) of `data`, continuing from `crc` to checksum data in pieces.
+     */
+    uint32_t crc32c(std::string_view data, uint32_t crc = 0);
+} // namespace JChess
@@ -0,0 +1,415 @@
+#include "formats/compressedInput.h"
+
+#include <algorithm>
+#include <bzlib.h>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <zstd.h>
+
+namespace JChess
+{
+    namespace
+    {
+        // Frames declaring at most this much content are decompressed whole, in parallel
+        constexpr unsigned long long maxParallelFrameBytes = 64 << 20;
+
+        class ZstdDecoder
+        {
+        public:
+            explicit ZstdDecoder(std::string_view input)
+                : m_context(ZSTD_createDCtx()), m_input{input.data(), input.size(), 0}
+            {
+                if (!m_context)
+                    throw std::bad_alloc();
+            }
+            ~ZstdDecoder() { ZSTD_freeDCtx(m_context); }
+
+            ZstdDecoder(const ZstdDecoder &) = delete;
+            ZstdDecoder &operator=(const ZstdDecoder &) = delete;
+
+            /* Fills `out` with up to `size` bytes; returns the number written and sets
+             * `finished` at the end of the input.
+             */
+            size_t decode(char *out, size_t size, bool &finished)
+            {
+                ZSTD_outBuffer output{out, size, 0};
+                while (output.pos < output.size)
+                {
+                    if (m_input.pos == m_input.size && m_frameDone)
+                    {
+                        finished = true;
+                        break;
+                    }
+
+                    size_t written = output.pos;
+                    size_t read = m_input.pos;
+                    size_t hint = ZSTD_decompressStream(m_context, &output, &m_input);
+                    if (ZSTD_isError(hint))
+                        throw std::runtime_error(std::string("Invalid zstd data: ") + ZSTD_getErrorName(hint));
+                    m_frameDone = (hint == 0);
+
+                    if (!m_frameDone && output.pos == written && m_input.pos == read)
+                        throw std::runtime_error("Truncated zstd data");
+                }
+                return output.pos;
+            }
+
+        private:
+            ZSTD_DCtx *m_context;
+            ZSTD_inBuffer m_input;
+            bool m_frameDone = false;
+        };
+
+        class Bzip2Decoder
+        {
+        public:
+            explicit Bzip2Decoder(std::string_view input)
+                : m_input(input)
+            {
+                begin();
+            }
+            ~Bzip2Decoder() { BZ2_bzDecompressEnd(&m_stream); }
+
+            Bzip2Decoder(const Bzip2Decoder &) = delete;
+            Bzip2Decoder &operator=(const Bzip2Decoder &) = delete;
+
+            size_t decode(char *out, size_t size, bool &finished)
+            {
+                size_t written = 0;
+                while (written < size)
+                {
+                    // bzlib counts in unsigned ints, so large inputs are fed in pieces
+                    if (m_stream.avail_in == 0 && !m_input.empty())
+                    {
+                        size_t piece = std::min<size_t>(m_input.size(), INT_MAX);
+                        m_stream.next_in = const_cast<char *>(m_input.data());
+                        m_stream.avail_in = static_cast<unsigned>(piece);
+                        m_input.remove_prefix(piece);
+                    }
+
+                    size_t space = std::min<size_t>(size - written, INT_MAX);
+                    m_stream.next_out = out + written;
+                    m_stream.avail_out = static_cast<unsigned>(space);
+                    int result = BZ2_bzDecompress(&m_stream);
+                    written += space - m_stream.avail_out;
+
+                    if (result == BZ_STREAM_END)
+                    {
+                        if (m_stream.avail_in == 0 && m_input.empty())
+                        {
+                            finished = true;
+                            break;
+                        }
+                        // Another stream follows, as written by parallel compressors
+                        std::string_view rest{m_stream.next_in, m_stream.avail_in + m_input.size()};
+                        BZ2_bzDecompressEnd(&m_stream);
+                        m_input = rest;
+                        begin();
+                    }
+                    else if (result != BZ_OK)
+                        throw std::runtime_error("Invalid bzip2 data (error " + std::to_string(result) + ")");
+                    else if (m_stream.avail_in == 0 && m_input.empty() && m_stream.avail_out > 0)
+                        throw std::runtime_error("Truncated bzip2 data");
+                }
+                return written;
+            }
+
+        private:
+            void begin()
+            {
+                m_stream = {};
+                if (BZ2_bzDecompressInit(&m_stream, 0, 0) != BZ_OK)
+                    throw std::runtime_error("Unable to initialize bzip2 decompression");
+            }
+
+        private:
+            std::string_view m_input; // not yet given to `m_stream`
+            bz_stream m_stream{};
+        };
+
+        // Decompresses all of `decoder`'s input, growing `data` as needed
+        template <class Decoder>
+        void decodeAll(Decoder &decoder, std::vector<char> &data, size_t initialSize)
+        {
+            data.resize(std::max<size_t>(initialSize, 1));
+            size_t size = 0;
+            bool finished = false;
+            while (true)
+            {
+                size += decoder.decode(data.data() + size, data.size() - size, finished);
+                if (finished)
+                    break;
+                if (size == data.size())
+                    data.resize(data.size() * 2);
+            }
+            data.resize(size);
+        }
+    } // namespace
+
+    Compression detectCompression(std::string_view head)
+    {
+        if (head.starts_with("\x28\xB5\x2F\xFD"))
+            return Compression::Zstd;
+        if (head.size() >= 4 && head.starts_with("BZh") && head[3] >= '1' && head[3] <= '9')
+            return Compression::Bzip2;
+        return Compression::None;
+    }
+
+    DecompressingBuffer::DecompressingBuffer(MappedFile file, Compression compression, DecompressionOptions options)
+        : m_file(std::move(file)), m_options(options)
+    {
+        m_options.bufferBytes = std::max<size_t>(m_options.bufferBytes, 1);
+        unsigned threads = m_options.threads ? m_options.threads : std::max(std::thread::hardware_concurrency(), 1u);
+
+        bool byFrame = false;
+        if (compression == Compression::Zstd && threads > 1)
+        {
+            auto first = ZSTD_findFrameCompressedSize(m_file.data(), m_file.size());
+            auto content = ZSTD_getFrameContentSize(m_file.data(), m_file.size());
+            byFrame = !ZSTD_isError(first) && first < m_file.size() && content <= maxParallelFrameBytes;
+        }
+        if (!byFrame)
+            threads = 1;
+
+        // One more block than in flight: the one being read
+        m_blocks.resize(std::max<size_t>(m_options.buffersInFlight, 1) + 1);
+        for (size_t i = m_blocks.size(); i-- > 0;)
+            m_free.push_back(i);
+        m_ready.reserve(m_blocks.size());
+
+        m_running = threads;
+        m_workers.reserve(threads);
+        for (unsigned i = 0; i < threads; ++i)
+        {
+            if (byFrame)
+                m_workers.emplace_back(&DecompressingBuffer::decompressFrames, this);
+            else
+                m_workers.emplace_back(&DecompressingBuffer::decompressStream, this, compression);
+        }
+    }
+
+    DecompressingBuffer::~DecompressingBuffer()
+    {
+        {
+            std::lock_guard lock{m_mutex};
+            m_stop = true;
+        }
+        m_blockFree.notify_all();
+        for (auto &worker : m_workers)
+            worker.join();
+    }
+
+    // Waits for a free block and numbers it; nullptr once the reader is destroyed
+    DecompressingBuffer::Block *DecompressingBuffer::acquire(size_t &index)
+    {
+        std::unique_lock lock{m_mutex};
+        m_blockFree.wait(lock, [this] { return m_stop || !m_free.empty(); });
+        if (m_stop)
+            return nullptr;
+
+        index = m_free.back();
+        m_free.pop_back();
+        auto &block = m_blocks[index];
+        block.sequence = m_claimed++;
+        block.error = nullptr;
+        return &block;
+    }
+
+    void DecompressingBuffer::publish(size_t index)
+    {
+        {
+            std::lock_guard lock{m_mutex};
+            m_ready.push_back(index);
+        }
+        m_blockReady.notify_one();
+    }
+
+    void DecompressingBuffer::decompressStream(Compression compression)
+    {
+        auto run = [this](auto &decoder)
+        {
+            bool finished = false;
+            while (!finished)
+            {
+                size_t index = 0;
+                auto *block = acquire(index);
+                if (!block)
+                    return;
+
+                try
+                {
+                    block->data.resize(m_options.bufferBytes);
+                    block->data.resize(decoder.decode(block->data.data(), block->data.size(), finished));
+                }
+                catch (...)
+                {
+                    block->data.clear();
+                    block->error = std::current_exception();
+                    finished = true;
+                }
+                publish(index);
+            }
+        };
+
+        try
+        {
+            if (compression == Compression::Zstd)
+            {
+                ZstdDecoder decoder{m_file.text()};
+                run(decoder);
+            }
+            else
+            {
+                Bzip2Decoder decoder{m_file.text()};
+                run(decoder);
+            }
+        }
+        catch (...) // setting up the decoder failed
+        {
+            size_t index = 0;
+            if (auto *block = acquire(index))
+            {
+                block->data.clear();
+                block->error = std::current_exception();
+                publish(index);
+            }
+        }
+
+        {
+            std::lock_guard lock{m_mutex};
+            --m_running;
+        }
+        m_blockReady.notify_one();
+    }
+
+    void DecompressingBuffer::decompressFrames()
+    {
+        while (true)
+        {
+            size_t index = 0;
+            Block *block = nullptr;
+            std::string_view frame;
+            {
+                std::unique_lock lock{m_mutex};
+                m_blockFree.wait(lock, [this] { return m_stop || m_offset == m_file.size() || !m_free.empty(); });
+                if (m_stop || m_offset == m_file.size())
+                    break;
+
+                index = m_free.back();
+                m_free.pop_back();
+                block = &m_blocks[index];
+                block->sequence = m_claimed++;
+                block->error = nullptr;
+
+                // Finding a frame's end only reads its block headers
+                auto rest = m_file.text().substr(m_offset);
+                auto size = ZSTD_findFrameCompressedSize(rest.data(), rest.size());
+                if (ZSTD_isError(size))
+                    size = rest.size(); // let the decoder report the error
+                frame = rest.substr(0, size);
+                m_offset += size;
+            }
+
+            try
+            {
+                auto content = ZSTD_getFrameContentSize(frame.data(), frame.size());
+                bool known = content != ZSTD_CONTENTSIZE_UNKNOWN && content != ZSTD_CONTENTSIZE_ERROR;
+                ZstdDecoder decoder{frame};
+                decodeAll(decoder, block->data, known ? static_cast<size_t>(content) : m_options.bufferBytes);
+            }
+            catch (...)
+            {
+                block->data.clear();
+                block->error = std::current_exception();
+                std::lock_guard lock{m_mutex};
+                m_offset = m_file.size(); // nothing after the error is read
+            }
+            publish(index);
+        }
+
+        {
+            std::lock_guard lock{m_mutex};
+            --m_running;
+        }
+        m_blockReady.notify_one();
+    }
+
+    DecompressingBuffer::int_type DecompressingBuffer::underflow()
+    {
+        if (gptr() < egptr())
+            return traits_type::to_int_type(*gptr());
+
+        while (true)
+        {
+            size_t index = 0;
+            {
+                std::unique_lock lock{m_mutex};
+                if (m_current)
+                {
+                    m_free.push_back(*m_current);
+                    m_current.reset();
+                    m_blockFree.notify_one();
+                }
+
+                auto found = m_ready.end();
+                m_blockReady.wait(lock, [&]
+                                  {
+                                      found = std::find_if(m_ready.begin(), m_ready.end(), [this](size_t i)
+                                                           { return m_blocks[i].sequence == m_delivered; });
+                                      return found != m_ready.end() || (m_running == 0 && m_delivered == m_claimed);
+                                  });
+                if (found == m_ready.end())
+                {
+                    setg(nullptr, nullptr, nullptr);
+                    return traits_type::eof();
+                }
+
+                index = *found;
+                m_ready.erase(found);
+                ++m_delivered;
+                m_current = index;
+            }
+
+            auto &block = m_blocks[index];
+            if (block.error)
+                std::rethrow_exception(block.error);
+            if (block.data.empty()) // e.g., a skippable frame
+                continue;
+
+            setg(block.data.data(), block.data.data(), block.data.data() + block.data.size());
+            return traits_type::to_int_type(*gptr());
+        }
+    }
+
+    InputFile::InputFile(const std::filesystem::path &path, DecompressionOptions options)
+        : std::istream(nullptr)
+    {
+        // Peek at the magic bytes without mapping the file
+        {
+            std::ifstream probe{path, std::ios::binary};
+            if (!probe)
+                throw std::runtime_error("Unable to open file: " + path.string());
+            char head[4] = {};
+            probe.read(head, sizeof(head));
+            m_compression = detectCompression(std::string_view(head, static_cast<size_t>(probe.gcount())));
+        }
+
+        if (m_compression == Compression::None)
+        {
+            auto file = std::make_unique<std::filebuf>();
+            if (!file->open(path, std::ios::in | std::ios::binary))
+                throw std::runtime_error("Unable to open file: " + path.string());
+            m_buffer = std::move(file);
+        }
+        else
+            m_buffer = std::make_unique<DecompressingBuffer>(MappedFile{path}, m_compression, options);
+
+        rdbuf(m_buffer.get());
+        // Rethrow decompression errors from reads rather than only setting badbit
+        exceptions(std::ios::badbit);
+    }
+} // namespace JChess
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <streambuf>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "formats/mappedFile.h"
+
+namespace JChess
+{
+    enum class Compression
+    {
+        None,
+        Zstd,
+        Bzip2,
+    };
+
+    // From the magic bytes at the start of a file
+    Compression detectCompression(std::string_view head);
+
+    struct DecompressionOptions
+    {
+        // Size of the blocks of decompressed text handed to the reader
+        size_t bufferBytes = 8 << 20;
+        // Blocks that may be decompressed ahead of the reader
+        size_t buffersInFlight = 4;
+        // Threads for zstd files made of many small frames; 0 for one per hardware thread
+        unsigned threads = 0;
+    };
+
+    /* A `std::streambuf` over a zstd or bzip2 compressed file, decompressed ahead of the reader
+     * on pipeline threads into large blocks that are handed to the reader without copying.
+     *
+     * A zstd file whose first frame declares a small content size (as written by `pzstd` or
+     * the seekable format) is split at frame boundaries and its frames are decompressed in
+     * parallel, then returned in order. Any other file is decompressed as a single stream on
+     * one thread. Concatenated streams are read through in both formats.
+     *
+     * Decompression errors, including a truncated file, are thrown from `underflow` after the
+     * text before them has been read.
+     */
+    class DecompressingBuffer : public std::streambuf
+    {
+    public:
+        DecompressingBuffer(MappedFile file, Compression compression, DecompressionOptions options = {});
+        ~DecompressingBuffer() override;
+
+        DecompressingBuffer(const DecompressingBuffer &) = delete;
+        DecompressingBuffer &operator=(const DecompressingBuffer &) = delete;
+
+    protected:
+        int_type underflow() override;
+
+    private:
+        struct Block
+        {
+            size_t sequence = 0;
+            std::vector<char> data;
+            std::exception_ptr error;
+        };
+
+        Block *acquire(size_t &index);
+        void publish(size_t index);
+        void decompressStream(Compression compression);
+        void decompressFrames();
+
+    private:
+        MappedFile m_file;
+        DecompressionOptions m_options;
+
+        std::mutex m_mutex;
+        std::condition_variable m_blockFree;
+        std::condition_variable m_blockReady;
+        std::vector<Block> m_blocks;
+        std::vector<size_t> m_free;  // indices into `m_blocks`
+        std::vector<size_t> m_ready; // indices into `m_blocks`
+        size_t m_offset = 0;         // start of the next zstd frame to claim
+        size_t m_claimed = 0;
+        size_t m_delivered = 0;
+        unsigned m_running = 0;
+        bool m_stop = false;
+        std::vector<std::thread> m_workers;
+
+        std::optional<size_t> m_current; // the block being read
+    };
+
+    /* An input stream over a file that may be zstd or bzip2 compressed, detected from its
+     * magic bytes, e.g., a `.pgn.zst` database export:
+     *
+     *     InputFile input{"lichess_db_standard_rated_2024-01.pgn.zst"};
+     *     PGNReader reader{input};
+     *
+     * Throws `std::runtime_error` if the file cannot be opened, and from reads if it cannot be
+     * decompressed.
+     */
+    class InputFile : public std::istream
+    {
+    public:
+        explicit InputFile(const std::filesystem::path &path, DecompressionOptions options = {});
+
+        Compression compression() const { return m_compression; }
+
+    private:
+        Compression m_compression = Compression::None;
+        std::unique_ptr<std::streambuf> m_buffer;
+    };
+} // namespace JChess
@@ -109,7 +109,7 @@ namespace JChess::FEN
 
         return occ;
     }
-    constexpr std::array<char, 12> pieceChars = {'p', 'n', 'b', 'r', 'q', 'k', 'P', 'N', 'B', 'R', 'Q', 'K'};
+    constexpr std::array<char, 12> pieceChars = {'P', 'N', 'B', 'R', 'Q', 'K', 'p', 'n', 'b', 'r', 'q', 'k'};
     constexpr inline char pieceToChar(Piece piece)
     {
         return pieceChars[static_cast<int>(piece.color) * 6 + static_cast<int>(piece.type)];
@@ -0,0 +1,423 @@
+#include "formats/fenParser.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <limits>
+
+#include "core/attackTables.h"
+#include "core/board.h"
+#include "core/castling.h"
+#include "formats/fen.h"
+
+namespace JChess::FEN
+{
+    namespace
+    {
+        constexpr uint8_t noSquare = 64;
+        constexpr uint8_t whiteKing = 1 + static_cast<uint8_t>(PieceType::King);
+        constexpr uint8_t blackKing = 1 + 6 + static_cast<uint8_t>(PieceType::King);
+        constexpr uint8_t whitePawn = 1 + static_cast<uint8_t>(PieceType::Pawn);
+        constexpr uint8_t blackPawn = 1 + 6 + static_cast<uint8_t>(PieceType::Pawn);
+        constexpr std::string_view castlingChars{"KQkq"};
+
+        // Piece codes by character, 0 for anything that is not a piece
+        constexpr std::array<uint8_t, 256> pieceCodes = []
+        {
+            std::array<uint8_t, 256> codes{};
+            for (size_t i = 0; i < pieceChars.size(); ++i)
+                codes[static_cast<unsigned char>(pieceChars[i])] = static_cast<uint8_t>(i + 1);
+            return codes;
+        }();
+
+        constexpr bool isSpace(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+        }
+
+        std::string_view trim(std::string_view text)
+        {
+            while (!text.empty() && isSpace(text.front()))
+                text.remove_prefix(1);
+            while (!text.empty() && isSpace(text.back()))
+                text.remove_suffix(1);
+            return text;
+        }
+
+        // Takes the next space-separated field off the front of `text`, empty at its end
+        std::string_view nextField(std::string_view &text)
+        {
+            size_t start = 0;
+            while (start < text.size() && isSpace(text[start]))
+                ++start;
+            size_t end = start;
+            while (end < text.size() && !isSpace(text[end]))
+                ++end;
+            auto field = text.substr(start, end - start);
+            text.remove_prefix(end);
+            return field;
+        }
+
+        bool parseCounter(std::string_view field, uint16_t &value)
+        {
+            auto [end, error] = std::from_chars(field.data(), field.data() + field.size(), value);
+            return !field.empty() && error == std::errc{} && end == field.data() + field.size();
+        }
+
+        Error parsePlacement(std::string_view field, Position &position)
+        {
+            size_t rank = 0, file = 0;
+            size_t whiteKings = 0, blackKings = 0;
+            std::array<size_t, 2> sideCounts{};
+            for (char c : field)
+            {
+                if (auto code = pieceCodes[static_cast<unsigned char>(c)])
+                {
+                    if (file == 8)
+                        return Error::RankLength;
+                    position.set(rank * 8 + file++, code);
+                    whiteKings += code == whiteKing;
+                    blackKings += code == blackKing;
+                    ++sideCounts[code > 6];
+                }
+                else if (c >= '1' && c <= '8')
+                {
+                    file += static_cast<size_t>(c - '0');
+                    if (file > 8)
+                        return Error::RankLength;
+                }
+                else if (c == '/')
+                {
+                    if (file != 8)
+                        return Error::RankLength;
+                    if (++rank == 8)
+                        return Error::RankCount;
+                    file = 0;
+                }
+                else
+                    return Error::Piece;
+            }
+            if (rank != 7)
+                return Error::RankCount;
+            if (file != 8)
+                return Error::RankLength;
+            if (whiteKings != 1 || blackKings != 1)
+                return Error::KingCount;
+            if (sideCounts[0] > 16 || sideCounts[1] > 16)
+                return Error::PieceCount;
+            return Error::None;
+        }
+
+        // The first four fields, common to FEN and EPD
+        Error parseFields(std::string_view &text, Position &position)
+        {
+            position = Position{};
+
+            auto placement = nextField(text);
+            if (placement.empty())
+                return Error::MissingField;
+            if (auto error = parsePlacement(placement, position); error != Error::None)
+                return error;
+
+            auto turn = nextField(text);
+            if (turn.empty())
+                return Error::MissingField;
+            if (turn != "w" && turn != "b")
+                return Error::SideToMove;
+            position.turn = static_cast<uint8_t>(turn[0] == 'b');
+
+            auto castling = nextField(text);
+            if (castling.empty())
+                return Error::MissingField;
+            if (castling != "-")
+            {
+                for (char c : castling)
+                {
+                    auto idx = castlingChars.find(c);
+                    if (idx == std::string_view::npos || position.castling & (1 << idx))
+                        return Error::Castling;
+                    position.castling |= static_cast<uint8_t>(1 << idx);
+                }
+            }
+
+            auto enPassant = nextField(text);
+            if (enPassant.empty())
+                return Error::MissingField;
+            if (enPassant != "-")
+            {
+                // White to move captures onto the sixth rank, behind a black pawn on the fifth
+                char rank = position.turn ? '3' : '6';
+                if (enPassant.size() != 2 || enPassant[0] < 'a' || enPassant[0] > 'h' || enPassant[1] != rank)
+                    return Error::EnPassant;
+                auto idx = Board::squareToIdx(Square{enPassant[0] - 'a', enPassant[1] - '1'});
+                auto pawnIdx = position.turn ? idx - 8 : idx + 8;
+                if (position.at(idx) || position.at(pawnIdx) != (position.turn ? whitePawn : blackPawn))
+                    return Error::EnPassant;
+                position.enPassant = static_cast<uint8_t>(idx);
+            }
+
+            return Error::None;
+        }
+
+        /* The counters, if `text` has them, leaving it after them. In EPD, anything but a number
+         * is taken as the start of the operations.
+         */
+        Error parseCounters(std::string_view &text, Position &position, bool epd)
+        {
+            auto rest = text;
+            auto halfmove = nextField(rest);
+            if (halfmove.empty() || (epd && (halfmove[0] < '0' || halfmove[0] > '9')))
+                return Error::None;
+            if (!parseCounter(halfmove, position.halfmoveClock))
+                return Error::HalfmoveClock;
+            auto fullmove = nextField(rest);
+            if (!parseCounter(fullmove, position.fullmoveNumber) || position.fullmoveNumber == 0)
+                return Error::FullmoveNumber;
+            text = rest;
+            return Error::None;
+        }
+
+        // Picks the `hmvc` and `fmvn` operations out of EPD operations
+        Error parseOperations(std::string_view operations, Position &position)
+        {
+            while (!operations.empty())
+            {
+                auto opcode = nextField(operations);
+                if (opcode.empty())
+                    break;
+                if (opcode.back() == ';')
+                    continue; // no operands
+                size_t end = 0;
+                for (bool quoted = false; end < operations.size() && (quoted || operations[end] != ';'); ++end)
+                    quoted ^= operations[end] == '"';
+                auto operands = trim(operations.substr(0, end));
+                operations.remove_prefix(std::min(end + 1, operations.size()));
+
+                if (opcode == "hmvc" && !parseCounter(operands, position.halfmoveClock))
+                    return Error::HalfmoveClock;
+                if (opcode == "fmvn" && (!parseCounter(operands, position.fullmoveNumber) || position.fullmoveNumber == 0))
+                    return Error::FullmoveNumber;
+            }
+            return Error::None;
+        }
+
+        char *writeFields(const Position &position, char *out)
+        {
+            for (size_t rank = 0; rank < 8; ++rank)
+            {
+                if (rank)
+                    *out++ = '/';
+                char empty = 0;
+                for (size_t file = 0; file < 8; ++file)
+                {
+                    auto code = position.at(rank * 8 + file);
+                    if (!code)
+                    {
+                        ++empty;
+                        continue;
+                    }
+                    if (empty)
+                        *out++ = static_cast<char>('0' + empty);
+                    empty = 0;
+                    *out++ = pieceChars[code - 1];
+                }
+                if (empty)
+                    *out++ = static_cast<char>('0' + empty);
+            }
+
+            *out++ = ' ';
+            *out++ = position.turn ? 'b' : 'w';
+
+            *out++ = ' ';
+            if (!position.castling)
+                *out++ = '-';
+            for (size_t i = 0; i < 4; ++i)
+                if (position.castling & (1 << i))
+                    *out++ = castlingChars[i];
+
+            *out++ = ' ';
+            if (position.enPassant == noSquare)
+                *out++ = '-';
+            else
+            {
+                auto square = Board::idxToSquare(position.enPassant);
+                *out++ = static_cast<char>('a' + square.file);
+                *out++ = static_cast<char>('1' + square.rank);
+            }
+            return out;
+        }
+    } // namespace
+
+    std::string_view describe(Error error)
+    {
+        switch (error)
+        {
+        case Error::None:
+            return "no error";
+        case Error::Piece:
+            return "invalid character in piece placement";
+        case Error::RankLength:
+            return "rank without eight squares";
+        case Error::RankCount:
+            return "piece placement without eight ranks";
+        case Error::KingCount:
+            return "not one king per side";
+        case Error::PieceCount:
+            return "more than sixteen pieces of a side";
+        case Error::SideToMove:
+            return "invalid side to move";
+        case Error::Castling:
+            return "invalid castling rights";
+        case Error::EnPassant:
+            return "invalid en passant square";
+        case Error::HalfmoveClock:
+            return "invalid halfmove clock";
+        case Error::FullmoveNumber:
+            return "invalid fullmove number";
+        case Error::MissingField:
+            return "missing field";
+        case Error::TrailingText:
+            return "unexpected text after the record";
+        }
+        return "unknown error";
+    }
+
+    Error parse(std::string_view fen, Position &position)
+    {
+        if (auto error = parseFields(fen, position); error != Error::None)
+            return error;
+        if (auto error = parseCounters(fen, position, false); error != Error::None)
+            return error;
+        return trim(fen).empty() ? Error::None : Error::TrailingText;
+    }
+
+    Error parseEPD(std::string_view epd, Position &position, std::string_view &operations)
+    {
+        if (auto error = parseFields(epd, position); error != Error::None)
+            return error;
+        if (auto error = parseCounters(epd, position, true); error != Error::None)
+            return error;
+        operations = trim(epd);
+        return parseOperations(operations, position);
+    }
+
+    char *write(const Position &position, char *out)
+    {
+        out = writeFields(position, out);
+        *out++ = ' ';
+        out = std::to_chars(out, out + 5, position.halfmoveClock).ptr;
+        *out++ = ' ';
+        return std::to_chars(out, out + 5, position.fullmoveNumber).ptr;
+    }
+
+    char *writeEPD(const Position &position, char *out)
+    {
+        return writeFields(position, out);
+    }
+
+    Position fromState(const State &state)
+    {
+        Position position;
+        const auto &occupants = state.board.eachOccupant();
+        for (size_t i = 0; i < 64; ++i)
+            if (const auto &piece = occupants[i])
+                position.set(i, static_cast<uint8_t>(1 + static_cast<int>(piece->color) * 6 + static_cast<int>(piece->type)));
+
+        const auto &rights = state.castleRights.get();
+        for (size_t i = 0; i < 4; ++i)
+            position.castling |= static_cast<uint8_t>(rights[i] << i);
+        if (state.enPassant)
+            position.enPassant = static_cast<uint8_t>(Board::squareToIdx(state.enPassant.value()));
+        position.turn = static_cast<uint8_t>(state.turn);
+
+        constexpr uint32_t counterMax = std::numeric_limits<uint16_t>::max();
+        position.halfmoveClock = static_cast<uint16_t>(std::min(state.halfTurnCounter, counterMax));
+        position.fullmoveNumber = static_cast<uint16_t>(std::min(state.fullTurnCounter, counterMax));
+        return position;
+    }
+
+    State toState(const Position &position)
+    {
+        std::array<Occupant, 64> occupants;
+        for (size_t i = 0; i < 64; ++i)
+            if (auto code = position.at(i))
+                occupants[i] = Piece{static_cast<Color>((code - 1) / 6), static_cast<PieceType>((code - 1) % 6)};
+
+        std::array<bool, 4> rights;
+        for (size_t i = 0; i < 4; ++i)
+            rights[i] = position.castling & (1 << i);
+        std::optional<Square> enPassant;
+        if (position.enPassant != noSquare)
+            enPassant = Board::idxToSquare(position.enPassant);
+
+        return State{Board{occupants}, static_cast<Color>(position.turn), Castling::Rights{rights}, enPassant,
+                     position.halfmoveClock, position.fullmoveNumber};
+    }
+
+    PackedPosition pack(const Position &position)
+    {
+        auto packed = PackedPosition::fromSquares(position.pieces);
+        packed.flags = static_cast<uint8_t>(position.turn | position.castling << 1);
+        // Canonical, as from a `State`: only a capturable en passant square
+        if (position.enPassant != noSquare)
+        {
+            auto turn = static_cast<Color>(position.turn);
+            auto pawn = static_cast<uint8_t>(1 + static_cast<int>(turn) * 6 + static_cast<int>(PieceType::Pawn));
+            auto attackers = AttackTables::pawnAttacks(oppositeColor(turn), position.enPassant);
+            while (attackers && packed.enPassant == noSquare)
+                if (position.at(Bitboards::popLsb(attackers)) == pawn)
+                    packed.enPassant = position.enPassant;
+        }
+        packed.halfmoveClock = position.halfmoveClock;
+        packed.fullmoveNumber = position.fullmoveNumber;
+        return packed;
+    }
+
+    Position unpack(const PackedPosition &packed)
+    {
+        Position position;
+        position.pieces = packed.squares();
+        position.castling = static_cast<uint8_t>(packed.flags >> 1);
+        position.enPassant = packed.enPassant;
+        position.turn = static_cast<uint8_t>(packed.flags & 1);
+        position.halfmoveClock = packed.halfmoveClock;
+        position.fullmoveNumber = packed.fullmoveNumber;
+        return position;
+    }
+
+    EPDBatch parseEPDLines(std::string_view text)
+    {
+        EPDBatch batch;
+        batch.positions.reserve(static_cast<size_t>(std::count(text.begin(), text.end(), '\n')) + 1);
+
+        const char *cursor = text.data(), *end = text.data() + text.size();
+        for (size_t line = 1; cursor < end; ++line)
+        {
+            auto *newline = static_cast<const char *>(std::memchr(cursor, '\n', static_cast<size_t>(end - cursor)));
+            auto *lineEnd = newline ? newline : end;
+            auto record = trim({cursor, static_cast<size_t>(lineEnd - cursor)});
+            cursor = lineEnd + 1;
+
+            if (record.empty() || record.front() == '#')
+                continue;
+            std::string_view operations;
+            auto &position = batch.positions.emplace_back();
+            if (auto error = parseEPD(record, position, operations); error != Error::None)
+            {
+                batch.positions.pop_back();
+                batch.failures.push_back({line, error});
+            }
+        }
+        return batch;
+    }
+
+    EPDBatch readEPD(const MappedFile &file)
+    {
+        return parseEPDLines(file.text());
+    }
+
+    EPDBatch readEPD(const std::filesystem::path &path)
+    {
+        return readEPD(MappedFile{path});
+    }
+} // namespace JChess::FEN
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+#include "core/packedPosition.h"
+#include "core/state.h"
+#include "formats/mappedFile.h"
+
+namespace JChess::FEN
+{
+    /* FEN and EPD without exceptions or allocation: parsing reports the first problem as an
+     * `Error`, and writing fills a caller's buffer. `State(std::string_view)` remains the
+     * convenient, throwing way in; this is for bulk work such as test suites and probe lists.
+     */
+    enum class Error : uint8_t
+    {
+        None,
+        Piece,          // a character that is not a piece, digit or '/'
+        RankLength,     // a rank of other than eight squares
+        RankCount,      // other than eight ranks
+        KingCount,      // other than one king per side
+        PieceCount,     // more than sixteen pieces of a side
+        SideToMove,     // not 'w' or 'b'
+        Castling,       // not '-' or distinct letters of "KQkq"
+        EnPassant,      // not '-' or a square on the third or sixth rank behind a pawn push
+        HalfmoveClock,  // not a number, or out of range
+        FullmoveNumber, // not a positive number, or out of range
+        MissingField,
+        TrailingText,
+    };
+
+    std::string_view describe(Error error);
+
+    /* A parsed position in 40 bytes, four bits per square. Square `i` (`Board::squareToIdx`
+     * order, a8 first) is in the low nibble of `pieces[i / 2]` for even `i` and the high
+     * nibble for odd `i`: 0 for empty, else 1 + color * 6 + piece type.
+     */
+    struct Position
+    {
+        std::array<uint8_t, 32> pieces{};
+        uint8_t castling = 0;    // bits K, Q, k, q from the lowest
+        uint8_t enPassant = 64;  // square index, or 64 for none
+        uint8_t turn = 0;        // as `Color`
+        uint16_t halfmoveClock = 0;
+        uint16_t fullmoveNumber = 1;
+
+        uint8_t at(size_t idx) const { return (pieces[idx / 2] >> ((idx % 2) * 4)) & 0xF; }
+        void set(size_t idx, uint8_t code)
+        {
+            auto shift = (idx % 2) * 4;
+            pieces[idx / 2] = static_cast<uint8_t>((pieces[idx / 2] & ~(0xF << shift)) | code << shift);
+        }
+
+        bool operator==(const Position &other) const = default;
+    };
+    static_assert(sizeof(Position) == 40);
+
+    /* Parse a FEN record, optionally without its two counters (which default to 0 and 1).
+     * Whitespace around it is ignored.
+     */
+    Error parse(std::string_view fen, Position &position);
+
+    /* Parse an EPD record: the first four FEN fields, then operations such as `bm Nf3; id
+     * "x";`, which are returned as written (trimmed). The counters may follow the four fields
+     * as in FEN, or be given by `hmvc` and `fmvn` operations.
+     */
+    Error parseEPD(std::string_view epd, Position &position, std::string_view &operations);
+
+    // The longest FEN `write` produces, with five-digit counters
+    constexpr size_t maxLength = 93;
+
+    /* Write the FEN (or, for `writeEPD`, its first four fields) to `out`, which must have
+     * room for `maxLength` characters, and return the end of what was written. No
+     * terminating null is added.
+     */
+    char *write(const Position &position, char *out);
+    char *writeEPD(const Position &position, char *out);
+
+    Position fromState(const State &state);
+    State toState(const Position &position);
+
+    // Between this mailbox form and the canonical packed one; see `PackedPosition`
+    PackedPosition pack(const Position &position);
+    Position unpack(const PackedPosition &packed);
+
+    // A batch of EPD records, in file order, with the lines that could not be parsed
+    struct EPDBatch
+    {
+        struct Failure
+        {
+            size_t line; // from 1
+            Error error;
+        };
+
+        std::vector<Position> positions;
+        std::vector<Failure> failures;
+    };
+
+    /* Parse every non-empty line of EPD (or FEN) text, e.g., from a `MappedFile`. Lines
+     * starting with '#' are comments.
+     */
+    EPDBatch parseEPDLines(std::string_view text);
+    EPDBatch readEPD(const MappedFile &file);
+    EPDBatch readEPD(const std::filesystem::path &path);
+} // namespace JChess::FEN
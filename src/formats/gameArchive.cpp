@@ -0,0 +1,199 @@
+#include "formats/gameArchive.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "formats/binaryFile.h"
+#include "formats/checksum.h"
+
+namespace JChess
+{
+    namespace
+    {
+        static_assert(std::endian::native == std::endian::little, "archives are read in place as little-endian");
+
+        constexpr std::string_view headerMagic = "JCARCHV1";
+        constexpr std::string_view trailerMagic = "JCARIDX1";
+        constexpr size_t blockEntrySize = 16;
+        constexpr size_t trailerSize = 32;
+
+        template <class T>
+        void append(std::string &out, T value)
+        {
+            out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+        }
+
+        template <class T>
+        T load(const char *p)
+        {
+            T value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        [[noreturn]] void damaged(const std::string &what)
+        {
+            throw std::runtime_error("Damaged game archive: " + what);
+        }
+    } // namespace
+
+    GameArchiveWriter::GameArchiveWriter(const std::filesystem::path &path, uint32_t gamesPerBlock)
+        : m_output(path, std::ios::binary | std::ios::trunc), m_gamesPerBlock(std::max<uint32_t>(gamesPerBlock, 1))
+    {
+        if (!m_output)
+            throw std::runtime_error("Unable to create game archive: " + path.string());
+        m_output.write(headerMagic.data(), static_cast<std::streamsize>(headerMagic.size()));
+        m_offset = headerMagic.size();
+    }
+
+    GameArchiveWriter::~GameArchiveWriter()
+    {
+        try
+        {
+            finish();
+        }
+        catch (...)
+        {
+        }
+    }
+
+    void GameArchiveWriter::add(const Game &game)
+    {
+        if (m_finished)
+            throw std::runtime_error("Game archive already finished");
+        m_gameOffsets.push_back(static_cast<uint32_t>(m_block.size()));
+        writeBinary(m_block, game, BinaryVersion::V2);
+        if (m_block.size() > UINT32_MAX)
+            throw std::runtime_error("Game archive block too large");
+        if (m_gameOffsets.size() % m_gamesPerBlock == 0)
+            flushBlock();
+    }
+
+    void GameArchiveWriter::flushBlock()
+    {
+        if (m_block.empty())
+            return;
+        m_blocks.push_back({.offset = m_offset, .size = static_cast<uint32_t>(m_block.size()), .checksum = crc32c(m_block)});
+        m_output.write(m_block.data(), static_cast<std::streamsize>(m_block.size()));
+        m_offset += m_block.size();
+        m_block.clear();
+    }
+
+    void GameArchiveWriter::finish()
+    {
+        if (m_finished)
+            return;
+        m_finished = true;
+        flushBlock();
+
+        std::string index;
+        index.reserve(m_blocks.size() * blockEntrySize + m_gameOffsets.size() * 4 + trailerSize);
+        for (const auto &block : m_blocks)
+        {
+            append(index, block.offset);
+            append(index, block.size);
+            append(index, block.checksum);
+        }
+        for (auto offset : m_gameOffsets)
+            append(index, offset);
+        uint32_t indexChecksum = crc32c(index);
+
+        append(index, m_offset);
+        append(index, static_cast<uint64_t>(m_gameOffsets.size()));
+        append(index, m_gamesPerBlock);
+        append(index, indexChecksum);
+        index += trailerMagic;
+
+        m_output.write(index.data(), static_cast<std::streamsize>(index.size()));
+        m_output.close();
+        if (!m_output)
+            throw std::runtime_error("Unable to write game archive");
+    }
+
+    GameArchive::GameArchive(const std::filesystem::path &path)
+        : m_file(path, MappedFile::Access::Random)
+    {
+        auto size = m_file.size();
+        if (size < headerMagic.size() + trailerSize || m_file.text().substr(0, headerMagic.size()) != headerMagic)
+            damaged("not an archive: " + path.string());
+
+        const char *trailer = m_file.data() + size - trailerSize;
+        if (std::string_view(trailer + 24, trailerMagic.size()) != trailerMagic)
+            damaged("missing index trailer");
+        auto indexOffset = load<uint64_t>(trailer);
+        m_gameCount = load<uint64_t>(trailer + 8);
+        m_gamesPerBlock = load<uint32_t>(trailer + 16);
+        auto indexChecksum = load<uint32_t>(trailer + 20);
+
+        if (m_gamesPerBlock == 0)
+            damaged("zero games per block");
+        // Every game takes 4 bytes of the index, which bounds the count before it is multiplied
+        if (m_gameCount > (size - trailerSize) / 4)
+            damaged("game count");
+        uint64_t blocks = m_gameCount / m_gamesPerBlock + (m_gameCount % m_gamesPerBlock != 0);
+        uint64_t indexSize = blocks * blockEntrySize + m_gameCount * 4;
+        if (indexOffset < headerMagic.size() || indexOffset > size - trailerSize ||
+            indexSize != size - trailerSize - indexOffset)
+            damaged("index size");
+        // Only the trailer is checked here, so opening costs the same at any size. Each block
+        // entry is checked when it is used, and the index checksum by `verify`.
+        m_indexOffset = indexOffset;
+        m_indexChecksum = indexChecksum;
+        m_blockCount = blocks;
+        m_blockIndex = m_file.data() + indexOffset;
+        m_gameIndex = m_blockIndex + blocks * blockEntrySize;
+    }
+
+    std::string_view GameArchive::block(size_t b) const
+    {
+        const char *entry = m_blockIndex + b * blockEntrySize;
+        auto offset = load<uint64_t>(entry);
+        auto size = load<uint32_t>(entry + 8);
+        if (offset < headerMagic.size() || offset > m_indexOffset || size > m_indexOffset - offset)
+            damaged("block " + std::to_string(b) + " out of range");
+        std::string_view data{m_file.data() + offset, size};
+        if (crc32c(data) != load<uint32_t>(entry + 12))
+            damaged("block " + std::to_string(b) + " checksum");
+        return data;
+    }
+
+    std::string_view GameArchive::gameData(size_t i) const
+    {
+        if (i >= m_gameCount)
+            throw std::out_of_range("Game " + std::to_string(i) + " is past the end of the archive");
+
+        size_t b = i / m_gamesPerBlock;
+        auto data = block(b);
+        size_t begin = load<uint32_t>(m_gameIndex + i * 4);
+        size_t end = (i + 1 < m_gameCount && (i + 1) % m_gamesPerBlock != 0) ? load<uint32_t>(m_gameIndex + (i + 1) * 4)
+                                                                                 : data.size();
+        if (begin > end || end > data.size())
+            damaged("offset of game " + std::to_string(i));
+        return data.substr(begin, end - begin);
+    }
+
+    void GameArchive::game(size_t i, Game &game) const
+    {
+        auto data = gameData(i);
+        readBinary(data, game);
+    }
+
+    Game GameArchive::game(size_t i) const
+    {
+        Game game;
+        this->game(i, game);
+        return game;
+    }
+
+    void GameArchive::verify() const
+    {
+        std::string_view index{m_blockIndex, static_cast<size_t>(m_gameIndex - m_blockIndex) + m_gameCount * 4};
+        if (crc32c(index) != m_indexChecksum)
+            damaged("index checksum");
+        for (uint64_t b = 0; b < m_blockCount; ++b)
+            block(b);
+    }
+} // namespace JChess
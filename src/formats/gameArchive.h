@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "core/game.h"
+#include "formats/mappedFile.h"
+
+namespace JChess
+{
+    /* An archive of binary (version 2) games with an index for random access:
+     *
+     *   "JCARCHV1"
+     *   blocks of up to `gamesPerBlock` games, back to back
+     *   index: per block, its offset (64 bits), size and CRC-32C (32 bits each); then per game,
+     *          its offset within its block (32 bits)
+     *   trailer: index offset, game count (64 bits), games per block, index CRC-32C (32 bits),
+     *            "JCARIDX1"
+     *
+     * All integers are little-endian. Game `i` is in block `i / gamesPerBlock`, so finding it
+     * takes two index reads and no scan.
+     */
+
+    /* Writes an archive. The index is written by `finish`, or by the destructor (which
+     * swallows any error) if `finish` was not called.
+     */
+    class GameArchiveWriter
+    {
+    public:
+        explicit GameArchiveWriter(const std::filesystem::path &path, uint32_t gamesPerBlock = 64);
+        ~GameArchiveWriter();
+
+        GameArchiveWriter(const GameArchiveWriter &) = delete;
+        GameArchiveWriter &operator=(const GameArchiveWriter &) = delete;
+
+        void add(const Game &game);
+        void finish();
+
+        size_t gamesWritten() const { return m_gameOffsets.size(); }
+
+    private:
+        struct BlockEntry
+        {
+            uint64_t offset;
+            uint32_t size;
+            uint32_t checksum;
+        };
+
+        void flushBlock();
+
+    private:
+        std::ofstream m_output;
+        uint32_t m_gamesPerBlock;
+        uint64_t m_offset = 0;
+        std::string m_block;
+        std::vector<BlockEntry> m_blocks;
+        std::vector<uint32_t> m_gameOffsets;
+        bool m_finished = false;
+    };
+
+    /* A mapped archive. Opening reads only the trailer, and reading a game checks only its
+     * block's entry and checksum, so neither grows with the archive. A damaged trailer, or a
+     * block that does not match, throws `std::runtime_error`; `verify` checks the rest.
+     *
+     *     auto game = GameArchive::open("games.jca").game(5'000'000);
+     */
+    class GameArchive
+    {
+    public:
+        explicit GameArchive(const std::filesystem::path &path);
+
+        static GameArchive open(const std::filesystem::path &path) { return GameArchive{path}; }
+
+        size_t size() const { return m_gameCount; }
+
+        Game game(size_t i) const;
+        void game(size_t i, Game &game) const;
+        // The game's encoded bytes, as `writeBinary` wrote them
+        std::string_view gameData(size_t i) const;
+
+        // Check the index's checksum and every block's
+        void verify() const;
+
+    private:
+        std::string_view block(size_t b) const;
+
+    private:
+        MappedFile m_file;
+        uint64_t m_gameCount = 0;
+        uint32_t m_gamesPerBlock = 0;
+        uint64_t m_blockCount = 0;
+        uint64_t m_indexOffset = 0;
+        uint32_t m_indexChecksum = 0;
+        const char *m_blockIndex = nullptr;
+        const char *m_gameIndex = nullptr;
+    };
+} // namespace JChess
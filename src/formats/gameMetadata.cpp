@@ -0,0 +1,488 @@
+#include "formats/gameMetadata.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define JCHESS_RUNTIME_AVX2 1
+#endif
+
+namespace JChess
+{
+    namespace
+    {
+        static_assert(std::endian::native == std::endian::little, "sidecars are read in place as little-endian");
+
+        constexpr std::string_view magic = "JCMETA01";
+        constexpr size_t blockGames = 64;
+        constexpr size_t alignment = 64;
+
+        enum Section : size_t
+        {
+            WhiteELO,
+            BlackELO,
+            BaseSeconds,
+            IncrementSeconds,
+            ECO,
+            Datetime,
+            Result,
+            WhitePlayer,
+            BlackPlayer,
+            UsernameOffsets,
+            Usernames,
+            SectionCount,
+        };
+
+        struct SectionEntry
+        {
+            uint64_t offset;
+            uint64_t size;
+        };
+        using Directory = std::array<SectionEntry, SectionCount>;
+
+        constexpr size_t headerSize = magic.size() + 16 + sizeof(Directory);
+
+        size_t padded(size_t games)
+        {
+            return (games + blockGames - 1) / blockGames * blockGames;
+        }
+
+        [[noreturn]] void invalid(const std::string &what)
+        {
+            throw std::runtime_error("Invalid game metadata: " + what);
+        }
+
+        /* Filter kernels: each tests the 64 games of a block and returns one bit per game.
+         * The scalar versions are the reference; the AVX2 versions are picked at runtime.
+         */
+        struct Kernels
+        {
+            uint64_t (*range16)(const uint16_t *values, uint16_t min, uint16_t max);
+            uint64_t (*range32)(const uint32_t *values, uint32_t min, uint32_t max);
+            uint64_t (*estimated)(const uint16_t *base, const uint16_t *increment, uint32_t min, uint32_t max);
+            uint64_t (*codeSet)(const uint8_t *codes, uint32_t set);
+        };
+
+        uint64_t range16Scalar(const uint16_t *values, uint16_t min, uint16_t max)
+        {
+            uint64_t mask = 0;
+            for (size_t i = 0; i < blockGames; ++i)
+                mask |= static_cast<uint64_t>(static_cast<uint16_t>(values[i] - min) <= static_cast<uint16_t>(max - min)) << i;
+            return mask;
+        }
+
+        uint64_t range32Scalar(const uint32_t *values, uint32_t min, uint32_t max)
+        {
+            uint64_t mask = 0;
+            for (size_t i = 0; i < blockGames; ++i)
+                mask |= static_cast<uint64_t>(values[i] - min <= max - min) << i;
+            return mask;
+        }
+
+        uint64_t estimatedScalar(const uint16_t *base, const uint16_t *increment, uint32_t min, uint32_t max)
+        {
+            uint64_t mask = 0;
+            for (size_t i = 0; i < blockGames; ++i)
+            {
+                uint32_t seconds = base[i] + 40u * increment[i];
+                mask |= static_cast<uint64_t>(seconds - min <= max - min) << i;
+            }
+            return mask;
+        }
+
+        uint64_t codeSetScalar(const uint8_t *codes, uint32_t set)
+        {
+            uint64_t mask = 0;
+            for (size_t i = 0; i < blockGames; ++i)
+                mask |= static_cast<uint64_t>((set >> (codes[i] & 0x1F)) & 1) << i;
+            return mask;
+        }
+
+#if defined(JCHESS_RUNTIME_AVX2)
+        // Unsigned `min <= x <= max` as `x - min <= max - min`, with the comparison as a min
+        __attribute__((target("avx2"))) uint64_t range16AVX2(const uint16_t *values, uint16_t min, uint16_t max)
+        {
+            __m256i low = _mm256_set1_epi16(static_cast<short>(min));
+            __m256i span = _mm256_set1_epi16(static_cast<short>(max - min));
+            uint64_t mask = 0;
+            for (size_t i = 0; i < blockGames; i += 32)
+            {
+                __m256i a = _mm256_sub_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + i)), low);
+                __m256i b = _mm256_sub_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + i + 16)), low);
+                a = _mm256_cmpeq_epi16(_mm256_min_epu16(a, span), a);
+                b = _mm256_cmpeq_epi16(_mm256_min_epu16(b, span), b);
+                // Pack to bytes, then undo the per-lane interleaving of the pack
+                __m256i bytes = _mm256_permute4x64_epi64(_mm256_packs_epi16(a, b), 0xD8);
+                mask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(bytes))) << i;
+            }
+            return mask;
+        }
+
+        __attribute__((target("avx2"))) inline uint64_t inRange32(__m256i values, __m256i low, __m256i span)
+        {
+            __m256i offset = _mm256_sub_epi32(values, low);
+            __m256i in = _mm256_cmpeq_epi32(_mm256_min_epu32(offset, span), offset);
+            return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(in)));
+        }
+
+        __attribute__((target("avx2"))) uint64_t range32AVX2(const uint32_t *values, uint32_t min, uint32_t max)
+        {
+            __m256i low = _mm256_set1_epi32(static_cast<int>(min));
+            __m256i span = _mm256_set1_epi32(static_cast<int>(max - min));
+            uint64_t mask = 0;
+            for (size_t i = 0; i < blockGames; i += 8)
+                mask |= inRange32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + i)), low, span) << i;
+            return mask;
+        }
+
+        __attribute__((target("avx2"))) uint64_t estimatedAVX2(const uint16_t *base, const uint16_t *increment, uint32_t min, uint32_t max)
+        {
+            __m256i low = _mm256_set1_epi32(static_cast<int>(min));
+            __m256i span = _mm256_set1_epi32(static_cast<int>(max - min));
+            __m256i forty = _mm256_set1_epi32(40);
+            uint64_t mask = 0;
+            for (size_t i = 0; i < blockGames; i += 8)
+            {
+                __m256i b = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(base + i)));
+                __m256i inc = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(increment + i)));
+                mask |= inRange32(_mm256_add_epi32(b, _mm256_mullo_epi32(inc, forty)), low, span) << i;
+            }
+            return mask;
+        }
+
+        // The 32-entry set as two byte tables, looked up by the low four bits of each code
+        __attribute__((target("avx2"))) uint64_t codeSetAVX2(const uint8_t *codes, uint32_t set)
+        {
+            alignas(32) std::array<uint8_t, 32> lowTable, highTable;
+            for (size_t i = 0; i < 16; ++i)
+            {
+                lowTable[i] = lowTable[i + 16] = ((set >> i) & 1) ? 0xFF : 0;
+                highTable[i] = highTable[i + 16] = ((set >> (i + 16)) & 1) ? 0xFF : 0;
+            }
+            __m256i lows = _mm256_load_si256(reinterpret_cast<const __m256i *>(lowTable.data()));
+            __m256i highs = _mm256_load_si256(reinterpret_cast<const __m256i *>(highTable.data()));
+            __m256i nibble = _mm256_set1_epi8(0x0F);
+            __m256i fiveBits = _mm256_set1_epi8(0x1F);
+
+            uint64_t mask = 0;
+            for (size_t i = 0; i < blockGames; i += 32)
+            {
+                __m256i code = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(codes + i)), fiveBits);
+                __m256i index = _mm256_and_si256(code, nibble);
+                // Bit 4 of each code, moved to bit 7 to select the table
+                __m256i high = _mm256_slli_epi16(code, 3);
+                __m256i in = _mm256_blendv_epi8(_mm256_shuffle_epi8(lows, index), _mm256_shuffle_epi8(highs, index), high);
+                mask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(in))) << i;
+            }
+            return mask;
+        }
+#endif
+
+        const Kernels &kernels()
+        {
+            static const Kernels selected = []
+            {
+#if defined(JCHESS_RUNTIME_AVX2)
+                __builtin_cpu_init();
+                if (__builtin_cpu_supports("avx2"))
+                    return Kernels{range16AVX2, range32AVX2, estimatedAVX2, codeSetAVX2};
+#endif
+                return Kernels{range16Scalar, range32Scalar, estimatedScalar, codeSetScalar};
+            }();
+            return selected;
+        }
+
+        uint32_t epochSeconds(std::chrono::sys_seconds time)
+        {
+            return static_cast<uint32_t>(std::clamp<int64_t>(time.time_since_epoch().count(), 0, UINT32_MAX));
+        }
+
+        template <class T>
+        void writeSection(std::ofstream &output, Directory &directory,
+                          Section section, const std::vector<T> &values, size_t count)
+        {
+            static constexpr char zeros[alignment]{};
+            auto offset = static_cast<uint64_t>(output.tellp());
+            if (offset % alignment)
+            {
+                output.write(zeros, static_cast<std::streamsize>(alignment - offset % alignment));
+                offset += alignment - offset % alignment;
+            }
+            output.write(reinterpret_cast<const char *>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)));
+            for (size_t i = values.size(); i < count; ++i)
+                output.write(zeros, sizeof(T));
+            directory[section] = {offset, count * sizeof(T)};
+        }
+    } // namespace
+
+    Range<uint32_t> estimatedSeconds(Speed speed)
+    {
+        switch (speed)
+        {
+        case Speed::UltraBullet:
+            return {0, 29};
+        case Speed::Bullet:
+            return {30, 179};
+        case Speed::Blitz:
+            return {180, 479};
+        case Speed::Rapid:
+            return {480, 1499};
+        default:
+            return {1500, UINT32_MAX};
+        }
+    }
+
+    uint16_t ecoIndex(std::string_view eco)
+    {
+        if (eco.size() != 3 || eco[0] < 'A' || eco[0] > 'E' || eco[1] < '0' || eco[1] > '9' || eco[2] < '0' || eco[2] > '9')
+            return 0;
+        return static_cast<uint16_t>((eco[0] - 'A') * 100 + (eco[1] - '0') * 10 + (eco[2] - '0') + 1);
+    }
+
+    MetadataFilter &MetadataFilter::acceptResults(std::optional<GameResult::Type> type, std::optional<GameResult::Reason> reason)
+    {
+        uint32_t set = 0;
+        for (uint8_t t = 0; t < 4; ++t)
+            for (uint8_t r = 0; r < 8; ++r)
+                if ((!type || static_cast<uint8_t>(*type) == t) && (!reason || static_cast<uint8_t>(*reason) == r))
+                    set |= 1u << (t | r << 2);
+        results = results.value_or(0) | set;
+        return *this;
+    }
+
+    GameMetadataWriter::GameMetadataWriter(std::filesystem::path path)
+        : m_path(std::move(path))
+    {
+    }
+
+    uint32_t GameMetadataWriter::userID(const std::string &username)
+    {
+        auto [it, added] = m_userIDs.try_emplace(username, static_cast<uint32_t>(m_usernames.size()));
+        if (added)
+            m_usernames.push_back(&it->first);
+        return it->second;
+    }
+
+    void GameMetadataWriter::add(const Game &game)
+    {
+        auto seconds = [](msDuration duration)
+        {
+            return static_cast<uint16_t>(std::min<uint32_t>(duration.count() / 1000, UINT16_MAX));
+        };
+        m_whiteELO.push_back(game.whiteELO);
+        m_blackELO.push_back(game.blackELO);
+        m_baseSeconds.push_back(seconds(game.timeControl.initial));
+        m_incrementSeconds.push_back(seconds(game.timeControl.increment));
+        m_ECO.push_back(ecoIndex(game.ECOCode));
+        m_datetime.push_back(epochSeconds(game.datetime));
+        m_result.push_back(resultCode(game.result));
+        m_white.push_back(userID(game.whiteUsername));
+        m_black.push_back(userID(game.blackUsername));
+    }
+
+    void GameMetadataWriter::finish()
+    {
+        // Sort the dictionary, so that readers can binary search it, and renumber the players
+        std::vector<uint32_t> order(m_usernames.size());
+        std::iota(order.begin(), order.end(), 0u);
+        std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b)
+                  { return *m_usernames[a] < *m_usernames[b]; });
+        std::vector<uint32_t> renumbered(order.size());
+        for (uint32_t i = 0; i < order.size(); ++i)
+            renumbered[order[i]] = i;
+        for (auto *players : {&m_white, &m_black})
+            for (auto &id : *players)
+                id = renumbered[id];
+
+        std::vector<uint32_t> offsets{0};
+        std::vector<char> usernames;
+        for (auto id : order)
+        {
+            usernames.insert(usernames.end(), m_usernames[id]->begin(), m_usernames[id]->end());
+            if (usernames.size() > UINT32_MAX)
+                throw std::runtime_error("Too many usernames for game metadata");
+            offsets.push_back(static_cast<uint32_t>(usernames.size()));
+        }
+
+        std::ofstream output{m_path, std::ios::binary | std::ios::trunc};
+        if (!output)
+            throw std::runtime_error("Unable to create game metadata: " + m_path.string());
+        output.write(magic.data(), static_cast<std::streamsize>(magic.size()));
+        uint64_t counts[2]{m_result.size(), m_usernames.size()};
+        output.write(reinterpret_cast<const char *>(counts), sizeof(counts));
+        Directory directory{};
+        output.write(reinterpret_cast<const char *>(directory.data()), sizeof(directory));
+
+        size_t count = padded(m_result.size());
+        writeSection(output, directory, WhiteELO, m_whiteELO, count);
+        writeSection(output, directory, BlackELO, m_blackELO, count);
+        writeSection(output, directory, BaseSeconds, m_baseSeconds, count);
+        writeSection(output, directory, IncrementSeconds, m_incrementSeconds, count);
+        writeSection(output, directory, ECO, m_ECO, count);
+        writeSection(output, directory, Datetime, m_datetime, count);
+        writeSection(output, directory, Result, m_result, count);
+        writeSection(output, directory, WhitePlayer, m_white, count);
+        writeSection(output, directory, BlackPlayer, m_black, count);
+        writeSection(output, directory, UsernameOffsets, offsets, offsets.size());
+        writeSection(output, directory, Usernames, usernames, usernames.size());
+
+        output.seekp(static_cast<std::streamoff>(magic.size() + sizeof(counts)));
+        output.write(reinterpret_cast<const char *>(directory.data()), sizeof(directory));
+        output.close();
+        if (!output)
+            throw std::runtime_error("Unable to write game metadata: " + m_path.string());
+    }
+
+    GameMetadata::GameMetadata(const std::filesystem::path &path)
+        : m_file(path)
+    {
+        if (m_file.size() < headerSize || m_file.text().substr(0, magic.size()) != magic)
+            invalid("not a sidecar: " + path.string());
+
+        uint64_t counts[2];
+        std::memcpy(counts, m_file.data() + magic.size(), sizeof(counts));
+        m_size = counts[0];
+        m_userCount = counts[1];
+        // Each game takes bytes in every column and each player 4 in the offsets, which
+        // bounds both counts before they size anything
+        if (m_size > m_file.size() || m_userCount > m_file.size() / sizeof(uint32_t))
+            invalid("counts");
+        Directory directory;
+        std::memcpy(directory.data(), m_file.data() + magic.size() + sizeof(counts), sizeof(directory));
+
+        auto section = [&]<class T>(Section s, size_t count, const T *&column)
+        {
+            auto [offset, size] = directory[s];
+            if (offset % alignof(T) || offset > m_file.size() || size > m_file.size() - offset || size % sizeof(T) ||
+                size / sizeof(T) != count)
+                invalid("column " + std::to_string(s));
+            column = reinterpret_cast<const T *>(m_file.data() + offset);
+        };
+        size_t count = padded(m_size);
+        section(WhiteELO, count, m_whiteELO);
+        section(BlackELO, count, m_blackELO);
+        section(BaseSeconds, count, m_baseSeconds);
+        section(IncrementSeconds, count, m_incrementSeconds);
+        section(ECO, count, m_ECO);
+        section(Datetime, count, m_datetime);
+        section(Result, count, m_result);
+        section(WhitePlayer, count, m_white);
+        section(BlackPlayer, count, m_black);
+        section(UsernameOffsets, m_userCount + 1, m_usernameOffsets);
+        // So that every username is a range within the section
+        if (m_usernameOffsets[0] != 0 || !std::is_sorted(m_usernameOffsets, m_usernameOffsets + m_userCount + 1))
+            invalid("username offsets");
+        section(Usernames, m_usernameOffsets[m_userCount], m_usernames);
+    }
+
+    std::string_view GameMetadata::username(uint32_t id) const
+    {
+        if (id >= m_userCount)
+            invalid("player " + std::to_string(id));
+        return {m_usernames + m_usernameOffsets[id], m_usernameOffsets[id + 1] - m_usernameOffsets[id]};
+    }
+
+    std::optional<uint32_t> GameMetadata::userID(std::string_view name) const
+    {
+        uint32_t low = 0, high = static_cast<uint32_t>(m_userCount);
+        while (low < high)
+        {
+            uint32_t mid = low + (high - low) / 2;
+            if (username(mid) < name)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+        if (low < m_userCount && username(low) == name)
+            return low;
+        return std::nullopt;
+    }
+
+    /* Each condition narrows the block's mask, and the rest are skipped once it is empty.
+     * The padding past the last game is masked off.
+     */
+    template <class Visit>
+    void GameMetadata::scan(const MetadataFilter &filter, Visit visit) const
+    {
+        const auto &k = kernels();
+
+        std::optional<uint32_t> white, black, player;
+        for (auto [name, id] : {std::pair{&filter.white, &white}, {&filter.black, &black}, {&filter.player, &player}})
+            if (*name && !(*id = userID(**name)))
+                return;
+
+        std::optional<Range<uint32_t>> datetime;
+        if (filter.datetime)
+        {
+            datetime = Range<uint32_t>{epochSeconds(filter.datetime->min), epochSeconds(filter.datetime->max)};
+            if (filter.datetime->max.time_since_epoch().count() < 0)
+                return;
+        }
+
+        auto empty = [](const auto &range)
+        { return range && range->min > range->max; };
+        if (empty(filter.whiteELO) || empty(filter.blackELO) || empty(filter.ELO) || empty(filter.baseSeconds) ||
+            empty(filter.incrementSeconds) || empty(filter.estimatedSeconds) || empty(filter.ECO) || empty(datetime))
+            return;
+
+        size_t blocks = padded(m_size) / blockGames;
+        for (size_t b = 0; b < blocks; ++b)
+        {
+            size_t first = b * blockGames;
+            uint64_t mask = (m_size - first >= blockGames) ? ~uint64_t{0} : (uint64_t{1} << (m_size - first)) - 1;
+
+            if (filter.results && mask)
+                mask &= k.codeSet(m_result + first, *filter.results);
+            if (datetime && mask)
+                mask &= k.range32(m_datetime + first, datetime->min, datetime->max);
+            if (filter.ELO && mask)
+                mask &= k.range16(m_whiteELO + first, filter.ELO->min, filter.ELO->max) &
+                        k.range16(m_blackELO + first, filter.ELO->min, filter.ELO->max);
+            if (filter.whiteELO && mask)
+                mask &= k.range16(m_whiteELO + first, filter.whiteELO->min, filter.whiteELO->max);
+            if (filter.blackELO && mask)
+                mask &= k.range16(m_blackELO + first, filter.blackELO->min, filter.blackELO->max);
+            if (filter.estimatedSeconds && mask)
+                mask &= k.estimated(m_baseSeconds + first, m_incrementSeconds + first, filter.estimatedSeconds->min, filter.estimatedSeconds->max);
+            if (filter.baseSeconds && mask)
+                mask &= k.range16(m_baseSeconds + first, filter.baseSeconds->min, filter.baseSeconds->max);
+            if (filter.incrementSeconds && mask)
+                mask &= k.range16(m_incrementSeconds + first, filter.incrementSeconds->min, filter.incrementSeconds->max);
+            if (filter.ECO && mask)
+                mask &= k.range16(m_ECO + first, filter.ECO->min, filter.ECO->max);
+            if (white && mask)
+                mask &= k.range32(m_white + first, *white, *white);
+            if (black && mask)
+                mask &= k.range32(m_black + first, *black, *black);
+            if (player && mask)
+                mask &= k.range32(m_white + first, *player, *player) | k.range32(m_black + first, *player, *player);
+
+            if (mask)
+                visit(first, mask);
+        }
+    }
+
+    std::vector<uint64_t> GameMetadata::select(const MetadataFilter &filter) const
+    {
+        std::vector<uint64_t> games;
+        scan(filter, [&](size_t first, uint64_t mask)
+             {
+                 for (; mask; mask &= mask - 1)
+                     games.push_back(first + static_cast<size_t>(std::countr_zero(mask))); });
+        return games;
+    }
+
+    size_t GameMetadata::count(const MetadataFilter &filter) const
+    {
+        size_t total = 0;
+        scan(filter, [&](size_t, uint64_t mask)
+             { total += static_cast<size_t>(std::popcount(mask)); });
+        return total;
+    }
+} // namespace JChess
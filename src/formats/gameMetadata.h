@@ -0,0 +1,159 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "core/game.h"
+#include "formats/mappedFile.h"
+
+namespace JChess
+{
+    /* A columnar sidecar of game headers, for filtering games without decoding them. Game `i`
+     * here is game `i` of the archive or file written alongside it.
+     *
+     *   "JCMETA01", game count, user count (64 bits each)
+     *   directory: offset and size of each column (64 bits each)
+     *   columns, each aligned to 64 bytes and padded to a multiple of 64 games:
+     *     white ELO, black ELO, base time and increment in seconds, ECO code (16 bits each);
+     *     UTC datetime in seconds since the epoch (32 bits); result (8 bits, type | reason << 2);
+     *     white and black player (32 bits each), as indices into the username dictionary;
+     *     username offsets (32 bits, one more than the users) and the usernames, sorted
+     *
+     * All integers are little-endian.
+     */
+
+    template <class T>
+    struct Range
+    {
+        T min = std::numeric_limits<T>::min();
+        T max = std::numeric_limits<T>::max();
+    };
+
+    // Speed categories by estimated duration, base + 40 * increment seconds, as on Lichess
+    enum class Speed
+    {
+        UltraBullet,
+        Bullet,
+        Blitz,
+        Rapid,
+        Classical,
+    };
+    Range<uint32_t> estimatedSeconds(Speed speed);
+
+    // ECO codes A00-E99 as 1-500, and 0 for anything else
+    uint16_t ecoIndex(std::string_view eco);
+
+    // Result codes, as stored in the result column
+    constexpr uint8_t resultCode(GameResult result)
+    {
+        return static_cast<uint8_t>(static_cast<uint8_t>(result.type) | static_cast<uint8_t>(result.reason) << 2);
+    }
+
+    /* Conditions that a game must meet all of. Unset fields match every game.
+     */
+    struct MetadataFilter
+    {
+        std::optional<Range<uint16_t>> whiteELO;
+        std::optional<Range<uint16_t>> blackELO;
+        // Both players' ELO
+        std::optional<Range<uint16_t>> ELO;
+        std::optional<Range<uint16_t>> baseSeconds;
+        std::optional<Range<uint16_t>> incrementSeconds;
+        // base + 40 * increment; see `Speed`
+        std::optional<Range<uint32_t>> estimatedSeconds;
+        // As `ecoIndex`
+        std::optional<Range<uint16_t>> ECO;
+        std::optional<Range<std::chrono::sys_seconds>> datetime;
+        // The set of accepted `resultCode`s, one bit each; see `acceptResults`
+        std::optional<uint32_t> results;
+        std::optional<std::string> white;
+        std::optional<std::string> black;
+        // Either player
+        std::optional<std::string> player;
+
+        // Accept results of the given type and reason; either may be left open
+        MetadataFilter &acceptResults(std::optional<GameResult::Type> type, std::optional<GameResult::Reason> reason);
+    };
+
+    /* Builds the sidecar in memory, game by game, and writes it with `finish`.
+     */
+    class GameMetadataWriter
+    {
+    public:
+        explicit GameMetadataWriter(std::filesystem::path path);
+
+        void add(const Game &game);
+        void finish();
+
+        size_t size() const { return m_result.size(); }
+
+    private:
+        uint32_t userID(const std::string &username);
+
+    private:
+        std::filesystem::path m_path;
+        std::vector<uint16_t> m_whiteELO, m_blackELO, m_baseSeconds, m_incrementSeconds, m_ECO;
+        std::vector<uint32_t> m_datetime;
+        std::vector<uint8_t> m_result;
+        std::vector<uint32_t> m_white, m_black;
+        std::unordered_map<std::string, uint32_t> m_userIDs;
+        std::vector<const std::string *> m_usernames; // by ID, pointing into `m_userIDs`
+    };
+
+    /* A mapped sidecar. `select` scans only the columns the filter uses, 64 games at a time,
+     * with AVX2 where the CPU has it.
+     *
+     * Throws `std::runtime_error` if the file is not a valid sidecar.
+     */
+    class GameMetadata
+    {
+    public:
+        explicit GameMetadata(const std::filesystem::path &path);
+
+        size_t size() const { return m_size; }
+
+        // The indices of the matching games, in order
+        std::vector<uint64_t> select(const MetadataFilter &filter) const;
+        size_t count(const MetadataFilter &filter) const;
+
+        uint16_t whiteELO(size_t i) const { return m_whiteELO[i]; }
+        uint16_t blackELO(size_t i) const { return m_blackELO[i]; }
+        std::chrono::sys_seconds datetime(size_t i) const { return std::chrono::sys_seconds{std::chrono::seconds{m_datetime[i]}}; }
+        std::string_view white(size_t i) const { return username(m_white[i]); }
+        std::string_view black(size_t i) const { return username(m_black[i]); }
+
+        // The dictionary index of a username, if any game has it
+        std::optional<uint32_t> userID(std::string_view username) const;
+
+    private:
+        std::string_view username(uint32_t id) const;
+
+        // Calls `visit(first, mask)` for each block of 64 games, from game `first`, with any match
+        template <class Visit>
+        void scan(const MetadataFilter &filter, Visit visit) const;
+
+    private:
+        MappedFile m_file;
+        size_t m_size = 0;
+        size_t m_userCount = 0;
+        const uint16_t *m_whiteELO = nullptr;
+        const uint16_t *m_blackELO = nullptr;
+        const uint16_t *m_baseSeconds = nullptr;
+        const uint16_t *m_incrementSeconds = nullptr;
+        const uint16_t *m_ECO = nullptr;
+        const uint32_t *m_datetime = nullptr;
+        const uint8_t *m_result = nullptr;
+        const uint32_t *m_white = nullptr;
+        const uint32_t *m_black = nullptr;
+        const uint32_t *m_usernameOffsets = nullptr;
+        const char *m_usernames = nullptr;
+    };
+} // namespace JChess
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+
+namespace JChess
+{
+    /* A whole file mapped read-only into memory, for parsers that work on the text in place.
+     * Throws `std::runtime_error` if the file cannot be opened or mapped.
+     */
+    class MappedFile
+    {
+    public:
+        // How the mapping will be read, passed on to the kernel's readahead
+        enum class Access
+        {
+            Sequential,
+            Random,
+        };
+
+        explicit MappedFile(const std::filesystem::path &path, Access access = Access::Sequential);
+        ~MappedFile();
+
+        MappedFile(MappedFile &&other) noexcept;
+        MappedFile &operator=(MappedFile &&other) noexcept;
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        const char *data() const { return m_data; }
+        size_t size() const { return m_size; }
+        std::string_view text() const { return {m_data, m_size}; }
+
+    private:
+        void unmap();
+
+    private:
+        const char *m_data = nullptr;
+        size_t m_size = 0;
+    };
+} // namespace JChess
@@ -0,0 +1,531 @@
+#include "formats/openingExplorer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unistd.h>
+
+#include "core/state.h"
+
+namespace JChess
+{
+    namespace
+    {
+        static_assert(std::endian::native == std::endian::little, "explorer indexes are read in place as little-endian");
+
+        constexpr std::string_view magic = "JCEXPL01";
+        constexpr size_t alignment = 64;
+
+        enum Section : size_t
+        {
+            Keys,
+            FirstRecords,
+            Records,
+            SectionCount,
+        };
+
+        struct SectionEntry
+        {
+            uint64_t offset;
+            uint64_t size;
+        };
+        using Directory = std::array<SectionEntry, SectionCount>;
+
+        constexpr size_t headerSize = magic.size() + 16 + sizeof(Directory);
+
+        [[noreturn]] void invalid(const std::string &what)
+        {
+            throw std::runtime_error("Invalid opening explorer index: " + what);
+        }
+
+        constexpr size_t minEntries = 64;
+        // An entry, and its slots when the table is between 3/8 and 3/4 full
+        constexpr size_t bytesPerEntry = 40 + 3 * sizeof(uint32_t);
+        constexpr size_t runBufferBytes = size_t{1} << 20;
+
+        // Slots for `count` entries, at most 3/4 full
+        constexpr size_t capacityFor(size_t count)
+        {
+            return std::bit_ceil(std::max<size_t>(16, count + count / 3 + 1));
+        }
+
+        // The position hash alone would put all the records of a position in a row
+        uint64_t slotHash(uint64_t hash, uint16_t move, uint8_t speed, uint8_t ELOBand)
+        {
+            uint64_t mixed = (hash ^ (uint64_t{move} << 16 | uint64_t{speed} << 8 | ELOBand)) * 0x9E3779B97F4A7C15ull;
+            return mixed ^ mixed >> 32;
+        }
+
+        // Entries in the order of the index: by position, then move, speed and band
+        constexpr auto entryLess = [](const auto &a, const auto &b)
+        {
+            return std::tuple{a.hash, a.record.move, a.record.speed, a.record.ELOBand} <
+                   std::tuple{b.hash, b.record.move, b.record.speed, b.record.ELOBand};
+        };
+
+        constexpr auto sameKey = [](const auto &a, const auto &b)
+        {
+            return !entryLess(a, b) && !entryLess(b, a);
+        };
+
+        void combine(ExplorerRecord &record, const ExplorerRecord &counts)
+        {
+            record.whiteWins += counts.whiteWins;
+            record.draws += counts.draws;
+            record.blackWins += counts.blackWins;
+            record.ratedGames += counts.ratedGames;
+            record.ELOSum += counts.ELOSum;
+            record.lastPlayed = std::max(record.lastPlayed, counts.lastPlayed);
+        }
+
+        // A file of this process's own in the directory
+        std::filesystem::path scratchPath(const std::filesystem::path &directory, std::string_view suffix)
+        {
+            static std::atomic<uint64_t> files{0};
+            return directory / ("jchess-explorer-" + std::to_string(getpid()) + "-" + std::to_string(files++) + std::string{suffix});
+        }
+
+        void removeAll(const std::vector<std::filesystem::path> &paths)
+        {
+            std::error_code ignored;
+            for (const auto &path : paths)
+                std::filesystem::remove(path, ignored);
+        }
+
+        // Pads the output to the next section and returns its offset
+        uint64_t align(std::ofstream &output)
+        {
+            static constexpr char zeros[alignment]{};
+            auto offset = static_cast<uint64_t>(output.tellp());
+            if (offset % alignment)
+            {
+                output.write(zeros, static_cast<std::streamsize>(alignment - offset % alignment));
+                offset += alignment - offset % alignment;
+            }
+            return offset;
+        }
+
+        void appendSection(std::ofstream &output, Directory &directory, Section section, const std::filesystem::path &path)
+        {
+            auto offset = align(output);
+            std::ifstream input{path, std::ios::binary};
+            if (!input)
+                throw std::runtime_error("Unable to read opening explorer section: " + path.string());
+            if (std::filesystem::file_size(path))
+                output << input.rdbuf();
+            directory[section] = {offset, static_cast<uint64_t>(output.tellp()) - offset};
+        }
+
+        uint8_t speedOf(const TimeControl &timeControl)
+        {
+            if (timeControl.initial.count() == 0 && timeControl.increment.count() == 0)
+                return unknownBucket;
+            uint64_t seconds = timeControl.initial.count() / 1000 + 40 * (timeControl.increment.count() / 1000);
+            uint8_t speed = 0;
+            while (speed < static_cast<uint8_t>(Speed::Classical) && seconds > estimatedSeconds(static_cast<Speed>(speed)).max)
+                ++speed;
+            return speed;
+        }
+
+        // The average of the players' ELOs that are known, or 0
+        uint16_t averageELO(const Game &game)
+        {
+            if (game.whiteELO && game.blackELO)
+                return static_cast<uint16_t>((game.whiteELO + game.blackELO) / 2);
+            return game.whiteELO ? game.whiteELO : game.blackELO;
+        }
+
+        uint8_t bandOf(uint16_t ELO)
+        {
+            if (!ELO)
+                return unknownBucket;
+            auto above = std::upper_bound(explorerELOBands.begin(), explorerELOBands.end(), ELO);
+            return static_cast<uint8_t>(above - explorerELOBands.begin() - 1);
+        }
+
+        // The bands a filter accepts, one bit each
+        uint32_t acceptedBands(const ExplorerFilter &filter)
+        {
+            if (!filter.ELO)
+                return ~uint32_t{0};
+            uint32_t bands = 0;
+            for (size_t i = 0; i < explorerELOBands.size(); ++i)
+            {
+                uint32_t top = i + 1 < explorerELOBands.size() ? explorerELOBands[i + 1] - 1u : UINT16_MAX;
+                if (explorerELOBands[i] <= filter.ELO->max && top >= filter.ELO->min)
+                    bands |= 1u << i;
+            }
+            return bands;
+        }
+    } // namespace
+
+    /* Reads a sorted run, from a file through a buffer, or from memory.
+     */
+    class OpeningExplorerBuilder::RunReader
+    {
+    public:
+        explicit RunReader(std::span<const Entry> entries) : m_entries(entries) {}
+        explicit RunReader(const std::filesystem::path &path)
+            : m_file(path, std::ios::binary)
+        {
+            if (!m_file)
+                throw std::runtime_error("Unable to read opening explorer run: " + path.string());
+            refill();
+        }
+
+        bool done() const { return m_next == m_entries.size(); }
+        const Entry &front() const { return m_entries[m_next]; }
+        void pop()
+        {
+            if (++m_next == m_entries.size() && m_file.is_open())
+                refill();
+        }
+
+    private:
+        void refill()
+        {
+            m_buffer.resize(runBufferBytes / sizeof(Entry));
+            m_file.read(reinterpret_cast<char *>(m_buffer.data()), static_cast<std::streamsize>(m_buffer.size() * sizeof(Entry)));
+            auto bytes = static_cast<size_t>(m_file.gcount());
+            if (bytes % sizeof(Entry))
+                throw std::runtime_error("Truncated opening explorer run.");
+            m_buffer.resize(bytes / sizeof(Entry));
+            m_entries = m_buffer;
+            m_next = 0;
+            if (m_buffer.empty())
+                m_file.close();
+        }
+
+    private:
+        std::ifstream m_file;
+        std::vector<Entry> m_buffer;
+        std::span<const Entry> m_entries;
+        size_t m_next = 0;
+    };
+
+    OpeningExplorerBuilder::OpeningExplorerBuilder(ExplorerBuildOptions options)
+        : m_options(std::move(options)),
+          m_limit(std::clamp<size_t>(m_options.memoryBytes / bytesPerEntry, minEntries, UINT32_MAX - 1))
+    {
+        static_assert(sizeof(Entry) + 3 * sizeof(uint32_t) == bytesPerEntry);
+        if (m_options.spillDirectory.empty())
+            m_options.spillDirectory = std::filesystem::temp_directory_path();
+    }
+
+    OpeningExplorerBuilder::~OpeningExplorerBuilder()
+    {
+        removeAll(m_runs);
+    }
+
+    size_t OpeningExplorerBuilder::memoryUsage() const
+    {
+        return m_slots.capacity() * sizeof(uint32_t) + m_entries.capacity() * sizeof(Entry);
+    }
+
+    size_t OpeningExplorerBuilder::probe(uint64_t hash, uint16_t move, uint8_t speed, uint8_t ELOBand) const
+    {
+        const size_t mask = m_slots.size() - 1;
+        for (size_t i = slotHash(hash, move, speed, ELOBand) & mask;; i = (i + 1) & mask)
+        {
+            uint32_t slot = m_slots[i];
+            if (!slot)
+                return i;
+            const auto &entry = m_entries[slot - 1];
+            if (entry.hash == hash && entry.record.move == move && entry.record.speed == speed && entry.record.ELOBand == ELOBand)
+                return i;
+        }
+    }
+
+    ExplorerRecord &OpeningExplorerBuilder::record(uint64_t hash, uint16_t move, uint8_t speed, uint8_t ELOBand)
+    {
+        if (!m_slots.empty())
+        {
+            uint32_t slot = m_slots[probe(hash, move, speed, ELOBand)];
+            if (slot)
+                return m_entries[slot - 1].record;
+        }
+
+        if (m_entries.size() == m_limit)
+            spill();
+        if (m_entries.size() == m_entries.capacity())
+            m_entries.reserve(std::min(m_limit, std::max<size_t>(minEntries, 2 * m_entries.capacity())));
+        if (m_slots.size() < capacityFor(m_entries.size() + 1))
+            rehash(capacityFor(m_entries.size() + 1));
+
+        m_entries.push_back({hash, ExplorerRecord{.move = move, .speed = speed, .ELOBand = ELOBand}});
+        m_slots[probe(hash, move, speed, ELOBand)] = static_cast<uint32_t>(m_entries.size());
+        return m_entries.back().record;
+    }
+
+    void OpeningExplorerBuilder::rehash(size_t capacity)
+    {
+        // Entries do not move, so only the slots are rebuilt
+        m_slots.assign(capacity, 0);
+        const size_t mask = capacity - 1;
+        for (size_t entry = 0; entry < m_entries.size(); ++entry)
+        {
+            const auto &[hash, record] = m_entries[entry];
+            size_t i = slotHash(hash, record.move, record.speed, record.ELOBand) & mask;
+            while (m_slots[i])
+                i = (i + 1) & mask;
+            m_slots[i] = static_cast<uint32_t>(entry + 1);
+        }
+    }
+
+    void OpeningExplorerBuilder::spill()
+    {
+        std::sort(m_entries.begin(), m_entries.end(), entryLess);
+        m_runs.push_back(scratchPath(m_options.spillDirectory, ".run"));
+        std::ofstream output{m_runs.back(), std::ios::binary | std::ios::trunc};
+        output.write(reinterpret_cast<const char *>(m_entries.data()), static_cast<std::streamsize>(m_entries.size() * sizeof(Entry)));
+        output.close();
+        if (!output)
+            throw std::runtime_error("Unable to write opening explorer run: " + m_runs.back().string());
+
+        // The table keeps its memory for the next run
+        m_entries.clear();
+        std::fill(m_slots.begin(), m_slots.end(), 0);
+    }
+
+    void OpeningExplorerBuilder::clear()
+    {
+        removeAll(m_runs);
+        m_runs.clear();
+        m_entries = {};
+        m_slots = {};
+        m_games = 0;
+    }
+
+    void OpeningExplorerBuilder::add(const Game &game)
+    {
+        std::vector<uint64_t> hashes;
+        State state = game.startFEN.empty() ? State{} : State{game.startFEN};
+        for (size_t ply = 0; ply < game.moves.size() && ply < maxPlies(); ++ply)
+        {
+            hashes.push_back(PackedPosition{state}.hash());
+            state.applyMove(game.moves[ply]);
+        }
+        add(game, hashes);
+    }
+
+    void OpeningExplorerBuilder::add(const Game &game, std::span<const uint64_t> hashes)
+    {
+        if (game.result.type == GameResult::Type::None)
+            return;
+        size_t plies = std::min(maxPlies(), game.moves.size());
+        if (hashes.size() < plies)
+            throw std::runtime_error("Missing position hashes for the opening explorer.");
+
+        // The game as a record of its own, added to each of its moves'
+        const uint8_t speed = speedOf(game.timeControl);
+        const uint16_t ELO = averageELO(game);
+        const uint8_t band = bandOf(ELO);
+        ExplorerRecord counts{};
+        switch (game.result.type)
+        {
+        case GameResult::Type::WhiteWins:
+            counts.whiteWins = 1;
+            break;
+        case GameResult::Type::BlackWins:
+            counts.blackWins = 1;
+            break;
+        default:
+            counts.draws = 1;
+            break;
+        }
+        counts.ratedGames = ELO ? 1 : 0;
+        counts.ELOSum = ELO;
+        counts.lastPlayed = static_cast<uint32_t>(std::clamp<int64_t>(game.datetime.time_since_epoch().count(), 0, UINT32_MAX));
+
+        for (size_t ply = 0; ply < plies; ++ply)
+            combine(record(hashes[ply], PackedMove{game.moves[ply]}.raw(), speed, band), counts);
+        ++m_games;
+    }
+
+    void OpeningExplorerBuilder::write(const std::filesystem::path &path)
+    {
+        std::sort(m_entries.begin(), m_entries.end(), entryLess);
+        std::vector<RunReader> readers;
+        readers.reserve(m_runs.size() + 1);
+        for (const auto &run : m_runs)
+            readers.emplace_back(run);
+        readers.emplace_back(std::span<const Entry>{m_entries});
+
+        // The records go straight to the index, the keys and first records to files of their
+        // own until the records are all written
+        std::vector<std::filesystem::path> scratch{scratchPath(m_options.spillDirectory, ".keys"),
+                                                   scratchPath(m_options.spillDirectory, ".firsts")};
+        try
+        {
+            std::ofstream output{path, std::ios::binary | std::ios::trunc};
+            if (!output)
+                throw std::runtime_error("Unable to create opening explorer index: " + path.string());
+            output.write(magic.data(), static_cast<std::streamsize>(magic.size()));
+            uint64_t counts[2]{};
+            output.write(reinterpret_cast<const char *>(counts), sizeof(counts));
+            Directory directory{};
+            output.write(reinterpret_cast<const char *>(directory.data()), sizeof(directory));
+
+            std::ofstream keys{scratch[0], std::ios::binary | std::ios::trunc};
+            std::ofstream firstRecords{scratch[1], std::ios::binary | std::ios::trunc};
+            auto &[positionCount, recordCount] = counts;
+            auto recordsOffset = align(output);
+            uint64_t lastHash = 0;
+            auto emit = [&](const Entry &entry)
+            {
+                if (!positionCount || entry.hash != lastHash)
+                {
+                    keys.write(reinterpret_cast<const char *>(&entry.hash), sizeof(entry.hash));
+                    firstRecords.write(reinterpret_cast<const char *>(&recordCount), sizeof(recordCount));
+                    lastHash = entry.hash;
+                    ++positionCount;
+                }
+                output.write(reinterpret_cast<const char *>(&entry.record), sizeof(entry.record));
+                ++recordCount;
+            };
+
+            // A merge of the sorted runs, summing the records of a key found in several
+            auto later = [&](size_t a, size_t b) { return entryLess(readers[b].front(), readers[a].front()); };
+            std::priority_queue<size_t, std::vector<size_t>, decltype(later)> heads{later};
+            for (size_t i = 0; i < readers.size(); ++i)
+                if (!readers[i].done())
+                    heads.push(i);
+            std::optional<Entry> pending;
+            while (!heads.empty())
+            {
+                size_t i = heads.top();
+                heads.pop();
+                const auto &entry = readers[i].front();
+                if (pending && sameKey(*pending, entry))
+                    combine(pending->record, entry.record);
+                else
+                {
+                    if (pending)
+                        emit(*pending);
+                    pending = entry;
+                }
+                readers[i].pop();
+                if (!readers[i].done())
+                    heads.push(i);
+            }
+            if (pending)
+                emit(*pending);
+            firstRecords.write(reinterpret_cast<const char *>(&recordCount), sizeof(recordCount));
+            directory[Records] = {recordsOffset, recordCount * sizeof(ExplorerRecord)};
+
+            keys.close();
+            firstRecords.close();
+            if (!keys || !firstRecords)
+                throw std::runtime_error("Unable to write opening explorer index: " + path.string());
+            appendSection(output, directory, Keys, scratch[0]);
+            appendSection(output, directory, FirstRecords, scratch[1]);
+
+            output.seekp(static_cast<std::streamoff>(magic.size()));
+            output.write(reinterpret_cast<const char *>(counts), sizeof(counts));
+            output.write(reinterpret_cast<const char *>(directory.data()), sizeof(directory));
+            output.close();
+            if (!output)
+                throw std::runtime_error("Unable to write opening explorer index: " + path.string());
+        }
+        catch (...)
+        {
+            removeAll(scratch);
+            throw;
+        }
+        removeAll(scratch);
+        readers.clear();
+        clear();
+    }
+
+    ExplorerFilter &ExplorerFilter::acceptSpeed(Speed speed)
+    {
+        speeds = speeds.value_or(0) | 1u << static_cast<uint32_t>(speed);
+        return *this;
+    }
+
+    OpeningExplorer::OpeningExplorer(const std::filesystem::path &path)
+        : m_file(path, MappedFile::Access::Random)
+    {
+        if (m_file.size() < headerSize || m_file.text().substr(0, magic.size()) != magic)
+            invalid("not an index: " + path.string());
+
+        uint64_t counts[2];
+        std::memcpy(counts, m_file.data() + magic.size(), sizeof(counts));
+        m_size = counts[0];
+        m_recordCount = counts[1];
+        Directory directory;
+        std::memcpy(directory.data(), m_file.data() + magic.size() + sizeof(counts), sizeof(directory));
+
+        auto section = [&]<class T>(Section s, size_t count, const T *&values)
+        {
+            auto [offset, size] = directory[s];
+            if (offset % alignof(T) || offset > m_file.size() || size > m_file.size() - offset || size / sizeof(T) != count || size % sizeof(T))
+                invalid("section " + std::to_string(s));
+            values = reinterpret_cast<const T *>(m_file.data() + offset);
+        };
+        section(Keys, m_size, m_keys);
+        section(FirstRecords, m_size + 1, m_firstRecords);
+        section(Records, m_recordCount, m_records);
+        if (m_firstRecords[m_size] != m_recordCount)
+            invalid("record count");
+    }
+
+    std::span<const ExplorerRecord> OpeningExplorer::records(uint64_t hash) const
+    {
+        const uint64_t *key = std::lower_bound(m_keys, m_keys + m_size, hash);
+        if (key == m_keys + m_size || *key != hash)
+            return {};
+        size_t i = static_cast<size_t>(key - m_keys);
+        uint64_t first = m_firstRecords[i], last = m_firstRecords[i + 1];
+        if (first > last || last > m_recordCount)
+            invalid("records of position " + std::to_string(i));
+        return {m_records + first, m_records + last};
+    }
+
+    std::vector<ExplorerMove> OpeningExplorer::moves(const PackedPosition &position, const ExplorerFilter &filter) const
+    {
+        return moves(position.hash(), filter);
+    }
+
+    std::vector<ExplorerMove> OpeningExplorer::moves(uint64_t hash, const ExplorerFilter &filter) const
+    {
+        const uint32_t bands = acceptedBands(filter);
+        std::vector<ExplorerMove> moves;
+        // Per move, the rated games and their ELO sum, for the average
+        std::vector<std::pair<uint64_t, uint64_t>> ratings;
+        // A move's records are adjacent, by speed and then band
+        for (const auto &record : records(hash))
+        {
+            if (filter.ELO && (record.ELOBand == unknownBucket || !((bands >> record.ELOBand) & 1)))
+                continue;
+            if (filter.speeds && (record.speed == unknownBucket || !((*filter.speeds >> record.speed) & 1)))
+                continue;
+            if (moves.empty() || moves.back().move.raw() != record.move)
+            {
+                moves.push_back({.move = PackedMove::fromRaw(record.move)});
+                ratings.emplace_back(0, 0);
+            }
+            auto &move = moves.back();
+            move.whiteWins += record.whiteWins;
+            move.draws += record.draws;
+            move.blackWins += record.blackWins;
+            move.lastPlayed = std::max(move.lastPlayed, std::chrono::sys_seconds{std::chrono::seconds{record.lastPlayed}});
+            ratings.back().first += record.ratedGames;
+            ratings.back().second += record.ELOSum;
+        }
+        for (size_t i = 0; i < moves.size(); ++i)
+            if (ratings[i].first)
+                moves[i].averageELO = static_cast<uint16_t>(ratings[i].second / ratings[i].first);
+
+        std::stable_sort(moves.begin(), moves.end(), [](const auto &a, const auto &b)
+                         { return a.games() > b.games(); });
+        return moves;
+    }
+} // namespace JChess
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "core/game.h"
+#include "core/packedMove.h"
+#include "core/packedPosition.h"
+#include "formats/gameMetadata.h"
+#include "formats/mappedFile.h"
+
+namespace JChess
+{
+    /* An opening explorer index: for each position of the opening, the moves played from it
+     * with their results, average ELO and last date, counted per speed and ELO band so that
+     * lookups can filter on either.
+     *
+     *   "JCEXPL01", position count, record count (64 bits each)
+     *   directory: offset and size of each section (64 bits each)
+     *   sections, each aligned to 64 bytes:
+     *     records (`ExplorerRecord`), by position, then move, speed and band;
+     *     keys: `PackedPosition::hash` of each position, sorted (64 bits each);
+     *     first record of each position, and one past the last (64 bits each, one more
+     *     than the positions)
+     *
+     * All integers are little-endian. Positions are told apart by their 64-bit hash alone.
+     */
+
+    // Bands of the players' average ELO, by lower bound
+    inline constexpr std::array<uint16_t, 8> explorerELOBands{0, 1200, 1400, 1600, 1800, 2000, 2200, 2500};
+
+    // The speed or band of games without a time control or any ELO
+    inline constexpr uint8_t unknownBucket = 0xFF;
+
+    struct ExplorerRecord
+    {
+        uint16_t move;  // `PackedMove::raw`
+        uint8_t speed;  // `Speed`, or `unknownBucket`
+        uint8_t ELOBand; // index into `explorerELOBands`, or `unknownBucket`
+        uint32_t whiteWins;
+        uint32_t draws;
+        uint32_t blackWins;
+        // Games with an ELO, and the sum of their players' average
+        uint32_t ratedGames;
+        uint32_t lastPlayed; // UTC seconds since the epoch
+        uint64_t ELOSum;
+    };
+    static_assert(sizeof(ExplorerRecord) == 32);
+
+    struct ExplorerBuildOptions
+    {
+        // Moves counted from the start of each game
+        size_t maxPlies = 40;
+        // Memory for the records being counted, at about 50 bytes each. Once it is full, they
+        // are sorted and spilled to a run file, and `write` merges the runs.
+        size_t memoryBytes = size_t{1} << 30;
+        // Where the runs go; the system's temporary directory if empty
+        std::filesystem::path spillDirectory;
+    };
+
+    /* Counts games into one record per position, move and bucket, and writes the index with
+     * `write`. Only the first `maxPlies` moves of each game, and only games with a result,
+     * are counted.
+     *
+     * The records are kept in an open-addressing table within `memoryBytes`. When it fills,
+     * they are sorted and spilled to a run file, and counting starts afresh; `write` merges
+     * the runs and what is left in memory in one streaming pass. So a builder can count any
+     * number of games, at the cost of disk for the runs: about 40 bytes per record, before
+     * records of the same position and move in different runs are merged.
+     *
+     * Not thread-safe: share one behind a mutex, as `Database::IngestPipeline` does.
+     */
+    class OpeningExplorerBuilder
+    {
+    public:
+        explicit OpeningExplorerBuilder(ExplorerBuildOptions options = {});
+        // Removes any runs left
+        ~OpeningExplorerBuilder();
+
+        OpeningExplorerBuilder(const OpeningExplorerBuilder &) = delete;
+        OpeningExplorerBuilder &operator=(const OpeningExplorerBuilder &) = delete;
+
+        // Replays the game to find its positions
+        void add(const Game &game);
+        // For a game already replayed: `hashes` has the `PackedPosition::hash` of the position
+        // before each of its first `maxPlies` moves
+        void add(const Game &game, std::span<const uint64_t> hashes);
+
+        size_t maxPlies() const { return m_options.maxPlies; }
+        // Games counted so far
+        size_t games() const { return m_games; }
+        // Run files spilled so far
+        size_t runs() const { return m_runs.size(); }
+        size_t memoryUsage() const;
+
+        // Writes the index of the games counted so far, and leaves the builder empty
+        void write(const std::filesystem::path &path);
+
+    private:
+        struct Entry
+        {
+            uint64_t hash;
+            ExplorerRecord record;
+        };
+        class RunReader;
+
+        // The slot holding the entry for the key, or the empty one where it would go
+        size_t probe(uint64_t hash, uint16_t move, uint8_t speed, uint8_t ELOBand) const;
+        ExplorerRecord &record(uint64_t hash, uint16_t move, uint8_t speed, uint8_t ELOBand);
+        void rehash(size_t capacity);
+        void spill();
+        void clear();
+
+    private:
+        ExplorerBuildOptions m_options;
+        // Entries that fit in `memoryBytes`, with their slots
+        size_t m_limit;
+        size_t m_games = 0;
+        // Indices into `m_entries`, plus one; 0 for an empty slot
+        std::vector<uint32_t> m_slots;
+        std::vector<Entry> m_entries;
+        std::vector<std::filesystem::path> m_runs;
+    };
+
+    /* Conditions on the games counted. Unset fields match every game, including those with no
+     * ELO or time control; set ones exclude them.
+     */
+    struct ExplorerFilter
+    {
+        // The players' average ELO, to the band: a band counts if it overlaps the range
+        std::optional<Range<uint16_t>> ELO;
+        // The set of accepted `Speed`s, one bit each; see `acceptSpeed`
+        std::optional<uint32_t> speeds;
+
+        ExplorerFilter &acceptSpeed(Speed speed);
+    };
+
+    // A move from a position, totalled over the buckets that a filter accepts
+    struct ExplorerMove
+    {
+        PackedMove move;
+        uint32_t whiteWins = 0;
+        uint32_t draws = 0;
+        uint32_t blackWins = 0;
+        uint16_t averageELO = 0; // 0 if no game had an ELO
+        std::chrono::sys_seconds lastPlayed{};
+
+        uint32_t games() const { return whiteWins + draws + blackWins; }
+    };
+
+    /* A mapped index. A lookup is a binary search of the keys and a read of the position's
+     * records, a few cache misses with no decoding.
+     *
+     * Throws `std::runtime_error` if the file is not a valid index.
+     */
+    class OpeningExplorer
+    {
+    public:
+        explicit OpeningExplorer(const std::filesystem::path &path);
+
+        // Positions in the index
+        size_t size() const { return m_size; }
+
+        // The moves played from the position, most played first
+        std::vector<ExplorerMove> moves(const PackedPosition &position, const ExplorerFilter &filter = {}) const;
+        std::vector<ExplorerMove> moves(uint64_t hash, const ExplorerFilter &filter = {}) const;
+
+        // The position's records, unfiltered
+        std::span<const ExplorerRecord> records(uint64_t hash) const;
+
+    private:
+        MappedFile m_file;
+        size_t m_size = 0;
+        size_t m_recordCount = 0;
+        const uint64_t *m_keys = nullptr;
+        const uint64_t *m_firstRecords = nullptr;
+        const ExplorerRecord *m_records = nullptr;
+    };
+} // namespace JChess
@@ -0,0 +1,222 @@
+#include "formats/parallelPGNReader.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include "formats/pgnFile.h"
+
+namespace JChess
+{
+    ParallelPGNReader::ParallelPGNReader(MappedFile file, ParallelPGNOptions options)
+        : m_file(std::move(file)), m_text(m_file->text()), m_options(options)
+    {
+        start();
+    }
+
+    ParallelPGNReader::ParallelPGNReader(std::string_view text, ParallelPGNOptions options)
+        : m_text(text), m_options(options)
+    {
+        start();
+    }
+
+    ParallelPGNReader::~ParallelPGNReader()
+    {
+        {
+            std::lock_guard lock{m_mutex};
+            m_stop = true;
+        }
+        m_batchFree.notify_all();
+        for (auto &worker : m_workers)
+            worker.join();
+    }
+
+    void ParallelPGNReader::start()
+    {
+        unsigned threads = m_options.threads ? m_options.threads : std::max(std::thread::hardware_concurrency(), 1u);
+        m_options.chunkBytes = std::max<size_t>(m_options.chunkBytes, 1);
+        size_t batches = m_options.chunksInFlight ? m_options.chunksInFlight : 2 * size_t{threads};
+
+        // One more batch than in flight: the one the consumer is reading from
+        m_batches.resize(batches + 1);
+        for (size_t i = m_batches.size(); i-- > 0;)
+            m_free.push_back(i);
+        m_ready.reserve(m_batches.size());
+
+        m_workers.reserve(threads);
+        for (unsigned i = 0; i < threads; ++i)
+            m_workers.emplace_back(&ParallelPGNReader::work, this);
+    }
+
+    // Called with the lock held
+    std::string_view ParallelPGNReader::claimChunk()
+    {
+        size_t begin = m_offset;
+        size_t end = m_text.size();
+        if (m_text.size() - begin > m_options.chunkBytes)
+            end = nextGameBoundary(m_text, begin + m_options.chunkBytes);
+        m_offset = end;
+        return m_text.substr(begin, end - begin);
+    }
+
+    void ParallelPGNReader::work()
+    {
+        while (true)
+        {
+            size_t index = 0;
+            std::string_view chunk;
+            {
+                std::unique_lock lock{m_mutex};
+                m_batchFree.wait(lock, [this] { return m_stop || m_offset == m_text.size() || !m_free.empty(); });
+                if (m_stop || m_offset == m_text.size())
+                    break;
+
+                index = m_free.back();
+                m_free.pop_back();
+                m_batches[index].chunk = m_chunksClaimed++;
+                chunk = claimChunk();
+            }
+
+            parseChunk(chunk, m_batches[index]);
+
+            {
+                std::lock_guard lock{m_mutex};
+                m_ready.push_back(index);
+            }
+            m_batchReady.notify_one();
+        }
+        // Wake the consumer in case this was the last chunk
+        m_batchReady.notify_one();
+    }
+
+    void ParallelPGNReader::parseChunk(std::string_view chunk, Batch &batch) const
+    {
+        batch.tags.clear();
+        batch.moves.clear();
+        batch.games.clear();
+        batch.readCount = 0;
+        batch.skipped = 0;
+        batch.error = nullptr;
+
+        try
+        {
+            PGNReader reader{chunk};
+            while (const auto *game = reader.next())
+            {
+                if (m_options.readGames)
+                {
+                    if (batch.readCount == batch.read.size())
+                        batch.read.emplace_back();
+                    try
+                    {
+                        readPGN(*game, batch.read[batch.readCount]);
+                        ++batch.readCount;
+                    }
+                    catch (const std::exception &)
+                    {
+                        ++batch.skipped;
+                    }
+                    continue;
+                }
+                batch.tags.insert(batch.tags.end(), game->tags.begin(), game->tags.end());
+                batch.moves.insert(batch.moves.end(), game->moves.begin(), game->moves.end());
+                batch.games.push_back({.tagsEnd = batch.tags.size(),
+                                       .movesEnd = batch.moves.size(),
+                                       .result = game->result,
+                                       .text = game->text});
+            }
+        }
+        catch (...)
+        {
+            batch.error = std::current_exception();
+        }
+    }
+
+    const PGNGame *ParallelPGNReader::next()
+    {
+        while (true)
+        {
+            if (m_current)
+            {
+                const auto &batch = m_batches[*m_current];
+                if (m_currentGame < batch.games.size())
+                {
+                    const auto &entry = batch.games[m_currentGame];
+                    size_t tagsBegin = m_currentGame ? batch.games[m_currentGame - 1].tagsEnd : 0;
+                    size_t movesBegin = m_currentGame ? batch.games[m_currentGame - 1].movesEnd : 0;
+                    ++m_currentGame;
+
+                    m_game.tags.assign(batch.tags.begin() + static_cast<ptrdiff_t>(tagsBegin),
+                                       batch.tags.begin() + static_cast<ptrdiff_t>(entry.tagsEnd));
+                    m_game.moves.assign(batch.moves.begin() + static_cast<ptrdiff_t>(movesBegin),
+                                        batch.moves.begin() + static_cast<ptrdiff_t>(entry.movesEnd));
+                    m_game.result = entry.result;
+                    m_game.text = entry.text;
+                    ++m_gamesRead;
+                    return &m_game;
+                }
+                if (batch.error)
+                    std::rethrow_exception(batch.error);
+            }
+            if (!nextBatch())
+                return nullptr;
+        }
+    }
+
+    const Game *ParallelPGNReader::nextGame()
+    {
+        if (!m_options.readGames)
+            throw std::runtime_error("ParallelPGNReader::nextGame needs the readGames option");
+        while (true)
+        {
+            if (m_current)
+            {
+                auto &batch = m_batches[*m_current];
+                if (m_currentGame < batch.readCount)
+                {
+                    ++m_gamesRead;
+                    return &batch.read[m_currentGame++];
+                }
+                if (batch.error)
+                    std::rethrow_exception(batch.error);
+            }
+            if (!nextBatch())
+                return nullptr;
+        }
+    }
+
+    bool ParallelPGNReader::nextBatch()
+    {
+        std::unique_lock lock{m_mutex};
+        if (m_current)
+        {
+            m_free.push_back(*m_current);
+            m_current.reset();
+            m_batchFree.notify_one();
+        }
+
+        auto deliverable = [this]
+        {
+            if (m_options.ordered)
+                return std::find_if(m_ready.begin(), m_ready.end(), [this](size_t i)
+                                    { return m_batches[i].chunk == m_chunksDelivered; });
+            return m_ready.begin();
+        };
+        auto found = m_ready.end();
+        m_batchReady.wait(lock, [&]
+                          {
+                              found = deliverable();
+                              return found != m_ready.end() ||
+                                     (m_offset == m_text.size() && m_chunksDelivered == m_chunksClaimed);
+                          });
+        if (found == m_ready.end())
+            return false;
+
+        m_current = *found;
+        m_ready.erase(found);
+        ++m_chunksDelivered;
+        m_currentGame = 0;
+        m_gamesSkipped += m_batches[*m_current].skipped;
+        return true;
+    }
+} // namespace JChess
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "core/game.h"
+
+#include "formats/mappedFile.h"
+#include "formats/pgnReader.h"
+
+namespace JChess
+{
+    struct ParallelPGNOptions
+    {
+        // Parsing threads; 0 for one per hardware thread
+        unsigned threads = 0;
+        // Approximate size of the pieces the input is split into; each ends at a game boundary
+        size_t chunkBytes = 4 << 20;
+        // Chunks that may be parsed or waiting to be read at once, which bounds the memory used
+        // ahead of a slow consumer; 0 for twice the number of threads
+        size_t chunksInFlight = 0;
+        // Return games in file order; otherwise chunks are returned as soon as they are parsed
+        bool ordered = true;
+        // Also read each game with `readPGN` on the workers, resolving and replaying its moves,
+        // for `nextGame`; only the tokens are parsed otherwise, for `next`
+        bool readGames = false;
+    };
+
+    /* Parses a PGN file on a pool of threads. The file is mapped into memory, split into chunks
+     * at game boundaries (a blank line followed by `[Event `), and each chunk is parsed
+     * by a `PGNReader` on a worker thread. Games are read back on the calling thread, either in
+     * file order or, through the unordered path, chunk by chunk as they finish. Workers stop
+     * when `chunksInFlight` chunks are parsed and waiting, so a slow consumer holds back the
+     * parsing instead of piling up memory.
+     *
+     *     ParallelPGNReader reader{MappedFile{"games.pgn"}};
+     *     while (const auto *game = reader.next())
+     *         use(*game);
+     *
+     * With `readGames`, the workers also convert the games to `Game`s, which is most of the
+     * cost of an import, and `nextGame` returns those instead. Games that `readPGN` rejects
+     * are left out and counted in `gamesSkipped`.
+     *
+     * The views in the games point into the mapped file and stay valid as long as the reader.
+     * A parse error is thrown from `next` or `nextGame` once the games before it in its chunk
+     * are returned.
+     */
+    class ParallelPGNReader
+    {
+    public:
+        explicit ParallelPGNReader(MappedFile file, ParallelPGNOptions options = {});
+        // Parse text already in memory, which must outlive the reader
+        explicit ParallelPGNReader(std::string_view text, ParallelPGNOptions options = {});
+        ~ParallelPGNReader();
+
+        ParallelPGNReader(const ParallelPGNReader &) = delete;
+        ParallelPGNReader &operator=(const ParallelPGNReader &) = delete;
+
+        /* The next game, or nullptr at the end of the input. The game is valid until the
+         * next call.
+         */
+        const PGNGame *next();
+        // The same with `readGames`, for which it is the only way to read the games
+        const Game *nextGame();
+
+        // Number of games returned so far
+        size_t gamesRead() const { return m_gamesRead; }
+        // Games left out of `nextGame` because they could not be read, so far
+        size_t gamesSkipped() const { return m_gamesSkipped; }
+
+    private:
+        // The games parsed from one chunk, stored flat so that the buffers can be reused
+        struct Batch
+        {
+            struct Entry
+            {
+                size_t tagsEnd;
+                size_t movesEnd;
+                std::string_view result;
+                std::string_view text;
+            };
+
+            size_t chunk = 0;
+            std::vector<PGNTag> tags;
+            std::vector<PGNMoveToken> moves;
+            std::vector<Entry> games;
+            // With `readGames`, the games read in place of the tokens; the vector only grows,
+            // so that the games' buffers are reused
+            std::vector<Game> read;
+            size_t readCount = 0;
+            size_t skipped = 0;
+            std::exception_ptr error;
+        };
+
+        void start();
+        void work();
+        std::string_view claimChunk();
+        void parseChunk(std::string_view chunk, Batch &batch) const;
+        // Releases the current batch and waits for the next one; false at the end of the input
+        bool nextBatch();
+
+    private:
+        std::optional<MappedFile> m_file;
+        std::string_view m_text;
+        ParallelPGNOptions m_options;
+
+        std::mutex m_mutex;
+        std::condition_variable m_batchFree;
+        std::condition_variable m_batchReady;
+        std::vector<Batch> m_batches;
+        std::vector<size_t> m_free;  // indices into `m_batches`
+        std::vector<size_t> m_ready; // indices into `m_batches`
+        size_t m_offset = 0;         // where the next chunk starts
+        size_t m_chunksClaimed = 0;
+        size_t m_chunksDelivered = 0;
+        bool m_stop = false;
+        std::vector<std::thread> m_workers;
+
+        // Consumer side
+        std::optional<size_t> m_current;
+        size_t m_currentGame = 0;
+        PGNGame m_game;
+        size_t m_gamesRead = 0;
+        size_t m_gamesSkipped = 0;
+    };
+} // namespace JChess
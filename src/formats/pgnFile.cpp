@@ -1,415 +1,440 @@
-#include <bitset>
-#include <cmath>
-#include <cstring>
-#include <fstream>
-#include <iostream>
-#include <optional>
-#include <regex>
-#include <sstream>
-#include <string>
-#include <unordered_map>
-#include <variant>
-#include <vector>
+#include "formats/pgnFile.h"
 
-#include "internal/evaluation.h"
-#include "internal/game/game.h"
-#include "internal/time/clockTime.h"
+#include <array>
+#include <charconv>
+#include <concepts>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 
-#include "fileFormat/pgnFile.h"
+#include "core/legalMoves.h"
+#include "core/state.h"
+#include "formats/algebraic.h"
 
 namespace JChess
 {
-    void readPGNHeader(std::istream &input, Game &game)
+    namespace
     {
-        std::unordered_map<std::string, GameResult::Type> resultTypeMap{
-            {"1-0", GameResult::Type::WhiteWins},
-            {"0-1", GameResult::Type::BlackWins},
-            {"1/2-1/2", GameResult::Type::Draw},
-            {"*", GameResult::Type::None}};
-
-        std::unordered_map<std::string, GameResult::Reason> resultReasonMap{
-            {"Normal", GameResult::Reason::None},
-            {"Time forfeit", GameResult::Reason::Timeout},
-            {"Rules infraction", GameResult::Reason::RulesInfraction},
-            {"Abandoned", GameResult::Reason::Checkmate},
-            {"Unterminated", GameResult::Reason::Checkmate}};
-
-        std::string line, dateString, timeString;
-
-        while (std::getline(input, line) && !line.empty())
+        // Tag values keep their `\"` and `\\` escapes in `PGNGame`
+        void unescape(std::string_view value, std::string &out)
         {
-            // Remove the leading and trailing square brackets.
-            std::istringstream iss(line.substr(1, line.size() - 2));
-            std::string tag;
-            std::getline(iss, tag, ' ');
-            std::string value;
-            std::getline(iss, value, '"');
-            std::getline(iss, value, '"');
-
-            // Store the value in the appropriate field of the header.
-            // This is left as an exercise for the reader.
-            if (tag == "White")
-                game.whiteUsername = value;
-            else if (tag == "Black")
-                game.blackUsername = value;
-            else if (tag == "Result")
-                game.result.type = resultTypeMap[value];
-            else if (tag == "UTCDate")
-                dateString = value;
-            else if (tag == "UTCTime")
-                timeString = value;
-            else if (tag == "WhiteElo")
-                game.whiteELO = std::stoi(value);
-            else if (tag == "BlackElo")
-                game.blackELO = std::stoi(value);
-            else if (tag == "ECO")
-                game.ECOCode = value;
-            else if (tag == "TimeControl")
-                game.timeControl = TimeControl(value);
-            else if (tag == "Termination")
-                game.result.reason = resultReasonMap[value];
+            out.clear();
+            for (size_t i = 0; i < value.size(); ++i)
+            {
+                if (value[i] == '\\' && i + 1 < value.size())
+                    ++i;
+                out += value[i];
+            }
         }
 
-        game.datetime = Datetime(dateString, timeString);
-    }
-
-    void readPGNMoves(std::istream &input, Game &game)
-    {
-        std::string line;
-        std::getline(input, line);
-
-        std::regex move_regex(R"(\d+\.{1,3}\s+(\S+)\s+(?:\{\s*(?:\[%eval\s+(\S+)\])?\s*(?:\[%clk\s+(\S+)\])?\s*\})?)");
-        auto move_begin = std::sregex_iterator(line.begin(), line.end(), move_regex);
-        auto move_end = std::sregex_iterator();
-
-        std::unordered_map<std::string, PieceType> pieceTypeMap{
-            {"K", PieceType::King},
-            {"Q", PieceType::Queen},
-            {"R", PieceType::Rook},
-            {"B", PieceType::Bishop},
-            {"N", PieceType::Knight},
-            {"", PieceType::Pawn}};
-        std::unordered_map<std::string, Annotation> annotationMap{
-            {"", Annotation::None},
-            {"!", Annotation::Good},
-            {"!!", Annotation::Brilliant},
-            {"?", Annotation::Mistake},
-            {"??", Annotation::Blunder},
-            {"!?", Annotation::Interesting},
-            {"?!", Annotation::Dubious}};
-
-        Color currentColor = Color::White;
-        game.evaluations.emplace();
-        game.clocks.emplace();
-        for (auto i = move_begin; i != move_end; ++i)
+        // Reads an unsigned number at the front of `text`, consuming it and one separator after it
+        template <class Int>
+        bool readField(std::string_view &text, Int &value)
         {
-            game.moves.emplace_back();
-            auto &move = game.moves.back();
-
-            move.capturedPiece = Piece{Color::White, PieceType::None};
+            auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+            if (error != std::errc{})
+                return false;
+            text.remove_prefix(static_cast<size_t>(end - text.data()));
+            if (!text.empty())
+                text.remove_prefix(1);
+            return true;
+        }
 
-            std::smatch match = *i;
-            std::string move_string = match[1].str();
+        uint16_t parseELO(std::string_view value)
+        {
+            uint16_t elo = 0;
+            readField(value, elo); // "?" for unrated players
+            return elo;
+        }
 
-            auto evalString = match[2].str();
-            if (!evalString.empty())
-                game.evaluations.value().emplace_back(evalString);
+        // "2022.01.01" and "00:00:11"; unknown fields ("????.??.??") leave the epoch
+        std::chrono::sys_seconds parseDatetime(std::string_view date, std::string_view time)
+        {
+            int year = 0;
+            unsigned month = 0, day = 0;
+            if (!readField(date, year) || !readField(date, month) || !readField(date, day))
+                return {};
+            std::chrono::year_month_day ymd{std::chrono::year{year}, std::chrono::month{month}, std::chrono::day{day}};
+            if (!ymd.ok())
+                return {};
+
+            std::chrono::sys_seconds datetime{std::chrono::sys_days{ymd}};
+            unsigned hours = 0, minutes = 0, seconds = 0;
+            if (readField(time, hours) && readField(time, minutes) && readField(time, seconds))
+                datetime += std::chrono::hours{hours} + std::chrono::minutes{minutes} + std::chrono::seconds{seconds};
+            return datetime;
+        }
 
-            auto clockString = match[3].str();
-            if (!clockString.empty())
-                game.clocks.value().emplace_back(clockString);
+        // "120+1" (seconds); "-" for correspondence games
+        TimeControl parseTimeControl(std::string_view value)
+        {
+            uint32_t initial = 0, increment = 0;
+            if (!readField(value, initial))
+                return {};
+            readField(value, increment);
+            return TimeControl{.initial = msDuration{initial * 1000}, .increment = msDuration{increment * 1000}};
+        }
 
-            move.piece.color = currentColor;
-            currentColor = oppositeColor(currentColor);
+        GameResult::Type parseResult(std::string_view value)
+        {
+            if (value == "1-0")
+                return GameResult::Type::WhiteWins;
+            if (value == "0-1")
+                return GameResult::Type::BlackWins;
+            if (value == "1/2-1/2")
+                return GameResult::Type::Draw;
+            return GameResult::Type::None;
+        }
 
-            auto idx = move_string.find_first_of("!?");
-            std::string annotation_string = (idx == std::string::npos) ? "" : move_string.substr(idx);
-            move.moveString = move_string.substr(0, idx);
+        GameResult::Reason parseTermination(std::string_view value)
+        {
+            if (value == "Time forfeit")
+                return GameResult::Reason::Timeout;
+            if (value == "Rules infraction")
+                return GameResult::Reason::RulesInfraction;
+            return GameResult::Reason::None;
+        }
 
-            move.check = (move.moveString.back() == '#') || (move.moveString.back() == '+');
+        constexpr std::array<std::string_view, 4> resultTokens{"1-0", "0-1", "1/2-1/2", "*"};
 
-            std::regex move_string_regex(R"(([KQRBN])?([a-h]?[1-8]?)(x)?([a-h][1-8])(?:=([QRBN]))?([+#])?)");
-            std::regex castle_regex(R"(O-O(-O)?([+#])?)");
-            std::regex annotation_regex(R"(([!?]{1,2})?)");
+        template <class Int>
+        void appendNumber(std::string &out, Int value, int width = 0)
+        {
+            char digits[24];
+            auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+            for (auto length = end - digits; length < width; ++length)
+                out += '0';
+            out.append(digits, end);
+        }
 
-            if (std::regex_match(move.moveString, match, move_string_regex))
+        void appendTag(std::string &out, std::string_view name, std::string_view value)
+        {
+            out += '[';
+            out += name;
+            out += " \"";
+            for (char c : value)
             {
-                move.piece.type = pieceTypeMap[match[1].str()];
-                if (match[2].str().size() == 2)
-                    move.from = Square(match[2].str());
+                if (c == '"' || c == '\\')
+                    out += '\\';
+                out += c;
+            }
+            out += "\"]\n";
+        }
 
-                if (match[3].matched)
-                    move.capturedPiece = Piece{Color::White, PieceType::Any};
+        // With a value written by `value(out)`, which needs no escaping
+        template <std::invocable<std::string &> Writer>
+        void appendTag(std::string &out, std::string_view name, Writer &&value)
+        {
+            out += '[';
+            out += name;
+            out += " \"";
+            value(out);
+            out += "\"]\n";
+        }
 
-                move.to = Square(match[4].str());
+        // "0.25" or "#-3"
+        void appendEval(std::string &out, Evaluation eval)
+        {
+            if (!eval.centipawns)
+            {
+                out += '#';
+                appendNumber(out, eval.value);
+                return;
             }
-            else if (std::regex_match(move.moveString, match, castle_regex))
+            if (eval.value < 0)
+                out += '-';
+            auto magnitude = static_cast<uint32_t>(eval.value < 0 ? -int64_t{eval.value} : eval.value);
+            appendNumber(out, magnitude / 100);
+            out += '.';
+            appendNumber(out, magnitude % 100, 2);
+        }
+
+        // "h:mm:ss", with up to three decimals when there are fractions of a second
+        void appendClock(std::string &out, msDuration clock)
+        {
+            uint32_t ms = clock.count();
+            uint32_t seconds = ms / 1000;
+            appendNumber(out, seconds / 3600);
+            out += ':';
+            appendNumber(out, seconds / 60 % 60, 2);
+            out += ':';
+            appendNumber(out, seconds % 60, 2);
+            if (uint32_t fraction = ms % 1000)
             {
-                move.piece.type = PieceType::King;
-                if (currentColor == Color::White)
-                {
-                    move.from = Square("e1");
-                    move.to = Square(match[1].str().empty() ? "g1" : "c1");
-                }
-                else
+                out += '.';
+                int width = 3;
+                while (fraction % 10 == 0)
                 {
-                    move.from = Square("e8");
-                    move.to = Square(match[1].str().empty() ? "g8" : "c8");
+                    fraction /= 10;
+                    --width;
                 }
+                appendNumber(out, fraction, width);
             }
-            else
-            {
-                throw std::runtime_error("Invalid move string");
-            }
-
-            // if (std::regex_match(annotation_string, match, annotation_regex))
-            //     move.annotation = annotationMap[match[2].str()];
-            // else
-            //     throw std::runtime_error("Invalid extra string");
         }
+    } // namespace
 
-        if (game.evaluations.value().size() < game.moves.size())
-            game.evaluations.reset();
-        if (game.clocks.value().size() < game.moves.size())
-            game.clocks.reset();
+    Game readPGN(std::istream &input)
+    {
+        PGNReader reader{input};
+        const auto *pgn = reader.next();
+        if (!pgn)
+            throw std::runtime_error("No game in PGN input");
+        return readPGN(*pgn);
     }
 
-    Game readPGN(std::istream &input)
+    Game readPGN(const PGNGame &pgn)
     {
         Game game;
-        readPGNHeader(input, game);
-        readPGNMoves(input, game);
+        readPGN(pgn, game);
+        return game;
+    }
+
+    void readPGN(const PGNGame &pgn, Game &game)
+    {
+        readPGNHeader(pgn, game);
+        readPGNMoves(pgn, game);
+    }
 
-        State board;
-        game.states.reserve(game.moves.size());
-        for (auto &move : game.moves)
+    void readPGNHeader(const PGNGame &pgn, Game &game)
+    {
+        game.whiteUsername.clear();
+        game.blackUsername.clear();
+        game.result = {};
+        game.whiteELO = game.blackELO = 0;
+        game.ECOCode.clear();
+        game.timeControl = {};
+        game.startFEN.clear();
+
+        std::string_view date, time;
+        for (const auto &tag : pgn.tags)
         {
-            board.applyMove(move);
-            game.states.push_back(board); // intentional copy
+            if (tag.name == "White")
+                unescape(tag.value, game.whiteUsername);
+            else if (tag.name == "Black")
+                unescape(tag.value, game.blackUsername);
+            else if (tag.name == "Result")
+                game.result.type = parseResult(tag.value);
+            else if (tag.name == "UTCDate" || (tag.name == "Date" && date.empty()))
+                date = tag.value;
+            else if (tag.name == "UTCTime" || (tag.name == "Time" && time.empty()))
+                time = tag.value;
+            else if (tag.name == "WhiteElo")
+                game.whiteELO = parseELO(tag.value);
+            else if (tag.name == "BlackElo")
+                game.blackELO = parseELO(tag.value);
+            else if (tag.name == "ECO")
+                unescape(tag.value, game.ECOCode);
+            else if (tag.name == "TimeControl")
+                game.timeControl = parseTimeControl(tag.value);
+            else if (tag.name == "Termination")
+                game.result.reason = parseTermination(tag.value);
+            else if (tag.name == "FEN")
+                unescape(tag.value, game.startFEN);
         }
+        game.datetime = parseDatetime(date, time);
 
-        return game;
+        // The movetext's result token is authoritative if the tag is missing
+        if (game.result.type == GameResult::Type::None)
+            game.result.type = parseResult(pgn.result);
     }
 
-    Square computeFromSquare(Square to, Piece piece, const Board &pos, std::string_view partialFrom)
+    void readPGNMoves(const PGNGame &pgn, Game &game)
     {
-        if (partialFrom.size() == 2)
-            return Square(partialFrom);
-
-        Square from{};
-        bool singleSpace{true};
-        std::vector<Offset> offsets{};
-        offsets.reserve(8);
-        std::vector<Square> candidates{};
-        candidates.reserve(8);
-        std::optional<Square> maybeSq{std::nullopt};
-        switch (piece.type)
+        game.moves.clear();
+        if (!game.evaluations)
+            game.evaluations.emplace();
+        if (!game.clocks)
+            game.clocks.emplace();
+        if (!game.annotations)
+            game.annotations.emplace();
+        auto &evaluations = game.evaluations.value();
+        auto &clocks = game.clocks.value();
+        auto &annotations = game.annotations.value();
+        evaluations.clear();
+        clocks.clear();
+        annotations.clear();
+
+        State state = game.startFEN.empty() ? State{} : State{game.startFEN};
+        Algebraic::SANResolver resolver;
+        game.moves.reserve(pgn.moves.size());
+        for (const auto &token : pgn.moves)
         {
-        case PieceType::Pawn:
-            singleSpace = true;
-            for (const auto &offset : pawnOffsets)
-                offsets.push_back(offset);
-            /* code */
-            break;
-
-        case PieceType::Knight:
-            singleSpace = true;
-            for (const auto &offset : knightOffsets)
-                offsets.push_back(offset);
-            break;
-
-        case PieceType::Bishop:
-            singleSpace = false;
-            for (const auto &offset : bishopOffsets)
-                offsets.push_back(offset);
-            break;
-
-        case PieceType::Rook:
-            singleSpace = false;
-            for (const auto &offset : rookOffsets)
-                offsets.push_back(offset);
-            break;
-
-        case PieceType::Queen:
-            singleSpace = false;
-            for (const auto &offset : queenKingOffsets)
-                offsets.push_back(offset);
-            break;
-
-        case PieceType::King:
-            singleSpace = true;
-            for (const auto &offset : queenKingOffsets)
-                offsets.push_back(offset);
-            break;
-
-        default:
-            std::unreachable();
+            resolver.reset(state);
+            auto move = resolver.resolve(token.san);
+            game.moves.push_back(move.unpack(state.board));
+            state.applyMove(move);
+
+            if (token.eval)
+                evaluations.push_back(token.eval.value());
+            if (token.clock)
+                clocks.push_back(token.clock.value());
+            // NAGs 1-6 are the suffix annotations, in the same order as `Annotation`
+            auto annotation = (token.nag <= 6) ? static_cast<Annotation>(token.nag) : Annotation::None;
+            if (annotation != Annotation::None && annotations.empty())
+                annotations.resize(game.moves.size() - 1, Annotation::None);
+            if (!annotations.empty())
+                annotations.push_back(annotation);
         }
 
-        if (singleSpace)
+        bool mated = !game.moves.empty() && inCheck(state) && !hasAnyLegalMove(state);
+        bool stalemated = !game.moves.empty() && !inCheck(state) && !hasAnyLegalMove(state);
+
+        // Analysed games have no evaluation after the mating move: record it as mate in 0
+        if (mated && evaluations.size() + 1 == game.moves.size())
+            evaluations.push_back(Evaluation{.value = 0, .centipawns = false});
+
+        if (evaluations.size() != game.moves.size())
+            game.evaluations.reset();
+        if (clocks.size() != game.moves.size())
+            game.clocks.reset();
+        if (annotations.empty())
+            game.annotations.reset();
+
+        // A normal termination is refined by the final position
+        auto termination = pgn.tag("Termination");
+        if (termination.empty() || termination == "Normal")
         {
-            for (const auto &offset : offsets)
-            {
-                maybeSq = offset(to);
-                if (maybeSq &&
-                    pos.get(maybeSq.value())
-                            .value_or(Piece{Color::White, PieceType::Queen})
-                            .type == piece.type)
-                    candidates.push_back(maybeSq.value());
-            }
+            if (mated)
+                game.result.reason = GameResult::Reason::Checkmate;
+            else if (stalemated)
+                game.result.reason = GameResult::Reason::Stalemate;
+            else if (game.result.type == GameResult::Type::WhiteWins || game.result.type == GameResult::Type::BlackWins)
+                game.result.reason = GameResult::Reason::Resignation;
         }
-        else
+    }
+
+    void writePGN(std::string &out, const Game &game)
+    {
+        writePGNHeader(out, game);
+        out += '\n';
+        writePGNMoves(out, game);
+        out += "\n\n";
+    }
+
+    void writePGNHeader(std::string &out, const Game &game)
+    {
+        using namespace std::chrono;
+        auto days = floor<std::chrono::days>(game.datetime);
+        year_month_day ymd{days};
+        hh_mm_ss time{game.datetime - days};
+        bool dated = game.datetime != sys_seconds{};
+        auto date = [&](std::string &out)
         {
-            for (const auto &offset : offsets)
+            if (!dated)
             {
-                auto path = pos.getPath(to, offset, true);
-                if (path.empty())
-                    continue;
-                if (!pos.get(path.back()))
-                    continue;
-                auto foundPiece = pos.get(path.back()).value();
-                if (foundPiece.type == piece.type)
-                    candidates.push_back(path.back());
+                out += "????.??.??";
+                return;
             }
-        }
-
-        if (candidates.size() == 0)
-            throw std::runtime_error("Could not identify which square the piece moved from");
-        if (candidates.size() == 1)
-            return candidates.front();
-        if (partialFrom.size() == 0)
-            throw std::runtime_error("Could not identify which square the piece moved from");
-
-        bool matchRank;
-        if ('1' <= partialFrom[0] && partialFrom[0] <= '8')
-            matchRank = true;
-        else if ('a' <= partialFrom[0] && partialFrom[0] <= 'h')
-            matchRank = false;
-        else
-            throw std::runtime_error("Could not identify which square the piece moved from");
-
-        std::string testString{};
-        if (matchRank)
+            appendNumber(out, static_cast<int>(ymd.year()), 4);
+            out += '.';
+            appendNumber(out, static_cast<unsigned>(ymd.month()), 2);
+            out += '.';
+            appendNumber(out, static_cast<unsigned>(ymd.day()), 2);
+        };
+        auto number = [](auto value)
         {
-            testString += "a";
-            testString += partialFrom;
-            Square test{testString};
-            auto matchPartial = [&](Square sq)
-            { return test.rank == sq.rank; };
-            for (const auto &candidate : candidates)
-                if (matchPartial(candidate))
-                    return candidate;
-            throw std::runtime_error("Could not identify which square the piece moved from");
-        }
-        else
+            return [value](std::string &out)
+            {
+                if (value)
+                    appendNumber(out, value);
+                else
+                    out += '?';
+            };
+        };
+
+        appendTag(out, "Event", "?");
+        appendTag(out, "Site", "?");
+        appendTag(out, "Date", date);
+        appendTag(out, "Round", "-");
+        appendTag(out, "White", game.whiteUsername);
+        appendTag(out, "Black", game.blackUsername);
+        appendTag(out, "Result", resultTokens[static_cast<size_t>(game.result.type)]);
+        appendTag(out, "UTCDate", date);
+        if (dated)
+            appendTag(out, "UTCTime", [&](std::string &out)
+                      {
+                          appendNumber(out, time.hours().count(), 2);
+                          out += ':';
+                          appendNumber(out, time.minutes().count(), 2);
+                          out += ':';
+                          appendNumber(out, time.seconds().count(), 2); });
+        appendTag(out, "WhiteElo", number(game.whiteELO));
+        appendTag(out, "BlackElo", number(game.blackELO));
+        if (!game.ECOCode.empty())
+            appendTag(out, "ECO", game.ECOCode);
+        appendTag(out, "TimeControl", [&](std::string &out)
+                  {
+                      if (game.timeControl.initial.count() == 0 && game.timeControl.increment.count() == 0)
+                      {
+                          out += '-';
+                          return;
+                      }
+                      appendNumber(out, game.timeControl.initial.count() / 1000);
+                      out += '+';
+                      appendNumber(out, game.timeControl.increment.count() / 1000); });
+
+        std::string_view termination = "Normal";
+        if (game.result.reason == GameResult::Reason::Timeout)
+            termination = "Time forfeit";
+        else if (game.result.reason == GameResult::Reason::RulesInfraction)
+            termination = "Rules infraction";
+        appendTag(out, "Termination", termination);
+
+        if (!game.startFEN.empty())
         {
-            testString += partialFrom;
-            testString += "1";
-            Square test{testString};
-            auto matchPartial = [&](Square sq)
-            { return test.file == sq.file; };
-            for (const auto &candidate : candidates)
-                if (matchPartial(candidate))
-                    return candidate;
-            throw std::runtime_error("Could not identify which square the piece moved from");
+            appendTag(out, "SetUp", "1");
+            appendTag(out, "FEN", game.startFEN);
         }
     }
 
-    Move interpretPGNMove(std::string_view pgnMove,
-                          const Board &previousPos,
-                          Color turn)
+    void writePGNMoves(std::string &out, const Game &game)
     {
-        Move move;
-
-        move.piece.color = turn;
-        move.piece.type = PGNPieceType.at(pgnMove[0]);
+        State state = game.startFEN.empty() ? State{} : State{game.startFEN};
+        uint32_t moveNumber = state.fullTurnCounter;
+        bool commented = true; // black's first move needs its number
 
-        std::cmatch match;
-        std::regex move_string_regex(R"(([KQRBN])?([a-h]?[1-8]?)(x)?([a-h][1-8])(?:=([QRBN]))?([+#])?([!?]{1,2})?)");
-        std::regex castle_regex(R"(O-O(-O)?([+#])?([!?]{1,2})?)");
-
-        if (std::regex_match(pgnMove.data(), match, move_string_regex))
+        for (size_t i = 0; i < game.moves.size(); ++i)
         {
-            move.to = Square(match[4].str());
-            move.from = computeFromSquare(move.to, move.piece, previousPos, match[2].str());
-
-            if (match[3].matched)
+            if (i)
+                out += ' ';
+            if (state.turn == Color::White || commented)
             {
-                if (move.piece.type == PieceType::Pawn && !previousPos.get(move.to))
+                appendNumber(out, moveNumber);
+                out += (state.turn == Color::White) ? ". " : "... ";
+            }
+            if (state.turn == Color::Black)
+                ++moveNumber;
+
+            Algebraic::writeSAN(out, state, PackedMove{game.moves[i]});
+            if (game.annotations)
+                out += Annotations::toPGN.at(game.annotations.value()[i]);
+
+            // `readPGN` adds mate in 0 after a mating move; Lichess writes nothing there
+            std::optional<Evaluation> eval;
+            if (game.evaluations && (game.evaluations.value()[i].centipawns || game.evaluations.value()[i].value != 0))
+                eval = game.evaluations.value()[i];
+            commented = eval || game.clocks;
+            if (commented)
+            {
+                out += " {";
+                if (eval)
                 {
-                    move.capture = PieceType::Pawn;
-                    move.enPassant = true;
+                    out += " [%eval ";
+                    appendEval(out, eval.value());
+                    out += ']';
                 }
-                else
-                    move.capture = previousPos.get(move.to).value().type;
+                if (game.clocks)
+                {
+                    out += " [%clk ";
+                    appendClock(out, game.clocks.value()[i]);
+                    out += ']';
+                }
+                out += " }";
             }
-
-            if (match[5].matched)
-                move.promotion = PGNPieceType.at(match[5].str()[0]);
-        }
-        else if (std::regex_match(pgnMove.data(), match, castle_regex))
-        {
-            move.castle = (match[1].str().empty()) ? Castling::Side::KING : Castling::Side::QUEEN;
-            move.from.rank = homeRank(turn);
-            move.to.rank = move.from.rank;
-            move.from.file = 4;
-            move.to.file = kingToFile(move.castle.value());
-        }
-        else
-        {
-            throw std::runtime_error("Invalid PGN move string");
         }
 
-        return move;
+        if (!game.moves.empty())
+            out += ' ';
+        out += resultTokens[static_cast<size_t>(game.result.type)];
     }
-
-    Move interpretUCIMove(std::string_view uciMove, const State &state)
-    {
-    }
-
-    State::State(std::string_view fenString)
-        : board(fenString), m_board(std::shared_ptr<Board>(&board)), attacks(m_board)
-    {
-        std::istringstream iss{fenString.data()};
-        std::string str;
-
-        iss >> str;
-
-        iss >> str;
-        if (str == "w")
-            turn = Color::White;
-        else if (str == "b")
-            turn = Color::Black;
-        else
-            throw std::runtime_error("Invalid FEN string");
-
-        iss >> str;
-        castleRights = Castling::Rights(str);
-
-        iss >> str;
-        if (str != "-")
-            enPassant = Square(str);
-
-        iss >> str;
-        halfTurnCounter = std::stoul(str);
-
-        iss >> str;
-        fullTurnCounter = std::stoul(str);
-    }
-
-    const std::unordered_map<char, PieceType> PGNPieceType{
-        {'K', PieceType::King},
-        {'O', PieceType::King},
-        {'Q', PieceType::Queen},
-        {'R', PieceType::Rook},
-        {'B', PieceType::Bishop},
-        {'N', PieceType::Knight},
-        {'a', PieceType::Pawn},
-        {'b', PieceType::Pawn},
-        {'c', PieceType::Pawn},
-        {'d', PieceType::Pawn},
-        {'e', PieceType::Pawn},
-        {'f', PieceType::Pawn},
-        {'g', PieceType::Pawn},
-        {'h', PieceType::Pawn}};
-}
\ No newline at end of file
+} // namespace JChess
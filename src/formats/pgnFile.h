@@ -1,20 +1,48 @@
 #pragma once
 
 #include <istream>
-#include <ostream>
-#include <string_view>
+#include <string>
 
-#include "internal/game/game.h"
-#include "internal/game/move.h"
+#include "core/game.h"
+#include "formats/pgnReader.h"
 
 namespace JChess
 {
+    /* Read the first game of PGN input, e.g., an `InputFile`. For many games, use a
+     * `PGNReader` or `ParallelPGNReader` and convert each game with the overloads below.
+     * Throws `std::runtime_error` on malformed input or an illegal or ambiguous move.
+     */
     Game readPGN(std::istream &input);
 
-    void readPGNHeader(std::istream &input, Game &game);
-    void readPGNMoves(std::istream &input, Game &game);
-    Move readPGNMove(std::string_view pgnMove,
-                     const Board &pos,
-                     const std::optional<Square> &enPassant,
-                     Color turn);
+    /* Convert a tokenized game, resolving each SAN move against the position it is played in,
+     * so that the moves are complete (captured piece, castling, en passant, promotion).
+     */
+    Game readPGN(const PGNGame &pgn);
+    // The same, reusing the strings and vectors of `game`
+    void readPGN(const PGNGame &pgn, Game &game);
+
+    void readPGNHeader(const PGNGame &pgn, Game &game);
+    void readPGNMoves(const PGNGame &pgn, Game &game);
+
+    /* Append a game as PGN to `out`, for the caller to write out in large pieces:
+     *
+     *     std::string buffer;
+     *     for (const auto &game : games)
+     *     {
+     *         writePGN(buffer, game);
+     *         if (buffer.size() > (1 << 20))
+     *         {
+     *             output.write(buffer.data(), buffer.size());
+     *             buffer.clear();
+     *         }
+     *     }
+     *
+     * Moves are written in SAN, each followed by its annotation and a `{ [%eval] [%clk] }`
+     * comment when the game has them, in the layout of the Lichess exports. `readPGN` reads
+     * the output back to an equal game, except for draws by agreement or insufficient
+     * material, which PGN has no termination for.
+     */
+    void writePGN(std::string &out, const Game &game);
+    void writePGNHeader(std::string &out, const Game &game);
+    void writePGNMoves(std::string &out, const Game &game);
 } // namespace JChess
@@ -0,0 +1,395 @@
+#include "formats/pgnReader.h"
+
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+namespace JChess
+{
+    namespace
+    {
+        enum CharClass : uint8_t
+        {
+            Space = 1,
+            Delimiter = 2, // ends a move or move-number token
+            Digit = 4,
+        };
+
+        constexpr std::array<uint8_t, 256> charClasses = []
+        {
+            std::array<uint8_t, 256> classes{};
+            for (unsigned char c : {' ', '\t', '\n', '\r', '\f', '\v'})
+                classes[c] = Space | Delimiter;
+            for (unsigned char c : {'{', '}', '(', ')', ';', '$', '['})
+                classes[c] = Delimiter;
+            for (unsigned char c = '0'; c <= '9'; ++c)
+                classes[c] = Digit;
+            return classes;
+        }();
+
+        inline bool is(char c, CharClass charClass)
+        {
+            return charClasses[static_cast<unsigned char>(c)] & charClass;
+        }
+
+        inline const char *skipSpace(const char *p, const char *end)
+        {
+            while (p < end && is(*p, Space))
+                ++p;
+            return p;
+        }
+
+        // Annotation suffixes as their standard NAGs
+        uint8_t suffixNag(std::string_view suffix)
+        {
+            constexpr std::array<std::string_view, 7> suffixes{"", "!", "?", "!!", "??", "!?", "?!"};
+            for (size_t i = 1; i < suffixes.size(); ++i)
+                if (suffix == suffixes[i])
+                    return static_cast<uint8_t>(i);
+            return 0;
+        }
+
+        // Consumes the digits at the front of `text`; returns false if there are none
+        bool readUnsigned(std::string_view &text, uint32_t &value)
+        {
+            size_t i = 0;
+            value = 0;
+            for (; i < text.size() && is(text[i], Digit); ++i)
+                value = value * 10 + static_cast<uint32_t>(text[i] - '0');
+            text.remove_prefix(i);
+            return i > 0;
+        }
+
+        /* "0.25" (pawns, to centipawns) or "#-3" (mate in 3 for black)
+         */
+        std::optional<Evaluation> parseEval(std::string_view text)
+        {
+            bool mate = !text.empty() && text.front() == '#';
+            if (mate)
+                text.remove_prefix(1);
+
+            bool negative = !text.empty() && text.front() == '-';
+            if (!text.empty() && (text.front() == '-' || text.front() == '+'))
+                text.remove_prefix(1);
+
+            uint32_t whole = 0;
+            if (!readUnsigned(text, whole))
+                return std::nullopt;
+
+            int32_t value = static_cast<int32_t>(whole);
+            if (!mate)
+            {
+                value *= 100;
+                if (!text.empty() && text.front() == '.')
+                {
+                    text.remove_prefix(1);
+                    int32_t scale = 10;
+                    for (size_t i = 0; i < text.size() && is(text[i], Digit) && scale; ++i, scale /= 10)
+                        value += (text[i] - '0') * scale;
+                }
+            }
+
+            return Evaluation{.value = negative ? -value : value, .centipawns = !mate};
+        }
+
+        /* "h:mm:ss", optionally with fractional seconds
+         */
+        std::optional<msDuration> parseClock(std::string_view text)
+        {
+            uint32_t seconds = 0;
+            for (int field = 0; field < 3; ++field)
+            {
+                uint32_t value = 0;
+                if (!readUnsigned(text, value))
+                    return std::nullopt;
+                seconds = seconds * 60 + value;
+                if (field < 2)
+                {
+                    if (text.empty() || text.front() != ':')
+                        return std::nullopt;
+                    text.remove_prefix(1);
+                }
+            }
+
+            uint32_t ms = seconds * 1000;
+            if (!text.empty() && text.front() == '.')
+            {
+                text.remove_prefix(1);
+                uint32_t scale = 100;
+                for (size_t i = 0; i < text.size() && is(text[i], Digit) && scale; ++i, scale /= 10)
+                    ms += static_cast<uint32_t>(text[i] - '0') * scale;
+            }
+            return msDuration{ms};
+        }
+
+        // Picks the `[%eval ...]` and `[%clk ...]` commands out of a comment
+        void parseCommands(std::string_view comment, PGNMoveToken &move)
+        {
+            for (auto pos = comment.find("[%"); pos != std::string_view::npos; pos = comment.find("[%"))
+            {
+                comment.remove_prefix(pos + 2);
+                auto close = comment.find(']');
+                if (close == std::string_view::npos)
+                    return;
+
+                auto command = comment.substr(0, close);
+                comment.remove_prefix(close + 1);
+
+                auto space = command.find(' ');
+                if (space == std::string_view::npos)
+                    continue;
+                auto name = command.substr(0, space);
+                auto argument = command.substr(command.find_first_not_of(' ', space));
+
+                if (name == "eval")
+                    move.eval = parseEval(argument);
+                else if (name == "clk")
+                    move.clock = parseClock(argument);
+            }
+        }
+
+        bool isResult(std::string_view token)
+        {
+            return token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+        }
+    } // namespace
+
+    size_t nextGameBoundary(std::string_view text, size_t from)
+    {
+        constexpr std::string_view event = "[Event ";
+        for (size_t pos = text.find(event, from); pos != std::string_view::npos; pos = text.find(event, pos + 1))
+        {
+            if (pos < 2 || text[pos - 1] != '\n')
+                continue;
+            if (text[pos - 2] == '\n' || (pos >= 3 && text[pos - 2] == '\r' && text[pos - 3] == '\n'))
+                return pos;
+        }
+        return text.size();
+    }
+
+    std::string_view PGNGame::tag(std::string_view name) const
+    {
+        for (const auto &t : tags)
+            if (t.name == name)
+                return t.value;
+        return {};
+    }
+
+    PGNReader::PGNReader(std::istream &input, size_t bufferSize)
+        : m_input(&input), m_buffer(std::max<size_t>(bufferSize, 1))
+    {
+    }
+
+    PGNReader::PGNReader(std::string_view text)
+        : m_text(text), m_eof(true)
+    {
+    }
+
+    const PGNGame *PGNReader::next()
+    {
+        while (true)
+        {
+            const char *gameEnd = nullptr;
+            switch (parse(m_text.data(), m_text.data() + m_text.size(), m_eof, gameEnd))
+            {
+            case ParseResult::Game:
+                m_text.remove_prefix(static_cast<size_t>(gameEnd - m_text.data()));
+                ++m_gamesRead;
+                return &m_game;
+            case ParseResult::End:
+                m_text = {};
+                return nullptr;
+            case ParseResult::NeedMore:
+                refill();
+                break;
+            }
+        }
+    }
+
+    /* Keep the unparsed text (the start of a game cut off by the end of the buffer), move it
+     * to the front of the buffer, and fill the rest from the stream. A game larger than the
+     * whole buffer doubles it.
+     */
+    void PGNReader::refill()
+    {
+        size_t kept = m_text.size();
+        if (kept && m_text.data() != m_buffer.data())
+            std::memmove(m_buffer.data(), m_text.data(), kept);
+        if (kept == m_buffer.size())
+            m_buffer.resize(m_buffer.size() * 2);
+
+        m_input->read(m_buffer.data() + kept, static_cast<std::streamsize>(m_buffer.size() - kept));
+        auto read = static_cast<size_t>(m_input->gcount());
+        if (!*m_input)
+            m_eof = true;
+
+        m_text = std::string_view{m_buffer.data(), kept + read};
+    }
+
+    PGNReader::ParseResult PGNReader::parse(const char *p, const char *end, bool atEof, const char *&gameEnd)
+    {
+        // Input that stops mid-game is only an error if there is no more to come
+        auto incomplete = [atEof]
+        {
+            if (atEof)
+                throw std::runtime_error("Unexpected end of PGN input");
+            return ParseResult::NeedMore;
+        };
+
+        p = skipSpace(p, end);
+        if (end - p >= 3 && std::memcmp(p, "\xEF\xBB\xBF", 3) == 0) // UTF-8 byte order mark
+            p = skipSpace(p + 3, end);
+        if (p == end)
+            return atEof ? ParseResult::End : ParseResult::NeedMore;
+
+        m_game.tags.clear();
+        m_game.moves.clear();
+        m_game.result = {};
+        const char *start = p;
+
+        // Tag pairs: [Name "Value"]
+        while (p < end && *p == '[')
+        {
+            const char *name = ++p;
+            while (p < end && !is(*p, Space) && *p != '"' && *p != ']')
+                ++p;
+            const char *nameEnd = p;
+            while (p < end && (*p == ' ' || *p == '\t'))
+                ++p;
+            if (p == end)
+                return incomplete();
+            if (*p != '"')
+                throw std::runtime_error("Invalid PGN tag pair: expected a quoted value");
+
+            const char *value = ++p;
+            while (p < end && *p != '"')
+                p += (*p == '\\') ? 2 : 1;
+            if (p >= end)
+                return incomplete();
+            const char *valueEnd = p;
+
+            auto close = static_cast<const char *>(std::memchr(p, ']', static_cast<size_t>(end - p)));
+            if (!close)
+                return incomplete();
+            p = skipSpace(close + 1, end);
+
+            m_game.tags.push_back({.name = std::string_view(name, static_cast<size_t>(nameEnd - name)),
+                                   .value = std::string_view(value, static_cast<size_t>(valueEnd - value))});
+        }
+
+        // Movetext
+        int depth = 0;
+        while (true)
+        {
+            p = skipSpace(p, end);
+            if (p == end)
+            {
+                if (!atEof)
+                    return ParseResult::NeedMore;
+                break;
+            }
+
+            char c = *p;
+            if (c == '[') // the next game, this one having no result token
+                break;
+
+            if (c == '{')
+            {
+                auto close = static_cast<const char *>(std::memchr(p + 1, '}', static_cast<size_t>(end - p - 1)));
+                if (!close)
+                    return incomplete();
+                if (depth == 0 && !m_game.moves.empty())
+                    parseCommands(std::string_view(p + 1, static_cast<size_t>(close - p - 1)), m_game.moves.back());
+                p = close + 1;
+            }
+            else if (c == ';' || (c == '%' && (p == start || p[-1] == '\n')))
+            {
+                auto newline = static_cast<const char *>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+                if (!newline)
+                {
+                    if (!atEof)
+                        return ParseResult::NeedMore;
+                    p = end;
+                }
+                else
+                    p = newline + 1;
+            }
+            else if (c == '(')
+            {
+                ++depth;
+                ++p;
+            }
+            else if (c == ')')
+            {
+                if (depth == 0)
+                    throw std::runtime_error("Unbalanced ')' in PGN movetext");
+                --depth;
+                ++p;
+            }
+            else if (c == '$')
+            {
+                ++p;
+                std::string_view digits{p, static_cast<size_t>(end - p)};
+                uint32_t nag = 0;
+                if (!readUnsigned(digits, nag))
+                    throw std::runtime_error("Invalid NAG in PGN movetext");
+                if (digits.empty() && !atEof)
+                    return ParseResult::NeedMore;
+                p = digits.data();
+                if (depth == 0 && !m_game.moves.empty() && m_game.moves.back().nag == 0)
+                    m_game.moves.back().nag = static_cast<uint8_t>(nag);
+            }
+            else if (c == '}')
+                throw std::runtime_error("Unbalanced '}' in PGN movetext");
+            else
+            {
+                const char *q = p;
+                while (q < end && !is(*q, Delimiter))
+                    ++q;
+                if (q == end && !atEof)
+                    return ParseResult::NeedMore;
+
+                std::string_view token{p, static_cast<size_t>(q - p)};
+                p = q;
+
+                if (isResult(token))
+                {
+                    if (depth > 0)
+                        continue;
+                    m_game.result = token;
+                    break;
+                }
+
+                // Move number ("12." or "12..."), possibly run together with the move ("12.e4")
+                size_t digits = 0;
+                while (digits < token.size() && is(token[digits], Digit))
+                    ++digits;
+                if (digits && digits < token.size() && token[digits] == '.')
+                {
+                    token.remove_prefix(digits);
+                    token.remove_prefix(std::min(token.find_first_not_of('.'), token.size()));
+                }
+                if (token.empty())
+                    continue;
+
+                auto suffix = token.find_first_of("!?");
+                uint8_t nag = 0;
+                if (suffix != std::string_view::npos)
+                {
+                    nag = suffixNag(token.substr(suffix));
+                    token = token.substr(0, suffix);
+                }
+
+                if (depth == 0)
+                    m_game.moves.push_back({.san = token, .nag = nag});
+            }
+        }
+
+        if (depth != 0 && !atEof)
+            return ParseResult::NeedMore;
+
+        m_game.text = std::string_view(start, static_cast<size_t>(p - start));
+        gameEnd = p;
+        return ParseResult::Game;
+    }
+} // namespace JChess
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "annotation/evaluation.h"
+#include "annotation/time.h"
+
+namespace JChess
+{
+    struct PGNTag
+    {
+        std::string_view name;
+        // As written between the quotes, i.e., with any `\"` and `\\` escapes intact
+        std::string_view value;
+    };
+
+    // One half-move of the main line, with the annotations that follow it
+    struct PGNMoveToken
+    {
+        // The move in SAN, including any check or mate suffix, e.g., "Nxc7+" or "e8=Q#"
+        std::string_view san;
+        // Numeric annotation glyph, from `$n` or a suffix such as "!?"; 0 if none
+        uint8_t nag = 0;
+        // From `[%eval ...]` and `[%clk ...]` commands in the comment after the move
+        std::optional<Evaluation> eval;
+        std::optional<msDuration> clock;
+    };
+
+    /* A game as tokenized from PGN, with every string a view into the reader's buffer.
+     * Variations are skipped; only the main line is kept.
+     */
+    struct PGNGame
+    {
+        std::vector<PGNTag> tags;
+        std::vector<PGNMoveToken> moves;
+        // "1-0", "0-1", "1/2-1/2" or "*"; empty if the game ended without a result token
+        std::string_view result;
+        // The game's full text, from the first tag to the result
+        std::string_view text;
+
+        // The value of the first tag with the given name, or an empty view
+        std::string_view tag(std::string_view name) const;
+    };
+
+    /* The start of the first game beginning at or after `from`: an `[Event ` tag at the start
+     * of a line that follows a blank line. The end of the text if there is none. Used to
+     * split PGN text into pieces that can be parsed apart.
+     */
+    size_t nextGameBoundary(std::string_view text, size_t from);
+
+    /* Single-pass, pull-style PGN tokenizer. Each call to `next` parses one game: tag pairs,
+     * SAN moves, comments with `[%eval]`/`[%clk]` commands, NAGs, annotation suffixes and
+     * (skipped) variations. Nothing is allocated per game once the buffers have grown to fit
+     * the largest game seen, and no text is copied when reading from memory.
+     *
+     *     PGNReader reader{input};
+     *     while (const auto *game = reader.next())
+     *         use(*game);
+     *
+     * Throws `std::runtime_error` on malformed input.
+     */
+    class PGNReader
+    {
+    public:
+        // Read from a stream through an internal buffer of (initially) `bufferSize` bytes
+        explicit PGNReader(std::istream &input, size_t bufferSize = 1 << 20);
+        // Read from text already in memory (e.g., a mapped file), which must outlive the reader
+        explicit PGNReader(std::string_view text);
+
+        PGNReader(const PGNReader &) = delete;
+        PGNReader &operator=(const PGNReader &) = delete;
+
+        /* The next game, or nullptr at the end of the input. The game and the views in it
+         * are valid until the next call.
+         */
+        const PGNGame *next();
+
+        // Number of games returned so far
+        size_t gamesRead() const { return m_gamesRead; }
+
+    private:
+        enum class ParseResult
+        {
+            Game,
+            End,
+            NeedMore,
+        };
+
+        ParseResult parse(const char *begin, const char *end, bool atEof, const char *&gameEnd);
+        void refill();
+
+    private:
+        std::istream *m_input = nullptr;
+        std::vector<char> m_buffer;
+        std::string_view m_text; // unread input: in `m_buffer` when reading a stream
+        bool m_eof = false;
+
+        PGNGame m_game;
+        size_t m_gamesRead = 0;
+    };
+} // namespace JChess
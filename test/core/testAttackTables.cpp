@@ -0,0 +1,85 @@
+#include "core/attackTables.h"
+#include "core/board.h"
+#include <gtest/gtest.h>
+
+using JChess::Bitboard, JChess::Board, JChess::Offset, JChess::Square;
+namespace AT = JChess::AttackTables;
+namespace BB = JChess::Bitboards;
+
+namespace
+{
+    template <size_t N>
+    Bitboard walkRays(const std::array<Offset, N> &directions, size_t idx, Bitboard occupied)
+    {
+        Bitboard attacked = BB::empty;
+        for (const auto &dir : directions)
+        {
+            for (Square sq = Board::idxToSquare(idx) + dir; Board::valid(sq); sq += dir)
+            {
+                attacked |= BB::bit(sq);
+                if (BB::test(occupied, Board::squareToIdx(sq)))
+                    break;
+            }
+        }
+        return attacked;
+    }
+}
+
+TEST(AttackTablesTest, Leapers)
+{
+    // Knight on a1 attacks b3 and c2
+    EXPECT_EQ(AT::knightAttacks(Board::squareToIdx({0, 0})),
+              BB::bit(Square{1, 2}) | BB::bit(Square{2, 1}));
+    // King in the corner has three neighbors, in the middle eight
+    EXPECT_EQ(BB::count(AT::kingAttacks(Board::squareToIdx({7, 7}))), 3ull);
+    EXPECT_EQ(BB::count(AT::kingAttacks(Board::squareToIdx({3, 3}))), 8ull);
+    // Pawns attack diagonally forward
+    EXPECT_EQ(AT::pawnAttacks(JChess::Color::White, Board::squareToIdx({4, 1})),
+              BB::bit(Square{3, 2}) | BB::bit(Square{5, 2}));
+    EXPECT_EQ(AT::pawnAttacks(JChess::Color::Black, Board::squareToIdx({0, 6})),
+              BB::bit(Square{1, 5}));
+}
+
+TEST(AttackTablesTest, SlidersMatchRayWalk)
+{
+    uint64_t seed = 0x123456789ABCDEFull;
+    auto next = [&]()
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        return seed;
+    };
+
+    for (size_t idx = 0; idx < 64; ++idx)
+    {
+        for (int trial = 0; trial < 200; ++trial)
+        {
+            Bitboard occupied = next() & next();
+            EXPECT_EQ(AT::bishopAttacks(idx, occupied), walkRays(JChess::Offsets::bishop, idx, occupied));
+            EXPECT_EQ(AT::rookAttacks(idx, occupied), walkRays(JChess::Offsets::rook, idx, occupied));
+            EXPECT_EQ(AT::queenAttacks(idx, occupied), walkRays(JChess::Offsets::queenKing, idx, occupied));
+        }
+    }
+}
+
+TEST(AttackTablesTest, BetweenAndLine)
+{
+    auto a1 = Board::squareToIdx({0, 0}), h8 = Board::squareToIdx({7, 7}),
+         d4 = Board::squareToIdx({3, 3}), d8 = Board::squareToIdx({3, 7}),
+         b3 = Board::squareToIdx({1, 2});
+
+    EXPECT_EQ(BB::count(AT::between(a1, h8)), 6ull);
+    EXPECT_EQ(AT::between(a1, h8), AT::between(h8, a1));
+    EXPECT_TRUE(BB::test(AT::between(a1, h8), d4));
+    EXPECT_EQ(BB::count(AT::line(a1, d4)), 8ull);
+    EXPECT_EQ(AT::line(a1, d4), AT::line(h8, a1));
+
+    EXPECT_EQ(AT::between(d4, d8), BB::bit(Square{3, 4}) | BB::bit(Square{3, 5}) | BB::bit(Square{3, 6}));
+    EXPECT_EQ(BB::count(AT::line(d4, d8)), 8ull);
+
+    // Not on a common line
+    EXPECT_EQ(AT::between(a1, b3), BB::empty);
+    EXPECT_EQ(AT::line(a1, b3), BB::empty);
+    EXPECT_EQ(AT::line(d4, d4), BB::empty);
+}
@@ -6,8 +6,7 @@ using JChess::Attacks, JChess::Board;
 TEST(AttacksTest, BasicAssertions)
 {
     Board pos{"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR"};
-    auto pos_p = std::make_shared<Board>(pos);
-    Attacks att{pos_p};
+    Attacks att{pos};
 
     {
         size_t nums[] = {0, 1, 1, 1, 1, 1, 1, 0};
@@ -181,4 +181,40 @@ TEST(BoardTest, GetPath)
         EXPECT_EQ(path2[i - 2].file, 4 - i);
         EXPECT_EQ(path2[i - 2].rank, i);
     }
-}
\ No newline at end of file
+}
+
+TEST(BoardTest, Bitboards)
+{
+    using JChess::Color, JChess::Piece, JChess::PieceType, JChess::Square;
+    namespace BB = JChess::Bitboards;
+
+    Board pos{"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR"};
+    EXPECT_EQ(BB::count(pos.occupied()), 32ull);
+    EXPECT_EQ(BB::count(pos.pieces(Color::White)), 16ull);
+    EXPECT_EQ(BB::count(pos.pieces(Color::Black, PieceType::Pawn)), 8ull);
+    EXPECT_EQ(BB::count(pos.pieces(PieceType::Knight)), 4ull);
+    EXPECT_EQ(pos.pieces(Color::White, PieceType::King), BB::bit(Square{4, 0}));
+    EXPECT_EQ(pos.pieces(Color::White) & pos.pieces(Color::Black), BB::empty);
+
+    pos.put({4, 3}, Piece{Color::White, PieceType::Pawn});
+    pos.remove({4, 1});
+    EXPECT_TRUE(BB::test(pos.pieces(Color::White, PieceType::Pawn), Board::squareToIdx({4, 3})));
+    EXPECT_FALSE(BB::test(pos.occupied(), Board::squareToIdx({4, 1})));
+
+    // Capturing replaces the occupant in both the mailbox and the bitboards
+    pos.put({3, 6}, Piece{Color::White, PieceType::Pawn});
+    EXPECT_EQ(BB::count(pos.pieces(Color::Black, PieceType::Pawn)), 7ull);
+    EXPECT_EQ(BB::count(pos.pieces(Color::White, PieceType::Pawn)), 9ull);
+    EXPECT_EQ(BB::count(pos.occupied()), 32ull);
+
+    for (size_t i = 0; i < 64; ++i)
+        EXPECT_EQ(Board::squareToIdx(Board::idxToSquare(i)), i);
+}
+
+TEST(BoardTest, ToFen)
+{
+    for (auto fen : {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR",
+                     "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R",
+                     "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8"})
+        EXPECT_EQ(Board{fen}.toFen(), fen);
+}
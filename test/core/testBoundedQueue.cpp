@@ -0,0 +1,84 @@
+#include "core/boundedQueue.h"
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using JChess::BoundedQueue;
+
+TEST(BoundedQueueTest, FirstInFirstOut)
+{
+    BoundedQueue<int> queue{3};
+    EXPECT_EQ(queue.capacity(), 3u);
+    EXPECT_TRUE(queue.push(1));
+    EXPECT_TRUE(queue.push(2));
+    EXPECT_EQ(queue.size(), 2u);
+    EXPECT_EQ(queue.pop(), 1);
+    EXPECT_EQ(queue.pop(), 2);
+    EXPECT_EQ(queue.size(), 0u);
+}
+
+TEST(BoundedQueueTest, Close)
+{
+    BoundedQueue<int> queue{2};
+    queue.push(1);
+    queue.close();
+    EXPECT_FALSE(queue.push(2));
+    // What was queued is still returned, then nothing
+    EXPECT_EQ(queue.pop(), 1);
+    EXPECT_EQ(queue.pop(), std::nullopt);
+}
+
+TEST(BoundedQueueTest, BlocksWhileFull)
+{
+    BoundedQueue<int> queue{1};
+    queue.push(1);
+    std::atomic<bool> pushed{false};
+    std::thread producer{[&]
+                         {
+                             queue.push(2);
+                             pushed = true;
+                         }};
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(pushed);
+    EXPECT_EQ(queue.pop(), 1);
+    producer.join();
+    EXPECT_TRUE(pushed);
+    EXPECT_EQ(queue.pop(), 2);
+}
+
+TEST(BoundedQueueTest, ManyProducersAndConsumers)
+{
+    constexpr int producers = 4, consumers = 3, items = 10000;
+    BoundedQueue<int> queue{8};
+    std::atomic<long> sum{0};
+    std::atomic<int> popped{0};
+
+    std::vector<std::thread> threads;
+    for (int c = 0; c < consumers; ++c)
+        threads.emplace_back([&]
+                             {
+                                 while (auto item = queue.pop())
+                                 {
+                                     sum += *item;
+                                     ++popped;
+                                 }
+                             });
+    std::vector<std::thread> producing;
+    for (int p = 0; p < producers; ++p)
+        producing.emplace_back([&]
+                               {
+                                   for (int i = 1; i <= items; ++i)
+                                       queue.push(i);
+                               });
+    for (auto &thread : producing)
+        thread.join();
+    queue.close();
+    for (auto &thread : threads)
+        thread.join();
+
+    EXPECT_EQ(popped, producers * items);
+    EXPECT_EQ(sum, long{producers} * items * (items + 1) / 2);
+}
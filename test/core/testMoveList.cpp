@@ -0,0 +1,174 @@
+#include "core/moveList.h"
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <new>
+
+#include "core/legalMoves.h"
+#include "core/state.h"
+
+namespace
+{
+    /* Counts the heap allocations made on this thread while it is alive. The replacements
+     * below count only then, so they behave as the default ones for the rest of the tests
+     * in the binary.
+     */
+    class AllocationCounter
+    {
+    public:
+        AllocationCounter() { s_current = this; }
+        ~AllocationCounter() { s_current = nullptr; }
+        AllocationCounter(const AllocationCounter &) = delete;
+        AllocationCounter &operator=(const AllocationCounter &) = delete;
+
+        size_t count() const { return m_count; }
+
+        static void record()
+        {
+            if (s_current)
+                ++s_current->m_count;
+        }
+
+    private:
+        static thread_local AllocationCounter *s_current;
+        size_t m_count = 0;
+    };
+    thread_local AllocationCounter *AllocationCounter::s_current = nullptr;
+} // namespace
+
+// Once inlined into a caller, GCC sees `free` paired with `new` and warns, although the
+// replacements below are themselves a matching pair
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void *operator new(size_t size)
+{
+    AllocationCounter::record();
+    if (void *ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc{};
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+#pragma GCC diagnostic pop
+
+using JChess::MoveList, JChess::State;
+
+TEST(MoveListTest, BasicAssertions)
+{
+    MoveList list;
+    EXPECT_TRUE(list.empty());
+
+    JChess::PackedMove e4{JChess::Square{4, 1}, JChess::Square{4, 3}, JChess::PackedMove::DoublePush};
+    list.push_back(e4);
+    list.emplace_back(JChess::Square{6, 0}, JChess::Square{5, 2}, JChess::PackedMove::Quiet);
+    EXPECT_EQ(list.size(), 2ull);
+    EXPECT_EQ(list[0], e4);
+    EXPECT_TRUE(list.contains(e4));
+    EXPECT_FALSE(list.contains(JChess::PackedMove{}));
+
+    list.clear();
+    EXPECT_TRUE(list.empty());
+}
+
+TEST(MoveListTest, MatchesVectorOverload)
+{
+    for (auto fen : {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                     "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+                     "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"})
+    {
+        State state{fen};
+        MoveList list;
+        JChess::legalMoves(state, list);
+        auto moves = JChess::legalPackedMoves(state);
+        ASSERT_EQ(list.size(), moves.size()) << fen;
+        for (size_t i = 0; i < moves.size(); ++i)
+            EXPECT_EQ(list[i], moves[i]);
+    }
+
+    // The position with the most legal moves known
+    MoveList list;
+    JChess::legalMoves(State{"R6R/3Q4/1Q4Q1/4Q3/2Q4Q/Q4Q2/pp1Q4/kBNN1KB1 w - - 0 1"}, list);
+    EXPECT_EQ(list.size(), 218ull);
+}
+
+TEST(MoveListTest, NoAllocation)
+{
+    State state{"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"};
+    MoveList list, replies;
+
+    size_t allocations;
+    {
+        AllocationCounter counter;
+        JChess::legalMoves(state, list);
+        for (auto move : list)
+        {
+            auto undo = state.makeMove(move);
+            JChess::legalMoves(state, replies);
+            state.unmakeMove(move, undo);
+        }
+        allocations = counter.count();
+    }
+    EXPECT_EQ(allocations, 0ull);
+    EXPECT_EQ(list.size(), 48ull);
+}
+
+TEST(MoveListTest, Stages)
+{
+    for (auto fen : {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                     "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+                     "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 b kq - 0 1",
+                     "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+                     "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"})
+    {
+        State state{fen};
+        MoveList all, captures, quiets, evasions;
+        JChess::legalMoves(state, all);
+        JChess::legalCaptures(state, captures);
+        JChess::legalQuiets(state, quiets);
+        JChess::legalEvasions(state, evasions);
+
+        EXPECT_EQ(captures.size() + quiets.size(), all.size()) << fen;
+        for (auto move : captures)
+        {
+            EXPECT_TRUE(all.contains(move)) << move.toUCI();
+            EXPECT_TRUE(move.isCapture() || move.isPromotion()) << move.toUCI();
+        }
+        for (auto move : quiets)
+        {
+            EXPECT_TRUE(all.contains(move)) << move.toUCI();
+            EXPECT_FALSE(move.isCapture() || move.isPromotion()) << move.toUCI();
+        }
+
+        EXPECT_EQ(evasions.size(), JChess::inCheck(state) ? all.size() : 0ull) << fen;
+        EXPECT_EQ(JChess::hasAnyLegalMove(state), !all.empty()) << fen;
+    }
+}
+
+TEST(MoveListTest, MateAndStalemate)
+{
+    State mate{"rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq - 1 3"};
+    EXPECT_TRUE(JChess::inCheck(mate));
+    EXPECT_FALSE(JChess::hasAnyLegalMove(mate));
+
+    State stalemate{"7k/5Q2/6K1/8/8/8/8/8 b - - 0 1"};
+    EXPECT_FALSE(JChess::inCheck(stalemate));
+    EXPECT_FALSE(JChess::hasAnyLegalMove(stalemate));
+
+    State check{"rnbqkbnr/ppppp2p/5p2/6pQ/4P3/8/PPPP1PPP/RNB1KBNR b KQkq - 1 3"};
+    EXPECT_TRUE(JChess::inCheck(check));
+    EXPECT_FALSE(JChess::hasAnyLegalMove(check)); // Fool's mate pattern, mirrored
+
+    State evade{"rnbqkbnr/ppppp1pp/5p2/7Q/4P3/8/PPPP1PPP/RNB1KBNR b KQkq - 1 2"};
+    MoveList evasions;
+    JChess::legalEvasions(evade, evasions);
+    EXPECT_TRUE(JChess::hasAnyLegalMove(evade));
+    EXPECT_EQ(evasions.size(), 1ull); // g7-g6
+}
@@ -0,0 +1,65 @@
+#include "core/packedMove.h"
+#include <gtest/gtest.h>
+
+#include "core/legalMoves.h"
+#include "core/state.h"
+
+using JChess::PackedMove, JChess::Square;
+
+TEST(PackedMoveTest, Layout)
+{
+    PackedMove e4{Square{4, 1}, Square{4, 3}, PackedMove::DoublePush};
+    EXPECT_EQ(e4.fromIdx(), JChess::Board::squareToIdx({4, 1}));
+    EXPECT_EQ(e4.toIdx(), JChess::Board::squareToIdx({4, 3}));
+    EXPECT_EQ(e4.raw(), 52u | (36u << 6) | (1u << 12));
+    EXPECT_EQ(PackedMove::fromRaw(e4.raw()), e4);
+    EXPECT_TRUE(e4.isDoublePush());
+    EXPECT_FALSE(e4.isCapture());
+    EXPECT_EQ(e4.toUCI(), "e2e4");
+
+    PackedMove promo{Square{1, 6}, Square{0, 7}, PackedMove::PromotionCapture | 2};
+    EXPECT_TRUE(promo.isPromotion());
+    EXPECT_TRUE(promo.isCapture());
+    EXPECT_FALSE(promo.isEnPassant());
+    EXPECT_EQ(promo.promotionType(), JChess::PieceType::Rook);
+    EXPECT_EQ(promo.toUCI(), "b7a8r");
+
+    PackedMove ep{Square{4, 4}, Square{3, 5}, PackedMove::EnPassant};
+    EXPECT_TRUE(ep.isCapture());
+    EXPECT_EQ(ep.enPassantCaptureSquare(), (Square{3, 4}));
+
+    PackedMove castle{Square{4, 0}, Square{2, 0}, PackedMove::QueenCastle};
+    EXPECT_EQ(castle.castle(), JChess::Castling::Side::QUEEN);
+    EXPECT_FALSE(castle.isCapture());
+    EXPECT_FALSE(e4.castle());
+
+    EXPECT_TRUE(PackedMove{}.isNull());
+}
+
+TEST(PackedMoveTest, RoundTrip)
+{
+    // Between them: castling both ways, promotions with and without capture, en passant
+    for (auto fen : {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                     "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 b kq - 0 1",
+                     "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3"})
+    {
+        JChess::State state{fen};
+        auto moves = JChess::legalMoves(state);
+        auto packed = JChess::legalPackedMoves(state);
+        ASSERT_EQ(moves.size(), packed.size()) << fen;
+
+        for (size_t i = 0; i < moves.size(); ++i)
+        {
+            const auto &move = moves[i];
+            EXPECT_EQ(PackedMove{move}, packed[i]) << move.toUCI();
+            EXPECT_EQ(packed[i].toUCI(), move.toUCI());
+
+            auto unpacked = PackedMove::fromRaw(packed[i].raw()).unpack(state.board);
+            EXPECT_EQ(unpacked, move);
+            EXPECT_EQ(unpacked.capture, move.capture) << move.toUCI();
+            EXPECT_EQ(unpacked.castle, move.castle) << move.toUCI();
+            EXPECT_EQ(unpacked.promotion, move.promotion) << move.toUCI();
+            EXPECT_EQ(unpacked.enPassant, move.enPassant) << move.toUCI();
+        }
+    }
+}
@@ -0,0 +1,125 @@
+#include "core/packedPosition.h"
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_set>
+
+#include "core/legalMoves.h"
+#include "core/state.h"
+
+using JChess::PackedPosition;
+using JChess::State;
+
+namespace
+{
+    // A mailbox of nibbles, built square by square
+    PackedPosition::Squares squaresOf(const State &state)
+    {
+        PackedPosition::Squares squares{};
+        const auto &occupants = state.board.eachOccupant();
+        for (size_t i = 0; i < 64; ++i)
+            if (const auto &piece = occupants[i])
+                squares[i / 2] |= static_cast<uint8_t>((1 + static_cast<int>(piece->color) * 6 + static_cast<int>(piece->type)) << (i % 2 * 4));
+        return squares;
+    }
+
+    void checkRoundTrip(const State &state)
+    {
+        PackedPosition packed{state};
+        auto squares = squaresOf(state);
+        EXPECT_EQ(packed.squares(), squares) << state.toFEN();
+
+        auto fromSquares = PackedPosition::fromSquares(squares);
+        EXPECT_EQ(fromSquares.occupancy, packed.occupancy) << state.toFEN();
+        EXPECT_EQ(fromSquares.pieces, packed.pieces) << state.toFEN();
+
+        auto unpacked = packed.unpack();
+        EXPECT_EQ(unpacked.board.toFen(), state.board.toFen());
+        EXPECT_EQ(unpacked.turn, state.turn);
+        EXPECT_EQ(unpacked.castleRights.get(), state.castleRights.get());
+        EXPECT_EQ(unpacked.halfTurnCounter, state.halfTurnCounter);
+        EXPECT_EQ(unpacked.fullTurnCounter, state.fullTurnCounter);
+        EXPECT_EQ(PackedPosition{unpacked}, packed);
+        EXPECT_EQ(JChess::legalMoves(unpacked).size(), JChess::legalMoves(state).size()) << state.toFEN();
+    }
+} // namespace
+
+TEST(PackedPositionTest, RoundTrips)
+{
+    for (std::string_view fen : {
+             JChess::FEN::startstate,
+             std::string_view{"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"},
+             std::string_view{"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"},
+             std::string_view{"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"},
+             std::string_view{"4k3/8/8/8/8/8/8/4K3 b - - 99 400"},
+         })
+    {
+        State state{fen};
+        checkRoundTrip(state);
+        // Every position one and two plies on
+        for (const auto &move : JChess::legalMoves(state))
+        {
+            State next = state;
+            next.applyMove(move);
+            checkRoundTrip(next);
+            for (const auto &reply : JChess::legalMoves(next))
+            {
+                State last = next;
+                last.applyMove(reply);
+                ASSERT_EQ(PackedPosition{last}.squares(), squaresOf(last)) << last.toFEN();
+            }
+        }
+    }
+}
+
+TEST(PackedPositionTest, Key)
+{
+    State state{"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"};
+    PackedPosition start{state};
+    EXPECT_EQ(JChess::Bitboards::count(start.occupancy), 32u);
+    EXPECT_EQ(start.flags, 0b11110);
+    EXPECT_EQ(start.enPassant, PackedPosition::noSquare);
+    EXPECT_EQ(start.unused, 0);
+
+    // The counters are not part of the position
+    PackedPosition later{State{"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 8 5"}};
+    EXPECT_EQ(later, start);
+    EXPECT_EQ(later.hash(), start.hash());
+    EXPECT_EQ(std::memcmp(&later, &start, PackedPosition::keySize), 0);
+    EXPECT_EQ(later.key(), start.key());
+    EXPECT_EQ(PackedPosition::fromKey(later.key()), start);
+    EXPECT_THROW(PackedPosition::fromKey("short"), std::runtime_error);
+
+    std::unordered_set<PackedPosition> seen{start};
+    for (std::string_view fen : {
+             "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR b KQkq - 0 1",
+             "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w Kkq - 0 1",
+             "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w - - 0 1",
+             "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBKQBNR w - - 0 1",
+         })
+        EXPECT_TRUE(seen.insert(PackedPosition{State{fen}}).second) << fen;
+    EXPECT_EQ(seen.size(), 5u);
+}
+
+TEST(PackedPositionTest, EnPassantOnlyWhenCapturable)
+{
+    // After 1. e4 no black pawn can take on e3
+    PackedPosition noCapture{State{"rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1"}};
+    EXPECT_EQ(noCapture.enPassant, PackedPosition::noSquare);
+    EXPECT_EQ(noCapture, PackedPosition{State{"rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1"}});
+
+    State capture{"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3"};
+    PackedPosition packed{capture};
+    EXPECT_EQ(packed.enPassantSquare(), capture.enPassant);
+    EXPECT_EQ(packed.unpack().hash(), capture.hash());
+}
+
+TEST(PackedPositionTest, TooManyPieces)
+{
+    EXPECT_THROW(PackedPosition{State{"pppppppp/pppppppp/pppppppp/pppppppp/3k4/3K4/8/8 w - - 0 1"}}, std::runtime_error);
+    PackedPosition::Squares squares;
+    squares.fill(0x11);
+    EXPECT_THROW(PackedPosition::fromSquares(squares), std::runtime_error);
+}
@@ -0,0 +1,121 @@
+#include "core/perft.h"
+#include <gtest/gtest.h>
+
+#include <array>
+#include <stdexcept>
+#include <string_view>
+
+using JChess::State;
+
+namespace
+{
+    struct PerftCase
+    {
+        std::string_view name;
+        std::string_view fen;
+        unsigned depth;
+        uint64_t nodes;
+    };
+
+    // Reference positions and node counts from https://www.chessprogramming.org/Perft_Results,
+    // at depths that keep the suite fast enough for every test run
+    constexpr PerftCase perftSuite[] = {
+        {"Initial", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 4, 197281},
+        {"Kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 3, 97862},
+        {"Position3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5, 674624},
+        {"Position4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 3, 9467},
+        {"Position4Mirrored", "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1", 3, 9467},
+        {"Position5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 3, 62379},
+        {"Position6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 3, 89890},
+    };
+}
+
+TEST(PerftTest, ShallowCounts)
+{
+    EXPECT_EQ(JChess::perft(State{perftSuite[0].fen}, 0), 1ull);
+    EXPECT_EQ(JChess::perft(State{perftSuite[0].fen}, 1), 20ull);
+    EXPECT_EQ(JChess::perft(State{perftSuite[1].fen}, 1), 48ull);
+    EXPECT_EQ(JChess::perft(State{perftSuite[1].fen}, 2), 2039ull);
+    EXPECT_EQ(JChess::perft(State{perftSuite[2].fen}, 1), 14ull);
+    EXPECT_EQ(JChess::perft(State{perftSuite[3].fen}, 1), 6ull);
+    EXPECT_EQ(JChess::perft(State{perftSuite[5].fen}, 1), 44ull);
+    EXPECT_EQ(JChess::perft(State{perftSuite[6].fen}, 1), 46ull);
+}
+
+TEST(PerftTest, Suite)
+{
+    for (const auto &c : perftSuite)
+        EXPECT_EQ(JChess::perft(State{c.fen}, c.depth), c.nodes) << c.name << " at depth " << c.depth;
+}
+
+TEST(PerftTest, Divide)
+{
+    State state{perftSuite[0].fen};
+    auto counts = JChess::perftDivide(state, 3);
+    ASSERT_EQ(counts.size(), 20ull);
+
+    uint64_t total = 0;
+    for (const auto &[move, count] : counts)
+    {
+        total += count;
+        if (move.toUCI() == "e2e4")
+        {
+            EXPECT_EQ(count, 600ull);
+        }
+        if (move.toUCI() == "g1f3")
+        {
+            EXPECT_EQ(count, 440ull);
+        }
+    }
+    EXPECT_EQ(total, 8902ull);
+}
+
+TEST(PerftTest, Parallel)
+{
+    for (const auto &c : perftSuite)
+    {
+        EXPECT_EQ(JChess::parallelPerft(State{c.fen}, c.depth, {.threads = 4}), c.nodes) << c.name;
+        EXPECT_EQ(JChess::parallelPerft(State{c.fen}, c.depth, {.threads = 3, .hashBytes = 1 << 20}), c.nodes)
+            << c.name << " with hash table";
+    }
+
+    EXPECT_EQ(JChess::parallelPerft(State{perftSuite[0].fen}, 0), 1ull);
+    EXPECT_EQ(JChess::parallelPerft(State{perftSuite[0].fen}, 1, {.threads = 2}), 20ull);
+}
+
+TEST(PerftTest, ParallelDivideMatchesSerial)
+{
+    State state{perftSuite[1].fen};
+    auto serial = JChess::perftDivide(state, 3);
+    auto parallel = JChess::parallelPerftDivide(state, 3, {.threads = 4, .hashBytes = 1 << 16});
+    ASSERT_EQ(parallel.size(), serial.size());
+    for (size_t i = 0; i < serial.size(); ++i)
+    {
+        EXPECT_EQ(parallel[i].first.toUCI(), serial[i].first.toUCI());
+        EXPECT_EQ(parallel[i].second, serial[i].second) << serial[i].first.toUCI();
+    }
+}
+
+TEST(PerftTest, EnumeratePositions)
+{
+    constexpr unsigned threads = 3;
+    std::array<uint64_t, threads> visits{};
+    auto count = JChess::enumeratePositions(
+        State{perftSuite[0].fen}, 3,
+        [&visits](const State &state, unsigned worker)
+        {
+            EXPECT_EQ(state.turn, JChess::Color::Black);
+            ++visits[worker];
+        },
+        threads);
+
+    EXPECT_EQ(count, 8902ull);
+    EXPECT_EQ(visits[0] + visits[1] + visits[2], 8902ull);
+
+    EXPECT_THROW(JChess::enumeratePositions(
+                     State{perftSuite[0].fen}, 2,
+                     [](const State &, unsigned)
+                     { throw std::runtime_error("stop"); },
+                     threads),
+                 std::runtime_error);
+}
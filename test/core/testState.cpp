@@ -0,0 +1,99 @@
+#include "core/state.h"
+#include <gtest/gtest.h>
+
+#include "core/legalMoves.h"
+
+using JChess::State;
+
+namespace
+{
+    void expectSameState(const State &actual, const State &expected)
+    {
+        EXPECT_EQ(actual.toFEN(), expected.toFEN());
+        EXPECT_EQ(actual.hash(), expected.hash());
+        for (auto square : JChess::Board::eachSquare())
+        {
+            EXPECT_EQ(actual.attacks.attackedBy(square), expected.attacks.attackedBy(square));
+            EXPECT_EQ(actual.attacks.attackers(square, JChess::Color::White),
+                      expected.attacks.attackers(square, JChess::Color::White));
+            EXPECT_EQ(actual.attacks.attackers(square, JChess::Color::Black),
+                      expected.attacks.attackers(square, JChess::Color::Black));
+        }
+    }
+
+    // Make and unmake every move to the given depth, checking that each unmake restores
+    // the state exactly and that each make matches a state built from scratch
+    void checkMakeUnmake(State &state, unsigned depth)
+    {
+        if (depth == 0)
+            return;
+
+        for (const auto &move : JChess::legalMoves(state))
+        {
+            const State before = state;
+            auto undo = state.makeMove(move);
+            EXPECT_EQ(state.hash(), State{state.toFEN()}.hash()) << move.toUCI();
+
+            checkMakeUnmake(state, depth - 1);
+
+            state.unmakeMove(move, undo);
+            if (state.toFEN() != before.toFEN() || state.hash() != before.hash())
+            {
+                ADD_FAILURE() << "unmaking " << move.toUCI() << " from " << before.toFEN();
+                return;
+            }
+        }
+    }
+}
+
+TEST(StateTest, MakeUnmake)
+{
+    for (auto fen : {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                     "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+                     "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"})
+    {
+        State state{fen};
+        const State original = state;
+        checkMakeUnmake(state, 3);
+        expectSameState(state, original);
+    }
+}
+
+TEST(StateTest, UndoRecord)
+{
+    // En passant capture: the captured pawn is not on the destination square
+    State state{"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3"};
+    const State original = state;
+
+    JChess::Move ep{.piece = {JChess::Color::White, JChess::PieceType::Pawn},
+                    .from = {4, 4},
+                    .to = {5, 5},
+                    .enPassant = true,
+                    .capture = JChess::Piece{JChess::Color::Black, JChess::PieceType::Pawn}};
+    auto undo = state.makeMove(ep);
+    EXPECT_EQ(undo.captured, ep.capture);
+    EXPECT_EQ(undo.enPassant, original.enPassant);
+    EXPECT_EQ(undo.halfTurnCounter, 0u);
+    EXPECT_EQ(undo.hash, original.hash());
+    EXPECT_EQ(state.toFEN(), "rnbqkbnr/ppp1p1pp/5P2/3p4/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 3");
+
+    state.unmakeMove(ep, undo);
+    expectSameState(state, original);
+}
+
+TEST(StateTest, CopiesAreIndependent)
+{
+    State original{};
+    State copy = original;
+
+    JChess::Move e4{.piece = {JChess::Color::White, JChess::PieceType::Pawn}, .from = {4, 1}, .to = {4, 3}};
+    copy.applyMove(e4);
+
+    // The copy's attacks follow its own board; the original's are untouched
+    EXPECT_EQ(copy.attacks.numAttackers({7, 4}, JChess::Color::White), 1ull); // Qd1-h5 opened
+    EXPECT_EQ(original.attacks.numAttackers({7, 4}, JChess::Color::White), 0ull);
+    EXPECT_EQ(copy.attacks.numAttackers({3, 4}, JChess::Color::White), 1ull);
+    EXPECT_EQ(original.attacks.numAttackers({3, 4}, JChess::Color::White), 0ull);
+    expectSameState(original, State{});
+    expectSameState(copy, State{copy.toFEN()});
+}
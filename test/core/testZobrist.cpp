@@ -0,0 +1,92 @@
+#include "core/zobrist.h"
+#include <gtest/gtest.h>
+
+#include "core/legalMoves.h"
+#include "core/state.h"
+
+using JChess::State;
+
+namespace
+{
+    uint64_t scratchHash(const State &state)
+    {
+        return JChess::Zobrist::hash(state.board, state.turn, state.castleRights, state.enPassant);
+    }
+
+    // Check the incremental key against a full recomputation at every node of the tree
+    void checkTree(const State &state, unsigned depth)
+    {
+        ASSERT_EQ(state.hash(), scratchHash(state)) << state.toFEN();
+        if (depth == 0)
+            return;
+
+        for (const auto &move : JChess::legalMoves(state))
+        {
+            State next = state;
+            next.applyMove(move);
+            checkTree(next, depth - 1);
+        }
+    }
+
+    State play(std::initializer_list<std::string_view> moves, std::string_view fen = JChess::FEN::startstate)
+    {
+        State state{fen};
+        for (auto uci : moves)
+        {
+            bool found = false;
+            for (const auto &move : JChess::legalMoves(state))
+            {
+                if (move.toUCI() == uci)
+                {
+                    state.applyMove(move);
+                    found = true;
+                    break;
+                }
+            }
+            EXPECT_TRUE(found) << uci;
+        }
+        return state;
+    }
+}
+
+TEST(ZobristTest, IncrementalMatchesScratch)
+{
+    // Castling, promotions, en passant and captures of rooks on their home squares
+    checkTree(State{"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"}, 3);
+    checkTree(State{"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"}, 3);
+    checkTree(State{"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"}, 4);
+}
+
+TEST(ZobristTest, Transpositions)
+{
+    auto a = play({"g1f3", "g8f6", "b1c3", "b8c6"});
+    auto b = play({"b1c3", "b8c6", "g1f3", "g8f6"});
+    EXPECT_EQ(a.hash(), b.hash());
+    EXPECT_EQ(a.hash(), State{a.toFEN()}.hash());
+
+    // Returning to the start position after a knight shuffle
+    auto c = play({"g1f3", "g8f6", "f3g1", "f6g8"});
+    EXPECT_EQ(c.hash(), State{}.hash());
+}
+
+TEST(ZobristTest, StateComponents)
+{
+    State start{};
+    EXPECT_NE(start.hash(), State{"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR b KQkq - 0 1"}.hash());
+    EXPECT_NE(start.hash(), State{"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w Qkq - 0 1"}.hash());
+    EXPECT_EQ(start.hash(), State{"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 5 9"}.hash());
+
+    // Same placement, with and without an en passant square
+    auto pushed = play({"e2e4"});
+    EXPECT_NE(pushed.hash(), State{"rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1"}.hash());
+    EXPECT_EQ(pushed.hash(), State{"rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1"}.hash());
+
+    // Rights lost by moving the king and back differ from the original position
+    auto shuffled = play({"e2e4", "e7e5", "e1e2", "e8e7", "e2e1", "e7e8"});
+    EXPECT_NE(shuffled.hash(), play({"e2e4", "e7e5"}).hash());
+
+    State copy = shuffled;
+    copy.castleRights.reset();
+    copy.rehash();
+    EXPECT_EQ(copy.hash(), scratchHash(copy));
+}
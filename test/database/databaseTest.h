@@ -0,0 +1,72 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include <vector>
+
+#include "core/game.h"
+#include "database/connection.h"
+#include "database/schema.h"
+#include "formats/pgnFile.h"
+#include "formats/pgnReader.h"
+
+namespace JChess::Database::Test
+{
+    // Two games sharing their first three positions
+    constexpr std::string_view games =
+        "[White \"alice\"]\n[Black \"bob\"]\n[Result \"1-0\"]\n[UTCDate \"2022.01.02\"]\n[UTCTime \"03:04:05\"]\n"
+        "[WhiteElo \"1500\"]\n[BlackElo \"?\"]\n[ECO \"C20\"]\n[TimeControl \"180+2\"]\n[Termination \"Normal\"]\n\n"
+        "1. e4 { [%clk 0:03:00] } 1... e5 { [%clk 0:03:00] } 2. Qh5 { [%clk 0:03:01] } 2... Nc6 { [%clk 0:03:01] } "
+        "3. Bc4 { [%clk 0:03:02] } 3... Nf6 { [%clk 0:03:02] } 4. Qxf7# { [%clk 0:03:03] } 1-0\n\n"
+        "[White \"bob\"]\n[Black \"carol\"]\n[Result \"1/2-1/2\"]\n[UTCDate \"2022.01.03\"]\n[UTCTime \"10:00:00\"]\n"
+        "[WhiteElo \"1600\"]\n[BlackElo \"1700\"]\n[ECO \"C20\"]\n[TimeControl \"60+0\"]\n[Termination \"Normal\"]\n\n"
+        "1. e4 e5 2. Nf3 Nc6 1/2-1/2\n\n";
+
+    inline std::vector<Game> readGames()
+    {
+        std::vector<Game> batch;
+        PGNReader reader{games};
+        while (const auto *pgnGame = reader.next())
+            batch.push_back(readPGN(*pgnGame));
+        return batch;
+    }
+
+    /* Runs against the database named by JCHESS_TEST_DATABASE (a conninfo string), in a
+     * schema of its own that is dropped afterwards, and is skipped without one.
+     */
+    class DatabaseTest : public ::testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            const char *conninfo = std::getenv("JCHESS_TEST_DATABASE");
+            if (!conninfo)
+                GTEST_SKIP() << "JCHESS_TEST_DATABASE is not set";
+            conn.emplace(conninfo);
+            auto name = "jchess_test_" + std::to_string(getpid());
+            // For connections of their own, given a conninfo of keywords rather than a URI
+            schemaConninfo = std::string{conninfo} + " options='-csearch_path=" + name + "'";
+            conn->exec(("CREATE SCHEMA " + name + "; SET search_path TO " + name).c_str());
+            conn->exec(schema);
+            schemaName = name;
+        }
+
+        void TearDown() override
+        {
+            if (conn && !schemaName.empty())
+                conn->exec(("DROP SCHEMA " + schemaName + " CASCADE").c_str());
+        }
+
+        int64_t count(const char *sql) { return std::stoll(std::string{conn->exec(sql).value(0, 0)}); }
+
+        std::optional<Connection> conn;
+        std::string schemaName;
+        std::string schemaConninfo;
+    };
+} // namespace JChess::Database::Test
@@ -0,0 +1,109 @@
+#include "database/bulkLoader.h"
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+
+#include "core/state.h"
+#include "database/ingestPipeline.h"
+#include "databaseTest.h"
+
+using JChess::Database::Test::games;
+
+class BulkLoaderTest : public JChess::Database::Test::DatabaseTest
+{
+};
+
+TEST_F(BulkLoaderTest, LoadsGamesMovesAndPositions)
+{
+    auto batch = JChess::Database::Test::readGames();
+    ASSERT_EQ(batch.size(), 2u);
+
+    JChess::Database::PositionDictionary dictionary;
+    JChess::Database::BulkLoader loader{*conn, dictionary};
+    auto stats = loader.load(batch);
+    EXPECT_EQ(stats.games, 2u);
+    EXPECT_EQ(stats.moves, 11u);
+    // The second game shares its first three positions with the first
+    EXPECT_EQ(stats.newPositions, 8u);
+
+    EXPECT_EQ(count("SELECT count(*) FROM games"), 2);
+    EXPECT_EQ(count("SELECT count(*) FROM moves"), 11);
+    EXPECT_EQ(count("SELECT count(*) FROM positions"), 8);
+    EXPECT_EQ(count("SELECT count(*) FROM games WHERE blackELO IS NULL AND timeLimit = '3 minutes'"), 1);
+    EXPECT_EQ(count("SELECT count(*) FROM moves WHERE timeLeft IS NOT NULL"), 7);
+    // Every move but the last of each game links to the next, and back
+    EXPECT_EQ(count("SELECT count(*) FROM moves a JOIN moves b ON a.nextMoveID = b.moveID "
+                    "WHERE b.prevMoveID = a.moveID AND b.moveNumber = a.moveNumber + 1 AND a.gameID = b.gameID"),
+              9);
+
+    // Loading them again adds games and moves, but no positions
+    stats = loader.load(batch);
+    EXPECT_EQ(stats.newPositions, 0u);
+    EXPECT_EQ(count("SELECT count(*) FROM games"), 4);
+    EXPECT_EQ(count("SELECT count(*) FROM positions"), 8);
+    EXPECT_EQ(dictionary.size(), 8u);
+
+    // So does a loader that has not seen them, learning their IDs from the server
+    JChess::Database::PositionDictionary cold;
+    JChess::Database::BulkLoader other{*conn, cold};
+    stats = other.load(batch);
+    EXPECT_EQ(stats.newPositions, 0u);
+    EXPECT_EQ(count("SELECT count(*) FROM positions"), 8);
+    ASSERT_EQ(cold.size(), 8u);
+
+    JChess::Database::PositionDictionary warmed;
+    EXPECT_EQ(warmed.warm(*conn), 8u);
+    EXPECT_EQ(warmed.find(JChess::PackedPosition{JChess::State{}}), cold.find(JChess::PackedPosition{JChess::State{}}));
+    EXPECT_EQ(warmed.find(JChess::PackedPosition{JChess::State{}}), dictionary.find(JChess::PackedPosition{JChess::State{}}));
+}
+
+TEST_F(BulkLoaderTest, Pipeline)
+{
+    using JChess::Database::Params;
+    using JChess::Database::Statement;
+    constexpr Statement echo{"test_echo", "SELECT $1"};
+    constexpr Statement divide{"test_divide", "SELECT 1 / $1"};
+
+    auto results = conn->pipeline({{&echo, Params{}.int64(7)}, {&echo, Params{}.int64(2)}});
+    ASSERT_EQ(results.size(), 2u);
+    EXPECT_EQ(results[0].integer(0, 0), 7);
+    EXPECT_EQ(results[1].integer(0, 0), 2);
+    EXPECT_THROW(conn->pipeline({{&echo, Params{}.int64(1)}, {&divide, Params{}.int64(0)}, {&echo, Params{}.int64(3)}}), std::runtime_error);
+    // Still usable afterwards
+    EXPECT_EQ(count("SELECT 5"), 5);
+}
+
+TEST_F(BulkLoaderTest, IngestPipeline)
+{
+    // Many small batches, written by several connections at once
+    std::string text;
+    for (int i = 0; i < 50; ++i)
+        text += std::string{"[Event \"Test\"]\n"} + std::string{games};
+    std::istringstream input{text};
+
+    JChess::Database::PositionDictionary dictionary;
+    JChess::OpeningExplorerBuilder explorer;
+    JChess::Database::IngestOptions options{.parsers = 2, .replayers = 2, .writers = 3, .batchBytes = 1000, .queueBatches = 1, .explorer = &explorer};
+    JChess::Database::IngestPipeline pipeline{schemaConninfo, input, dictionary, options};
+    auto loaded = pipeline.wait();
+    EXPECT_EQ(explorer.games(), 100u);
+    EXPECT_EQ(loaded.games, 100u);
+    EXPECT_EQ(loaded.moves, 550u);
+    EXPECT_EQ(loaded.newPositions, 8u);
+    EXPECT_EQ(dictionary.size(), 8u);
+
+    auto stats = pipeline.stats();
+    EXPECT_EQ(stats[JChess::Database::IngestStage::Write].games, 100u);
+    EXPECT_GT(stats[JChess::Database::IngestStage::Read].batches, 1u);
+    EXPECT_EQ(count("SELECT count(*) FROM games"), 100);
+    EXPECT_EQ(count("SELECT count(*) FROM positions"), 8);
+}
+
+TEST_F(BulkLoaderTest, IngestPipelineError)
+{
+    std::istringstream input{std::string{games}};
+    JChess::Database::PositionDictionary dictionary;
+    JChess::Database::IngestPipeline pipeline{schemaConninfo + " port=1", input, dictionary};
+    EXPECT_THROW(pipeline.wait(), std::runtime_error);
+}
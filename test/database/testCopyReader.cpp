@@ -0,0 +1,55 @@
+#include "database/copyReader.h"
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "database/copyWriter.h"
+
+using JChess::Database::CopyReader;
+using JChess::Database::CopyWriter;
+
+TEST(CopyReaderTest, ReadsWhatCopyWriterWrites)
+{
+    CopyWriter copy;
+    auto headerSize = copy.size();
+    copy.row(3);
+    copy.int64(-5);
+    copy.bytes("ab");
+    copy.null();
+    std::string data = copy.finish();
+
+    CopyReader reader;
+    // The header on its own, then the row with the trailer
+    reader.feed(std::string_view{data}.substr(0, headerSize));
+    EXPECT_EQ(reader.row(), 0u);
+    reader.feed(std::string_view{data}.substr(headerSize));
+    ASSERT_EQ(reader.row(), 3u);
+    EXPECT_EQ(reader.int64(), -5);
+    EXPECT_EQ(reader.field(), "ab");
+    EXPECT_EQ(reader.field(), std::nullopt);
+    EXPECT_EQ(reader.row(), 0u);
+
+    // The header and the row together
+    reader.feed(data);
+    ASSERT_EQ(reader.row(), 3u);
+    EXPECT_EQ(reader.int64(), -5);
+}
+
+TEST(CopyReaderTest, Malformed)
+{
+    CopyWriter copy;
+    copy.row(1);
+    copy.text("abc");
+    std::string data = copy.finish();
+
+    CopyReader reader;
+    reader.feed(std::string_view{data}.substr(0, data.size() - 4));
+    ASSERT_EQ(reader.row(), 1u);
+    EXPECT_THROW(reader.field(), std::runtime_error);
+
+    reader.feed(data);
+    ASSERT_EQ(reader.row(), 1u);
+    EXPECT_THROW(reader.int64(), std::runtime_error);
+}
@@ -0,0 +1,58 @@
+#include "database/copyWriter.h"
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+#include <string_view>
+
+using JChess::Database::CopyWriter;
+using namespace std::string_view_literals;
+
+TEST(CopyWriterTest, HeaderAndTrailer)
+{
+    CopyWriter copy;
+    EXPECT_EQ(std::string_view{copy.finish()}, "PGCOPY\n\377\r\n\0\0\0\0\0\0\0\0\0\377\377"sv);
+}
+
+TEST(CopyWriterTest, Fields)
+{
+    CopyWriter copy;
+    auto headerSize = copy.size();
+    copy.row(3);
+    copy.int16(-2);
+    copy.int64(0x0102030405060708);
+    copy.null();
+    copy.row(2);
+    copy.text("ab");
+    copy.boolean(true);
+    const auto &data = copy.finish();
+
+    EXPECT_EQ(data.substr(headerSize),
+              "\0\3"
+              "\0\0\0\2\377\376"
+              "\0\0\0\10\1\2\3\4\5\6\7\10"
+              "\377\377\377\377"
+              "\0\2"
+              "\0\0\0\2ab"
+              "\0\0\0\1\1"
+              "\377\377"sv);
+
+    copy.clear();
+    EXPECT_EQ(copy.size(), headerSize);
+}
+
+TEST(CopyWriterTest, Times)
+{
+    using namespace std::chrono;
+    CopyWriter copy;
+    auto headerSize = copy.size();
+    // One second after the Postgres epoch, 2000-01-01
+    copy.timestamp(sys_days{2000y / January / 1} + seconds{1});
+    copy.interval(milliseconds{1500});
+    const auto &data = copy.finish();
+
+    EXPECT_EQ(data.substr(headerSize),
+              "\0\0\0\10\0\0\0\0\0\17\102\100"
+              "\0\0\0\20\0\0\0\0\0\26\343\140\0\0\0\0\0\0\0\0"
+              "\377\377"sv);
+}
@@ -0,0 +1,76 @@
+#include "database/games.h"
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "core/state.h"
+#include "database/bulkLoader.h"
+#include "database/connectionPool.h"
+#include "databaseTest.h"
+
+using JChess::PackedPosition;
+using JChess::State;
+
+class GamesTest : public JChess::Database::Test::DatabaseTest
+{
+};
+
+TEST_F(GamesTest, InsertGame)
+{
+    auto batch = JChess::Database::Test::readGames();
+    EXPECT_EQ(JChess::Database::findPosition(*conn, PackedPosition{State{}}), 0);
+
+    auto first = JChess::Database::insertGame(*conn, batch[0]);
+    auto second = JChess::Database::insertGame(*conn, batch[1]);
+    EXPECT_NE(first, second);
+    EXPECT_GT(JChess::Database::findPosition(*conn, PackedPosition{State{}}), 0);
+
+    EXPECT_EQ(count("SELECT count(*) FROM games"), 2);
+    EXPECT_EQ(count("SELECT count(*) FROM moves"), 11);
+    EXPECT_EQ(count("SELECT count(*) FROM positions"), 8);
+    EXPECT_EQ(count("SELECT count(*) FROM moves WHERE timeLeft IS NOT NULL"), 7);
+    EXPECT_EQ(count("SELECT count(*) FROM moves a JOIN moves b ON a.nextMoveID = b.moveID "
+                    "WHERE b.prevMoveID = a.moveID AND b.moveNumber = a.moveNumber + 1 AND a.gameID = b.gameID"),
+              9);
+    EXPECT_EQ(count("SELECT count(*) FROM games WHERE winner = 'draw' AND blackELO = 1700"), 1);
+}
+
+TEST_F(GamesTest, ConnectionPool)
+{
+    auto batch = JChess::Database::Test::readGames();
+    // Two games that reach the same two positions in opposite orders, with the knights on f3
+    // and f6 and on c3 and c6, which writers adding positions as played could deadlock on
+    JChess::PGNReader reader{"[Result \"1/2-1/2\"]\n\n1. Nf3 Nf6 2. Ng1 Ng8 3. Nc3 Nc6 4. Nb1 1/2-1/2\n\n"
+                             "[Result \"1/2-1/2\"]\n\n1. Nc3 Nc6 2. Nb1 Nb8 3. Nf3 Nf6 4. Ng1 1/2-1/2\n\n"};
+    while (const auto *pgnGame = reader.next())
+        batch.push_back(JChess::readPGN(*pgnGame));
+    ASSERT_EQ(batch.size(), 4u);
+
+    JChess::Database::ConnectionPool pool{schemaConninfo, 2};
+    {
+        std::vector<std::jthread> threads;
+        for (int t = 0; t < 4; ++t)
+            threads.emplace_back([&, t]
+                                 {
+                                     for (int i = 0; i < 8; ++i)
+                                     {
+                                         auto lease = pool.acquire();
+                                         JChess::Database::insertGame(*lease, batch[(t + i) % 4]);
+                                     }
+                                 });
+    }
+    EXPECT_LE(pool.open(), 2u);
+    EXPECT_EQ(count("SELECT count(*) FROM games"), 32);
+    JChess::Database::BatchPositions positions;
+    JChess::Database::PositionDictionary scratch;
+    positions.collect(batch, scratch);
+    EXPECT_EQ(count("SELECT count(*) FROM positions"), static_cast<int64_t>(positions.positions.size()));
+
+    // A connection left in a transaction is closed rather than reused
+    {
+        auto lease = pool.acquire();
+        lease->exec("BEGIN");
+    }
+    EXPECT_LE(pool.open(), 1u);
+}
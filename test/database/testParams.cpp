@@ -0,0 +1,49 @@
+#include "database/params.h"
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string_view>
+
+using JChess::Database::Params;
+using namespace std::string_view_literals;
+
+namespace
+{
+    std::string_view value(const Params &params, size_t i)
+    {
+        return {params.values()[i], static_cast<size_t>(params.lengths()[i])};
+    }
+} // namespace
+
+TEST(ParamsTest, TypesAndValues)
+{
+    Params params;
+    params.int16(-2).int32(7).int64(0x0102030405060708).boolean(true).text("ab").bytes("\0\1"sv).null();
+    ASSERT_EQ(params.size(), 7u);
+
+    const Oid types[] = {21, 23, 20, 16, 25, 17, 0};
+    for (size_t i = 0; i < params.size(); ++i)
+    {
+        EXPECT_EQ(params.types()[i], types[i]) << i;
+        EXPECT_EQ(params.formats()[i], 1) << i;
+    }
+    EXPECT_EQ(value(params, 0), "\377\376"sv);
+    EXPECT_EQ(value(params, 1), "\0\0\0\7"sv);
+    EXPECT_EQ(value(params, 2), "\1\2\3\4\5\6\7\10"sv);
+    EXPECT_EQ(value(params, 3), "\1"sv);
+    EXPECT_EQ(value(params, 4), "ab"sv);
+    EXPECT_EQ(value(params, 5), "\0\1"sv);
+    EXPECT_EQ(params.values()[6], nullptr);
+    EXPECT_EQ(params.lengths()[6], -1);
+}
+
+TEST(ParamsTest, Times)
+{
+    using namespace std::chrono;
+    Params params;
+    params.timestamp(sys_days{2000y / January / 2}).interval(seconds{3});
+    EXPECT_EQ(params.types()[0], 1114u);
+    EXPECT_EQ(value(params, 0), "\0\0\0\24\35\327\140\0"sv); // a day in microseconds
+    EXPECT_EQ(params.types()[1], 1186u);
+    EXPECT_EQ(value(params, 1), "\0\0\0\0\0\55\306\300\0\0\0\0\0\0\0\0"sv);
+}
@@ -0,0 +1,97 @@
+#include "database/positionDictionary.h"
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "core/legalMoves.h"
+#include "core/state.h"
+
+using JChess::PackedPosition;
+using JChess::State;
+using JChess::Database::PositionDictionary;
+
+namespace
+{
+    // Every position up to three plies from the start, with repeats
+    std::vector<PackedPosition> openingPositions()
+    {
+        std::vector<PackedPosition> positions;
+        std::vector<State> frontier{State{}};
+        for (int ply = 0; ply < 3; ++ply)
+        {
+            std::vector<State> next;
+            for (const auto &state : frontier)
+            {
+                positions.emplace_back(state);
+                for (const auto &move : JChess::legalMoves(state))
+                {
+                    next.push_back(state);
+                    next.back().applyMove(move);
+                }
+            }
+            frontier = std::move(next);
+        }
+        for (const auto &state : frontier)
+            positions.emplace_back(state);
+        return positions;
+    }
+} // namespace
+
+TEST(PositionDictionaryTest, InsertAndFind)
+{
+    PositionDictionary dictionary;
+    PackedPosition start{State{}};
+    EXPECT_EQ(dictionary.find(start), 0);
+    EXPECT_TRUE(dictionary.insert(start, 7));
+    EXPECT_EQ(dictionary.find(start), 7);
+    EXPECT_FALSE(dictionary.insert(start, 8));
+    EXPECT_EQ(dictionary.find(start), 7);
+    EXPECT_EQ(dictionary.size(), 1u);
+
+    // The clocks are not part of the key
+    State later{"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 10 20"};
+    EXPECT_EQ(dictionary.find(PackedPosition{later}), 7);
+
+    EXPECT_EQ(dictionary.find(PackedPosition{State{"8/8/8/4k3/8/8/8/4K3 w - - 0 1"}}), 0);
+    EXPECT_THROW(dictionary.insert(PackedPosition{later}, 0), std::runtime_error);
+}
+
+TEST(PositionDictionaryTest, MatchesAMap)
+{
+    auto positions = openingPositions();
+    PositionDictionary dictionary;
+    std::unordered_map<PackedPosition, int64_t> expected;
+    for (const auto &position : positions)
+    {
+        auto id = static_cast<int64_t>(expected.size() + 1);
+        EXPECT_EQ(dictionary.insert(position, id), expected.try_emplace(position, id).second);
+    }
+    ASSERT_EQ(expected.size(), 5783u);
+    EXPECT_EQ(dictionary.size(), expected.size());
+    for (const auto &[position, id] : expected)
+        EXPECT_EQ(dictionary.find(position), id);
+    // Slots at most three quarters full, entries 40 bytes
+    EXPECT_LE(dictionary.memoryUsage(), dictionary.size() * (40 + 8 * 8 / 3) * 2);
+
+    auto usage = dictionary.memoryUsage();
+    dictionary.clear();
+    EXPECT_EQ(dictionary.size(), 0u);
+    EXPECT_EQ(dictionary.memoryUsage(), usage);
+    for (const auto &[position, id] : expected)
+        EXPECT_EQ(dictionary.find(position), 0);
+}
+
+TEST(PositionDictionaryTest, Reserve)
+{
+    auto positions = openingPositions();
+    PositionDictionary dictionary;
+    dictionary.reserve(positions.size());
+    auto usage = dictionary.memoryUsage();
+    int64_t id = 0;
+    for (const auto &position : positions)
+        dictionary.insert(position, ++id);
+    EXPECT_EQ(dictionary.memoryUsage(), usage);
+    EXPECT_EQ(dictionary.find(positions.front()), 1);
+}
@@ -0,0 +1,162 @@
+#include "formats/algebraic.h"
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+
+#include "core/board.h"
+#include "core/legalMoves.h"
+#include "core/state.h"
+
+using JChess::PackedMove;
+using JChess::State;
+using JChess::Algebraic::SANResolver;
+
+namespace
+{
+    std::string uci(const State &state, std::string_view san)
+    {
+        return SANResolver{state}.resolve(san).toUCI();
+    }
+} // namespace
+
+TEST(AlgebraicTest, Disambiguation)
+{
+    State knights{"4k3/8/8/8/8/5N2/8/1N2K3 w - - 0 1"};
+    EXPECT_EQ(uci(knights, "Nbd2"), "b1d2");
+    EXPECT_EQ(uci(knights, "Nfd2"), "f3d2");
+    EXPECT_EQ(uci(knights, "Nf3xd2"), "f3d2");
+    EXPECT_THROW(uci(knights, "Nd2"), std::runtime_error);
+
+    State rooks{"4k3/8/8/R7/8/8/8/R3K3 w - - 0 1"};
+    EXPECT_EQ(uci(rooks, "R1a3"), "a1a3");
+    EXPECT_EQ(uci(rooks, "R5a3+"), "a5a3");
+    EXPECT_THROW(uci(rooks, "Raa3"), std::runtime_error);
+
+    // Two queens share a file and two share a rank: the square is needed
+    State queens{"4k3/8/8/8/8/Q7/8/Q1Q1K3 w - - 0 1"};
+    EXPECT_EQ(uci(queens, "Qa1b2"), "a1b2");
+    EXPECT_EQ(uci(queens, "Qcb2"), "c1b2");
+    EXPECT_EQ(uci(queens, "Q3b2"), "a3b2");
+    EXPECT_THROW(uci(queens, "Qab2"), std::runtime_error);
+    EXPECT_THROW(uci(queens, "Q1b2"), std::runtime_error);
+}
+
+TEST(AlgebraicTest, PinsEnPassantPromotionCastling)
+{
+    // The knight on c3 is pinned, so "Ne2" is not ambiguous
+    State pinned{"4k3/8/8/4b3/8/2N5/8/K5N1 w - - 0 1"};
+    EXPECT_EQ(uci(pinned, "Ne2"), "g1e2");
+    EXPECT_THROW(uci(pinned, "Nce2"), std::runtime_error);
+
+    State enPassant{"4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1"};
+    auto move = SANResolver{enPassant}.resolve("exd6");
+    EXPECT_TRUE(move.isEnPassant());
+    auto full = JChess::Algebraic::fromSAN(enPassant, "exd6");
+    EXPECT_TRUE(full.enPassant);
+    EXPECT_EQ(full.capture, (JChess::Piece{JChess::Color::Black, JChess::PieceType::Pawn}));
+
+    State promotion{"1r2k3/P7/8/8/8/8/8/4K3 w - - 0 1"};
+    EXPECT_EQ(uci(promotion, "a8=Q"), "a7a8q");
+    EXPECT_EQ(uci(promotion, "a8Q"), "a7a8q");
+    EXPECT_EQ(uci(promotion, "axb8=N+"), "a7b8n");
+    EXPECT_TRUE(SANResolver{promotion}.resolve("axb8=R").isCapture());
+    EXPECT_THROW(uci(promotion, "a8"), std::runtime_error);
+    EXPECT_THROW(uci(promotion, "a8=K"), std::runtime_error);
+
+    State castling{"r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1"};
+    EXPECT_EQ(SANResolver{castling}.resolve("O-O").castle(), JChess::Castling::Side::KING);
+    EXPECT_EQ(SANResolver{castling}.resolve("O-O-O+").castle(), JChess::Castling::Side::QUEEN);
+    EXPECT_EQ(SANResolver{castling}.resolve("0-0").castle(), JChess::Castling::Side::KING);
+    EXPECT_THROW(uci(castling, "Kg1"), std::runtime_error);
+    EXPECT_THROW(uci(State{"r3k2r/8/8/8/8/8/8/R3K2R w - - 0 1"}, "O-O"), std::runtime_error);
+}
+
+TEST(AlgebraicTest, Malformed)
+{
+    State start;
+    for (auto san : {"", "e", "e9", "i4", "Zf3", "Nxx3", "Ng1f3f", "O-O-O-O", "exd"})
+        EXPECT_THROW(uci(start, san), std::runtime_error) << san;
+    EXPECT_EQ(uci(start, "e4!?"), "e2e4");
+    EXPECT_EQ(uci(start, "Nf3"), "g1f3");
+}
+
+TEST(AlgebraicTest, EveryLegalMoveResolves)
+{
+    // With the from square spelled out, every legal move must resolve to itself
+    for (auto fen : {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                     "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+                     "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+                     "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1"})
+    {
+        State state{fen};
+        SANResolver resolver{state};
+        for (auto move : resolver.legalMoves())
+        {
+            std::string san;
+            if (move.castle())
+                san = (move.castle() == JChess::Castling::Side::KING) ? "O-O" : "O-O-O";
+            else
+            {
+                auto piece = state.board.get(move.from()).value();
+                if (piece.type != JChess::PieceType::Pawn)
+                    san += "?NBRQK"[static_cast<int>(piece.type)];
+                auto uciMove = move.toUCI();
+                san += uciMove.substr(0, 2);
+                if (move.isCapture())
+                    san += 'x';
+                san += uciMove.substr(2, 2);
+                if (move.isPromotion())
+                    san += std::string("=") + "?NBRQ"[static_cast<int>(move.promotionType())];
+            }
+            EXPECT_EQ(resolver.resolve(san), move) << fen << " " << san;
+        }
+    }
+}
+
+TEST(AlgebraicTest, WriteSAN)
+{
+    auto san = [](std::string_view fen, std::string_view uciMove)
+    {
+        State state{fen};
+        // Named: g++ 12 does not extend the life of a temporary in a range-for (P2718)
+        SANResolver resolver{state};
+        for (auto move : resolver.legalMoves())
+            if (move.toUCI() == uciMove)
+                return JChess::Algebraic::toSAN(state, move);
+        return std::string("not legal");
+    };
+
+    EXPECT_EQ(san(JChess::FEN::startstate, "g1f3"), "Nf3");
+    EXPECT_EQ(san(JChess::FEN::startstate, "e2e4"), "e4");
+    EXPECT_EQ(san("4k3/8/8/8/8/5N2/8/1N2K3 w - - 0 1", "b1d2"), "Nbd2");
+    EXPECT_EQ(san("4k3/8/8/R7/8/8/8/R3K3 w - - 0 1", "a5a3"), "R5a3");
+    EXPECT_EQ(san("4k3/8/8/8/8/Q7/8/Q1Q1K3 w - - 0 1", "a1b2"), "Qa1b2");
+    EXPECT_EQ(san("4k3/8/8/8/8/Q7/8/Q1Q1K3 w - - 0 1", "c1b2"), "Qcb2");
+    EXPECT_EQ(san("4k3/8/8/8/8/Q7/8/Q1Q1K3 w - - 0 1", "a3b2"), "Q3b2");
+    // The pinned knight on c3 does not count
+    EXPECT_EQ(san("4k3/8/8/4b3/8/2N5/8/K5N1 w - - 0 1", "g1e2"), "Ne2");
+    EXPECT_EQ(san("4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1", "e5d6"), "exd6");
+    EXPECT_EQ(san("1r2k3/P7/8/8/8/8/8/4K3 w - - 0 1", "a7b8n"), "axb8=N");
+    EXPECT_EQ(san("1r2k3/P7/8/8/8/8/8/4K3 w - - 0 1", "a7a8q"), "a8=Q");
+    EXPECT_EQ(san("4k3/P7/8/8/8/8/8/4K3 w - - 0 1", "a7a8q"), "a8=Q+");
+    EXPECT_EQ(san("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1", "e1c1"), "O-O-O");
+    EXPECT_EQ(san("r1bqkbnr/pppp1ppp/2n5/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - 2 3", "h5f7"), "Qxf7#");
+    EXPECT_EQ(san("6k1/5ppp/8/8/8/8/8/R3K3 w Q - 0 1", "e1c1"), "O-O-O");
+    EXPECT_EQ(san("6k1/5ppp/8/8/8/8/8/R3K3 w Q - 0 1", "a1a8"), "Ra8#");
+}
+
+TEST(AlgebraicTest, WrittenSANResolves)
+{
+    // Every legal move's SAN resolves back to it, so the disambiguation is always enough
+    for (auto fen : {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                     "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+                     "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1",
+                     "4k3/8/8/8/8/Q7/8/Q1Q1K3 w - - 0 1"})
+    {
+        State state{fen};
+        SANResolver resolver{state};
+        for (auto move : resolver.legalMoves())
+            EXPECT_EQ(resolver.resolve(JChess::Algebraic::toSAN(state, move)), move) << fen << " " << move.toUCI();
+    }
+}
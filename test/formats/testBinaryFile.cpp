@@ -0,0 +1,216 @@
+#include "formats/binaryFile.h"
+#include <gtest/gtest.h>
+
+#include <array>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "core/legalMoves.h"
+#include "formats/algebraic.h"
+#include "formats/pgnFile.h"
+#include "formats/pgnReader.h"
+
+using JChess::BinaryVersion;
+using JChess::Evaluation;
+using JChess::msDuration;
+
+namespace
+{
+    constexpr std::string_view italianGame =
+        "[White \"Alice\"]\n"
+        "[Black \"Bob\"]\n"
+        "[Result \"0-1\"]\n"
+        "[UTCDate \"2023.07.08\"]\n"
+        "[UTCTime \"19:20:21\"]\n"
+        "[WhiteElo \"1843\"]\n"
+        "[BlackElo \"1907\"]\n"
+        "[ECO \"C50\"]\n"
+        "[TimeControl \"300+3\"]\n"
+        "[Termination \"Time forfeit\"]\n"
+        "\n"
+        "1. e4 { [%eval 0.2] [%clk 0:05:00] } 1... e5 { [%eval 0.25] [%clk 0:05:00] } "
+        "2. Nf3 { [%eval 0.2] [%clk 0:05:01] } 2... Nc6 { [%eval 0.22] [%clk 0:05:02] } "
+        "3. Bc4 { [%eval 0.15] [%clk 0:05:02] } 3... Bc5 { [%eval 0.3] [%clk 0:05:03] } "
+        "4. O-O { [%eval 0.1] [%clk 0:04:58] } 4... Nf6 { [%eval 0.18] [%clk 0:04:59] } "
+        "5. d3 { [%eval 0.12] [%clk 0:04:55] } 5... d6 { [%eval 0.2] [%clk 0:04:50] } "
+        "6. c3 { [%eval 0.05] [%clk 0:04:40] } 6... O-O { [%eval 0.1] [%clk 0:04:45] } "
+        "7. Bg5 { [%eval -0.3] [%clk 0:04:30] } 7... h6 { [%eval -0.25] [%clk 0:04:41] } "
+        "8. Bh4 { [%eval -0.35] [%clk 0:04:25] } 8... g5 { [%eval 1.5] [%clk 0:04:33] } "
+        "9. Nxg5 { [%eval -12.5] [%clk 0:04:00] } 9... hxg5 { [%eval -13.1] [%clk 0:04:30] } "
+        "10. Bxg5 { [%eval #-4] [%clk 0:03:10] } 10... Bxf2+ { [%eval #-3] [%clk 0:04:28] } 0-1\n";
+
+    JChess::Game sampleGame()
+    {
+        JChess::PGNReader reader{italianGame};
+        return JChess::readPGN(*reader.next());
+    }
+
+    void expectSameGame(const JChess::Game &read, const JChess::Game &expected)
+    {
+        EXPECT_EQ(read.whiteUsername, expected.whiteUsername);
+        EXPECT_EQ(read.blackUsername, expected.blackUsername);
+        EXPECT_EQ(read.datetime, expected.datetime);
+        EXPECT_EQ(read.whiteELO, expected.whiteELO);
+        EXPECT_EQ(read.blackELO, expected.blackELO);
+        EXPECT_EQ(read.ECOCode, expected.ECOCode);
+        EXPECT_EQ(read.timeControl.initial, expected.timeControl.initial);
+        EXPECT_EQ(read.timeControl.increment, expected.timeControl.increment);
+        EXPECT_EQ(read.result.type, expected.result.type);
+        EXPECT_EQ(read.result.reason, expected.result.reason);
+        EXPECT_EQ(read.moves, expected.moves);
+        EXPECT_EQ(read.clocks, expected.clocks);
+        ASSERT_EQ(read.evaluations.has_value(), expected.evaluations.has_value());
+        if (read.evaluations)
+            for (size_t i = 0; i < read.evaluations->size(); ++i)
+            {
+                EXPECT_EQ(read.evaluations->at(i).value, expected.evaluations->at(i).value) << i;
+                EXPECT_EQ(read.evaluations->at(i).centipawns, expected.evaluations->at(i).centipawns) << i;
+            }
+    }
+} // namespace
+
+TEST(BinaryFileTest, RoundTripVersion1)
+{
+    auto game = sampleGame();
+    std::string out;
+    JChess::writeBinary(out, game, BinaryVersion::V1);
+    EXPECT_TRUE(out.starts_with("PGP1"));
+
+    std::string_view input{out};
+    expectSameGame(JChess::readBinary(input), game);
+    EXPECT_TRUE(input.empty());
+
+    // From a stream, followed by a version 2 game
+    game.evaluations.reset();
+    JChess::writeBinary(out, game, BinaryVersion::V1);
+    JChess::writeBinary(out, game);
+    std::istringstream stream{out};
+    JChess::readBinary(stream);
+    expectSameGame(JChess::readBinary(stream), game);
+    expectSameGame(JChess::readBinary(stream), game);
+    EXPECT_EQ(stream.peek(), std::char_traits<char>::eof());
+}
+
+TEST(BinaryFileTest, RoundTripVersion2)
+{
+    auto game = sampleGame();
+    game.clocks->at(3) = msDuration{301500};
+    game.annotations.emplace(game.moves.size(), JChess::Annotation::None);
+    game.annotations->at(17) = JChess::Annotation::Blunder;
+
+    // Two games back to back, the second from a FEN and without annotations
+    JChess::Game endgame;
+    endgame.startFEN = "8/8/8/4k3/8/8/4P3/4K3 b - - 0 1";
+    endgame.moves = {JChess::Algebraic::fromSAN(JChess::State{endgame.startFEN}, "Kd5")};
+    endgame.ECOCode = "?";
+    endgame.result.type = JChess::GameResult::Type::Draw;
+
+    std::string out;
+    JChess::writeBinary(out, game);
+    JChess::writeBinary(out, endgame);
+    EXPECT_TRUE(out.starts_with("PGN2"));
+
+    std::string_view input{out};
+    auto read = JChess::readBinary(input);
+    expectSameGame(read, game);
+    EXPECT_EQ(read.annotations, game.annotations);
+
+    read = JChess::readBinary(input);
+    expectSameGame(read, endgame);
+    EXPECT_EQ(read.startFEN, endgame.startFEN);
+    EXPECT_FALSE(read.annotations);
+    EXPECT_TRUE(input.empty());
+
+    std::istringstream stream{out};
+    expectSameGame(JChess::readBinary(stream), game);
+    expectSameGame(JChess::readBinary(stream), endgame);
+}
+
+TEST(BinaryFileTest, SubsecondTimeControl)
+{
+    // The clocks are coded from the initial time, which must come back exactly
+    auto game = sampleGame();
+    game.timeControl.initial = msDuration{1500};
+    game.timeControl.increment = msDuration{250};
+    for (size_t i = 0; i < game.clocks->size(); ++i)
+        game.clocks->at(i) = msDuration{static_cast<uint32_t>(1500 - 10 * i)};
+
+    std::string out;
+    JChess::writeBinary(out, game);
+    std::string_view input{out};
+    expectSameGame(JChess::readBinary(input), game);
+}
+
+TEST(BinaryFileTest, Version2Size)
+{
+    // A blitz game of typical length, with evaluations and clocks on every move
+    JChess::Game game = sampleGame();
+    game.moves.clear();
+    game.evaluations.emplace();
+    game.clocks.emplace();
+    JChess::State state;
+    std::array<uint32_t, 2> clocks{300000, 300000};
+    for (size_t ply = 0; ply < 80; ++ply)
+    {
+        auto legal = JChess::legalMoves(state);
+        if (legal.empty())
+            break;
+        auto move = legal[(ply * 7 + 3) % legal.size()];
+        game.moves.push_back(move);
+        state.applyMove(move);
+        clocks[ply % 2] -= static_cast<uint32_t>((ply * 5 % 11) * 1000) - 3000;
+        game.clocks->push_back(msDuration{clocks[ply % 2]});
+        game.evaluations->push_back(Evaluation{.value = static_cast<int32_t>(ply * 13 % 70) - 30});
+    }
+
+    std::string v1, v2;
+    JChess::writeBinary(v1, game, BinaryVersion::V1);
+    JChess::writeBinary(v2, game, BinaryVersion::V2);
+    EXPECT_LT(v2.size() * 3, v1.size()) << v1.size() << " vs " << v2.size();
+
+    std::string_view input{v2};
+    expectSameGame(JChess::readBinary(input), game);
+}
+
+TEST(BinaryFileTest, EvaluationQuantization)
+{
+    // Large evaluations are kept to a tenth of a pawn
+    auto game = sampleGame();
+    game.evaluations->at(0) = Evaluation{.value = 2345};
+    game.evaluations->at(1) = Evaluation{.value = -99999};
+    std::string out;
+    JChess::writeBinary(out, game);
+    std::string_view input{out};
+    auto read = JChess::readBinary(input);
+    EXPECT_EQ(read.evaluations->at(0).value, 2350);
+    EXPECT_EQ(read.evaluations->at(1).value, -30000);
+    EXPECT_EQ(read.evaluations->at(19).value, -3);
+    EXPECT_FALSE(read.evaluations->at(19).centipawns);
+}
+
+TEST(BinaryFileTest, InvalidInput)
+{
+    std::string out;
+    JChess::writeBinary(out, sampleGame());
+
+    for (size_t length : {size_t{0}, size_t{3}, size_t{6}, out.size() - 1})
+    {
+        std::string_view truncated{out.data(), length};
+        EXPECT_THROW(JChess::readBinary(truncated), std::runtime_error) << length;
+        std::istringstream stream{std::string{truncated}};
+        EXPECT_THROW(JChess::readBinary(stream), std::runtime_error) << length;
+    }
+
+    std::string_view unknown{"PGN9"};
+    EXPECT_THROW(JChess::readBinary(unknown), std::runtime_error);
+    // Version 1 before moves were `PackedMove`s
+    std::string_view legacy{"PGN1\x06\x00\x06\x00"};
+    EXPECT_THROW(JChess::readBinary(legacy), std::runtime_error);
+
+    auto illegal = sampleGame();
+    illegal.clocks.reset();
+    illegal.evaluations.reset();
+    illegal.moves.push_back(illegal.moves.front());
+    EXPECT_THROW(JChess::writeBinary(out, illegal), std::runtime_error);
+}
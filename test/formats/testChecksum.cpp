@@ -0,0 +1,29 @@
+#include "formats/checksum.h"
+#include <gtest/gtest.h>
+
+#include <string>
+
+using JChess::crc32c;
+
+TEST(ChecksumTest, StandardVector)
+{
+    EXPECT_EQ(crc32c(""), 0u);
+    EXPECT_EQ(crc32c("123456789"), 0xE3069283u);
+    // 32 zero bytes, from RFC 3720
+    EXPECT_EQ(crc32c(std::string(32, '\0')), 0x8A9136AAu);
+}
+
+TEST(ChecksumTest, Continuation)
+{
+    // Long enough for the eight-byte loop, with an unaligned tail
+    std::string data;
+    for (int i = 0; i < 1000; ++i)
+        data += static_cast<char>(i * 31 + 7);
+
+    for (size_t split : {0, 1, 7, 8, 9, 500, 999, 1000})
+    {
+        auto a = data.substr(0, split), b = data.substr(split);
+        EXPECT_EQ(crc32c(b, crc32c(a)), crc32c(data)) << split;
+    }
+    EXPECT_EQ(crc32c("6789", crc32c("12345")), 0xE3069283u);
+}
@@ -0,0 +1,138 @@
+#include "formats/compressedInput.h"
+#include "formats/pgnReader.h"
+#include <gtest/gtest.h>
+
+#include <bzlib.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <zstd.h>
+
+using JChess::Compression;
+using JChess::DecompressionOptions;
+using JChess::InputFile;
+
+namespace
+{
+    std::string games(size_t count)
+    {
+        std::string text;
+        for (size_t i = 0; i < count; ++i)
+            text += "[Event \"Game " + std::to_string(i) + "\"]\n[Result \"0-1\"]\n\n"
+                    "1. e4 { [%clk 0:03:00] } 1... e5 { [%clk 0:03:00] } 2. Qh5 Nc6 3. Bc4 Nf6 4. Qxf7# 0-1\n\n";
+        return text;
+    }
+
+    std::string zstdFrames(std::string_view text, size_t frameBytes)
+    {
+        std::string compressed;
+        for (size_t pos = 0; pos < text.size(); pos += frameBytes)
+        {
+            auto piece = text.substr(pos, frameBytes);
+            std::string frame(ZSTD_compressBound(piece.size()), '\0');
+            frame.resize(ZSTD_compress(frame.data(), frame.size(), piece.data(), piece.size(), 3));
+            compressed += frame;
+        }
+        return compressed;
+    }
+
+    std::string bzip2Streams(std::string_view text, size_t streamBytes)
+    {
+        std::string compressed;
+        for (size_t pos = 0; pos < text.size(); pos += streamBytes)
+        {
+            auto piece = text.substr(pos, streamBytes);
+            std::string stream(piece.size() + piece.size() / 100 + 600, '\0');
+            auto size = static_cast<unsigned>(stream.size());
+            BZ2_bzBuffToBuffCompress(stream.data(), &size, const_cast<char *>(piece.data()),
+                                     static_cast<unsigned>(piece.size()), 9, 0, 0);
+            stream.resize(size);
+            compressed += stream;
+        }
+        return compressed;
+    }
+
+    class CompressedInputTest : public testing::Test
+    {
+    protected:
+        void TearDown() override { std::filesystem::remove(path); }
+
+        void write(std::string_view contents)
+        {
+            std::ofstream file{path, std::ios::binary};
+            file << contents;
+        }
+
+        std::string readAll(DecompressionOptions options, Compression expected)
+        {
+            InputFile input{path, options};
+            EXPECT_EQ(input.compression(), expected);
+            return {std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+        }
+
+        std::filesystem::path path = std::filesystem::temp_directory_path() / ("jchess-test-compressed-" + std::to_string(getpid()));
+    };
+} // namespace
+
+TEST_F(CompressedInputTest, Detect)
+{
+    EXPECT_EQ(JChess::detectCompression("\x28\xB5\x2F\xFD..."), Compression::Zstd);
+    EXPECT_EQ(JChess::detectCompression("BZh91AY"), Compression::Bzip2);
+    EXPECT_EQ(JChess::detectCompression("[Event"), Compression::None);
+    EXPECT_EQ(JChess::detectCompression(""), Compression::None);
+
+    EXPECT_THROW(InputFile{"/nonexistent/games.pgn.zst"}, std::runtime_error);
+}
+
+TEST_F(CompressedInputTest, RoundTrip)
+{
+    auto text = games(400);
+    DecompressionOptions small{.bufferBytes = 1000, .buffersInFlight = 2, .threads = 3};
+
+    write(text);
+    EXPECT_EQ(readAll(small, Compression::None), text);
+
+    // One stream, frames decompressed in parallel, and frames read as one stream
+    write(zstdFrames(text, text.size()));
+    EXPECT_EQ(readAll(small, Compression::Zstd), text);
+    write(zstdFrames(text, 5000));
+    EXPECT_EQ(readAll(small, Compression::Zstd), text);
+    EXPECT_EQ(readAll({.threads = 1}, Compression::Zstd), text);
+
+    write(bzip2Streams(text, text.size()));
+    EXPECT_EQ(readAll(small, Compression::Bzip2), text);
+    write(bzip2Streams(text, 7000));
+    EXPECT_EQ(readAll(small, Compression::Bzip2), text);
+}
+
+TEST_F(CompressedInputTest, FeedsPGNReader)
+{
+    write(zstdFrames(games(300), 4096));
+    InputFile input{path, {.bufferBytes = 512, .threads = 2}};
+    JChess::PGNReader reader{input, 100};
+
+    size_t count = 0;
+    while (const auto *game = reader.next())
+    {
+        EXPECT_EQ(game->tag("Event"), "Game " + std::to_string(count));
+        EXPECT_EQ(game->moves.size(), 7ull);
+        ++count;
+    }
+    EXPECT_EQ(count, 300ull);
+}
+
+TEST_F(CompressedInputTest, Truncated)
+{
+    auto text = games(100);
+    for (auto compressed : {zstdFrames(text, text.size()), zstdFrames(text, 2000), bzip2Streams(text, text.size())})
+    {
+        write(compressed.substr(0, compressed.size() - 10));
+        InputFile input{path, {.bufferBytes = 1000, .threads = 2}};
+        std::string read;
+        EXPECT_THROW(read.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()),
+                     std::runtime_error);
+    }
+}
@@ -0,0 +1,136 @@
+#include "formats/fenParser.h"
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include <vector>
+
+#include "core/legalMoves.h"
+
+using JChess::FEN::Error;
+using JChess::FEN::Position;
+
+namespace
+{
+    std::string writeFEN(const Position &position)
+    {
+        char buffer[JChess::FEN::maxLength];
+        return {buffer, JChess::FEN::write(position, buffer)};
+    }
+
+    Error parseError(std::string_view fen)
+    {
+        Position position;
+        return JChess::FEN::parse(fen, position);
+    }
+} // namespace
+
+TEST(FENParserTest, RoundTrips)
+{
+    for (std::string_view fen : {
+             JChess::FEN::startstate,
+             std::string_view{"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"},
+             std::string_view{"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"},
+             std::string_view{"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3"},
+             std::string_view{"rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b Kq e3 0 1"},
+             std::string_view{"4k3/8/8/8/8/8/8/4K3 b - - 99 65535"},
+         })
+    {
+        Position position;
+        ASSERT_EQ(JChess::FEN::parse(fen, position), Error::None) << fen;
+        EXPECT_EQ(writeFEN(position), fen);
+
+        JChess::State state{fen};
+        EXPECT_EQ(JChess::FEN::fromState(state), position) << fen;
+        auto converted = JChess::FEN::toState(position);
+        EXPECT_EQ(converted.toFEN(), fen);
+        EXPECT_EQ(converted.hash(), state.hash());
+        EXPECT_EQ(JChess::legalMoves(converted).size(), JChess::legalMoves(state).size());
+
+        auto packed = JChess::FEN::pack(position);
+        EXPECT_EQ(packed, JChess::PackedPosition{state}) << fen;
+        EXPECT_EQ(JChess::FEN::unpack(packed).pieces, position.pieces);
+    }
+}
+
+TEST(FENParserTest, Defaults)
+{
+    Position position;
+    ASSERT_EQ(JChess::FEN::parse("  rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -\n", position), Error::None);
+    EXPECT_EQ(position, JChess::FEN::fromState(JChess::State{}));
+
+    char buffer[JChess::FEN::maxLength];
+    EXPECT_EQ(std::string_view(buffer, JChess::FEN::writeEPD(position, buffer)), "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -");
+}
+
+TEST(FENParserTest, Errors)
+{
+    EXPECT_EQ(parseError(""), Error::MissingField);
+    EXPECT_EQ(parseError("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR"), Error::MissingField);
+    EXPECT_EQ(parseError("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNX w - - 0 1"), Error::Piece);
+    EXPECT_EQ(parseError("rnbqkbnr/ppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w - - 0 1"), Error::RankLength);
+    EXPECT_EQ(parseError("rnbqkbnr/ppppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w - - 0 1"), Error::RankLength);
+    EXPECT_EQ(parseError("rnbqkbnr/pppppppp/9/8/8/8/PPPPPPPP/RNBQKBNR w - - 0 1"), Error::Piece);
+    EXPECT_EQ(parseError("rnbqkbnr/pppppppp/8/8/8/PPPPPPPP/RNBQKBNR w - - 0 1"), Error::RankCount);
+    EXPECT_EQ(parseError("rnbqkbnr/pppppppp/8/8/8/8/8/PPPPPPPP/RNBQKBNR w - - 0 1"), Error::RankCount);
+    EXPECT_EQ(parseError("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQQBNR w - - 0 1"), Error::KingCount);
+    EXPECT_EQ(parseError("rnbqkbnr/pppppppp/8/8/8/P7/PPPPPPPP/RNBQKBNR w - - 0 1"), Error::PieceCount);
+    EXPECT_EQ(parseError("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR x - - 0 1"), Error::SideToMove);
+    EXPECT_EQ(parseError("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KK - 0 1"), Error::Castling);
+    EXPECT_EQ(parseError("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkqx - 0 1"), Error::Castling);
+    EXPECT_EQ(parseError("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w - e3 0 1"), Error::EnPassant);
+    EXPECT_EQ(parseError("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w - e6 0 1"), Error::EnPassant);
+    EXPECT_EQ(parseError("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w - - x 1"), Error::HalfmoveClock);
+    EXPECT_EQ(parseError("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w - - 70000 1"), Error::HalfmoveClock);
+    EXPECT_EQ(parseError("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w - - 0"), Error::FullmoveNumber);
+    EXPECT_EQ(parseError("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w - - 0 0"), Error::FullmoveNumber);
+    EXPECT_EQ(parseError("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w - - 0 1 x"), Error::TrailingText);
+    EXPECT_FALSE(JChess::FEN::describe(Error::TrailingText).empty());
+}
+
+TEST(FENParserTest, EPD)
+{
+    Position position;
+    std::string_view operations;
+    ASSERT_EQ(JChess::FEN::parseEPD("1k1r4/pp1b1R2/3q2pp/4p3/2B5/4Q3/PPP2B2/2K5 b - - bm Qd1+; id \"BK.01; quoted\"; hmvc 3; fmvn 40;",
+                                    position, operations),
+              Error::None);
+    EXPECT_EQ(operations, "bm Qd1+; id \"BK.01; quoted\"; hmvc 3; fmvn 40;");
+    EXPECT_EQ(position.halfmoveClock, 3);
+    EXPECT_EQ(position.fullmoveNumber, 40);
+    EXPECT_EQ(writeFEN(position), "1k1r4/pp1b1R2/3q2pp/4p3/2B5/4Q3/PPP2B2/2K5 b - - 3 40");
+
+    ASSERT_EQ(JChess::FEN::parseEPD("4k3/8/8/8/8/8/8/4K3 w - - 5 9 c0;", position, operations), Error::None);
+    EXPECT_EQ(operations, "c0;");
+    EXPECT_EQ(position.fullmoveNumber, 9);
+    EXPECT_EQ(JChess::FEN::parseEPD("4k3/8/8/8/8/8/8/4K3 w - - hmvc x;", position, operations), Error::HalfmoveClock);
+}
+
+TEST(FENParserTest, Batch)
+{
+    auto path = std::filesystem::temp_directory_path() / ("jchess-test-positions-" + std::to_string(getpid()) + ".epd");
+    {
+        std::ofstream file{path, std::ios::binary};
+        file << "# a comment\r\n"
+             << "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - bm e4;\r\n"
+             << "\n"
+             << "not a position\n"
+             << "4k3/8/8/8/8/8/8/4K3 w - - 0 1\n"
+             << "4k3/8/8/8/8/8/8/4K3 w - e4 id \"bad\";";
+    }
+
+    auto batch = JChess::FEN::readEPD(path);
+    std::filesystem::remove(path);
+
+    ASSERT_EQ(batch.positions.size(), 2u);
+    EXPECT_EQ(batch.positions[0], JChess::FEN::fromState(JChess::State{}));
+    EXPECT_EQ(writeFEN(batch.positions[1]), "4k3/8/8/8/8/8/8/4K3 w - - 0 1");
+    ASSERT_EQ(batch.failures.size(), 2u);
+    EXPECT_EQ(batch.failures[0].line, 4u);
+    EXPECT_EQ(batch.failures[0].error, Error::Piece);
+    EXPECT_EQ(batch.failures[1].line, 6u);
+    EXPECT_EQ(batch.failures[1].error, Error::EnPassant);
+}
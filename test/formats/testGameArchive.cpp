@@ -0,0 +1,151 @@
+#include "formats/gameArchive.h"
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+#include "core/legalMoves.h"
+#include "core/state.h"
+
+using JChess::GameArchive;
+using JChess::GameArchiveWriter;
+
+namespace
+{
+    // A game of `plies` moves, the choice of each varied by `seed`
+    JChess::Game makeGame(size_t seed, size_t plies)
+    {
+        JChess::Game game;
+        game.whiteUsername = "white" + std::to_string(seed);
+        game.blackUsername = "black";
+        game.whiteELO = static_cast<uint16_t>(1000 + seed);
+        game.result.type = JChess::GameResult::Type::Draw;
+        JChess::State state;
+        for (size_t ply = 0; ply < plies; ++ply)
+        {
+            auto legal = JChess::legalMoves(state);
+            if (legal.empty())
+                break;
+            auto move = legal[(ply * 7 + seed) % legal.size()];
+            game.moves.push_back(move);
+            state.applyMove(move);
+        }
+        return game;
+    }
+
+    class GameArchiveTest : public ::testing::Test
+    {
+    protected:
+        void TearDown() override { std::filesystem::remove(path); }
+
+        void write(size_t games, uint32_t gamesPerBlock)
+        {
+            GameArchiveWriter writer{path, gamesPerBlock};
+            for (size_t i = 0; i < games; ++i)
+                writer.add(makeGame(i, i % 50));
+            writer.finish();
+            EXPECT_EQ(writer.gamesWritten(), games);
+        }
+
+        void corrupt(std::streamoff offset)
+        {
+            std::fstream file{path, std::ios::in | std::ios::out | std::ios::binary};
+            file.seekg(offset);
+            char c = static_cast<char>(file.get() ^ 0x5A);
+            file.seekp(offset);
+            file.put(c);
+        }
+
+        std::filesystem::path path = std::filesystem::temp_directory_path() / ("jchess-test-archive-" + std::to_string(getpid()));
+    };
+} // namespace
+
+TEST_F(GameArchiveTest, RandomAccess)
+{
+    write(1000, 64);
+    auto archive = GameArchive::open(path);
+    ASSERT_EQ(archive.size(), 1000ull);
+    archive.verify();
+
+    for (size_t i : {999, 0, 63, 64, 500, 127, 128, 998})
+    {
+        auto game = archive.game(i);
+        auto expected = makeGame(i, i % 50);
+        EXPECT_EQ(game.whiteUsername, expected.whiteUsername) << i;
+        EXPECT_EQ(game.whiteELO, expected.whiteELO) << i;
+        EXPECT_EQ(game.moves, expected.moves) << i;
+    }
+    EXPECT_THROW(archive.game(1000), std::out_of_range);
+}
+
+TEST_F(GameArchiveTest, EmptyAndPartialBlocks)
+{
+    write(0, 16);
+    EXPECT_EQ(GameArchive::open(path).size(), 0ull);
+
+    write(17, 16);
+    auto archive = GameArchive::open(path);
+    EXPECT_EQ(archive.size(), 17ull);
+    EXPECT_EQ(archive.game(16).moves, makeGame(16, 16).moves);
+    EXPECT_EQ(archive.game(15).moves, makeGame(15, 15).moves);
+}
+
+TEST_F(GameArchiveTest, DamagedArchives)
+{
+    write(100, 10);
+    auto size = static_cast<std::streamoff>(std::filesystem::file_size(path));
+
+    // A damaged block is only noticed when one of its games is read
+    corrupt(20);
+    {
+        auto archive = GameArchive::open(path);
+        EXPECT_THROW(archive.game(0), std::runtime_error);
+        EXPECT_NO_THROW(archive.game(10));
+        EXPECT_THROW(archive.verify(), std::runtime_error);
+    }
+    corrupt(20);
+
+    // So is a damaged block entry, which opening does not read
+    auto indexOffset = size - 32 - 10 * 16 - 100 * 4;
+    corrupt(indexOffset + 5);
+    {
+        auto archive = GameArchive::open(path);
+        EXPECT_THROW(archive.game(0), std::runtime_error);
+        EXPECT_NO_THROW(archive.game(10));
+        EXPECT_THROW(archive.verify(), std::runtime_error);
+    }
+    corrupt(indexOffset + 5);
+
+    // A damaged game offset is caught by the index checksum in `verify`
+    corrupt(size - 40);
+    EXPECT_THROW(GameArchive::open(path).verify(), std::runtime_error);
+    corrupt(size - 40);
+
+    // A damaged trailer or header is noticed on opening
+    for (auto offset : {size - 1, size - 30, std::streamoff{0}})
+    {
+        corrupt(offset);
+        EXPECT_THROW(GameArchive::open(path), std::runtime_error) << offset;
+        corrupt(offset);
+    }
+    EXPECT_NO_THROW(GameArchive::open(path).verify());
+
+    // A game count that wraps the index size around to the real one: 20 bytes a game, one
+    // game a block
+    {
+        std::fstream file{path, std::ios::in | std::ios::out | std::ios::binary};
+        uint64_t gameCount = 28 + (uint64_t{1} << 62);
+        uint32_t gamesPerBlock = 1;
+        file.seekp(size - 24);
+        file.write(reinterpret_cast<const char *>(&gameCount), sizeof(gameCount));
+        file.write(reinterpret_cast<const char *>(&gamesPerBlock), sizeof(gamesPerBlock));
+    }
+    EXPECT_THROW(GameArchive::open(path), std::runtime_error);
+
+    std::filesystem::resize_file(path, static_cast<uintmax_t>(size - 8));
+    EXPECT_THROW(GameArchive::open(path), std::runtime_error);
+}
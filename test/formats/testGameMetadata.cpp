@@ -0,0 +1,166 @@
+#include "formats/gameMetadata.h"
+#include <gtest/gtest.h>
+
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using JChess::GameMetadata;
+using JChess::GameMetadataWriter;
+using JChess::GameResult;
+using JChess::MetadataFilter;
+
+namespace
+{
+    std::vector<JChess::Game> makeGames(size_t count)
+    {
+        std::vector<JChess::Game> games(count);
+        uint64_t seed = 12345;
+        auto next = [&seed](uint64_t bound)
+        {
+            seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+            return (seed >> 33) % bound;
+        };
+        constexpr std::array<uint32_t, 6> bases{15, 60, 180, 300, 600, 1800};
+        for (auto &game : games)
+        {
+            game.whiteUsername = "player" + std::to_string(next(50));
+            game.blackUsername = "player" + std::to_string(next(50));
+            game.whiteELO = static_cast<uint16_t>(800 + next(2200));
+            game.blackELO = static_cast<uint16_t>(800 + next(2200));
+            game.timeControl.initial = JChess::msDuration{bases[next(bases.size())] * 1000};
+            game.timeControl.increment = JChess::msDuration{static_cast<uint32_t>(next(4) * 1000)};
+            game.ECOCode = std::string{static_cast<char>('A' + next(5)), static_cast<char>('0' + next(10)), static_cast<char>('0' + next(10))};
+            game.datetime = std::chrono::sys_seconds{std::chrono::seconds{1600000000 + next(100000000)}};
+            game.result.type = static_cast<GameResult::Type>(next(4));
+            game.result.reason = static_cast<GameResult::Reason>(next(8));
+        }
+        return games;
+    }
+
+    class GameMetadataTest : public ::testing::Test
+    {
+    protected:
+        void TearDown() override { std::filesystem::remove(path); }
+
+        GameMetadata write(const std::vector<JChess::Game> &games)
+        {
+            GameMetadataWriter writer{path};
+            for (const auto &game : games)
+                writer.add(game);
+            writer.finish();
+            return GameMetadata{path};
+        }
+
+        std::filesystem::path path = std::filesystem::temp_directory_path() / ("jchess-test-metadata-" + std::to_string(getpid()));
+    };
+} // namespace
+
+TEST_F(GameMetadataTest, FiltersMatchGames)
+{
+    auto games = makeGames(1000);
+    auto metadata = write(games);
+    ASSERT_EQ(metadata.size(), games.size());
+    EXPECT_EQ(metadata.white(7), games[7].whiteUsername);
+    EXPECT_EQ(metadata.blackELO(999), games[999].blackELO);
+    EXPECT_EQ(metadata.datetime(500), games[500].datetime);
+
+    using namespace std::chrono;
+    sys_seconds from = sys_days{2022y / January / 1}, to = sys_days{2023y / January / 1} - seconds{1};
+    auto blitz = JChess::estimatedSeconds(JChess::Speed::Blitz);
+
+    std::vector<std::pair<MetadataFilter, std::function<bool(const JChess::Game &)>>> cases;
+    cases.push_back({{}, [](const auto &) { return true; }});
+    cases.push_back({{.ELO = JChess::Range<uint16_t>{.min = 2200}}, [](const auto &g)
+                     { return g.whiteELO >= 2200 && g.blackELO >= 2200; }});
+    cases.push_back({{.whiteELO = JChess::Range<uint16_t>{1500, 1600}, .blackELO = JChess::Range<uint16_t>{.max = 1200}}, [](const auto &g)
+                     { return g.whiteELO >= 1500 && g.whiteELO <= 1600 && g.blackELO <= 1200; }});
+    cases.push_back({{.estimatedSeconds = blitz, .datetime = JChess::Range<sys_seconds>{from, to}}, [&](const auto &g)
+                     {
+                         auto estimated = g.timeControl.initial.count() / 1000 + 40 * (g.timeControl.increment.count() / 1000);
+                         return estimated >= blitz.min && estimated <= blitz.max && g.datetime >= from && g.datetime <= to;
+                     }});
+    cases.push_back({{.baseSeconds = JChess::Range<uint16_t>{60, 60}, .incrementSeconds = JChess::Range<uint16_t>{.min = 2}}, [](const auto &g)
+                     { return g.timeControl.initial.count() == 60000 && g.timeControl.increment.count() >= 2000; }});
+    cases.push_back({{.ECO = JChess::Range<uint16_t>{JChess::ecoIndex("B20"), JChess::ecoIndex("B99")}}, [](const auto &g)
+                     { return g.ECOCode >= "B20" && g.ECOCode <= "B99"; }});
+    cases.push_back({MetadataFilter{}.acceptResults(std::nullopt, GameResult::Reason::Checkmate), [](const auto &g)
+                     { return g.result.reason == GameResult::Reason::Checkmate; }});
+    cases.push_back({MetadataFilter{.ELO = JChess::Range<uint16_t>{.min = 1800}}.acceptResults(GameResult::Type::WhiteWins, std::nullopt).acceptResults(GameResult::Type::Draw, GameResult::Reason::Stalemate), [](const auto &g)
+                     { return g.whiteELO >= 1800 && g.blackELO >= 1800 &&
+                              (g.result.type == GameResult::Type::WhiteWins ||
+                               (g.result.type == GameResult::Type::Draw && g.result.reason == GameResult::Reason::Stalemate)); }});
+    cases.push_back({{.player = "player7"}, [](const auto &g)
+                     { return g.whiteUsername == "player7" || g.blackUsername == "player7"; }});
+    cases.push_back({{.white = "player3", .black = "player4"}, [](const auto &g)
+                     { return g.whiteUsername == "player3" && g.blackUsername == "player4"; }});
+    cases.push_back({{.white = "nobody"}, [](const auto &) { return false; }});
+    cases.push_back({{.whiteELO = JChess::Range<uint16_t>{2000, 1000}}, [](const auto &) { return false; }});
+
+    for (size_t c = 0; c < cases.size(); ++c)
+    {
+        const auto &[filter, matches] = cases[c];
+        std::vector<uint64_t> expected;
+        for (size_t i = 0; i < games.size(); ++i)
+            if (matches(games[i]))
+                expected.push_back(i);
+        EXPECT_EQ(metadata.select(filter), expected) << "case " << c;
+        EXPECT_EQ(metadata.count(filter), expected.size()) << "case " << c;
+    }
+}
+
+TEST_F(GameMetadataTest, EmptyAndInvalid)
+{
+    auto metadata = write({});
+    EXPECT_EQ(metadata.size(), 0ull);
+    EXPECT_TRUE(metadata.select({}).empty());
+    EXPECT_FALSE(metadata.userID("anyone"));
+
+    std::filesystem::resize_file(path, 100);
+    EXPECT_THROW(GameMetadata{path}, std::runtime_error);
+    {
+        std::ofstream file{path, std::ios::binary | std::ios::trunc};
+        file << "not a sidecar at all, but long enough to have a header if it were one. " << std::string(200, ' ');
+    }
+    EXPECT_THROW(GameMetadata{path}, std::runtime_error);
+}
+
+TEST_F(GameMetadataTest, DamagedSidecar)
+{
+    write(makeGames(100));
+    auto patch = [&](std::streamoff offset, auto value)
+    {
+        std::fstream file{path, std::ios::in | std::ios::out | std::ios::binary};
+        auto original = value;
+        file.seekg(offset);
+        file.read(reinterpret_cast<char *>(&original), sizeof(original));
+        file.seekp(offset);
+        file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+        return original;
+    };
+
+    // The username offsets: "JCMETA01", two counts, then the tenth section's offset
+    uint64_t offsets = 0;
+    {
+        std::ifstream file{path, std::ios::binary};
+        file.seekg(8 + 16 + 9 * 16);
+        file.read(reinterpret_cast<char *>(&offsets), sizeof(offsets));
+    }
+    auto second = patch(static_cast<std::streamoff>(offsets + 4), uint32_t{1} << 30);
+    EXPECT_THROW(GameMetadata{path}, std::runtime_error);
+    patch(static_cast<std::streamoff>(offsets + 4), second);
+    auto first = patch(static_cast<std::streamoff>(offsets), uint32_t{1});
+    EXPECT_THROW(GameMetadata{path}, std::runtime_error);
+    patch(static_cast<std::streamoff>(offsets), first);
+    EXPECT_NO_THROW(GameMetadata{path});
+
+    // A game count whose padding would wrap around
+    patch(8, ~uint64_t{0});
+    EXPECT_THROW(GameMetadata{path}, std::runtime_error);
+}
@@ -0,0 +1,230 @@
+#include "formats/openingExplorer.h"
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include <vector>
+
+#include "core/legalMoves.h"
+#include "core/state.h"
+#include "formats/pgnFile.h"
+#include "formats/pgnReader.h"
+
+using JChess::ExplorerFilter;
+using JChess::OpeningExplorer;
+using JChess::OpeningExplorerBuilder;
+
+namespace
+{
+    // Blitz at a 1600 average, bullet at 2300, one unrated without a time control, and an
+    // unfinished one, which is not counted
+    constexpr std::string_view games =
+        "[Result \"1-0\"]\n[UTCDate \"2022.01.02\"]\n[UTCTime \"03:04:05\"]\n"
+        "[WhiteElo \"1500\"]\n[BlackElo \"1700\"]\n[TimeControl \"180+2\"]\n\n1. e4 e5 2. Nf3 1-0\n\n"
+        "[Result \"0-1\"]\n[UTCDate \"2023.05.06\"]\n[UTCTime \"07:08:09\"]\n"
+        "[WhiteElo \"2300\"]\n[BlackElo \"2300\"]\n[TimeControl \"60+0\"]\n\n1. e4 c5 0-1\n\n"
+        "[Result \"1/2-1/2\"]\n\n1. d4 d5 1/2-1/2\n\n"
+        "[Result \"*\"]\n\n1. e4 e5 *\n\n";
+
+    std::vector<JChess::Game> readGames()
+    {
+        std::vector<JChess::Game> batch;
+        JChess::PGNReader reader{games};
+        while (const auto *pgnGame = reader.next())
+            batch.push_back(JChess::readPGN(*pgnGame));
+        return batch;
+    }
+
+    // Games of random legal moves, so that most positions are new
+    std::vector<JChess::Game> randomGames(size_t count)
+    {
+        std::mt19937 random{7};
+        std::vector<JChess::Game> batch(count);
+        for (auto &game : batch)
+        {
+            JChess::State state;
+            for (int ply = 0; ply < 20; ++ply)
+            {
+                auto legal = JChess::legalMoves(state);
+                if (legal.empty())
+                    break;
+                game.moves.push_back(legal[random() % legal.size()]);
+                state.applyMove(game.moves.back());
+            }
+            game.result.type = static_cast<JChess::GameResult::Type>(random() % 3);
+            game.whiteELO = static_cast<uint16_t>(1000 + random() % 1500);
+        }
+        return batch;
+    }
+
+    std::string contents(const std::filesystem::path &path)
+    {
+        std::ifstream input{path, std::ios::binary};
+        return {std::istreambuf_iterator<char>{input}, {}};
+    }
+
+    JChess::PackedPosition after(std::vector<JChess::Move> moves)
+    {
+        JChess::State state;
+        for (const auto &move : moves)
+            state.applyMove(move);
+        return JChess::PackedPosition{state};
+    }
+
+    class OpeningExplorerTest : public ::testing::Test
+    {
+    protected:
+        void TearDown() override
+        {
+            std::filesystem::remove(path);
+            std::filesystem::remove_all(spillDirectory);
+        }
+
+        OpeningExplorer write(size_t maxPlies = JChess::ExplorerBuildOptions{}.maxPlies)
+        {
+            OpeningExplorerBuilder builder{{.maxPlies = maxPlies}};
+            for (const auto &game : batch)
+                builder.add(game);
+            EXPECT_EQ(builder.games(), 3u);
+            builder.write(path);
+            return OpeningExplorer{path};
+        }
+
+        std::vector<JChess::Game> batch = readGames();
+        std::filesystem::path path = std::filesystem::temp_directory_path() / ("jchess-test-explorer-" + std::to_string(getpid()));
+        std::filesystem::path spillDirectory = std::filesystem::temp_directory_path() / ("jchess-test-explorer-runs-" + std::to_string(getpid()));
+    };
+} // namespace
+
+TEST_F(OpeningExplorerTest, CountsMovesByPosition)
+{
+    ASSERT_EQ(batch.size(), 4u);
+    auto explorer = write();
+    // The start, after 1. e4, after 1. e4 e5 and after 1. d4
+    EXPECT_EQ(explorer.size(), 4u);
+
+    auto start = explorer.moves(JChess::PackedPosition{JChess::State{}});
+    ASSERT_EQ(start.size(), 2u);
+    EXPECT_EQ(start[0].move.toUCI(), "e2e4");
+    EXPECT_EQ(start[0].whiteWins, 1u);
+    EXPECT_EQ(start[0].draws, 0u);
+    EXPECT_EQ(start[0].blackWins, 1u);
+    EXPECT_EQ(start[0].averageELO, (1600 + 2300) / 2);
+    EXPECT_EQ(start[0].lastPlayed, batch[1].datetime);
+    EXPECT_EQ(start[1].move.toUCI(), "d2d4");
+    EXPECT_EQ(start[1].draws, 1u);
+    EXPECT_EQ(start[1].averageELO, 0);
+
+    auto e4 = explorer.moves(after({batch[0].moves[0]}));
+    ASSERT_EQ(e4.size(), 2u);
+    EXPECT_EQ(e4[0].games(), 1u);
+    EXPECT_EQ(e4[1].games(), 1u);
+
+    auto e5 = explorer.moves(after({batch[0].moves[0], batch[0].moves[1]}));
+    ASSERT_EQ(e5.size(), 1u);
+    EXPECT_EQ(e5[0].move.toUCI(), "g1f3");
+    EXPECT_EQ(e5[0].lastPlayed, batch[0].datetime);
+
+    EXPECT_TRUE(explorer.moves(after({batch[0].moves[0], batch[0].moves[1], batch[0].moves[2]})).empty());
+}
+
+TEST_F(OpeningExplorerTest, Filters)
+{
+    auto explorer = write();
+    JChess::PackedPosition start{JChess::State{}};
+
+    // The 2200 band overlaps; unrated games are left out
+    auto strong = explorer.moves(start, {.ELO = JChess::Range<uint16_t>{2000, 2500}});
+    ASSERT_EQ(strong.size(), 1u);
+    EXPECT_EQ(strong[0].blackWins, 1u);
+    EXPECT_EQ(strong[0].whiteWins, 0u);
+    EXPECT_EQ(strong[0].averageELO, 2300);
+
+    auto blitz = explorer.moves(start, ExplorerFilter{}.acceptSpeed(JChess::Speed::Blitz));
+    ASSERT_EQ(blitz.size(), 1u);
+    EXPECT_EQ(blitz[0].whiteWins, 1u);
+    EXPECT_EQ(blitz[0].blackWins, 0u);
+
+    auto fast = explorer.moves(start, ExplorerFilter{}.acceptSpeed(JChess::Speed::Blitz).acceptSpeed(JChess::Speed::Bullet));
+    ASSERT_EQ(fast.size(), 1u);
+    EXPECT_EQ(fast[0].games(), 2u);
+
+    EXPECT_TRUE(explorer.moves(start, ExplorerFilter{.ELO = JChess::Range<uint16_t>{1000, 1100}}.acceptSpeed(JChess::Speed::Blitz)).empty());
+}
+
+TEST_F(OpeningExplorerTest, MaxPlies)
+{
+    auto explorer = write(1);
+    EXPECT_EQ(explorer.size(), 1u);
+    // 1. e4 in a blitz and a bullet bucket, 1. d4 in the unknown one
+    EXPECT_EQ(explorer.records(JChess::PackedPosition{JChess::State{}}.hash()).size(), 3u);
+    EXPECT_TRUE(explorer.moves(after({batch[0].moves[0]})).empty());
+}
+
+TEST_F(OpeningExplorerTest, ReplayedGames)
+{
+    OpeningExplorerBuilder builder;
+    EXPECT_THROW(builder.add(batch[0], std::vector<uint64_t>{1}), std::runtime_error);
+    std::vector<uint64_t> hashes{JChess::PackedPosition{JChess::State{}}.hash(), 1, 2};
+    builder.add(batch[0], hashes);
+    builder.write(path);
+
+    OpeningExplorer explorer{path};
+    EXPECT_EQ(explorer.size(), 3u);
+    ASSERT_EQ(explorer.moves(1).size(), 1u);
+    EXPECT_EQ(explorer.moves(1)[0].move.toUCI(), "e7e5");
+}
+
+TEST_F(OpeningExplorerTest, RejectsInvalidFiles)
+{
+    EXPECT_THROW(OpeningExplorer{path}, std::runtime_error);
+    {
+        std::ofstream output{path, std::ios::binary};
+        output << "JCMETA01 and then some more bytes than a header would need, to be sure.";
+    }
+    EXPECT_THROW(OpeningExplorer{path}, std::runtime_error);
+
+    write();
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+    EXPECT_THROW(OpeningExplorer{path}, std::runtime_error);
+}
+
+TEST_F(OpeningExplorerTest, SpillsRuns)
+{
+    auto games = randomGames(250);
+    std::copy_n(games.begin(), 50, games.begin() + 200);
+    OpeningExplorerBuilder inMemory;
+    for (const auto &game : games)
+        inMemory.add(game);
+    EXPECT_EQ(inMemory.runs(), 0u);
+    inMemory.write(path);
+    auto expected = contents(path);
+
+    // Room for a few hundred records, so repeated ones are merged across runs
+    std::filesystem::create_directory(spillDirectory);
+    OpeningExplorerBuilder spilling{{.memoryBytes = 16 << 10, .spillDirectory = spillDirectory}};
+    for (const auto &game : games)
+        spilling.add(game);
+    EXPECT_GT(spilling.runs(), 5u);
+    EXPECT_LE(spilling.memoryUsage(), size_t{16 << 10});
+    EXPECT_EQ(spilling.games(), games.size());
+    spilling.write(path);
+    EXPECT_EQ(contents(path), expected);
+    EXPECT_EQ(spilling.games(), 0u);
+    EXPECT_TRUE(std::filesystem::is_empty(spillDirectory));
+
+    OpeningExplorer explorer{path};
+    auto start = explorer.moves(JChess::PackedPosition{JChess::State{}});
+    uint32_t total = 0;
+    for (const auto &move : start)
+        total += move.games();
+    EXPECT_EQ(total, games.size());
+}
@@ -0,0 +1,137 @@
+#include "formats/pgnFile.h"
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using JChess::GameResult;
+
+namespace
+{
+    constexpr std::string_view scholarsMate =
+        "[Event \"Rated Blitz game\"]\n"
+        "[White \"Alice \\\"A\\\"\"]\n"
+        "[Black \"Bob\"]\n"
+        "[Result \"1-0\"]\n"
+        "[UTCDate \"2022.01.02\"]\n"
+        "[UTCTime \"03:04:05\"]\n"
+        "[WhiteElo \"1500\"]\n"
+        "[BlackElo \"?\"]\n"
+        "[ECO \"C20\"]\n"
+        "[TimeControl \"180+2\"]\n"
+        "[Termination \"Normal\"]\n"
+        "\n"
+        "1. e4 { [%eval 0.2] [%clk 0:03:00] } 1... e5 { [%eval 0.25] [%clk 0:03:00] } "
+        "2. Qh5 { [%eval 0.1] [%clk 0:03:01] } 2... Nc6 { [%eval 0.1] [%clk 0:03:01] } "
+        "3. Bc4 { [%eval 0.1] [%clk 0:03:02] } 3... Nf6?? { [%eval #1] [%clk 0:03:02] } "
+        "4. Qxf7# { [%clk 0:03:03] } 1-0\n";
+} // namespace
+
+TEST(PGNFileTest, ReadGame)
+{
+    std::istringstream input{std::string(scholarsMate)};
+    auto game = JChess::readPGN(input);
+
+    EXPECT_EQ(game.whiteUsername, "Alice \"A\"");
+    EXPECT_EQ(game.blackUsername, "Bob");
+    EXPECT_EQ(game.whiteELO, 1500);
+    EXPECT_EQ(game.blackELO, 0);
+    EXPECT_EQ(game.ECOCode, "C20");
+    EXPECT_EQ(game.timeControl.initial.count(), 180000u);
+    EXPECT_EQ(game.timeControl.increment.count(), 2000u);
+    EXPECT_EQ(game.datetime.time_since_epoch().count(), 1641092645);
+    EXPECT_EQ(game.result.type, GameResult::Type::WhiteWins);
+    EXPECT_EQ(game.result.reason, GameResult::Reason::Checkmate);
+
+    ASSERT_EQ(game.moves.size(), 7ull);
+    const auto &mate = game.moves.back();
+    EXPECT_EQ(mate.toUCI(), "h5f7");
+    EXPECT_EQ(mate.piece, (JChess::Piece{JChess::Color::White, JChess::PieceType::Queen}));
+    EXPECT_EQ(mate.capture, (JChess::Piece{JChess::Color::Black, JChess::PieceType::Pawn}));
+
+    ASSERT_TRUE(game.clocks);
+    EXPECT_EQ(game.clocks->back().count(), 183000u);
+    ASSERT_TRUE(game.evaluations);
+    EXPECT_EQ(game.evaluations->at(1).value, 25);
+    EXPECT_FALSE(game.evaluations->back().centipawns);
+    EXPECT_EQ(game.evaluations->back().value, 0);
+}
+
+TEST(PGNFileTest, MissingAnnotationsAndErrors)
+{
+    JChess::PGNReader reader{"[Result \"1/2-1/2\"]\n\n1. e4 { [%clk 0:01:00] } e5 1/2-1/2\n\n"
+                             "[Event \"?\"]\n\n1. e4 e5 2. Ke3 *\n\n"
+                             "[FEN \"7k/5Q2/6K1/8/8/8/8/8 b - - 0 1\"]\n[Result \"1/2-1/2\"]\n\n1/2-1/2\n"};
+    auto game = JChess::readPGN(*reader.next());
+    EXPECT_EQ(game.moves.size(), 2ull);
+    EXPECT_FALSE(game.clocks);
+    EXPECT_FALSE(game.evaluations);
+    EXPECT_EQ(game.result.type, GameResult::Type::Draw);
+    EXPECT_EQ(game.result.reason, GameResult::Reason::None);
+
+    EXPECT_THROW(JChess::readPGN(*reader.next()), std::runtime_error);
+
+    // No moves from a stalemate position
+    game = JChess::readPGN(*reader.next());
+    EXPECT_TRUE(game.moves.empty());
+    EXPECT_EQ(game.startFEN, "7k/5Q2/6K1/8/8/8/8/8 b - - 0 1");
+
+    std::istringstream empty{""};
+    EXPECT_THROW(JChess::readPGN(empty), std::runtime_error);
+}
+
+TEST(PGNFileTest, WriteRoundTrip)
+{
+    std::istringstream input{std::string(scholarsMate)};
+    auto game = JChess::readPGN(input);
+    game.annotations.emplace(game.moves.size(), JChess::Annotation::None);
+    game.annotations->at(2) = JChess::Annotation::Dubious;
+    game.clocks->at(0) = JChess::msDuration{61250};
+    game.evaluations->at(3) = JChess::Evaluation{.value = -1234};
+
+    std::string out;
+    JChess::writePGN(out, game);
+    EXPECT_NE(out.find("[White \"Alice \\\"A\\\"\"]\n"), std::string::npos) << out;
+    EXPECT_NE(out.find("[BlackElo \"?\"]\n"), std::string::npos) << out;
+    EXPECT_NE(out.find("\n\n1. e4 { [%eval 0.20] [%clk 0:01:01.25] } 1... e5 { [%eval 0.25] [%clk 0:03:00] } "
+                       "2. Qh5?! { [%eval 0.10] [%clk 0:03:01] } 2... Nc6 { [%eval -12.34] [%clk 0:03:01] } "),
+              std::string::npos)
+        << out;
+    EXPECT_TRUE(out.ends_with("4. Qxf7# { [%clk 0:03:03] } 1-0\n\n")) << out;
+
+    // Appending a second game without annotations, then reading both back
+    JChess::PGNReader first{out};
+    auto plain = JChess::readPGN(*first.next());
+    plain.clocks.reset();
+    plain.evaluations.reset();
+    plain.annotations.reset();
+    plain.startFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    plain.datetime = {};
+    JChess::writePGN(out, plain);
+
+    JChess::PGNReader reader{out};
+    for (const auto *expected : {&game, &plain})
+    {
+        auto read = JChess::readPGN(*reader.next());
+        EXPECT_EQ(read.whiteUsername, expected->whiteUsername);
+        EXPECT_EQ(read.datetime, expected->datetime);
+        EXPECT_EQ(read.whiteELO, expected->whiteELO);
+        EXPECT_EQ(read.blackELO, expected->blackELO);
+        EXPECT_EQ(read.timeControl.initial, expected->timeControl.initial);
+        EXPECT_EQ(read.result.type, expected->result.type);
+        EXPECT_EQ(read.result.reason, expected->result.reason);
+        EXPECT_EQ(read.startFEN, expected->startFEN);
+        EXPECT_EQ(read.moves, expected->moves);
+        EXPECT_EQ(read.clocks, expected->clocks);
+        EXPECT_EQ(read.annotations, expected->annotations);
+        ASSERT_EQ(read.evaluations.has_value(), expected->evaluations.has_value());
+        if (read.evaluations)
+        {
+            for (size_t i = 0; i < read.evaluations->size(); ++i)
+                EXPECT_EQ(read.evaluations->at(i).value, expected->evaluations->at(i).value);
+        }
+    }
+    EXPECT_EQ(reader.next(), nullptr);
+    EXPECT_NE(out.find("[Date \"????.??.??\"]"), std::string::npos);
+}
@@ -0,0 +1,129 @@
+#include "formats/pgnReader.h"
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+
+using JChess::PGNReader;
+
+namespace
+{
+    constexpr std::string_view twoGames =
+        "[Event \"Rated Bullet game\"]\n"
+        "[White \"Kike73\"]\n"
+        "[Black \"Aox066\"]\n"
+        "[Result \"0-1\"]\n"
+        "[Annotator \"a \\\"quoted\\\" name\"]\n"
+        "\n"
+        "1. e4 { [%eval 0.25] [%clk 0:02:00] } 1... e5 { [%eval -1.5] [%clk 0:01:59.5] } "
+        "2. Nf3?! $2 (2. Qh5 Nc6 (2... g6) 3. Bc4) 2... Nc6!! { a comment } ; rest of line\n"
+        "3. Bb5 { [%eval #-3] } 0-1\n"
+        "\n"
+        "[Event \"Casual\"]\n"
+        "[Result \"*\"]\n"
+        "\n"
+        "1.d4 d5 2.c4 *\n";
+}
+
+TEST(PGNReaderTest, Tokens)
+{
+    PGNReader reader{twoGames};
+
+    const auto *game = reader.next();
+    ASSERT_NE(game, nullptr);
+    EXPECT_EQ(game->tags.size(), 5ull);
+    EXPECT_EQ(game->tag("White"), "Kike73");
+    EXPECT_EQ(game->tag("Annotator"), "a \\\"quoted\\\" name");
+    EXPECT_EQ(game->tag("Missing"), "");
+    EXPECT_EQ(game->result, "0-1");
+    EXPECT_TRUE(game->text.starts_with("[Event"));
+    EXPECT_TRUE(game->text.ends_with("0-1"));
+
+    ASSERT_EQ(game->moves.size(), 5ull);
+    const auto &moves = game->moves;
+    EXPECT_EQ(moves[0].san, "e4");
+    EXPECT_EQ(moves[0].eval->value, 25);
+    EXPECT_TRUE(moves[0].eval->centipawns);
+    EXPECT_EQ(moves[0].clock->count(), 120000u);
+    EXPECT_EQ(moves[1].eval->value, -150);
+    EXPECT_EQ(moves[1].clock->count(), 119500u);
+
+    // The suffix comes first; the variation's moves are skipped
+    EXPECT_EQ(moves[2].san, "Nf3");
+    EXPECT_EQ(moves[2].nag, 6);
+    EXPECT_FALSE(moves[2].eval);
+    EXPECT_EQ(moves[3].san, "Nc6");
+    EXPECT_EQ(moves[3].nag, 3);
+
+    EXPECT_EQ(moves[4].san, "Bb5");
+    EXPECT_EQ(moves[4].eval->value, -3);
+    EXPECT_FALSE(moves[4].eval->centipawns);
+
+    game = reader.next();
+    ASSERT_NE(game, nullptr);
+    EXPECT_EQ(game->tag("Event"), "Casual");
+    EXPECT_EQ(game->result, "*");
+    ASSERT_EQ(game->moves.size(), 3ull);
+    EXPECT_EQ(game->moves[0].san, "d4");
+    EXPECT_EQ(game->moves[2].san, "c4");
+
+    EXPECT_EQ(reader.next(), nullptr);
+    EXPECT_EQ(reader.gamesRead(), 2ull);
+}
+
+TEST(PGNReaderTest, StreamMatchesMemory)
+{
+    std::string text;
+    for (int i = 0; i < 50; ++i)
+        text += twoGames;
+
+    // A tiny buffer forces games to straddle refills and the buffer to grow
+    for (size_t bufferSize : {1, 7, 64, 1 << 16})
+    {
+        std::istringstream input{text};
+        PGNReader streamed{input, bufferSize};
+        PGNReader mapped{text};
+
+        size_t games = 0;
+        while (const auto *game = mapped.next())
+        {
+            auto expected = *game;
+            std::string expectedSan;
+            for (const auto &move : expected.moves)
+                expectedSan += std::string(move.san) + ' ';
+
+            const auto *actual = streamed.next();
+            ASSERT_NE(actual, nullptr) << bufferSize;
+            std::string actualSan;
+            for (const auto &move : actual->moves)
+                actualSan += std::string(move.san) + ' ';
+
+            EXPECT_EQ(actualSan, expectedSan);
+            EXPECT_EQ(actual->text, expected.text);
+            EXPECT_EQ(actual->tags.size(), expected.tags.size());
+            ++games;
+        }
+        EXPECT_EQ(streamed.next(), nullptr);
+        EXPECT_EQ(games, 100ull);
+    }
+}
+
+TEST(PGNReaderTest, MissingResultAndErrors)
+{
+    PGNReader reader{"[Event \"A\"]\n\n1. e4 e5\n\n[Event \"B\"]\n\n1. d4\n"};
+    const auto *game = reader.next();
+    ASSERT_NE(game, nullptr);
+    EXPECT_EQ(game->moves.size(), 2ull);
+    EXPECT_EQ(game->result, "");
+    game = reader.next();
+    ASSERT_NE(game, nullptr);
+    EXPECT_EQ(game->tag("Event"), "B");
+    EXPECT_EQ(game->moves.size(), 1ull);
+    EXPECT_EQ(reader.next(), nullptr);
+
+    PGNReader unterminated{"[Event \"A\"]\n\n1. e4 { never closed"};
+    EXPECT_THROW(unterminated.next(), std::runtime_error);
+
+    PGNReader unbalanced{"1. e4 ) e5 *"};
+    EXPECT_THROW(unbalanced.next(), std::runtime_error);
+}
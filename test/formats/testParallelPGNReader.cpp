@@ -0,0 +1,172 @@
+#include "formats/parallelPGNReader.h"
+#include "formats/pgnReader.h"
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "formats/pgnFile.h"
+
+using JChess::ParallelPGNOptions;
+using JChess::ParallelPGNReader;
+using JChess::PGNReader;
+
+namespace
+{
+    // Games of different lengths, some with CRLF line endings
+    std::string manyGames(size_t count)
+    {
+        std::string text;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const char *newline = (i % 5 == 4) ? "\r\n" : "\n";
+            text += "[Event \"Game " + std::to_string(i) + "\"]" + newline;
+            text += "[Result \"1-0\"]" + std::string(newline) + newline;
+            for (size_t move = 0; move < i % 7; ++move)
+                text += std::to_string(move + 1) + ". e4 { [%clk 0:01:00] } e5 ";
+            text += std::string("1-0") + newline + newline;
+        }
+        return text;
+    }
+
+    // Legal games of 0 to 7 plies, with every 10th one illegal
+    std::string legalGames(size_t count)
+    {
+        constexpr const char *plies[]{"1. e4", "e5", "2. Nf3", "Nc6", "3. Bc4", "Bc5", "4. c3", "Nf6"};
+        std::string text;
+        for (size_t i = 0; i < count; ++i)
+        {
+            text += "[Event \"Game " + std::to_string(i) + "\"]\n[White \"player" + std::to_string(i) + "\"]\n[Result \"1-0\"]\n\n";
+            for (size_t ply = 0; ply < i % 8; ++ply)
+                text += std::string(plies[ply]) + " ";
+            if (i % 10 == 9)
+                text += "Ke5 ";
+            text += "1-0\n\n";
+        }
+        return text;
+    }
+
+    std::vector<std::string> serialTexts(std::string_view text)
+    {
+        std::vector<std::string> texts;
+        PGNReader reader{text};
+        while (const auto *game = reader.next())
+            texts.emplace_back(game->text);
+        return texts;
+    }
+
+    std::vector<std::string> parallelTexts(ParallelPGNReader &reader)
+    {
+        std::vector<std::string> texts;
+        while (const auto *game = reader.next())
+        {
+            EXPECT_EQ(game->moves.size(), 2 * ((texts.size() % 7)));
+            texts.emplace_back(game->text);
+        }
+        return texts;
+    }
+} // namespace
+
+TEST(ParallelPGNReaderTest, OrderedMatchesSerial)
+{
+    auto text = manyGames(500);
+    auto expected = serialTexts(text);
+    ASSERT_EQ(expected.size(), 500ull);
+
+    for (unsigned threads : {1u, 2u, 4u})
+        for (size_t chunkBytes : {size_t{1}, size_t{300}, size_t{1} << 20})
+        {
+            ParallelPGNReader reader{text, ParallelPGNOptions{.threads = threads, .chunkBytes = chunkBytes}};
+            EXPECT_EQ(parallelTexts(reader), expected) << threads << " threads, " << chunkBytes << " byte chunks";
+            EXPECT_EQ(reader.gamesRead(), expected.size());
+        }
+}
+
+TEST(ParallelPGNReaderTest, UnorderedAndMapped)
+{
+    auto text = manyGames(300);
+    auto expected = serialTexts(text);
+    std::sort(expected.begin(), expected.end());
+
+    auto path = std::filesystem::temp_directory_path() / ("jchess-test-parallel-" + std::to_string(getpid()) + ".pgn");
+    {
+        std::ofstream file{path, std::ios::binary};
+        file << text;
+    }
+
+    ParallelPGNReader reader{JChess::MappedFile{path}, ParallelPGNOptions{.threads = 3, .chunkBytes = 500, .chunksInFlight = 2, .ordered = false}};
+    std::vector<std::string> texts;
+    while (const auto *game = reader.next())
+        texts.emplace_back(game->text);
+    std::sort(texts.begin(), texts.end());
+    EXPECT_EQ(texts, expected);
+
+    std::filesystem::remove(path);
+}
+
+TEST(ParallelPGNReaderTest, EmptyAndErrors)
+{
+    ParallelPGNReader empty{std::string_view{}};
+    EXPECT_EQ(empty.next(), nullptr);
+
+    EXPECT_THROW(JChess::MappedFile{"/nonexistent/games.pgn"}, std::runtime_error);
+
+    // The games before the bad one come out first
+    auto text = manyGames(20) + "[Event \"Bad\"]\n\n1. e4 } 1-0\n\n" + manyGames(20);
+    ParallelPGNReader reader{text, ParallelPGNOptions{.threads = 2, .chunkBytes = 100}};
+    size_t games = 0;
+    EXPECT_THROW(
+        {
+            while (reader.next())
+                ++games;
+        },
+        std::runtime_error);
+    EXPECT_EQ(games, 20ull);
+
+    // Destroying a reader with unread chunks stops its workers
+    auto many = manyGames(200);
+    ParallelPGNReader abandoned{many, ParallelPGNOptions{.threads = 2, .chunkBytes = 64, .chunksInFlight = 1}};
+    EXPECT_NE(abandoned.next(), nullptr);
+}
+
+TEST(ParallelPGNReaderTest, ReadsGames)
+{
+    auto text = legalGames(200);
+    std::vector<JChess::Game> expected;
+    PGNReader serial{text};
+    while (const auto *game = serial.next())
+    {
+        try
+        {
+            expected.push_back(JChess::readPGN(*game));
+        }
+        catch (const std::exception &)
+        {
+        }
+    }
+    ASSERT_EQ(expected.size(), 180ull);
+
+    for (size_t chunkBytes : {size_t{1}, size_t{400}, size_t{1} << 20})
+    {
+        ParallelPGNReader reader{text, ParallelPGNOptions{.threads = 3, .chunkBytes = chunkBytes, .readGames = true}};
+        size_t i = 0;
+        while (const auto *game = reader.nextGame())
+        {
+            ASSERT_LT(i, expected.size());
+            EXPECT_EQ(game->whiteUsername, expected[i].whiteUsername) << chunkBytes;
+            EXPECT_EQ(game->moves, expected[i].moves) << chunkBytes;
+            ++i;
+        }
+        EXPECT_EQ(i, expected.size());
+        EXPECT_EQ(reader.gamesRead(), expected.size());
+        EXPECT_EQ(reader.gamesSkipped(), 20ull);
+    }
+
+    ParallelPGNReader tokens{text};
+    EXPECT_THROW(tokens.nextGame(), std::runtime_error);
+}